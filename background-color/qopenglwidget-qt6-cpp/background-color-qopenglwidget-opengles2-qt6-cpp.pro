@@ -8,3 +8,5 @@ SOURCES += \
     main.cpp
 
 TARGET = app
+
+include(../../common/offscreen-host/offscreen_host.pri)
@@ -2,8 +2,12 @@
 #include <QtOpenGLWidgets/QOpenGLWidget>
 #include <QtWidgets/QApplication>
 
+#include "offscreen_host.h"
+
 class OpenGLWidget : public QOpenGLWidget, private QOpenGLFunctions
 {
+    friend class OffscreenHost;
+
 public:
     OpenGLWidget()
     {
@@ -28,6 +32,10 @@ int main(int argc, char *argv[])
     QApplication::setAttribute(Qt::ApplicationAttribute::AA_UseDesktopOpenGL);
     QApplication app(argc, argv);
     OpenGLWidget w;
+    if (OffscreenHost::isRequested(app.arguments()))
+    {
+        return OffscreenHost(app.arguments()).run(w);
+    }
     w.show();
     return app.exec();
 }
@@ -6,3 +6,10 @@ CONFIG += c++17
 
 SOURCES += \
     main.cpp
+
+include(../../../common/gl-state-cache/gl_state_cache.pri)
+include(../../../common/offscreen-host/offscreen_host.pri)
+include(../../../common/rect-batch/rect_batch.pri)
+include(../../../common/render-targets/render_targets.pri)
+include(../../../common/shader-cache/shader_cache.pri)
+include(../../../common/streaming-buffer/streaming_buffer.pri)
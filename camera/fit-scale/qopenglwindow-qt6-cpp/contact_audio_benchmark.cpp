@@ -0,0 +1,200 @@
+#include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QRandomGenerator>
+
+#include <memory>
+#include <vector>
+
+#include "audio_engine.h"
+#include "contact_audio_benchmark.h"
+#include "contact_event_queue.h"
+#include "impact_sounds.h"
+#include "physics_world_2d.h"
+
+namespace
+{
+    const float metersPerUnit = 0.1f;
+    const QVector2D gravity(0.f, -98.f);
+    const float stepDt = 1.f / 60.f;
+    const int sampleRate = 44100;
+    const int frameSamples = sampleRate / 60;
+    const int bodyCount = 10000;
+    const int rowSize = 100;
+    const float spacing = 1.75f;
+    const int stepsPerRow = 10;
+    const int spawnSteps = bodyCount / rowSize * stepsPerRow;
+    const int settleSteps = 300;
+    const int windowCount = 5;
+    const int queueCapacity = 4096;
+    const int drainSize = 256;
+
+    struct Window
+    {
+        double stepMs = 0.0;
+        double maxStepMs = 0.0;
+        double audioMs = 0.0;
+    };
+
+    // The borders of the fit-scale window
+    void addBorders(PhysicsWorld2D *world)
+    {
+        world->addStaticBox(5, 50, 5, 85);
+        world->addStaticBox(195, 50, 5, 85);
+        world->addStaticBox(100, 95, 185, 5);
+        world->addStaticBox(100, 5, 185, 5);
+    }
+
+    void spawnRow(PhysicsWorld2D *world, QRandomGenerator *random)
+    {
+        const float left = 100.f - (rowSize - 1) * spacing / 2.f;
+        for (int i = 0; i < rowSize; ++i)
+        {
+            world->addDynamicBox(left + i * spacing + random->bounded(0.3f), 88.f, 1.f, 1.f,
+                random->bounded(1.f));
+        }
+    }
+
+    QString formatWindows(const Window *windows, int steps)
+    {
+        QString text;
+        const int windowSteps = steps / windowCount;
+        for (int i = 0; i < windowCount; ++i)
+        {
+            text += QString(" %1/%2").arg(windows[i].stepMs / windowSteps, 0, 'f', 2)
+                .arg(windows[i].maxStepMs, 0, 'f', 2);
+        }
+        return text;
+    }
+
+    ImpactSounds::Settings impactSettings()
+    {
+        ImpactSounds::Settings settings;
+        // A 1 by 1 box weighs 10 g and lands at up to 12 m/s
+        settings.minImpulse = 0.005f;
+        settings.fullImpulse = 0.2f;
+        settings.referenceDistance = 100.f;
+        return settings;
+    }
+
+    // The consumer side, only built for the pass with an engine
+    struct ImpactAudio
+    {
+        explicit ImpactAudio(AudioEngine *engine)
+            : cache(engine, 256 * 1024, 64 * 1024)
+            , impacts(&cache, impactSettings())
+        {
+            impacts.setClips({ ":/assets/sounds/impact-1.wav", ":/assets/sounds/impact-2.wav",
+                ":/assets/sounds/impact-3.wav", ":/assets/sounds/impact-4.wav" });
+        }
+
+        SoundCache cache;
+        ImpactSounds impacts;
+    };
+
+    // With engine nullptr no contact listener is set
+    int run(AudioEngine *engine)
+    {
+        PhysicsWorld2D world(gravity, metersPerUnit);
+        addBorders(&world);
+
+        ContactEventQueue queue(queueCapacity);
+        std::vector<ContactEvent> drained(drainSize);
+        std::vector<qint16> output(frameSamples * 2);
+        std::unique_ptr<ImpactAudio> audio;
+        if (engine)
+        {
+            audio.reset(new ImpactAudio(engine));
+            engine->resetStats();
+            engine->setListener(QVector3D(100.f, 50.f, 100.f), QVector3D(0.f, 0.f, 1.f),
+                QVector3D(0.f, 1.f, 0.f));
+            world.setContactEvents(&queue);
+        }
+
+        QRandomGenerator random(42);
+        const int steps = spawnSteps + settleSteps;
+        const int windowSteps = steps / windowCount;
+        Window windows[windowCount];
+        quint64 maxPlayed = 0;
+        QElapsedTimer timer;
+        for (int step = 0; step < windowSteps * windowCount; ++step)
+        {
+            if (step < spawnSteps && step % stepsPerRow == 0)
+            {
+                spawnRow(&world, &random);
+            }
+            Window &window = windows[step / windowSteps];
+            timer.start();
+            world.step(stepDt);
+            const double stepMs = timer.nsecsElapsed() / 1e6;
+            window.stepMs += stepMs;
+            window.maxStepMs = qMax(window.maxStepMs, stepMs);
+            if (!audio)
+            {
+                continue;
+            }
+            ImpactSounds &impacts = audio->impacts;
+
+            // One frame of the window: drain, merge, play, mix
+            timer.start();
+            const quint64 played = impacts.stats().played;
+            int count;
+            while ((count = queue.pop(drained.data(), drainSize)) > 0)
+            {
+                for (int i = 0; i < count; ++i)
+                {
+                    impacts.add(QVector3D(drained[i].x, drained[i].y, 0.f), drained[i].impulse);
+                }
+            }
+            impacts.flush();
+            engine->update();
+            engine->render(output.data(), frameSamples);
+            window.audioMs += timer.nsecsElapsed() / 1e6;
+            maxPlayed = qMax(maxPlayed, impacts.stats().played - played);
+        }
+        world.setContactEvents(nullptr);
+
+        qInfo().noquote() << QString("%1 bodies, %2: avg/max ms per step in %3 windows of %4 "
+            "steps:%5").arg(world.bodyCount() - 4).arg(engine ? "contact audio" : "no listener")
+            .arg(windowCount).arg(windowSteps).arg(formatWindows(windows, steps));
+        if (!audio)
+        {
+            return 0;
+        }
+
+        double audioMs = 0.0;
+        for (const Window &window : windows)
+        {
+            audioMs += window.audioMs;
+        }
+        const ImpactSounds::Stats &stats = audio->impacts.stats();
+        const AudioEngine::Stats &engineStats = engine->stats();
+        qInfo().noquote() << QString("  %1 contacts queued, %2 dropped, %3 quiet, %4 merged, "
+            "%5 throttled, %6 played (max %7 per frame), %8 stolen, %9 ms audio per frame")
+            .arg(queue.pushed()).arg(queue.dropped()).arg(stats.quiet).arg(stats.merged)
+            .arg(stats.throttled).arg(stats.played).arg(maxPlayed).arg(engineStats.stolen)
+            .arg(audioMs / steps, 0, 'f', 3);
+        // Nothing grows with the body or contact count
+        qInfo().noquote() << QString("  fixed memory: %1 KB event queue, %2 KB impact table, "
+            "%3 voices")
+            .arg(queue.capacity() * sizeof(ContactEvent) / 1024.0, 0, 'f', 0)
+            .arg(audio->impacts.memoryBytes() / 1024.0, 0, 'f', 0).arg(engineStats.voices);
+        return 0;
+    }
+}
+
+int runContactAudioBenchmark()
+{
+    AudioEngine engine(32);
+    if (!engine.open(AudioEngine::Device::Loopback, sampleRate))
+    {
+        qWarning() << "Contact audio benchmark needs ALC_SOFT_loopback";
+        return 1;
+    }
+    int result = run(nullptr);
+    if (result == 0)
+    {
+        result = run(&engine);
+    }
+    engine.close();
+    return result;
+}
@@ -0,0 +1,12 @@
+#ifndef CONTACT_AUDIO_BENCHMARK_H
+#define CONTACT_AUDIO_BENCHMARK_H
+
+// Drops 10k boxes in rows onto the window's border rectangles and steps
+// PhysicsWorld2D once without contact events and once with the events
+// queued, drained every frame and played through ImpactSounds on an
+// OpenAL loopback device. Prints step times per window of steps,
+// contacts queued and dropped, voices started per frame and the fixed
+// memory of the pipeline. Returns a process exit code.
+int runContactAudioBenchmark();
+
+#endif // CONTACT_AUDIO_BENCHMARK_H
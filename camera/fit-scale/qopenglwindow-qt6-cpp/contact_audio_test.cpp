@@ -0,0 +1,139 @@
+#include <QtCore/QDebug>
+
+#include "audio_engine.h"
+#include "contact_audio_test.h"
+#include "contact_event_queue.h"
+#include "impact_sounds.h"
+
+namespace
+{
+    bool check(bool condition, const char *what)
+    {
+        if (!condition)
+        {
+            qWarning() << "Check failed:" << what;
+        }
+        return condition;
+    }
+
+    ContactEvent event(int id)
+    {
+        return { float(id), 0.f, 1.f, id, id + 1 };
+    }
+
+    // Events carry their push index in bodyA
+    bool inOrder(const ContactEvent *events, int count, int firstId)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            if (events[i].bodyA != firstId + i)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool testQueue()
+    {
+        bool ok = true;
+        ContactEventQueue queue(5);
+        ok &= check(queue.capacity() == 8, "capacity is rounded up to a power of two");
+
+        int accepted = 0;
+        for (int i = 0; i < 10; ++i)
+        {
+            accepted += queue.push(event(i)) ? 1 : 0;
+        }
+        ok &= check(accepted == 8, "a full queue refuses events");
+        ok &= check(queue.pushed() == 8 && queue.dropped() == 2,
+            "refused events are counted as dropped");
+
+        ContactEvent events[16];
+        ok &= check(queue.pop(events, 3) == 3 && inOrder(events, 3, 0),
+            "pop returns the oldest events first");
+        // Slots 0 .. 2 are free again, the next pushes wrap around to them
+        for (int i = 8; i < 11; ++i)
+        {
+            ok &= check(queue.push(event(i)), "freed slots take new events");
+        }
+        ok &= check(!queue.push(event(11)), "the queue is full again after wrapping");
+        ok &= check(queue.pop(events, 16) == 8 && inOrder(events, 8, 3),
+            "pop across the wrap point keeps the push order");
+        ok &= check(queue.pop(events, 16) == 0, "an empty queue pops nothing");
+        ok &= check(queue.pushed() == 11 && queue.dropped() == 3,
+            "counters after the wrap");
+
+        qInfo().noquote() << QString("ContactEventQueue: %1").arg(ok ? "ok" : "FAILED");
+        return ok;
+    }
+
+    bool testImpacts()
+    {
+        AudioEngine engine(32);
+        if (!engine.open(AudioEngine::Device::Null) &&
+            !engine.open(AudioEngine::Device::Loopback))
+        {
+            qWarning() << "Impact sounds test needs an OpenAL null or loopback device";
+            return false;
+        }
+
+        bool ok = true;
+        {
+            SoundCache cache(&engine, 256 * 1024, 64 * 1024);
+            ImpactSounds::Settings settings;
+            settings.cellSize = 10.f;
+            settings.minImpulse = 1.f;
+            settings.fullImpulse = 100.f;
+            settings.maxPerFrame = 2;
+            settings.maxImpacts = 16;
+            ImpactSounds impacts(&cache, settings);
+            impacts.setClips({ ":/assets/sounds/impact-1.wav", ":/assets/sounds/impact-2.wav" });
+            const quint64 cacheMisses = cache.stats().misses;
+
+            // Four impacts in the cell from (0, 0) to (10, 10), one of them quiet
+            impacts.add(QVector3D(1.f, 1.f, 0.f), 5.f);
+            impacts.add(QVector3D(9.f, 2.f, 0.f), 20.f);
+            impacts.add(QVector3D(4.f, 9.f, 0.f), 10.f);
+            impacts.add(QVector3D(5.f, 5.f, 0.f), 0.5f);
+            ok &= check(impacts.stats().merged == 2, "impacts in one cell merge");
+            ok &= check(impacts.stats().quiet == 1, "impacts under minImpulse are quiet");
+            // Three more cells, four in total for two voices
+            impacts.add(QVector3D(15.f, 5.f, 0.f), 5.f);
+            impacts.add(QVector3D(-5.f, 5.f, 0.f), 5.f);
+            impacts.add(QVector3D(5.f, 15.f, 0.f), 5.f);
+            impacts.flush();
+            ok &= check(impacts.stats().played == 2 && impacts.stats().rejected == 0,
+                "flush() starts maxPerFrame voices");
+            ok &= check(impacts.stats().throttled == 2, "the other cells are throttled");
+            ok &= check(cache.stats().misses == cacheMisses,
+                "setClips() decoded the clips before flush()");
+
+            // A new frame, the cell of the first frame must not merge any more
+            impacts.resetStats();
+            impacts.add(QVector3D(1.f, 1.f, 0.f), 5.f);
+            ok &= check(impacts.stats().merged == 0, "flush() empties the merge table");
+            for (int i = 0; i < 20; ++i)
+            {
+                impacts.add(QVector3D(100.f + i * 10.f, 0.f, 0.f), 5.f);
+            }
+            ok &= check(impacts.stats().throttled == 5, "cells over maxImpacts are dropped");
+            impacts.flush();
+            ok &= check(impacts.stats().played == 2 && impacts.stats().throttled == 19,
+                "maxPerFrame bounds a full frame");
+        }
+        engine.close();
+
+        qInfo().noquote() << QString("ImpactSounds: %1").arg(ok ? "ok" : "FAILED");
+        return ok;
+    }
+}
+
+int runContactAudioTest()
+{
+    const bool queueOk = testQueue();
+    const bool impactsOk = testImpacts();
+    const bool ok = queueOk && impactsOk;
+    qInfo() << (ok ? "Contact audio test passed" : "Contact audio test FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,13 @@
+#ifndef CONTACT_AUDIO_TEST_H
+#define CONTACT_AUDIO_TEST_H
+
+// Checks ContactEventQueue without a physics world: pushes past the
+// capacity and expects the rest to be dropped and counted, then pops
+// across the wrap-around point and expects the events in push order.
+// Then feeds ImpactSounds on an OpenAL null device and checks that the
+// impacts of one cell merge, that the merge table is empty again after
+// flush(), and that maxPerFrame and maxImpacts bound the voices.
+// Returns a process exit code.
+int runContactAudioTest();
+
+#endif // CONTACT_AUDIO_TEST_H
@@ -0,0 +1,112 @@
+#include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QRandomGenerator>
+#include <QtGui/QMatrix4x4>
+
+#include <vector>
+
+#include "culling_benchmark.h"
+#include "culling_bvh.h"
+
+namespace
+{
+    const int objectCount = 200000;
+    const float worldWidth = 2000.f;
+    const float worldHeight = 1000.f;
+    const float viewWidth = 200.f;
+    const float viewHeight = 100.f;
+    const int movedPerFrame = objectCount / 20;
+    const int frameCount = 120;
+}
+
+int runCullingBenchmark()
+{
+    QRandomGenerator random(42);
+    std::vector<float> centers(objectCount * 3);
+    std::vector<float> extents(objectCount * 3);
+    for (int i = 0; i < objectCount; ++i)
+    {
+        centers[i * 3] = random.bounded(worldWidth);
+        centers[i * 3 + 1] = random.bounded(worldHeight);
+        centers[i * 3 + 2] = 0.f;
+        // Half diagonal of the rectangle, so any rotation stays inside
+        extents[i * 3] = extents[i * 3 + 1] = 1.f + random.bounded(3.f);
+        extents[i * 3 + 2] = 0.f;
+    }
+
+    QMatrix4x4 viewMatrix;
+    viewMatrix.lookAt(QVector3D(0, 0, 1), QVector3D(0, 0, 0), QVector3D(0, 1, 0));
+
+    QElapsedTimer timer;
+    timer.start();
+    CullingBvh culling(1.f);
+    culling.build(centers.data(), extents.data(), objectCount);
+    const double buildMs = timer.nsecsElapsed() / 1e6;
+
+    std::vector<int> visible;
+    visible.reserve(objectCount);
+    double refitMs = 0.0;
+    double cullMs = 0.0;
+    double bruteMs = 0.0;
+    quint64 submitted = 0;
+    quint64 culled = 0;
+    quint64 leavesRefitted = 0;
+    int result = 0;
+    for (int frame = 0; frame < frameCount; ++frame)
+    {
+        // Pan diagonally across the world
+        const float left = (worldWidth - viewWidth) * frame / (frameCount - 1);
+        const float bottom = (worldHeight - viewHeight) * frame / (frameCount - 1);
+        QMatrix4x4 projMatrix;
+        projMatrix.ortho(left, left + viewWidth, bottom, bottom + viewHeight, 1.f, -1.f);
+        const Frustum frustum(projMatrix * viewMatrix);
+
+        for (int n = 0; n < movedPerFrame; ++n)
+        {
+            const int i = (frame * movedPerFrame + n) % objectCount;
+            centers[i * 3] += random.bounded(2.f) - 1.f;
+            centers[i * 3 + 1] += random.bounded(2.f) - 1.f;
+        }
+        timer.start();
+        for (int n = 0; n < movedPerFrame; ++n)
+        {
+            const int i = (frame * movedPerFrame + n) % objectCount;
+            culling.update(i, &centers[i * 3], &extents[i * 3]);
+        }
+        culling.refit();
+        refitMs += timer.nsecsElapsed() / 1e6;
+
+        // Near and far never reject anything in 2D
+        visible.clear();
+        timer.start();
+        culling.cull(frustum, Frustum::sidePlanes, &visible);
+        cullMs += timer.nsecsElapsed() / 1e6;
+        submitted += culling.stats().submitted;
+        culled += culling.stats().culled;
+        leavesRefitted += culling.stats().leavesRefitted;
+
+        timer.start();
+        int bruteVisible = 0;
+        for (int i = 0; i < objectCount; ++i)
+        {
+            int mask = Frustum::sidePlanes;
+            bruteVisible += frustum.test(&centers[i * 3], &extents[i * 3], &mask) !=
+                Frustum::Result::Outside;
+        }
+        bruteMs += timer.nsecsElapsed() / 1e6;
+        if (bruteVisible != culling.stats().submitted)
+        {
+            result = 1;
+        }
+    }
+
+    qInfo().noquote() << QString("Culling %1 rectangles: build %2 ms, refit %3 ms "
+        "(%4 leaves), visible set %5 ms, brute force %6 ms per frame")
+        .arg(objectCount).arg(buildMs, 0, 'f', 1)
+        .arg(refitMs / frameCount, 0, 'f', 3).arg(leavesRefitted / frameCount)
+        .arg(cullMs / frameCount, 0, 'f', 3).arg(bruteMs / frameCount, 0, 'f', 3);
+    qInfo().noquote() << QString("    %1 submitted, %2 culled per frame%3")
+        .arg(submitted / frameCount).arg(culled / frameCount)
+        .arg(result == 0 ? "" : ", MISMATCH with brute force");
+    return result;
+}
@@ -0,0 +1,11 @@
+#ifndef CULLING_BENCHMARK_H
+#define CULLING_BENCHMARK_H
+
+// The example always shows its whole world, so culling would reject
+// nothing there. This pans a 200 x 100 view across a 2000 x 1000 world of
+// 200k rectangles, 5% of them moving every frame, and prints the time to
+// refit the culling tree and extract the visible set next to testing
+// every rectangle. Returns a process exit code, 1 when the two disagree.
+int runCullingBenchmark();
+
+#endif // CULLING_BENCHMARK_H
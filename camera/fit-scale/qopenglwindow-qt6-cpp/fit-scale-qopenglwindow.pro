@@ -5,4 +5,64 @@ win32: LIBS += -lopengl32
 CONFIG += c++17
 
 SOURCES += \
-    main.cpp
+    culling_benchmark.cpp \
+    gl_state_cache_benchmark.cpp \
+    main.cpp \
+    rect_batch_benchmark.cpp \
+    render_command_benchmark.cpp \
+    streaming_buffer_benchmark.cpp \
+    transform_kernel_benchmark.cpp
+
+HEADERS += \
+    culling_benchmark.h \
+    gl_state_cache_benchmark.h \
+    rect_batch_benchmark.h \
+    render_command_benchmark.h \
+    streaming_buffer_benchmark.h \
+    transform_kernel_benchmark.h
+
+RESOURCES += \
+    assets.qrc
+
+include(../../../common/culling/culling.pri)
+include(../../../common/frame-profiler/frame_profiler.pri)
+include(../../../common/frame-scheduler/frame_scheduler.pri)
+include(../../../common/game-loop/game_loop.pri)
+include(../../../common/gl-state-cache/gl_state_cache.pri)
+include(../../../common/offscreen-host/offscreen_host.pri)
+include(../../../common/rect-batch/rect_batch.pri)
+include(../../../common/render-commands/render_commands.pri)
+include(../../../common/render-targets/render_targets.pri)
+include(../../../common/shader-cache/shader_cache.pri)
+include(../../../common/streaming-buffer/streaming_buffer.pri)
+include(../../../common/transform-kernel/transform_kernel.pri)
+
+# Box2D drops the square and the space-bar boxes, configure with
+# "qmake CONFIG+=box2d". Without it the scene stays static.
+box2d {
+    DEFINES += BOX2D_PHYSICS
+
+    SOURCES += \
+        physics_benchmark.cpp
+
+    HEADERS += \
+        physics_benchmark.h
+
+    include(../../../common/physics-2d/physics_world_2d.pri)
+}
+
+# Impact sounds for "--audio" need both Box2D and OpenAL, configure with
+# "qmake CONFIG+=box2d CONFIG+=openal"
+box2d:openal {
+    DEFINES += IMPACT_AUDIO
+
+    SOURCES += \
+        contact_audio_benchmark.cpp \
+        contact_audio_test.cpp
+
+    HEADERS += \
+        contact_audio_benchmark.h \
+        contact_audio_test.h
+
+    include(../../../common/spatial-audio/spatial_audio.pri)
+}
@@ -0,0 +1,161 @@
+#include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QRandomGenerator>
+#include <QtGui/QOffscreenSurface>
+#include <QtGui/QOpenGLContext>
+#include <QtOpenGL/QOpenGLBuffer>
+#include <QtOpenGL/QOpenGLFramebufferObject>
+
+#include "gl_state_cache.h"
+#include "gl_state_cache_benchmark.h"
+#include "shader_cache.h"
+
+namespace
+{
+    const float worldWidth = 200.f;
+    const float worldHeight = 100.f;
+    const int rectCount = 10000;
+    const int colorRunLength = 100;
+    const int warmUpFrames = 5;
+    const int measuredFrames = 50;
+    // Program, buffer, matrix and color for every rectangle
+    const int stateCallsPerRect = 4;
+
+    const char *vertShaderSrc =
+        "attribute vec2 aPosition;\n"
+        "uniform mat4 uMvpMatrix;\n"
+        "void main()\n"
+        "{\n"
+        "    gl_Position = uMvpMatrix * vec4(aPosition, 0.0, 1.0);\n"
+        "}\n";
+
+    const char *fragShaderSrc =
+        "#ifdef GL_ES\n"
+        "precision mediump float;\n"
+        "#endif\n"
+        "uniform vec3 uColor;\n"
+        "void main()\n"
+        "{\n"
+        "    gl_FragColor = vec4(uColor, 1.0);\n"
+        "}\n";
+}
+
+int runGLStateCacheBenchmark()
+{
+    QOpenGLContext context;
+    if (!context.create())
+    {
+        qWarning() << "Failed to create an OpenGL context";
+        return 1;
+    }
+    QOffscreenSurface surface;
+    surface.setFormat(context.format());
+    surface.create();
+    if (!context.makeCurrent(&surface))
+    {
+        qWarning() << "Failed to make the OpenGL context current";
+        return 1;
+    }
+
+    QOpenGLFramebufferObject fbo(800, 400);
+    fbo.bind();
+    QOpenGLFunctions *gl = context.functions();
+    gl->glViewport(0, 0, fbo.width(), fbo.height());
+
+    QOpenGLShaderProgram *program = ShaderCache::instance()->program(vertShaderSrc,
+        fragShaderSrc, { { "aPosition", 0 } });
+    if (!program)
+    {
+        return 1;
+    }
+    const int uMvpMatrixLocation = program->uniformLocation("uMvpMatrix");
+    const int uColorLocation = program->uniformLocation("uColor");
+
+    float vertPositions[] = {
+        -0.5f, -0.5f,
+        0.5f, -0.5f,
+        -0.5f, 0.5f,
+        0.5f, 0.5f
+    };
+    QOpenGLBuffer vertPosBuffer;
+    vertPosBuffer.create();
+    vertPosBuffer.bind();
+    vertPosBuffer.allocate(vertPositions, sizeof(vertPositions));
+    program->bind();
+    program->setAttributeBuffer(0, GL_FLOAT, 0, 2);
+    program->enableAttributeArray(0);
+
+    QMatrix4x4 projViewMatrix;
+    projViewMatrix.ortho(0.f, worldWidth, 0.f, worldHeight, 1.f, -1.f);
+    QRandomGenerator random(42);
+    QVector<QMatrix4x4> mvpMatrices(rectCount);
+    QVector<QVector3D> colors(rectCount);
+    for (int i = 0; i < rectCount; ++i)
+    {
+        QMatrix4x4 modelMatrix;
+        modelMatrix.translate(random.bounded(worldWidth), random.bounded(worldHeight));
+        modelMatrix.rotate(random.bounded(360.f), QVector3D(0, 0, 1));
+        modelMatrix.scale(0.5f + random.bounded(4.f), 0.5f + random.bounded(4.f));
+        mvpMatrices[i] = projViewMatrix * modelMatrix;
+        colors[i] = i % colorRunLength == 0 ? QVector3D(random.bounded(1.f),
+            random.bounded(1.f), random.bounded(1.f)) : colors[i - 1];
+    }
+
+    GLStateCache state;
+    state.initialize();
+
+    // 0 - direct calls, 1 - through the state cache
+    double frameTimes[2];
+    for (int mode = 0; mode < 2; ++mode)
+    {
+        QElapsedTimer timer;
+        for (int frame = 0; frame < warmUpFrames + measuredFrames; ++frame)
+        {
+            if (frame == warmUpFrames)
+            {
+                timer.start();
+                state.resetStats();
+            }
+            gl->glClear(GL_COLOR_BUFFER_BIT);
+            for (int i = 0; i < rectCount; ++i)
+            {
+                if (mode == 0)
+                {
+                    program->bind();
+                    vertPosBuffer.bind();
+                    program->setUniformValue(uMvpMatrixLocation, mvpMatrices[i]);
+                    program->setUniformValue(uColorLocation, colors[i]);
+                }
+                else
+                {
+                    state.useProgram(program);
+                    state.bindBuffer(GL_ARRAY_BUFFER, vertPosBuffer.bufferId());
+                    state.setUniform(uMvpMatrixLocation, mvpMatrices[i]);
+                    state.setUniform(uColorLocation, colors[i]);
+                }
+                gl->glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+            }
+            // Wait for the GPU so that frame time includes rendering
+            gl->glFinish();
+        }
+        frameTimes[mode] = timer.nsecsElapsed() / 1e6 / measuredFrames;
+
+        if (mode == 0)
+        {
+            // The direct calls changed bindings and uniforms behind its back
+            state.invalidate();
+        }
+    }
+
+    const GLStateCache::Stats &stats = state.stats();
+    qInfo().noquote() << QString("%1 rectangles, direct calls: %2 state calls, %3 ms per frame")
+        .arg(rectCount).arg(rectCount * stateCallsPerRect).arg(frameTimes[0], 0, 'f', 3);
+    qInfo().noquote() << QString("%1 rectangles, state cache: %2 issued, %3 skipped, "
+        "%4 ms per frame").arg(rectCount).arg(stats.issued / measuredFrames)
+        .arg(stats.skipped / measuredFrames).arg(frameTimes[1], 0, 'f', 3);
+
+    vertPosBuffer.destroy();
+    fbo.release();
+    context.doneCurrent();
+    return 0;
+}
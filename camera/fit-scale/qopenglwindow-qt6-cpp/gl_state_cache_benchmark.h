@@ -0,0 +1,11 @@
+#ifndef GL_STATE_CACHE_BENCHMARK_H
+#define GL_STATE_CACHE_BENCHMARK_H
+
+// Draws 10k rectangles one draw call each, the way drawRectangle() did
+// before RectBatch, with colors in runs of 100 like the border
+// rectangles. The scene is drawn once with direct Qt calls and once
+// through GLStateCache. Prints the frame times and the issued and skipped
+// state calls. Returns a process exit code.
+int runGLStateCacheBenchmark();
+
+#endif // GL_STATE_CACHE_BENCHMARK_H
@@ -1,19 +1,65 @@
+#include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QRandomGenerator>
+#include <QtCore/QTimer>
+#include <QtGui/QKeyEvent>
 #include <QtGui/QMatrix4x4>
 #include <QtGui/QOpenGLFunctions>
 #include <QtGui/QSurfaceFormat>
 #include <QtGui/QVector3D>
-#include <QtOpenGL/QOpenGLBuffer>
-#include <QtOpenGL/QOpenGLShader>
-#include <QtOpenGL/QOpenGLShaderProgram>
 #include <QtOpenGL/QOpenGLWindow>
 #include <QtWidgets/QApplication>
+#include <QtMath>
 
-class OpenGLWindow : public QOpenGLWindow, private QOpenGLFunctions
+#include "culling_benchmark.h"
+#include "fixed_timestep.h"
+#include "frame_profiler.h"
+#include "frame_scheduler.h"
+#include "gl_state_cache_benchmark.h"
+#include "offscreen_host.h"
+#include "rect_batch.h"
+#include "rect_batch_benchmark.h"
+#include "render_command_benchmark.h"
+#include "render_command_queue.h"
+#include "render_target_manager.h"
+#include "streaming_buffer_benchmark.h"
+#include "transform_kernel_benchmark.h"
+
+#ifdef BOX2D_PHYSICS
+#include "physics_benchmark.h"
+#include "physics_world_2d.h"
+#endif
+
+#ifdef IMPACT_AUDIO
+#include <memory>
+
+#include "audio_engine.h"
+#include "contact_audio_benchmark.h"
+#include "contact_audio_test.h"
+#include "contact_event_queue.h"
+#include "impact_sounds.h"
+#endif
+
+class OpenGLWindow : public QOpenGLWindow, private QOpenGLFunctions,
+    private RenderCommandBackend
 {
+    friend class OffscreenHost;
 
 public:
 
     OpenGLWindow()
+        // The live scene is a few dozen rectangles, waking worker threads
+        // would cost more than recording them
+        : m_commands(1)
+#ifdef BOX2D_PHYSICS
+        // 0.1 m per unit makes the box 5 m and the world 20 by 10 m,
+        // which is the range Box2D is tuned for
+        , m_physics(QVector2D(0.f, -98.f), 0.1f)
+        , m_physicsTimestep(60)
+#endif
+#ifdef IMPACT_AUDIO
+        , m_contacts(contactBufferSize * 4)
+#endif
     {
         setTitle("OpenGL ES 2.0, Qt6, C++");
         resize(380, 380);
@@ -22,126 +68,428 @@ public:
         surfaceFormat.setDepthBufferSize(24);
         surfaceFormat.setSamples(4);
         setFormat(surfaceFormat);
+        m_frameScheduler = new FrameScheduler(this,
+            FrameScheduler::modeFromArguments(QCoreApplication::arguments()));
+
+#ifdef FRAME_PROFILER
+        connect(this, &QOpenGLWindow::frameSwapped, this, [] { PROFILE_FRAME_END(); });
+#endif
+
+#ifdef BOX2D_PHYSICS
+        const QVector3D borderColor(0.62, 0.04, 0.18);
+        // Square, tilted so that it lands on a corner
+        addBody(m_physics.addDynamicBox(100, 50, 50, 50, qDegreesToRadians(20.f)),
+            QVector3D(0.3, 0.07, 0.5));
+        // Left border
+        addBody(m_physics.addStaticBox(5, 50, 5, 85), borderColor);
+        // Right border
+        addBody(m_physics.addStaticBox(195, 50, 5, 85), borderColor);
+        // Top border
+        addBody(m_physics.addStaticBox(100, 95, 185, 5), borderColor);
+        // Bottom border
+        addBody(m_physics.addStaticBox(100, 5, 185, 5), borderColor);
+#endif
+
+#ifdef IMPACT_AUDIO
+        m_printStats = QCoreApplication::arguments().contains("--frame-stats");
+        if (QCoreApplication::arguments().contains("--audio"))
+        {
+            startAudio();
+        }
+#endif
+    }
+
+#ifdef IMPACT_AUDIO
+    ~OpenGLWindow()
+    {
+        if (m_printStats && m_impacts)
+        {
+            const ImpactSounds::Stats &stats = m_impacts->stats();
+            qInfo().noquote() << QString("Impacts: %1 contacts, %2 dropped by the queue, "
+                "%3 quiet, %4 merged, %5 throttled, %6 played, %7 rejected, %8 ms in flush()")
+                .arg(m_contacts.pushed()).arg(m_contacts.dropped()).arg(stats.quiet)
+                .arg(stats.merged).arg(stats.throttled).arg(stats.played).arg(stats.rejected)
+                .arg(stats.flushMs, 0, 'f', 3);
+        }
+        m_physics.setContactEvents(nullptr);
     }
 
+    static ImpactSounds::Settings impactSettings()
+    {
+        ImpactSounds::Settings settings;
+        // A space-bar box lands with 2 to 12 kg m/s, the big square
+        // with about 200
+        settings.minImpulse = 0.5f;
+        settings.fullImpulse = 200.f;
+        // The listener is 100 units in front of the scene
+        settings.referenceDistance = 100.f;
+        return settings;
+    }
+
+    void startAudio()
+    {
+        m_audio = std::make_unique<AudioEngine>();
+        // The null device keeps the example running without audio hardware
+        if (!m_audio->open(AudioEngine::Device::Default) &&
+            !m_audio->open(AudioEngine::Device::Null))
+        {
+            m_audio.reset();
+            return;
+        }
+        m_audio->setListener(QVector3D(m_worldWidth / 2.f, m_worldHeight / 2.f, m_worldWidth / 2.f),
+            QVector3D(0.f, 0.f, 1.f), QVector3D(0.f, 1.f, 0.f));
+        m_sounds = std::make_unique<SoundCache>(m_audio.get(), 256 * 1024, 64 * 1024);
+        m_impacts = std::make_unique<ImpactSounds>(m_sounds.get(), impactSettings());
+        m_impacts->setClips({ ":/assets/sounds/impact-1.wav", ":/assets/sounds/impact-2.wav",
+            ":/assets/sounds/impact-3.wav", ":/assets/sounds/impact-4.wav" });
+        // Smaller impacts are dropped by the listener already, the rest
+        // are counted as quiet
+        m_physics.setContactEvents(&m_contacts, 0.05f);
+
+        // Frames stop once everything sleeps, the voices still finish.
+        // Runs only while voices play, playImpacts() starts it again.
+        connect(&m_audioTimer, &QTimer::timeout, this, [this]
+            {
+                m_audio->update();
+                if (m_audio->stats().activeVoices == 0)
+                {
+                    m_audioTimer.stop();
+                }
+            });
+        m_audioTimer.setInterval(20);
+    }
+#endif
+
+#ifdef BOX2D_PHYSICS
+    void addBody(int id, const QVector3D &color)
+    {
+        m_bodyColors.resize(id + 1);
+        m_bodyColors[id] = color;
+    }
+#endif
+
     void initializeGL() override
     {
         initializeOpenGLFunctions();
         glClearColor(0.04f, 0.62f, 0.48f, 1.f);
 
-        QString vertShaderSrc =
-            "attribute vec2 aPosition;\n"
-            "uniform mat4 uMvpMatrix;"
-            "void main()\n"
-            "{\n"
-            "    gl_Position = uMvpMatrix * vec4(aPosition, 0.0, 1.0);\n"
-            "}\n";
-
-        QString fragShaderSrc =
-            "#ifdef GL_ES\n"
-            "precision mediump float;\n"
-            "#endif\n"
-            "uniform vec3 uColor;\n"
-            "void main()\n"
-            "{\n"
-            "    gl_FragColor = vec4(uColor, 1.0);\n"
-            "}\n";
-
-        m_program.create();
-        m_program.addShaderFromSourceCode(QOpenGLShader::ShaderTypeBit::Vertex, vertShaderSrc);
-        m_program.addShaderFromSourceCode(QOpenGLShader::ShaderTypeBit::Fragment, fragShaderSrc);
-        m_program.link();
-        m_program.bind();
-
-        float vertPositions[] = {
-            -0.5f, -0.5f,
-            0.5f, -0.5f,
-            -0.5f, 0.5f,
-            0.5f, 0.5f
-        };
-        m_vertPosBuffer.create();
-        m_vertPosBuffer.bind();
-        m_vertPosBuffer.allocate(vertPositions, sizeof(vertPositions));
-        m_program.setAttributeBuffer("aPosition", GL_FLOAT, 0, 2);
-        m_program.enableAttributeArray("aPosition");
-
-        m_uColorLocation = m_program.uniformLocation("uColor");
-        m_uMvpMatrixLocation = m_program.uniformLocation("uMvpMatrix");
+        m_glState.initialize();
+        m_rectBatch.initialize(&m_glState);
+#ifdef BOX2D_PHYSICS
+        m_physicsClock.start();
+#endif
         m_viewMatrix.lookAt(QVector3D(0, 0, 1), QVector3D(0, 0, 0), QVector3D(0, 1, 0));
     }
 
     void resizeGL(int w, int h) override
     {
-        int deviceW = w * devicePixelRatio();
-        int deviceH = h * devicePixelRatio();
-        float deviceAspect = deviceH / (float) deviceW;
+        const QRect viewport = RenderTargetManager::letterbox(
+            QSize(w * devicePixelRatio(), h * devicePixelRatio()), m_worldAspect);
+        m_viewportX = viewport.x();
+        m_viewportY = viewport.y();
+        m_viewportWidth = viewport.width();
+        m_viewportHeight = viewport.height();
+        m_projMatrix.setToIdentity();
+        m_projMatrix.ortho(0.f, m_worldWidth, 0.f, m_worldHeight, 1.f, -1.f);
+        m_projViewMatrix = m_projMatrix * m_viewMatrix;
+    }
 
-        if (deviceAspect > m_worldAspect)
+    void paintGL() override
+    {
+        PROFILE_FRAME_BEGIN();
+#ifdef BOX2D_PHYSICS
         {
-            m_viewportWidth = deviceW;
-            m_viewportHeight = (int) deviceW * m_worldAspect;
-            m_viewportX = 0;
-            m_viewportY = (int) (deviceH - m_viewportHeight) / 2.f;
+            PROFILE_SCOPE("physics");
+            stepPhysics();
         }
-        else
+#endif
+
+        // QOpenGLWindow sets the viewport before every paintGL()
+        m_glState.invalidate(GLStateCache::StateBit::Viewport);
+
         {
-            m_viewportWidth = (int) deviceH / m_worldAspect;
-            m_viewportHeight = deviceH;
-            m_viewportX = (int) (deviceW - m_viewportWidth) / 2.f;
-            m_viewportY = 0;
+            PROFILE_SCOPE("clear");
+            glClear(GL_COLOR_BUFFER_BIT);
+            m_glState.clearColor(0.2, 0.2, 0.2, 1);
+            glClear(GL_COLOR_BUFFER_BIT);
+            m_glState.viewport(m_viewportX, m_viewportY, m_viewportWidth, m_viewportHeight);
+            m_glState.scissor(m_viewportX, m_viewportY, m_viewportWidth, m_viewportHeight);
+            m_glState.clearColor(0.04, 0.62, 0.48, 1);
+            m_glState.setEnabled(GL_SCISSOR_TEST, true);
+            glClear(GL_COLOR_BUFFER_BIT);
+            m_glState.setEnabled(GL_SCISSOR_TEST, false);
         }
-        m_projMatrix.setToIdentity();
-        m_projMatrix.ortho(0.f, m_worldWidth, 0.f, m_worldHeight, 1.f, -1.f);
-        m_projViewMatrix = m_projMatrix * m_viewMatrix;
+
+        {
+            PROFILE_SCOPE("record");
+#ifdef FRAME_PROFILER
+            m_frameTimeCount = m_showOverlay ? FrameProfiler::instance()->recentFrameTimes(
+                m_frameTimes, frameTimeBarCount) : 0;
+#endif
+            m_commands.record([this](int thread, int threadCount, CommandArena *arena)
+                {
+                    recordScene(thread, threadCount, arena);
+                });
+            m_commands.sort();
+        }
+
+        {
+            PROFILE_SCOPE("draw");
+            m_rectBatch.begin(m_projViewMatrix);
+            m_commands.replay(this);
+            m_rectBatch.end();
+            m_rectBatch.endFrame();
+        }
+
+        PROFILE_SWAP_BEGIN();
+#ifdef BOX2D_PHYSICS
+        if (m_physics.awakeCount() > 0)
+        {
+            m_frameScheduler->requestFrame();
+        }
+#endif
+#ifdef FRAME_PROFILER
+        if (m_showOverlay)
+        {
+            m_frameScheduler->requestFrame();
+        }
+#endif
     }
 
-    void paintGL() override
+#ifdef BOX2D_PHYSICS
+
+    // Fixed 60 Hz steps, then only the bodies that moved are uploaded.
+    // Once everything sleeps no frames are requested and nothing is
+    // uploaded until the scene is woken up again.
+    void stepPhysics()
     {
-        glClear(GL_COLOR_BUFFER_BIT);
-        glClearColor(0.2, 0.2, 0.2, 1);
-        glClear(GL_COLOR_BUFFER_BIT);
-        glViewport(m_viewportX, m_viewportY, m_viewportWidth, m_viewportHeight);
-        glScissor(m_viewportX, m_viewportY, m_viewportWidth, m_viewportHeight);
-        glClearColor(0.04, 0.62, 0.48, 1);
-        glEnable(GL_SCISSOR_TEST);
-        glClear(GL_COLOR_BUFFER_BIT);
-        glDisable(GL_SCISSOR_TEST);
-
-        // Square
-        drawRectangle(100, 50, 50, 50, 0, QVector3D(0.3, 0.07, 0.5));
-        // Left border
-        drawRectangle(5, 50, 5, 85, 0, QVector3D(0.62, 0.04, 0.18));
-        // Right border
-        drawRectangle(195, 50, 5, 85, 0, QVector3D(0.62, 0.04, 0.18));
-        // Top border
-        drawRectangle(100, 95, 185, 5, 0, QVector3D(0.62, 0.04, 0.18));
-        // Bottom border
-        drawRectangle(100, 5, 185, 5, 0, QVector3D(0.62, 0.04, 0.18));
+        const qint64 nowNs = m_physicsClock.nsecsElapsed();
+        // A sleeping scene has no time to catch up on
+        if (m_physicsIdle)
+        {
+            m_physicsTimestep.restart(nowNs);
+        }
+        const int steps = m_physicsTimestep.advance(nowNs,
+            [this](float dt) { m_physics.step(dt); });
+        m_physicsIdle = m_physics.awakeCount() == 0;
+#ifdef IMPACT_AUDIO
+        if (steps > 0)
+        {
+            playImpacts();
+        }
+#else
+        Q_UNUSED(steps);
+#endif
+
+        const RectBatch::RectArrays rects = {
+            m_physics.x(), m_physics.y(), m_physics.width(), m_physics.height(),
+            m_physics.angle(), m_bodyColors.data()
+        };
+        if (m_rectBatch.retainedCount() != m_physics.bodyCount())
+        {
+            m_rectBatch.resizeRetained(m_physics.bodyCount());
+            m_rectBatch.updateRetained(0, m_physics.bodyCount(), rects);
+            m_physics.takeDirtyRanges(&m_dirtyRanges);
+            return;
+        }
+        m_physics.takeDirtyRanges(&m_dirtyRanges);
+        for (const PhysicsWorld2D::Range &range : m_dirtyRanges)
+        {
+            m_rectBatch.updateRetained(range.first, range.count, rects);
+        }
     }
 
+#endif
+
+#ifdef IMPACT_AUDIO
+    // Drains the impacts of this frame's steps, at most a few voices
+    // are started however many bodies collided
+    void playImpacts()
+    {
+        if (!m_impacts)
+        {
+            return;
+        }
+        int count;
+        while ((count = m_contacts.pop(m_contactBuffer, contactBufferSize)) > 0)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                const ContactEvent &event = m_contactBuffer[i];
+                m_impacts->add(QVector3D(event.x, event.y, 0.f), event.impulse);
+            }
+        }
+        const quint64 played = m_impacts->stats().played;
+        m_impacts->flush();
+        if (m_impacts->stats().played != played && !m_audioTimer.isActive())
+        {
+            m_audioTimer.start();
+        }
+    }
+
+#endif
+
+    void keyPressEvent(QKeyEvent *event) override
+    {
+#ifdef BOX2D_PHYSICS
+        // Space drops a handful of small boxes to wake the scene up
+        if (event->key() == Qt::Key::Key_Space)
+        {
+            QRandomGenerator *random = QRandomGenerator::global();
+            for (int i = 0; i < 10; ++i)
+            {
+                const float size = 4.f + random->bounded(6.f);
+                addBody(m_physics.addDynamicBox(20.f + random->bounded(160.f), 80.f,
+                    size, size, random->bounded(3.14f)),
+                    QVector3D(0.3f + random->bounded(0.6f), 0.07f, 0.5f));
+            }
+            m_physicsIdle = false;
+            m_frameScheduler->requestFrame();
+        }
+#endif
+#ifdef FRAME_PROFILER
+        if (event->key() == Qt::Key::Key_F3)
+        {
+            m_showOverlay = !m_showOverlay;
+            m_frameScheduler->requestFrame();
+        }
+#endif
+#if !defined(BOX2D_PHYSICS) && !defined(FRAME_PROFILER)
+        Q_UNUSED(event);
+#endif
+    }
+
+    // Runs on every recording thread; thread picks its share of the work.
+    // Only plain data may be read here, the GL context belongs to paintGL().
+    void recordScene(int thread, int threadCount, CommandArena *arena)
+    {
+        if (thread == 0)
+        {
+#ifdef BOX2D_PHYSICS
+            arena->push(sceneLayer, DrawRetainedCommand());
+#else
+            recordStaticScene(arena);
+#endif
+        }
+#ifdef FRAME_PROFILER
+        recordFrameTimeOverlay(thread, threadCount, arena);
+#else
+        Q_UNUSED(threadCount);
+#endif
+    }
+
+#ifndef BOX2D_PHYSICS
+
+    // Without Box2D the square stays where the physics scene drops it from
+    void recordStaticScene(CommandArena *arena)
+    {
+        const DrawRectCommand rects[] = {
+            // Square
+            { 100.f, 50.f, 50.f, 50.f, 0.f, 0.3f, 0.07f, 0.5f },
+            // Left border
+            { 5.f, 50.f, 5.f, 85.f, 0.f, 0.62f, 0.04f, 0.18f },
+            // Right border
+            { 195.f, 50.f, 5.f, 85.f, 0.f, 0.62f, 0.04f, 0.18f },
+            // Top border
+            { 100.f, 95.f, 185.f, 5.f, 0.f, 0.62f, 0.04f, 0.18f },
+            // Bottom border
+            { 100.f, 5.f, 185.f, 5.f, 0.f, 0.62f, 0.04f, 0.18f }
+        };
+        for (const DrawRectCommand &rect : rects)
+        {
+            arena->push(sceneLayer, rect);
+        }
+    }
+#endif
+
+#ifdef FRAME_PROFILER
+
+    // One bar per recent frame along the bottom edge, a bar reaching
+    // the top border is 33 ms, bars over 16.7 ms are red
+    void recordFrameTimeOverlay(int thread, int threadCount, CommandArena *arena)
+    {
+        const float barWidth = (m_worldWidth - 20.f) / frameTimeBarCount;
+        const float maxHeight = m_worldHeight - 20.f;
+        for (int i = thread; i < m_frameTimeCount; i += threadCount)
+        {
+            const float h = qMin(m_frameTimes[i] / 33.3f, 1.f) * maxHeight;
+            const bool slow = m_frameTimes[i] > 16.7f;
+            const DrawRectCommand bar = {
+                10.f + barWidth * (i + 0.5f), 10.f + h / 2.f, barWidth * 0.8f, h, 0.f,
+                0.9f, slow ? 0.2f : 0.9f, slow ? 0.2f : 0.9f
+            };
+            arena->push(overlayLayer, bar);
+        }
+    }
+#endif
+
     void drawRectangle(float x, float y, float w, float h,
         float angle, const QVector3D& color)
     {
-        m_modelMatrix.setToIdentity();
-        m_modelMatrix.translate(QVector3D(x, y, 0));
-        m_modelMatrix.rotate(angle, QVector3D(0, 0, 1));
-        m_modelMatrix.scale(QVector3D(w, h, 1));
-        m_mvpMatrix = m_projViewMatrix * m_modelMatrix;
-        m_program.setUniformValue(m_uMvpMatrixLocation, m_mvpMatrix);
-        m_program.setUniformValue(m_uColorLocation, color);
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        m_rectBatch.add(x, y, w, h, angle, color);
+    }
+
+    // RenderCommandBackend, called from m_commands.replay()
+    void drawRect(const DrawRectCommand &command) override
+    {
+        drawRectangle(command.x, command.y, command.w, command.h, command.angle,
+            QVector3D(command.r, command.g, command.b));
+    }
+
+    void drawRetained(const DrawRetainedCommand &) override
+    {
+        m_rectBatch.drawRetained(m_projViewMatrix);
+    }
+
+    void setTexture(const SetTextureCommand &command) override
+    {
+        m_rectBatch.end();
+        m_glState.bindTexture(GL_TEXTURE_2D, command.texture, command.unit);
+        m_rectBatch.begin(m_projViewMatrix);
+    }
+
+    void setScissor(const SetScissorCommand &command) override
+    {
+        // Rectangles collected so far were meant for the old state
+        m_rectBatch.end();
+        m_glState.scissor(command.x, command.y, command.width, command.height);
+        m_glState.setEnabled(GL_SCISSOR_TEST, command.enabled != 0);
+        m_rectBatch.begin(m_projViewMatrix);
     }
 
 private:
-    QOpenGLBuffer m_vertPosBuffer;
-    QOpenGLShaderProgram m_program;
-    int m_uColorLocation;
-    int m_uMvpMatrixLocation;
-    QMatrix4x4 m_mvpMatrix;
+    // Top byte of the sort key, layers replay in this order
+    static constexpr quint64 sceneLayer = quint64(0) << 56;
+    static constexpr quint64 overlayLayer = quint64(1) << 56;
+#ifdef IMPACT_AUDIO
+    static constexpr int contactBufferSize = 256;
+#endif
+
+    FrameScheduler *m_frameScheduler;
+    GLStateCache m_glState;
+    RectBatch m_rectBatch;
+    RenderCommandQueue m_commands;
+#ifdef BOX2D_PHYSICS
+    PhysicsWorld2D m_physics;
+    std::vector<QVector3D> m_bodyColors;
+    std::vector<PhysicsWorld2D::Range> m_dirtyRanges;
+    QElapsedTimer m_physicsClock;
+    FixedTimestep m_physicsTimestep;
+    bool m_physicsIdle = false;
+#endif
+#ifdef IMPACT_AUDIO
+    // Only with --audio, impacts from the physics step
+    std::unique_ptr<AudioEngine> m_audio;
+    std::unique_ptr<SoundCache> m_sounds;
+    std::unique_ptr<ImpactSounds> m_impacts;
+    ContactEventQueue m_contacts;
+    ContactEvent m_contactBuffer[contactBufferSize];
+    QTimer m_audioTimer;
+    bool m_printStats = false;
+#endif
     QMatrix4x4 m_projMatrix;
     QMatrix4x4 m_viewMatrix;
     QMatrix4x4 m_projViewMatrix;
-    QMatrix4x4 m_modelMatrix;
     const float m_worldWidth = 200.f;
     const float m_worldHeight = 100.f;
     float m_worldAspect = m_worldHeight / m_worldWidth;
@@ -149,13 +497,74 @@ private:
     int m_viewportY;
     int m_viewportWidth;
     int m_viewportHeight;
+#ifdef FRAME_PROFILER
+    static constexpr int frameTimeBarCount = 90;
+    bool m_showOverlay = false;
+    float m_frameTimes[frameTimeBarCount];
+    int m_frameTimeCount = 0;
+#endif
 };
 
 int main(int argc, char *argv[])
 {
     QApplication::setAttribute(Qt::ApplicationAttribute::AA_UseDesktopOpenGL);
     QApplication app(argc, argv);
+    if (app.arguments().contains("--test"))
+    {
+#ifdef IMPACT_AUDIO
+        return runContactAudioTest();
+#else
+        qInfo() << "Built without CONFIG+=box2d and CONFIG+=openal, "
+            "there are no contact audio tests to run";
+        return 0;
+#endif
+    }
+    if (app.arguments().contains("--benchmark"))
+    {
+        int result = runRectBatchBenchmark();
+        if (result == 0)
+        {
+            result = runGLStateCacheBenchmark();
+        }
+#ifdef BOX2D_PHYSICS
+        if (result == 0)
+        {
+            result = runPhysicsBenchmark();
+        }
+#endif
+        if (result == 0)
+        {
+            result = runTransformKernelBenchmark();
+        }
+        if (result == 0)
+        {
+            result = runCullingBenchmark();
+        }
+        if (result == 0)
+        {
+            result = runRenderCommandBenchmark();
+        }
+        if (result == 0)
+        {
+            result = runStreamingBufferBenchmark();
+        }
+#ifdef IMPACT_AUDIO
+        if (result == 0)
+        {
+            result = runContactAudioBenchmark();
+        }
+#endif
+        return result;
+    }
     OpenGLWindow w;
+    if (OffscreenHost::isRequested(app.arguments()))
+    {
+        const int result = OffscreenHost(app.arguments()).run(w);
+        PROFILE_EXPORT(app.arguments());
+        return result;
+    }
     w.show();
-    return app.exec();
+    const int result = app.exec();
+    PROFILE_EXPORT(app.arguments());
+    return result;
 }
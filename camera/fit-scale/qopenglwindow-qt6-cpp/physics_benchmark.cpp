@@ -0,0 +1,119 @@
+#include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QRandomGenerator>
+
+#include <cmath>
+
+#include "physics_benchmark.h"
+#include "physics_world_2d.h"
+
+namespace
+{
+    const float metersPerUnit = 0.1f;
+    const QVector2D gravity(0.f, -98.f);
+    const float stepDt = 1.f / 60.f;
+    const float boxSize = 1.f;
+    const float spacing = 1.5f;
+    const int measuredSteps = 120;
+    // Box2D puts a body to sleep after half a second at rest
+    const int settleSteps = 90;
+
+    struct Result
+    {
+        double stepMs = 0.0;
+        double maxStepMs = 0.0;
+        double awake = 0.0;
+        double syncedRects = 0.0;
+    };
+
+    Result measure(PhysicsWorld2D *world, int steps)
+    {
+        std::vector<PhysicsWorld2D::Range> ranges;
+        world->takeDirtyRanges(&ranges);
+
+        Result result;
+        QElapsedTimer timer;
+        for (int i = 0; i < steps; ++i)
+        {
+            timer.start();
+            world->step(stepDt);
+            const double stepMs = timer.nsecsElapsed() / 1e6;
+            result.stepMs += stepMs;
+            result.maxStepMs = qMax(result.maxStepMs, stepMs);
+            result.awake += world->awakeCount();
+
+            world->takeDirtyRanges(&ranges);
+            for (const PhysicsWorld2D::Range &range : ranges)
+            {
+                result.syncedRects += range.count;
+            }
+        }
+        result.stepMs /= steps;
+        result.awake /= steps;
+        result.syncedRects /= steps;
+        return result;
+    }
+
+    QString format(const Result &result)
+    {
+        return QString("%1 ms per step (max %2), %3 awake, %4 rectangles synced per step")
+            .arg(result.stepMs, 0, 'f', 3).arg(result.maxStepMs, 0, 'f', 3)
+            .arg(result.awake, 0, 'f', 0).arg(result.syncedRects, 0, 'f', 0);
+    }
+
+    // A container wide enough for the grid, boxes start in a jittered
+    // grid above the floor and fall into a pile
+    Result runFalling(int bodyCount)
+    {
+        const int columns = int(std::ceil(std::sqrt(bodyCount / 2.f)));
+        const int rows = (bodyCount + columns - 1) / columns;
+        const float width = columns * spacing + 10.f;
+        const float height = rows * spacing + 10.f;
+
+        PhysicsWorld2D world(gravity, metersPerUnit);
+        world.addStaticBox(width / 2.f, -2.5f, width + 10.f, 5.f);
+        world.addStaticBox(-2.5f, height / 2.f, 5.f, height);
+        world.addStaticBox(width + 2.5f, height / 2.f, 5.f, height);
+
+        QRandomGenerator random(42);
+        for (int i = 0; i < bodyCount; ++i)
+        {
+            const float x = 5.f + (i % columns + 0.5f) * spacing + random.bounded(0.2f);
+            const float y = 5.f + (i / columns + 0.5f) * spacing;
+            world.addDynamicBox(x, y, boxSize, boxSize, random.bounded(1.f));
+        }
+        return measure(&world, measuredSteps);
+    }
+
+    // Boxes placed on the floor side by side, they fall asleep within
+    // the settling steps and are then measured at rest
+    Result runResting(int bodyCount)
+    {
+        const float width = bodyCount * spacing;
+
+        PhysicsWorld2D world(gravity, metersPerUnit);
+        world.addStaticBox(width / 2.f, -2.5f, width + 10.f, 5.f);
+        for (int i = 0; i < bodyCount; ++i)
+        {
+            world.addDynamicBox((i + 0.5f) * spacing, boxSize / 2.f, boxSize, boxSize);
+        }
+        for (int i = 0; i < settleSteps; ++i)
+        {
+            world.step(stepDt);
+        }
+        return measure(&world, measuredSteps);
+    }
+}
+
+int runPhysicsBenchmark()
+{
+    const int bodyCounts[] = { 1000, 10000, 50000 };
+    for (int bodyCount : bodyCounts)
+    {
+        qInfo().noquote() << QString("%1 bodies falling: %2")
+            .arg(bodyCount, 5).arg(format(runFalling(bodyCount)));
+        qInfo().noquote() << QString("%1 bodies resting: %2")
+            .arg(bodyCount, 5).arg(format(runResting(bodyCount)));
+    }
+    return 0;
+}
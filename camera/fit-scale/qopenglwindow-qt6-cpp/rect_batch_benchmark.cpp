@@ -0,0 +1,103 @@
+#include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QRandomGenerator>
+#include <QtGui/QOffscreenSurface>
+#include <QtGui/QOpenGLContext>
+#include <QtOpenGL/QOpenGLFramebufferObject>
+
+#include "rect_batch.h"
+#include "rect_batch_benchmark.h"
+
+namespace
+{
+    struct Rect
+    {
+        float x, y, w, h, angle;
+        QVector3D color;
+    };
+
+    const float worldWidth = 200.f;
+    const float worldHeight = 100.f;
+    const int warmUpFrames = 5;
+    const int measuredFrames = 100;
+}
+
+int runRectBatchBenchmark()
+{
+    QOpenGLContext context;
+    if (!context.create())
+    {
+        qWarning() << "Failed to create an OpenGL context";
+        return 1;
+    }
+    QOffscreenSurface surface;
+    surface.setFormat(context.format());
+    surface.create();
+    if (!context.makeCurrent(&surface))
+    {
+        qWarning() << "Failed to make the OpenGL context current";
+        return 1;
+    }
+
+    QOpenGLFramebufferObject fbo(800, 400);
+    fbo.bind();
+    QOpenGLFunctions *gl = context.functions();
+    gl->glViewport(0, 0, fbo.width(), fbo.height());
+    gl->glClearColor(0.04f, 0.62f, 0.48f, 1.f);
+
+    QMatrix4x4 projViewMatrix;
+    projViewMatrix.ortho(0.f, worldWidth, 0.f, worldHeight, 1.f, -1.f);
+
+    GLStateCache state;
+    state.initialize();
+    RectBatch batch;
+    batch.initialize(&state);
+    qInfo().noquote() << "Renderer:"
+        << reinterpret_cast<const char *>(gl->glGetString(GL_RENDERER))
+        << (batch.isInstanced() ? "(instanced)" : "(expanded quads)");
+
+    QRandomGenerator random(42);
+    const int rectCounts[] = { 1000, 10000, 100000 };
+    for (int rectCount : rectCounts)
+    {
+        QVector<Rect> rects(rectCount);
+        for (Rect &rect : rects)
+        {
+            rect.x = random.bounded(worldWidth);
+            rect.y = random.bounded(worldHeight);
+            rect.w = 0.5f + random.bounded(4.f);
+            rect.h = 0.5f + random.bounded(4.f);
+            rect.angle = random.bounded(360.f);
+            rect.color = QVector3D(random.bounded(1.f), random.bounded(1.f),
+                random.bounded(1.f));
+        }
+
+        QElapsedTimer timer;
+        for (int frame = 0; frame < warmUpFrames + measuredFrames; ++frame)
+        {
+            if (frame == warmUpFrames)
+            {
+                timer.start();
+            }
+            gl->glClear(GL_COLOR_BUFFER_BIT);
+            batch.begin(projViewMatrix);
+            for (const Rect &rect : rects)
+            {
+                batch.add(rect.x, rect.y, rect.w, rect.h, rect.angle, rect.color);
+            }
+            batch.end();
+            batch.endFrame();
+            // Wait for the GPU so that frame time includes rendering
+            gl->glFinish();
+        }
+        const double frameTime = timer.nsecsElapsed() / 1e6 / measuredFrames;
+
+        qInfo().noquote() << QString("%1 rectangles: %2 draw calls per frame, %3 ms per frame")
+            .arg(rectCount, 6).arg(batch.drawCallCount()).arg(frameTime, 0, 'f', 3);
+    }
+
+    batch.destroy();
+    fbo.release();
+    context.doneCurrent();
+    return 0;
+}
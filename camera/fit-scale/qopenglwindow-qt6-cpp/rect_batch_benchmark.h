@@ -0,0 +1,9 @@
+#ifndef RECT_BATCH_BENCHMARK_H
+#define RECT_BATCH_BENCHMARK_H
+
+// Draws 1k, 10k and 100k random rectangles through RectBatch into an
+// offscreen framebuffer and prints draw calls per frame and frame time.
+// Returns a process exit code.
+int runRectBatchBenchmark();
+
+#endif // RECT_BATCH_BENCHMARK_H
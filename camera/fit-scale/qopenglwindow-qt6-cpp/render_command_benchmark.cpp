@@ -0,0 +1,176 @@
+#include <QtCore/QDebug>
+#include <QtCore/QRandomGenerator>
+#include <QtCore/QThread>
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "render_command_benchmark.h"
+#include "render_command_queue.h"
+
+namespace
+{
+    const int rectCount = 1000000;
+    const int measuredFrames = 10;
+    const float worldWidth = 200.f;
+    const float worldHeight = 100.f;
+    // Rectangles per scissor region, each region starts with a SetScissor
+    const int regionSize = 1000;
+
+    // The scene as a traversal would see it: positions and velocities,
+    // with some per-object work before anything is recorded
+    struct Scene
+    {
+        std::vector<float> x, y, vx, vy, size;
+        std::vector<int> material;
+
+        Scene()
+            : x(rectCount), y(rectCount), vx(rectCount), vy(rectCount), size(rectCount),
+              material(rectCount)
+        {
+            QRandomGenerator random(42);
+            for (int i = 0; i < rectCount; ++i)
+            {
+                x[i] = random.bounded(worldWidth);
+                y[i] = random.bounded(worldHeight);
+                vx[i] = random.bounded(2.f) - 1.f;
+                vy[i] = random.bounded(2.f) - 1.f;
+                size[i] = 0.5f + random.bounded(2.f);
+                material[i] = int(random.bounded(16.f));
+            }
+        }
+    };
+
+    void recordSlice(const Scene &scene, float time, int thread, int threadCount,
+        CommandArena *arena)
+    {
+        const int regions = (rectCount + regionSize - 1) / regionSize;
+        const int first = regions * thread / threadCount;
+        const int last = regions * (thread + 1) / threadCount;
+        for (int region = first; region < last; ++region)
+        {
+            const quint64 regionKey = quint64(region) << 32;
+            const SetScissorCommand scissor = { 1, region % 20 * 10, region / 20 % 10 * 10,
+                10, 10 };
+            arena->push(regionKey, scissor);
+            const int end = qMin(rectCount, (region + 1) * regionSize);
+            for (int i = region * regionSize; i < end; ++i)
+            {
+                const float x = std::fmod(scene.x[i] + scene.vx[i] * time + worldWidth, worldWidth);
+                const float y = std::fmod(scene.y[i] + scene.vy[i] * time + worldHeight, worldHeight);
+                const float angle = std::atan2(scene.vy[i], scene.vx[i]) * 57.29578f;
+                const float shade = scene.material[i] / 15.f;
+                const DrawRectCommand rect = {
+                    x, y, scene.size[i], scene.size[i], angle, shade, 0.5f, 1.f - shade
+                };
+                // Materials sort after the scissor of their region
+                arena->push(regionKey | quint64(1 + scene.material[i]), rect);
+            }
+        }
+    }
+
+    // Stands in for the GL thread: folds the replayed stream into a hash
+    class ChecksumBackend : public RenderCommandBackend
+    {
+
+    public:
+        quint64 checksum = 1469598103934665603ULL;
+        int stateChanges = 0;
+
+        void drawRect(const DrawRectCommand &command) override
+        {
+            mix(command.x);
+            mix(command.y);
+            mix(command.r);
+        }
+
+        void drawRetained(const DrawRetainedCommand &) override
+        {
+        }
+
+        void setTexture(const SetTextureCommand &command) override
+        {
+            stateChanges++;
+            mix(float(command.texture));
+        }
+
+        void setScissor(const SetScissorCommand &command) override
+        {
+            stateChanges++;
+            mix(float(command.x * 1000 + command.y));
+        }
+
+    private:
+        void mix(float value)
+        {
+            quint32 bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            checksum = (checksum ^ bits) * 1099511628211ULL;
+        }
+    };
+}
+
+int runRenderCommandBenchmark()
+{
+    const Scene scene;
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < QThread::idealThreadCount(); threads *= 2)
+    {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(qMax(1, QThread::idealThreadCount()));
+
+    quint64 expectedChecksum = 0;
+    double singleThreadMs = 0.0;
+    int result = 0;
+    for (int threads : threadCounts)
+    {
+        RenderCommandQueue queue(threads);
+        double recordMs = 0.0;
+        double sortMs = 0.0;
+        double replayMs = 0.0;
+        ChecksumBackend backend;
+        // One warm-up frame grows the arenas, the measured ones reuse them
+        for (int frame = 0; frame <= measuredFrames; ++frame)
+        {
+            const float time = frame / 60.f;
+            queue.record([&scene, time](int thread, int threadCount, CommandArena *arena)
+                {
+                    recordSlice(scene, time, thread, threadCount, arena);
+                });
+            queue.sort();
+            backend = ChecksumBackend();
+            queue.replay(&backend);
+            if (frame > 0)
+            {
+                recordMs += queue.stats().recordMs;
+                sortMs += queue.stats().sortMs;
+                replayMs += queue.stats().replayMs;
+            }
+        }
+        recordMs /= measuredFrames;
+        sortMs /= measuredFrames;
+        replayMs /= measuredFrames;
+
+        if (threads == threadCounts.front())
+        {
+            expectedChecksum = backend.checksum;
+            singleThreadMs = recordMs;
+        }
+        const bool match = backend.checksum == expectedChecksum;
+        if (!match)
+        {
+            result = 1;
+        }
+        qInfo().noquote() << QString("Render commands, %1 thread(s): record %2 ms "
+            "(%3 M commands/s, %4x), sort %5 ms, replay %6 ms, %7 MB%8")
+            .arg(threads).arg(recordMs, 0, 'f', 2)
+            .arg(queue.stats().commands / recordMs / 1e3, 0, 'f', 1)
+            .arg(singleThreadMs / recordMs, 0, 'f', 2)
+            .arg(sortMs, 0, 'f', 2).arg(replayMs, 0, 'f', 2)
+            .arg(queue.stats().bytes / 1e6, 0, 'f', 1)
+            .arg(match ? "" : ", replay order differs from 1 thread");
+    }
+    return result;
+}
@@ -0,0 +1,10 @@
+#ifndef RENDER_COMMAND_BENCHMARK_H
+#define RENDER_COMMAND_BENCHMARK_H
+
+// Records one million rectangle commands with 1, 2, 4 ... threads up to
+// the core count and prints recording throughput next to the sort and
+// replay cost on the GL thread. Returns a process exit code, 1 when the
+// replayed order depends on the thread count.
+int runRenderCommandBenchmark();
+
+#endif // RENDER_COMMAND_BENCHMARK_H
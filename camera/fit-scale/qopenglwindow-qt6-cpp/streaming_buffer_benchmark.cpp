@@ -0,0 +1,166 @@
+#include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QRandomGenerator>
+#include <QtGui/QOffscreenSurface>
+#include <QtGui/QOpenGLContext>
+#include <QtOpenGL/QOpenGLBuffer>
+#include <QtOpenGL/QOpenGLFramebufferObject>
+#include <QtOpenGL/QOpenGLShaderProgram>
+
+#include <cstring>
+#include <vector>
+
+#include "shader_cache.h"
+#include "streaming_buffer.h"
+#include "streaming_buffer_benchmark.h"
+
+namespace
+{
+    const int positionLocation = 0;
+    const int uploadsPerFrame = 64;
+    const int pointsPerUpload = 2048;
+    const int bytesPerUpload = pointsPerUpload * 2 * int(sizeof(float));
+    const int warmUpFrames = 10;
+    const int measuredFrames = 200;
+
+    void drawPoints(QOpenGLFunctions *gl, QOpenGLShaderProgram *program, int offset)
+    {
+        program->setAttributeBuffer(positionLocation, GL_FLOAT, offset, 2);
+        program->enableAttributeArray(positionLocation);
+        gl->glDrawArrays(GL_POINTS, 0, pointsPerUpload);
+    }
+
+    void report(const char *name, double ms, const StreamingBuffer::Stats *stats)
+    {
+        const double megabytes = double(bytesPerUpload) * uploadsPerFrame * measuredFrames / 1e6;
+        QString line = QString("%1: %2 ms per frame, %3 MB/s")
+            .arg(name, -26).arg(ms / measuredFrames, 0, 'f', 3)
+            .arg(megabytes / (ms / 1e3), 0, 'f', 0);
+        if (stats)
+        {
+            line += QString(", %1 wraps, %2 orphans, %3 waits")
+                .arg(stats->wraps).arg(stats->orphans).arg(stats->waits);
+        }
+        qInfo().noquote() << line;
+    }
+}
+
+int runStreamingBufferBenchmark()
+{
+    QOpenGLContext context;
+    if (!context.create())
+    {
+        qWarning() << "Failed to create an OpenGL context";
+        return 1;
+    }
+    QOffscreenSurface surface;
+    surface.setFormat(context.format());
+    surface.create();
+    if (!context.makeCurrent(&surface))
+    {
+        qWarning() << "Failed to make the OpenGL context current";
+        return 1;
+    }
+
+    QOpenGLFramebufferObject fbo(256, 256);
+    fbo.bind();
+    QOpenGLFunctions *gl = context.functions();
+    gl->glViewport(0, 0, fbo.width(), fbo.height());
+
+    QOpenGLShaderProgram *program = ShaderCache::instance()->program(
+        "attribute vec2 aPosition;\n"
+        "void main()\n"
+        "{\n"
+        "    gl_Position = vec4(aPosition, 0.0, 1.0);\n"
+        "    gl_PointSize = 1.0;\n"
+        "}\n",
+        "#ifdef GL_ES\n"
+        "precision mediump float;\n"
+        "#endif\n"
+        "void main()\n"
+        "{\n"
+        "    gl_FragColor = vec4(1.0);\n"
+        "}\n",
+        { { "aPosition", positionLocation } });
+    program->bind();
+
+    // Different data every upload, as sprites and text would be
+    QRandomGenerator random(42);
+    std::vector<float> source(size_t(pointsPerUpload) * 2 * uploadsPerFrame);
+    for (float &value : source)
+    {
+        value = random.bounded(2.f) - 1.f;
+    }
+    const char *sourceBytes = reinterpret_cast<const char *>(source.data());
+
+    QElapsedTimer timer;
+    {
+        QOpenGLBuffer buffer(QOpenGLBuffer::Type::VertexBuffer);
+        buffer.setUsagePattern(QOpenGLBuffer::UsagePattern::StreamDraw);
+        buffer.create();
+        buffer.bind();
+        for (int frame = 0; frame < warmUpFrames + measuredFrames; ++frame)
+        {
+            if (frame == warmUpFrames)
+            {
+                gl->glFinish();
+                timer.start();
+            }
+            gl->glClear(GL_COLOR_BUFFER_BIT);
+            for (int upload = 0; upload < uploadsPerFrame; ++upload)
+            {
+                buffer.allocate(sourceBytes + size_t(upload) * bytesPerUpload, bytesPerUpload);
+                drawPoints(gl, program, 0);
+            }
+        }
+        gl->glFinish();
+        report("QOpenGLBuffer::allocate", timer.nsecsElapsed() / 1e6, nullptr);
+        buffer.destroy();
+    }
+
+    const StreamingBuffer::Mode modes[] = {
+        StreamingBuffer::Mode::Orphaning,
+        StreamingBuffer::Mode::MapRange
+    };
+    for (StreamingBuffer::Mode mode : modes)
+    {
+        GLStateCache state;
+        state.initialize();
+        StreamingBuffer stream;
+        stream.initialize(&state, mode);
+        if (stream.mode() != mode)
+        {
+            qInfo().noquote() << "StreamingBuffer map-range: not supported by this context";
+            stream.destroy();
+            continue;
+        }
+        for (int frame = 0; frame < warmUpFrames + measuredFrames; ++frame)
+        {
+            if (frame == warmUpFrames)
+            {
+                gl->glFinish();
+                stream.resetStats();
+                timer.start();
+            }
+            gl->glClear(GL_COLOR_BUFFER_BIT);
+            for (int upload = 0; upload < uploadsPerFrame; ++upload)
+            {
+                const StreamingBuffer::Allocation allocation = stream.allocate(bytesPerUpload);
+                std::memcpy(allocation.data, sourceBytes + size_t(upload) * bytesPerUpload,
+                    bytesPerUpload);
+                stream.commit();
+                drawPoints(gl, program, allocation.offset);
+            }
+            stream.endFrame();
+        }
+        gl->glFinish();
+        report(mode == StreamingBuffer::Mode::MapRange ? "StreamingBuffer map-range" :
+            "StreamingBuffer orphaning", timer.nsecsElapsed() / 1e6, &stream.stats());
+        stream.destroy();
+    }
+
+    program->disableAttributeArray(positionLocation);
+    fbo.release();
+    context.doneCurrent();
+    return 0;
+}
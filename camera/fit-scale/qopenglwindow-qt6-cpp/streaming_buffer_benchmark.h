@@ -0,0 +1,11 @@
+#ifndef STREAMING_BUFFER_BENCHMARK_H
+#define STREAMING_BUFFER_BENCHMARK_H
+
+// Streams 1 MB of point data per frame in 64 uploads, each followed by
+// a draw that reads it, into an offscreen framebuffer. Compares
+// QOpenGLBuffer::allocate() per upload with StreamingBuffer in orphaning
+// and map-range mode and prints upload bandwidth. Returns a process exit
+// code.
+int runStreamingBufferBenchmark();
+
+#endif // STREAMING_BUFFER_BENCHMARK_H
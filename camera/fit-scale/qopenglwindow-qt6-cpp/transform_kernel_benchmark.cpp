@@ -0,0 +1,163 @@
+#include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QRandomGenerator>
+#include <QtMath>
+
+#include <cmath>
+#include <vector>
+
+#include "transform_kernel.h"
+#include "transform_kernel_benchmark.h"
+
+namespace
+{
+    const float worldWidth = 200.f;
+    const float worldHeight = 100.f;
+    const int verifiedCount = 10007;
+    const int benchmarkCount = 1000000;
+    const int measuredCalls = 10;
+    // The kernels are good to a few float ulps; QMatrix4x4::rotate()
+    // takes degrees and the round trip costs a little more on large angles
+    const float tolerance = 1e-4f;
+
+    struct RectArrays
+    {
+        std::vector<float> x, y, w, h, angle;
+
+        explicit RectArrays(int count)
+            : x(count), y(count), w(count), h(count), angle(count)
+        {
+            QRandomGenerator random(42);
+            for (int i = 0; i < count; ++i)
+            {
+                x[i] = random.bounded(worldWidth);
+                y[i] = random.bounded(worldHeight);
+                w[i] = 0.5f + random.bounded(4.f);
+                h[i] = 0.5f + random.bounded(4.f);
+                // Several turns both ways to exercise the range reduction
+                angle[i] = random.bounded(8.f * float(M_PI)) - 4.f * float(M_PI);
+            }
+        }
+
+        TransformKernel::Rects rects() const
+        {
+            return { x.data(), y.data(), w.data(), h.data(), angle.data() };
+        }
+    };
+
+    QMatrix4x4 modelMatrix(const RectArrays &arrays, int i)
+    {
+        QMatrix4x4 matrix;
+        matrix.translate(arrays.x[i], arrays.y[i]);
+        matrix.rotate(qRadiansToDegrees(arrays.angle[i]), QVector3D(0, 0, 1));
+        matrix.scale(arrays.w[i], arrays.h[i]);
+        return matrix;
+    }
+
+    float verify(TransformKernel::Path path, const QMatrix4x4 &projViewMatrix,
+        const RectArrays &arrays)
+    {
+        std::vector<float> mvp(size_t(verifiedCount) * 16);
+        std::vector<float> affine(size_t(verifiedCount) * 6);
+        TransformKernel::computeMvp(projViewMatrix, arrays.rects(), verifiedCount, mvp.data(), path);
+        TransformKernel::computeAffine(arrays.rects(), verifiedCount, affine.data(), path);
+
+        float maxError = 0.f;
+        for (int i = 0; i < verifiedCount; ++i)
+        {
+            const QMatrix4x4 model = modelMatrix(arrays, i);
+            const QMatrix4x4 expected = projViewMatrix * model;
+            for (int k = 0; k < 16; ++k)
+            {
+                maxError = qMax(maxError, std::abs(expected.constData()[k] - mvp[i * 16 + k]));
+            }
+            const float expectedAffine[6] = {
+                model(0, 0), model(1, 0), model(0, 1), model(1, 1), model(0, 3), model(1, 3)
+            };
+            for (int k = 0; k < 6; ++k)
+            {
+                // Affine elements are in world units, compare relative
+                // to the rectangle size and position
+                const float scale = qMax(1.f, std::abs(expectedAffine[k]));
+                maxError = qMax(maxError, std::abs(expectedAffine[k] - affine[i * 6 + k]) / scale);
+            }
+        }
+        return maxError;
+    }
+}
+
+int runTransformKernelBenchmark()
+{
+    QMatrix4x4 projViewMatrix;
+    projViewMatrix.ortho(0.f, worldWidth, 0.f, worldHeight, 1.f, -1.f);
+
+    const TransformKernel::Path paths[] = {
+        TransformKernel::Path::Scalar,
+        TransformKernel::Path::Sse2,
+        TransformKernel::Path::Avx2,
+        TransformKernel::Path::Neon
+    };
+    qInfo().noquote() << "Transform kernel, best path:"
+        << TransformKernel::pathName(TransformKernel::bestPath());
+
+    const RectArrays verified(verifiedCount);
+    int result = 0;
+    for (TransformKernel::Path path : paths)
+    {
+        if (!TransformKernel::isSupported(path))
+        {
+            continue;
+        }
+        const float maxError = verify(path, projViewMatrix, verified);
+        const bool passed = maxError <= tolerance;
+        qInfo().noquote() << QString("%1: max error %2 against QMatrix4x4, %3")
+            .arg(TransformKernel::pathName(path), 6).arg(maxError, 0, 'g', 3)
+            .arg(passed ? "ok" : "FAILED");
+        if (!passed)
+        {
+            result = 1;
+        }
+    }
+
+    const RectArrays arrays(benchmarkCount);
+    std::vector<float> out(size_t(benchmarkCount) * 16);
+    QElapsedTimer timer;
+
+    std::vector<QMatrix4x4> matrices(benchmarkCount);
+    timer.start();
+    for (int call = 0; call < measuredCalls; ++call)
+    {
+        for (int i = 0; i < benchmarkCount; ++i)
+        {
+            matrices[i] = projViewMatrix * modelMatrix(arrays, i);
+        }
+    }
+    const double qtMs = timer.nsecsElapsed() / 1e6 / measuredCalls;
+    qInfo().noquote() << QString("%1: %2 ms per 1M MVP matrices")
+        .arg("Qt", 6).arg(qtMs, 0, 'f', 2);
+
+    for (TransformKernel::Path path : paths)
+    {
+        if (!TransformKernel::isSupported(path))
+        {
+            continue;
+        }
+        timer.start();
+        for (int call = 0; call < measuredCalls; ++call)
+        {
+            TransformKernel::computeMvp(projViewMatrix, arrays.rects(), benchmarkCount,
+                out.data(), path);
+        }
+        const double mvpMs = timer.nsecsElapsed() / 1e6 / measuredCalls;
+        timer.start();
+        for (int call = 0; call < measuredCalls; ++call)
+        {
+            TransformKernel::computeAffine(arrays.rects(), benchmarkCount, out.data(), path);
+        }
+        const double affineMs = timer.nsecsElapsed() / 1e6 / measuredCalls;
+        qInfo().noquote() << QString("%1: %2 ms per 1M MVP matrices (%3x Qt), %4 ms per 1M affine")
+            .arg(TransformKernel::pathName(path), 6).arg(mvpMs, 0, 'f', 2)
+            .arg(qtMs / mvpMs, 0, 'f', 1).arg(affineMs, 0, 'f', 2);
+    }
+    return result;
+}
@@ -0,0 +1,10 @@
+#ifndef TRANSFORM_KERNEL_BENCHMARK_H
+#define TRANSFORM_KERNEL_BENCHMARK_H
+
+// Checks every TransformKernel path the CPU supports against matrices
+// built with QMatrix4x4 translate, rotate and scale, then times 1M
+// transforms per call for each path next to the QMatrix4x4 chain.
+// Returns a process exit code, 1 when a path disagrees with QMatrix4x4.
+int runTransformKernelBenchmark();
+
+#endif // TRANSFORM_KERNEL_BENCHMARK_H
@@ -0,0 +1,14 @@
+#ifdef GL_ES
+precision mediump float;
+#endif
+
+uniform vec3 uColor;
+
+varying vec3 vNormal;
+
+void main()
+{
+    vec3 lightDirection = normalize(vec3(0.4, 1.0, 0.6));
+    float diffuse = max(dot(normalize(vNormal), lightDirection), 0.0);
+    gl_FragColor = vec4(uColor * (0.35 + 0.65 * diffuse), 1.0);
+}
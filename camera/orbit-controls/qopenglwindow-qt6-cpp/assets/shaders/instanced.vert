@@ -0,0 +1,13 @@
+attribute vec3 aPosition;
+attribute vec3 aNormal;
+attribute mat4 aModelMatrix;
+
+uniform mat4 uProjViewMatrix;
+
+varying vec3 vNormal;
+
+void main()
+{
+    gl_Position = uProjViewMatrix * aModelMatrix * vec4(aPosition, 1.0);
+    vNormal = mat3(aModelMatrix) * aNormal;
+}
@@ -0,0 +1,155 @@
+#include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QRandomGenerator>
+
+#include <thread>
+#include <vector>
+
+#include "audio_decode_benchmark.h"
+#include "audio_decoder.h"
+#include "audio_engine.h"
+#include "sound_cache.h"
+
+namespace
+{
+    const char *const humPath = ":/assets/sounds/hum.wav";
+    const char *const impactPaths[] = {
+        ":/assets/sounds/impact-1.wav",
+        ":/assets/sounds/impact-2.wav",
+        ":/assets/sounds/impact-3.wav",
+        ":/assets/sounds/impact-4.wav"
+    };
+    const int impactCount = 4;
+    const int decodeRepeats = 50;
+    const int sampleRate = 44100;
+    const int blockFrames = 512;
+    const int streamCount = 16;
+    const int cacheBlocks = 2000;
+
+    int measureThroughput(const char *path)
+    {
+        std::vector<qint16> chunk(AudioEngine::streamChunkFrames * 2);
+        qint64 frames = 0;
+        qint64 bytes = 0;
+        int streamRate = 0;
+        QElapsedTimer timer;
+        timer.start();
+        for (int repeat = 0; repeat < decodeRepeats; ++repeat)
+        {
+            std::unique_ptr<AudioStream> stream = openAudioStream(path);
+            if (!stream)
+            {
+                return 1;
+            }
+            streamRate = stream->sampleRate();
+            int read;
+            while ((read = stream->read(chunk.data(), AudioEngine::streamChunkFrames)) > 0)
+            {
+                frames += read;
+                bytes += read * stream->channels() * qint64(sizeof(qint16));
+            }
+        }
+        const double ms = timer.nsecsElapsed() / 1e6;
+        qInfo().noquote() << QString("%1: %2 MB/s of PCM, %3x real time")
+            .arg(path).arg(bytes / 1e3 / ms, 0, 'f', 1)
+            .arg(frames * 1000.0 / streamRate / ms, 0, 'f', 0);
+        return 0;
+    }
+
+    int measureFirstSample(int decodeThreads)
+    {
+        AudioEngine engine(32, decodeThreads);
+        if (!engine.open(AudioEngine::Device::Loopback, sampleRate))
+        {
+            return 1;
+        }
+        AudioEngine::VoiceParams params;
+        params.looping = true;
+        for (int stream = 0; stream < streamCount; ++stream)
+        {
+            params.position = QVector3D(float(stream), 0.f, 0.f);
+            engine.playStream(openAudioStream(humPath), params);
+        }
+
+        // Updates as fast as possible, giving way to the decode threads
+        // since the mixer is not paced by a real device here
+        std::vector<qint16> output(blockFrames * 2);
+        QElapsedTimer timer;
+        timer.start();
+        while (engine.stats().firstSamples < quint64(streamCount) && timer.elapsed() < 2000)
+        {
+            engine.update();
+            engine.render(output.data(), blockFrames);
+            std::this_thread::yield();
+        }
+        const AudioEngine::Stats &stats = engine.stats();
+        if (stats.firstSamples < quint64(streamCount))
+        {
+            qWarning() << "Only" << stats.firstSamples << "of" << streamCount << "streams started";
+            return 1;
+        }
+        qInfo().noquote() << QString("%1 decode threads: first sample after %2 ms on average, "
+            "%3 ms at most, for %4 streams started together%5")
+            .arg(decodeThreads).arg(stats.firstSampleMs / stats.firstSamples, 0, 'f', 3)
+            .arg(stats.maxFirstSampleMs, 0, 'f', 3).arg(streamCount)
+            .arg(engine.hasStaticBuffers() ? ", zero-copy" : "");
+        engine.close();
+        return 0;
+    }
+
+    int measureCache()
+    {
+        AudioEngine engine(32);
+        if (!engine.open(AudioEngine::Device::Loopback, sampleRate))
+        {
+            return 1;
+        }
+        {
+            // Room for about two of the four impacts, the hum is streamed
+            SoundCache cache(&engine, 24 * 1024, 16 * 1024);
+            QRandomGenerator random(42);
+            std::vector<qint16> output(blockFrames * 2);
+            AudioEngine::VoiceParams params;
+            for (int block = 0; block < cacheBlocks; ++block)
+            {
+                // Mostly the two smallest impacts, now and then the others
+                const int pick = int(random.bounded(20.f));
+                const char *path = pick < 8 ? impactPaths[0] : pick < 16 ? impactPaths[1] :
+                    pick < 19 ? impactPaths[2 + pick % 2] : humPath;
+                cache.play(path, params);
+                engine.update();
+                engine.render(output.data(), blockFrames);
+            }
+            const SoundCache::Stats &stats = cache.stats();
+            qInfo().noquote() << QString("Sound cache: %1 hits, %2 misses, %3 evictions, "
+                "%4 streamed, %5 clips in %6 KB, %7 ms decoding")
+                .arg(stats.hits).arg(stats.misses).arg(stats.evictions).arg(stats.streamed)
+                .arg(stats.clips).arg(stats.bytes / 1024.0, 0, 'f', 1)
+                .arg(stats.decodeMs, 0, 'f', 2);
+        }
+        engine.close();
+        return 0;
+    }
+}
+
+int runAudioDecodeBenchmark()
+{
+    int result = measureThroughput(humPath);
+    for (int impact = 0; impact < impactCount && result == 0; ++impact)
+    {
+        result = measureThroughput(impactPaths[impact]);
+    }
+    if (result == 0)
+    {
+        result = measureFirstSample(1);
+    }
+    if (result == 0)
+    {
+        result = measureFirstSample(4);
+    }
+    if (result == 0)
+    {
+        result = measureCache();
+    }
+    return result;
+}
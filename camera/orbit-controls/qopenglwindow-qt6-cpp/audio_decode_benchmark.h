@@ -0,0 +1,13 @@
+#ifndef AUDIO_DECODE_BENCHMARK_H
+#define AUDIO_DECODE_BENCHMARK_H
+
+// Decodes the sound resources chunk by chunk and prints the throughput.
+// Then starts 16 streams of the looping hum at once on the loopback
+// device, with 1 and 4 decode threads, and prints the time from
+// playStream() to the first queued sample. Last, plays the impacts
+// through a 24 KB sound cache and prints hits, misses and evictions.
+// Returns a process exit code, 1 when a resource does not decode or
+// the loopback device is not available.
+int runAudioDecodeBenchmark();
+
+#endif // AUDIO_DECODE_BENCHMARK_H
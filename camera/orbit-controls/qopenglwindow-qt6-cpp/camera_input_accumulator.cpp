@@ -0,0 +1,172 @@
+#include <QtCore/QSignalBlocker>
+
+#include "camera_input_accumulator.h"
+
+CameraInputAccumulator::CameraInputAccumulator(OrbitControls *controls)
+    : m_controls(controls)
+{
+    // A second of 1000 Hz input, the queue never reallocates after that
+    m_events.reserve(1024);
+}
+
+void CameraInputAccumulator::startCameraRotation(int x, int y, qint64 timestamp)
+{
+    push(EventType::StartRotation, x, y, 0.f, timestamp);
+}
+
+void CameraInputAccumulator::finishCameraRotation(qint64 timestamp)
+{
+    push(EventType::FinishRotation, 0, 0, 0.f, timestamp);
+}
+
+void CameraInputAccumulator::startCameraPanning(int x, int y, qint64 timestamp)
+{
+    push(EventType::StartPanning, x, y, 0.f, timestamp);
+}
+
+void CameraInputAccumulator::finishCameraPanning(qint64 timestamp)
+{
+    push(EventType::FinishPanning, 0, 0, 0.f, timestamp);
+}
+
+void CameraInputAccumulator::mouseMove(int x, int y, qint64 timestamp)
+{
+    push(EventType::Move, x, y, 0.f, timestamp);
+}
+
+void CameraInputAccumulator::zoomInZoomOut(float angleDeltaY, qint64 timestamp)
+{
+    push(EventType::Zoom, 0, 0, angleDeltaY, timestamp);
+}
+
+bool CameraInputAccumulator::apply(qint64 upToTimestamp)
+{
+    const quint64 version = m_controls->version();
+    // One frame is already being produced, the update() signal would
+    // only request another one
+    const QSignalBlocker blocker(m_controls);
+    size_t applied = 0;
+    for (; applied < m_events.size(); ++applied)
+    {
+        const Event &event = m_events[applied];
+        const QVector2D position(event.x, event.y);
+        if (upToTimestamp >= 0 && event.timestamp > upToTimestamp)
+        {
+            // Moves in a straight line between the two events, the part
+            // up to the frame boundary belongs to this frame
+            if (event.type == EventType::Move && upToTimestamp > m_lastTimestamp)
+            {
+                const float t = float(upToTimestamp - m_lastTimestamp) /
+                    float(event.timestamp - m_lastTimestamp);
+                m_lastPosition += (position - m_lastPosition) * t;
+                move(m_lastPosition);
+                m_lastTimestamp = upToTimestamp;
+            }
+            break;
+        }
+        switch (event.type)
+        {
+            case EventType::StartRotation:
+                flush();
+                m_rotating = true;
+                m_rotationPrev = position;
+                m_lastPosition = position;
+                break;
+            case EventType::FinishRotation:
+                flush();
+                m_rotating = false;
+                break;
+            case EventType::StartPanning:
+                flush();
+                m_panning = true;
+                m_panPrev = position;
+                m_lastPosition = position;
+                break;
+            case EventType::FinishPanning:
+                flush();
+                m_panning = false;
+                break;
+            case EventType::Move:
+                move(position);
+                m_lastPosition = position;
+                break;
+            case EventType::Zoom:
+                beginSum();
+                m_angleDeltaY += event.angleDeltaY;
+                break;
+        }
+        m_lastTimestamp = event.timestamp;
+    }
+    flush();
+
+    if (applied == m_events.size())
+    {
+        m_events.clear();
+    }
+    else
+    {
+        m_events.erase(m_events.begin(), m_events.begin() + applied);
+        // Events newer than this frame wait for the next one
+        emit inputPending();
+    }
+
+    m_applyCount++;
+    return m_controls->version() != version;
+}
+
+void CameraInputAccumulator::move(const QVector2D &position)
+{
+    if (!m_rotating && !m_panning)
+    {
+        return;
+    }
+    beginSum();
+    if (m_rotating)
+    {
+        const QVector2D delta = position - m_rotationPrev;
+        const QVector2D degreesPerPixel = m_controls->degreesPerPixel();
+        m_rotation.setX(OrbitControls::clampRotationX(
+            m_rotation.x() + degreesPerPixel.x() * delta.y()));
+        m_rotation.setY(m_rotation.y() + degreesPerPixel.y() * delta.x());
+        m_rotationPrev = position;
+    }
+    if (m_panning)
+    {
+        m_panPixels += position - m_panPrev;
+        m_panPrev = position;
+    }
+}
+
+void CameraInputAccumulator::beginSum()
+{
+    if (!m_pending)
+    {
+        m_pending = true;
+        m_rotation = m_controls->rotation();
+    }
+}
+
+// One camera update for everything summed since the last call
+void CameraInputAccumulator::flush()
+{
+    if (!m_pending)
+    {
+        return;
+    }
+    m_controls->moveCamera(m_rotation, m_panPixels, m_angleDeltaY);
+    m_pending = false;
+    m_panPixels = QVector2D();
+    m_angleDeltaY = 0.f;
+}
+
+void CameraInputAccumulator::push(EventType type, int x, int y, float angleDeltaY,
+    qint64 timestamp)
+{
+    const bool wasEmpty = pendingCount() == 0;
+    m_events.push_back({ type, x, y, angleDeltaY, timestamp });
+    m_receivedEvents++;
+    if (wasEmpty)
+    {
+        emit inputPending();
+    }
+}
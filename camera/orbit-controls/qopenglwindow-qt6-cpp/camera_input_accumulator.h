@@ -0,0 +1,94 @@
+#ifndef CAMERA_INPUT_ACCUMULATOR_H
+#define CAMERA_INPUT_ACCUMULATOR_H
+
+#include <QtCore/QObject>
+#include <QtGui/QVector2D>
+
+#include <vector>
+
+#include "orbit_controls.h"
+
+// Queues mouse and wheel input for OrbitControls between frames and
+// folds it into one camera update per frame with apply(), so a 1000 Hz
+// mouse costs one update per displayed frame instead of one per event.
+// Rotation, pan and zoom deltas are summed; the rotation is clamped per
+// event, so hitting the limit mid-frame ends where per-event updates do.
+// A frame boundary that falls between two moves splits the later move by
+// its timestamp, the rest of it goes to the next frame. Pressing or
+// releasing a button flushes what was summed before it, so rotation and
+// panning keep their order.
+class CameraInputAccumulator : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CameraInputAccumulator(OrbitControls *controls);
+
+    // timestamp - event time in milliseconds, see QInputEvent::timestamp()
+    void startCameraRotation(int x, int y, qint64 timestamp = 0);
+    void finishCameraRotation(qint64 timestamp = 0);
+    void startCameraPanning(int x, int y, qint64 timestamp = 0);
+    void finishCameraPanning(qint64 timestamp = 0);
+    void mouseMove(int x, int y, qint64 timestamp = 0);
+    void zoomInZoomOut(float angleDeltaY, qint64 timestamp = 0);
+
+    // Applies the events up to and including upToTimestamp (all of them
+    // when it is negative) and keeps the later ones for the next frame.
+    // Returns true when the camera has changed.
+    bool apply(qint64 upToTimestamp = -1);
+
+    int pendingCount() const { return int(m_events.size()); }
+    quint64 receivedEvents() const { return m_receivedEvents; }
+    quint64 applyCount() const { return m_applyCount; }
+
+signals:
+    // Emitted when the queue stops being empty, connect it to update()
+    void inputPending();
+
+private:
+    enum class EventType
+    {
+        StartRotation,
+        FinishRotation,
+        StartPanning,
+        FinishPanning,
+        Move,
+        Zoom
+    };
+
+    struct Event
+    {
+        EventType type;
+        int x;
+        int y;
+        float angleDeltaY;
+        qint64 timestamp;
+    };
+
+    void push(EventType type, int x, int y, float angleDeltaY, qint64 timestamp);
+    void move(const QVector2D &position);
+    void beginSum();
+    void flush();
+
+    OrbitControls *m_controls;
+    std::vector<Event> m_events;
+
+    // Drag state as of the last applied event, positions in pixels are
+    // fractional once a move has been split at a frame boundary
+    bool m_rotating = false;
+    bool m_panning = false;
+    QVector2D m_rotationPrev;
+    QVector2D m_panPrev;
+    QVector2D m_lastPosition;
+    qint64 m_lastTimestamp = 0;
+
+    // Summed since the last flush(), the rotation is absolute
+    bool m_pending = false;
+    QVector2D m_rotation;
+    QVector2D m_panPixels;
+    float m_angleDeltaY = 0.f;
+    quint64 m_receivedEvents = 0;
+    quint64 m_applyCount = 0;
+};
+
+#endif // CAMERA_INPUT_ACCUMULATOR_H
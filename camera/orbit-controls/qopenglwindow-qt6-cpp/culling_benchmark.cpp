@@ -0,0 +1,106 @@
+#include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QRandomGenerator>
+
+#include <vector>
+
+#include "culling_benchmark.h"
+#include "culling_bvh.h"
+#include "orbit_controls.h"
+
+namespace
+{
+    const int objectCount = 200000;
+    const float fieldSize = 400.f;
+    const int movedPerFrame = objectCount / 20;
+    const int frameCount = 120;
+}
+
+int runCullingBenchmark()
+{
+    QRandomGenerator random(42);
+    std::vector<float> centers(objectCount * 3);
+    std::vector<float> extents(objectCount * 3);
+    for (int i = 0; i < objectCount; ++i)
+    {
+        centers[i * 3] = random.bounded(fieldSize) - fieldSize / 2.f;
+        centers[i * 3 + 1] = random.bounded(20.f);
+        centers[i * 3 + 2] = random.bounded(fieldSize) - fieldSize / 2.f;
+        extents[i * 3] = extents[i * 3 + 1] = extents[i * 3 + 2] = 0.3f;
+    }
+
+    // The window's camera, pulled back and orbiting the field
+    OrbitControls controls(60.f, QVector2D(30.f, 0.f), QVector2D(0.f, 0.f));
+    controls.setPerspective(50.f, 0.1f, 150.f);
+    controls.resize(800, 600);
+    controls.startCameraRotation(0, 0);
+
+    QElapsedTimer timer;
+    timer.start();
+    CullingBvh culling(0.2f);
+    culling.build(centers.data(), extents.data(), objectCount);
+    const double buildMs = timer.nsecsElapsed() / 1e6;
+
+    std::vector<int> visible;
+    visible.reserve(objectCount);
+    double refitMs = 0.0;
+    double cullMs = 0.0;
+    double bruteMs = 0.0;
+    quint64 submitted = 0;
+    quint64 culled = 0;
+    quint64 leavesRefitted = 0;
+    int result = 0;
+    for (int frame = 0; frame < frameCount; ++frame)
+    {
+        controls.mouseMove(frame * 6, 0);
+        const Frustum frustum(controls.getProjViewMatrix());
+
+        // Random walk of a different slice of objects every frame
+        for (int n = 0; n < movedPerFrame; ++n)
+        {
+            const int i = (frame * movedPerFrame + n) % objectCount;
+            centers[i * 3] += random.bounded(0.5f) - 0.25f;
+            centers[i * 3 + 2] += random.bounded(0.5f) - 0.25f;
+        }
+        timer.start();
+        for (int n = 0; n < movedPerFrame; ++n)
+        {
+            const int i = (frame * movedPerFrame + n) % objectCount;
+            culling.update(i, &centers[i * 3], &extents[i * 3]);
+        }
+        culling.refit();
+        refitMs += timer.nsecsElapsed() / 1e6;
+
+        visible.clear();
+        timer.start();
+        culling.cull(frustum, Frustum::allPlanes, &visible);
+        cullMs += timer.nsecsElapsed() / 1e6;
+        submitted += culling.stats().submitted;
+        culled += culling.stats().culled;
+        leavesRefitted += culling.stats().leavesRefitted;
+
+        timer.start();
+        int bruteVisible = 0;
+        for (int i = 0; i < objectCount; ++i)
+        {
+            int mask = Frustum::allPlanes;
+            bruteVisible += frustum.test(&centers[i * 3], &extents[i * 3], &mask) !=
+                Frustum::Result::Outside;
+        }
+        bruteMs += timer.nsecsElapsed() / 1e6;
+        if (bruteVisible != culling.stats().submitted)
+        {
+            result = 1;
+        }
+    }
+
+    qInfo().noquote() << QString("Culling %1 objects: build %2 ms, refit %3 ms "
+        "(%4 leaves), visible set %5 ms, brute force %6 ms per frame")
+        .arg(objectCount).arg(buildMs, 0, 'f', 1)
+        .arg(refitMs / frameCount, 0, 'f', 3).arg(leavesRefitted / frameCount)
+        .arg(cullMs / frameCount, 0, 'f', 3).arg(bruteMs / frameCount, 0, 'f', 3);
+    qInfo().noquote() << QString("    %1 submitted, %2 culled per frame%3")
+        .arg(submitted / frameCount).arg(culled / frameCount)
+        .arg(result == 0 ? "" : ", MISMATCH with brute force");
+    return result;
+}
@@ -0,0 +1,11 @@
+#ifndef CULLING_BENCHMARK_H
+#define CULLING_BENCHMARK_H
+
+// 200k boxes scattered over a 400 x 400 field, 5% of them moving every
+// frame, seen by an orbiting perspective camera. Prints the time to
+// refit the culling tree and to extract the visible set next to testing
+// every box, with submitted and culled counts. Returns a process exit
+// code, 1 when the tree and the brute-force test disagree.
+int runCullingBenchmark();
+
+#endif // CULLING_BENCHMARK_H
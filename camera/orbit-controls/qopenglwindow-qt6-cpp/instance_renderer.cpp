@@ -0,0 +1,187 @@
+#include <QtGui/QOpenGLContext>
+#include <QtMath>
+
+#include "instance_renderer.h"
+#include "shader_cache.h"
+
+namespace
+{
+    const int positionLocation = 0;
+    const int normalLocation = 1;
+    // A mat4 attribute takes four consecutive locations, one per column
+    const int modelMatrixLocation = 2;
+
+    const int floatsPerMatrix = 16;
+}
+
+InstanceRenderer::InstanceRenderer()
+{
+}
+
+void InstanceRenderer::initialize()
+{
+    initializeOpenGLFunctions();
+
+    m_program = ShaderCache::instance()->programFromFiles(":/assets/shaders/instanced.vert",
+        ":/assets/shaders/instanced.frag", {
+            { "aPosition", positionLocation },
+            { "aNormal", normalLocation },
+            { "aModelMatrix", modelMatrixLocation }
+        });
+    m_uProjViewMatrixLocation = m_program->uniformLocation("uProjViewMatrix");
+    m_uColorLocation = m_program->uniformLocation("uColor");
+
+    // Same lookup as RectBatch in the fit-scale example: core ES 3.0 /
+    // GL 3.3 first, then the extensions that expose it on ES 2.0
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    const QSurfaceFormat format = context->format();
+    const char *drawName = nullptr;
+    const char *divisorName = nullptr;
+    if ((context->isOpenGLES() && format.majorVersion() >= 3) ||
+        (!context->isOpenGLES() && format.version() >= qMakePair(3, 3)))
+    {
+        drawName = "glDrawArraysInstanced";
+        divisorName = "glVertexAttribDivisor";
+    }
+    else if (context->hasExtension("GL_ANGLE_instanced_arrays"))
+    {
+        drawName = "glDrawArraysInstancedANGLE";
+        divisorName = "glVertexAttribDivisorANGLE";
+    }
+    else if (context->hasExtension("GL_ARB_instanced_arrays"))
+    {
+        drawName = "glDrawArraysInstancedARB";
+        divisorName = "glVertexAttribDivisorARB";
+    }
+    if (drawName)
+    {
+        m_drawArraysInstanced = reinterpret_cast<DrawArraysInstancedFunc>(
+            context->getProcAddress(drawName));
+        m_vertexAttribDivisor = reinterpret_cast<VertexAttribDivisorFunc>(
+            context->getProcAddress(divisorName));
+    }
+    m_instanced = m_drawArraysInstanced && m_vertexAttribDivisor;
+}
+
+void InstanceRenderer::destroy()
+{
+    // Vertex data belongs to the geometry registry
+    for (Mesh &mesh : m_meshes)
+    {
+        mesh.instanceBuffer.destroy();
+    }
+    m_meshes.clear();
+    // The program belongs to the shader cache
+    m_program = nullptr;
+}
+
+int InstanceRenderer::addMesh(const GeometryRegistry::Mesh &geometry)
+{
+    Mesh mesh;
+    mesh.geometry = geometry;
+    mesh.instanceBuffer.setUsagePattern(QOpenGLBuffer::UsagePattern::StreamDraw);
+    mesh.instanceBuffer.create();
+    m_meshes.push_back(mesh);
+    return int(m_meshes.size()) - 1;
+}
+
+void InstanceRenderer::draw(int meshId, const float *matrices, int count,
+    const QVector3D &color, const QMatrix4x4 &projViewMatrix)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    Mesh &mesh = m_meshes[meshId];
+
+    m_program->bind();
+    m_program->setUniformValue(m_uProjViewMatrixLocation, projViewMatrix);
+    m_program->setUniformValue(m_uColorLocation, color);
+
+    const GeometryRegistry::Mesh &geometry = mesh.geometry;
+    glBindBuffer(GL_ARRAY_BUFFER, geometry.vertexBuffer);
+    m_program->setAttributeBuffer(positionLocation, GL_FLOAT, geometry.vertexOffset, 3,
+        geometry.stride);
+    m_program->setAttributeBuffer(normalLocation, GL_FLOAT,
+        geometry.vertexOffset + 3 * sizeof(float), 3, geometry.stride);
+    m_program->enableAttributeArray(positionLocation);
+    m_program->enableAttributeArray(normalLocation);
+
+    if (m_instanced)
+    {
+        const int matrixStride = floatsPerMatrix * sizeof(float);
+        // Re-specifying the whole store orphans last frame's matrices
+        mesh.instanceBuffer.bind();
+        mesh.instanceBuffer.allocate(matrices, count * matrixStride);
+        for (int column = 0; column < 4; ++column)
+        {
+            m_program->setAttributeBuffer(modelMatrixLocation + column, GL_FLOAT,
+                column * 4 * sizeof(float), 4, matrixStride);
+            m_program->enableAttributeArray(modelMatrixLocation + column);
+            m_vertexAttribDivisor(modelMatrixLocation + column, 1);
+        }
+
+        m_drawArraysInstanced(geometry.primitive, 0, geometry.vertexCount, count);
+        m_drawCallCount++;
+
+        for (int column = 0; column < 4; ++column)
+        {
+            m_vertexAttribDivisor(modelMatrixLocation + column, 0);
+            m_program->disableAttributeArray(modelMatrixLocation + column);
+        }
+        mesh.instanceBuffer.release();
+    }
+    else
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            const float *matrix = matrices + i * floatsPerMatrix;
+            for (int column = 0; column < 4; ++column)
+            {
+                glVertexAttrib4fv(modelMatrixLocation + column, matrix + column * 4);
+            }
+            glDrawArrays(geometry.primitive, 0, geometry.vertexCount);
+            m_drawCallCount++;
+        }
+    }
+
+    m_program->disableAttributeArray(positionLocation);
+    m_program->disableAttributeArray(normalLocation);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+std::vector<float> InstanceRenderer::sphereVertices(int rings, int segments)
+{
+    auto point = [rings, segments](int ring, int segment)
+    {
+        const float theta = float(M_PI) * ring / rings;
+        const float phi = 2.f * float(M_PI) * segment / segments;
+        return QVector3D(qSin(theta) * qCos(phi), qCos(theta), qSin(theta) * qSin(phi));
+    };
+
+    std::vector<float> vertices;
+    auto addVertex = [&vertices](const QVector3D &normal)
+    {
+        const QVector3D p = normal * 0.5f;
+        vertices.insert(vertices.end(), { p.x(), p.y(), p.z(),
+            normal.x(), normal.y(), normal.z() });
+    };
+    for (int ring = 0; ring < rings; ++ring)
+    {
+        for (int segment = 0; segment < segments; ++segment)
+        {
+            const QVector3D a = point(ring, segment);
+            const QVector3D b = point(ring + 1, segment);
+            const QVector3D c = point(ring + 1, segment + 1);
+            const QVector3D d = point(ring, segment + 1);
+            // Counter-clockwise seen from outside
+            addVertex(a);
+            addVertex(d);
+            addVertex(c);
+            addVertex(a);
+            addVertex(c);
+            addVertex(b);
+        }
+    }
+    return vertices;
+}
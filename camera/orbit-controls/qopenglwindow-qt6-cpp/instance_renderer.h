@@ -0,0 +1,68 @@
+#ifndef INSTANCE_RENDERER_H
+#define INSTANCE_RENDERER_H
+
+#include <QtGui/QMatrix4x4>
+#include <QtGui/QOpenGLFunctions>
+#include <QtGui/QVector3D>
+#include <QtOpenGL/QOpenGLBuffer>
+#include <QtOpenGL/QOpenGLShaderProgram>
+
+#include <vector>
+
+#include "geometry_registry.h"
+
+// Draws many copies of a mesh, each with its own model matrix, lit by a
+// fixed directional light. Matrices come packed as 16 floats per instance
+// and are streamed into a per-mesh instance buffer, so every mesh takes
+// one instanced draw call (ES 3.0, GL 3.3, ANGLE_instanced_arrays or
+// ARB_instanced_arrays). Without instancing the matrix is passed as a
+// constant attribute and every instance is drawn on its own.
+class InstanceRenderer : protected QOpenGLFunctions
+{
+
+public:
+    InstanceRenderer();
+
+    // Must be called with a current OpenGL context
+    void initialize();
+    void destroy();
+
+    // A Position3DNormal mesh from the geometry registry, returns the
+    // mesh id
+    int addMesh(const GeometryRegistry::Mesh &geometry);
+
+    void draw(int mesh, const float *matrices, int count, const QVector3D &color,
+        const QMatrix4x4 &projViewMatrix);
+
+    bool isInstanced() const { return m_instanced; }
+    int drawCallCount() const { return m_drawCallCount; }
+    void resetDrawCallCount() { m_drawCallCount = 0; }
+
+    // Triangles of a sphere of diameter 1 centered at the origin, with
+    // position and normal per vertex
+    static std::vector<float> sphereVertices(int rings, int segments);
+
+private:
+    struct Mesh
+    {
+        GeometryRegistry::Mesh geometry;
+        QOpenGLBuffer instanceBuffer;
+    };
+
+    typedef void (QOPENGLF_APIENTRYP DrawArraysInstancedFunc)(GLenum mode,
+        GLint first, GLsizei count, GLsizei instanceCount);
+    typedef void (QOPENGLF_APIENTRYP VertexAttribDivisorFunc)(GLuint index,
+        GLuint divisor);
+
+    QOpenGLShaderProgram *m_program = nullptr;
+    int m_uProjViewMatrixLocation;
+    int m_uColorLocation;
+    std::vector<Mesh> m_meshes;
+
+    bool m_instanced = false;
+    DrawArraysInstancedFunc m_drawArraysInstanced = nullptr;
+    VertexAttribDivisorFunc m_vertexAttribDivisor = nullptr;
+    int m_drawCallCount = 0;
+};
+
+#endif // INSTANCE_RENDERER_H
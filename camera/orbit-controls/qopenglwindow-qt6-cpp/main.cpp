@@ -1,12 +1,53 @@
 #include <QtWidgets/QApplication>
 
+#include "culling_benchmark.h"
+#include "offscreen_host.h"
 #include "opengl_window.h"
+#include "orbit_controls_benchmark.h"
+
+#ifdef BULLET_PHYSICS
+#include "physics_scene_benchmark.h"
+#endif
+
+#ifdef SPATIAL_AUDIO
+#include "audio_decode_benchmark.h"
+#include "spatial_audio_benchmark.h"
+#endif
 
 int main(int argc, char *argv[])
 {
     QApplication::setAttribute(Qt::ApplicationAttribute::AA_UseDesktopOpenGL);
     QApplication app(argc, argv);
+    if (app.arguments().contains("--benchmark"))
+    {
+        int result = runOrbitControlsBenchmark();
+#ifdef BULLET_PHYSICS
+        if (result == 0)
+        {
+            result = runPhysicsSceneBenchmark();
+        }
+#endif
+        if (result == 0)
+        {
+            result = runCullingBenchmark();
+        }
+#ifdef SPATIAL_AUDIO
+        if (result == 0)
+        {
+            result = runSpatialAudioBenchmark();
+        }
+        if (result == 0)
+        {
+            result = runAudioDecodeBenchmark();
+        }
+#endif
+        return result;
+    }
     OpenGLWindow w;
+    if (OffscreenHost::isRequested(app.arguments()))
+    {
+        return OffscreenHost(app.arguments()).run(w);
+    }
     w.show();
     return app.exec();
 }
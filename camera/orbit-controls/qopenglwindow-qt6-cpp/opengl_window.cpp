@@ -1,6 +1,31 @@
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDebug>
+#include <QtCore/QThread>
 #include <QtGui/QSurfaceFormat>
 
+#include <algorithm>
+
 #include "opengl_window.h"
+#include "shader_cache.h"
+
+#ifdef SPATIAL_AUDIO
+#include "audio_decoder.h"
+#endif
+
+#ifdef BULLET_PHYSICS
+#include "physics_scene.h"
+
+// World-space box of a unit cube transformed by a column-major matrix
+static void instanceBounds(const float *matrix, float *center, float *extent)
+{
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        center[axis] = matrix[12 + axis];
+        extent[axis] = 0.5f * (qAbs(matrix[axis]) + qAbs(matrix[4 + axis]) +
+            qAbs(matrix[8 + axis]));
+    }
+}
+#endif
 
 OpenGLWindow::OpenGLWindow()
 {
@@ -11,20 +36,73 @@ OpenGLWindow::OpenGLWindow()
     surfaceFormat.setDepthBufferSize(24);
     surfaceFormat.setSamples(4);
     setFormat(surfaceFormat);
+    m_frameScheduler = new FrameScheduler(this,
+        FrameScheduler::modeFromArguments(QCoreApplication::arguments()));
 
-    m_cameraController = new OrbitControls(5.f, QVector2D(30.f, 0.f), QVector2D(0.f, 0.f));
+    float cameraDistance = 5.f;
+#ifdef BULLET_PHYSICS
+    // Thousands of Bullet bodies on a larger ground instead of the quad
+    if (QCoreApplication::arguments().contains("--physics"))
+    {
+        m_physics = std::make_unique<PhysicsScene3D>(QThread::idealThreadCount());
+        fillPhysicsScene(m_physics.get(), 4000);
+        // Loose enough that resting bodies jiggling in place do not refit
+        for (CullingBvh &culling : m_culling)
+        {
+            culling = CullingBvh(0.2f);
+        }
+        m_groundSize = physicsGroundSize;
+        cameraDistance = 22.f;
+    }
+#endif
+
+    m_cameraController = new OrbitControls(cameraDistance, QVector2D(30.f, 0.f),
+        QVector2D(0.f, 0.f));
+    m_cameraController->setPerspective(50.f, 0.01f, 100.f);
     connect(m_cameraController, &OrbitControls::update, this, &OpenGLWindow::onCameraUpdate);
+
+    // Mouse input is queued and applied once per frame in paintGL
+    m_cameraInput = new CameraInputAccumulator(m_cameraController);
+    connect(m_cameraInput, &CameraInputAccumulator::inputPending, this, &OpenGLWindow::onCameraUpdate);
+
+    m_printCullStats = QCoreApplication::arguments().contains("--frame-stats");
+#ifdef SPATIAL_AUDIO
+    if (QCoreApplication::arguments().contains("--audio"))
+    {
+        startAudio();
+    }
+#endif
 }
 
 OpenGLWindow::~OpenGLWindow()
 {
+#ifdef BULLET_PHYSICS
+    if (m_printCullStats && m_cullFrames > 0)
+    {
+        qInfo().noquote() << QString("Culling: %1 frames, %2 submitted and %3 culled "
+            "per frame, %4 ms per frame")
+            .arg(m_cullFrames).arg(m_submitted / m_cullFrames).arg(m_culled / m_cullFrames)
+            .arg(m_cullNs / 1e6 / m_cullFrames, 0, 'f', 3);
+    }
+#endif
+#ifdef SPATIAL_AUDIO
+    if (m_printCullStats && m_audio)
+    {
+        const AudioEngine::Stats &stats = m_audio->stats();
+        qInfo().noquote() << QString("Audio: %1 of %2 voices active, %3 started, "
+            "%4 stolen, %5 underruns, decode backlog %6 slabs, %7 ms in update()")
+            .arg(stats.activeVoices).arg(stats.voices).arg(stats.started).arg(stats.stolen)
+            .arg(stats.underruns).arg(stats.decodeBacklog).arg(stats.updateMs, 0, 'f', 3);
+    }
+#endif
+    delete m_cameraInput;
     delete m_cameraController;
 }
 
 void OpenGLWindow::onCameraUpdate()
 {
-    m_viewMatrix = m_cameraController->getViewMatrix();
-    update();
+    // Matrices are rebuilt lazily by the controller when paintGL asks for them
+    m_frameScheduler->requestFrame();
 }
 
 void OpenGLWindow::initializeGL()
@@ -32,50 +110,190 @@ void OpenGLWindow::initializeGL()
     initializeOpenGLFunctions();
     glClearColor(0.6f, 0.862f, 0.925f, 1.f);
 
-    m_program.create();
-    m_program.addShaderFromSourceFile(QOpenGLShader::ShaderTypeBit::Vertex,
-        ":/assets/shaders/color.vert");
-    m_program.addShaderFromSourceFile(QOpenGLShader::ShaderTypeBit::Fragment,
+    m_program = ShaderCache::instance()->programFromFiles(":/assets/shaders/color.vert",
         ":/assets/shaders/color.frag");
-    m_program.link();
-    m_program.bind();
-
-    float vertPositions[] = {
-        -0.5f, -0.5f,
-        0.5f, -0.5f,
-        -0.5f, 0.5f,
-        0.5f, 0.5f
-    };
-    m_vertPosBuffer.create();
-    m_vertPosBuffer.bind();
-    m_vertPosBuffer.allocate(vertPositions, sizeof(vertPositions));
-    m_program.setAttributeBuffer("aPosition", GL_FLOAT, 0, 2);
-    m_program.enableAttributeArray("aPosition");
+    m_program->bind();
+    m_quad = GeometryRegistry::instance()->quad();
+    m_uMvpMatrixLocation = m_program->uniformLocation("uMvpMatrix");
 
-    m_uMvpMatrixLocation = m_program.uniformLocation("uMvpMatrix");
-    m_viewMatrix = m_cameraController->getViewMatrix();
+    glEnable(GL_DEPTH_TEST);
+#ifdef BULLET_PHYSICS
+    if (m_physics)
+    {
+        m_instanceRenderer.initialize();
+        GeometryRegistry *geometry = GeometryRegistry::instance();
+        m_meshes[int(PhysicsScene3D::Shape::Box)] = m_instanceRenderer.addMesh(geometry->cube());
+        m_meshes[int(PhysicsScene3D::Shape::Sphere)] = m_instanceRenderer.addMesh(
+            geometry->mesh("sphere-8-12", GeometryRegistry::Layout::Position3DNormal,
+                GL_TRIANGLES, InstanceRenderer::sphereVertices(8, 12)));
+        m_physicsClock.start();
+    }
+#endif
 }
 
 void OpenGLWindow::resizeGL(int w, int h)
 {
-    m_projMatrix.setToIdentity();
-    m_projMatrix.perspective(50.f, w / (float)h, 0.01f, 100.f);
     m_cameraController->resize(w, h);
 }
 
 void OpenGLWindow::paintGL()
 {
-    glClear(GL_COLOR_BUFFER_BIT);
+    m_cameraInput->apply();
+#ifdef SPATIAL_AUDIO
+    updateListener();
+#endif
+#ifdef BULLET_PHYSICS
+    if (m_physics)
+    {
+        stepPhysics();
+    }
+#endif
+
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     m_modelMatrix.setToIdentity();
     m_modelMatrix.translate(QVector3D(0, 0, 0));
     m_modelMatrix.rotate(90, QVector3D(1, 0, 0));
-    m_modelMatrix.scale(QVector3D(3, 3, 1));
-    m_projViewMatrix = m_projMatrix * m_viewMatrix;
-    m_mvpMatrix = m_projViewMatrix * m_modelMatrix;
-    m_program.setUniformValue(m_uMvpMatrixLocation, m_mvpMatrix);
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    m_modelMatrix.scale(QVector3D(m_groundSize, m_groundSize, 1));
+    m_mvpMatrix = m_cameraController->getProjViewMatrix() * m_modelMatrix;
+    m_program->bind();
+    m_program->setUniformValue(m_uMvpMatrixLocation, m_mvpMatrix);
+    // The instance renderer changes the attribute setup
+    glBindBuffer(GL_ARRAY_BUFFER, m_quad.vertexBuffer);
+    m_program->setAttributeBuffer("aPosition", GL_FLOAT, m_quad.vertexOffset, 2, m_quad.stride);
+    m_program->enableAttributeArray("aPosition");
+    glDrawArrays(m_quad.primitive, 0, m_quad.vertexCount);
+
+#ifdef BULLET_PHYSICS
+    if (m_physics)
+    {
+        drawBodies();
+    }
+#endif
 }
 
+#ifdef BULLET_PHYSICS
+
+void OpenGLWindow::drawBodies()
+{
+    const QVector3D colors[PhysicsScene3D::shapeCount] = {
+        QVector3D(0.85f, 0.45f, 0.2f),
+        QVector3D(0.3f, 0.45f, 0.85f)
+    };
+    const Frustum frustum(m_cameraController->getProjViewMatrix());
+    for (int shape = 0; shape < PhysicsScene3D::shapeCount; ++shape)
+    {
+        cullInstances(shape, frustum);
+        m_instanceRenderer.draw(m_meshes[shape], m_visibleMatrices.data(),
+            int(m_visible.size()), colors[shape], m_cameraController->getProjViewMatrix());
+    }
+    m_cullFrames++;
+
+    // Keep rendering until every body has come to rest
+    if (m_physics->activeCount() > 0)
+    {
+        m_frameScheduler->requestFrame();
+    }
+}
+
+// Refits the shape's tree with the bodies that moved, then gathers the
+// matrices of the visible ones into m_visibleMatrices
+void OpenGLWindow::cullInstances(int shape, const Frustum &frustum)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const PhysicsScene3D::Shape meshShape = PhysicsScene3D::Shape(shape);
+    const int count = m_physics->instanceCount(meshShape);
+    const float *matrices = m_physics->instances(meshShape);
+    CullingBvh &culling = m_culling[shape];
+    float center[3];
+    float extent[3];
+    if (culling.objectCount() != count)
+    {
+        m_boundsCenters.resize(count * 3);
+        m_boundsExtents.resize(count * 3);
+        for (int i = 0; i < count; ++i)
+        {
+            instanceBounds(matrices + i * 16, &m_boundsCenters[i * 3], &m_boundsExtents[i * 3]);
+        }
+        culling.build(m_boundsCenters.data(), m_boundsExtents.data(), count);
+    }
+    else
+    {
+        for (int i : m_physics->movedInstances(meshShape))
+        {
+            instanceBounds(matrices + i * 16, center, extent);
+            culling.update(i, center, extent);
+        }
+        culling.refit();
+    }
+
+    m_visible.clear();
+    culling.cull(frustum, Frustum::allPlanes, &m_visible);
+    m_visibleMatrices.resize(m_visible.size() * 16);
+    float *dst = m_visibleMatrices.data();
+    for (int i : m_visible)
+    {
+        std::copy(matrices + i * 16, matrices + i * 16 + 16, dst);
+        dst += 16;
+    }
+
+    m_submitted += culling.stats().submitted;
+    m_culled += culling.stats().culled;
+    m_cullNs += timer.nsecsElapsed();
+}
+
+void OpenGLWindow::stepPhysics()
+{
+    const qint64 elapsedNs = m_physicsClock.restart();
+    // Bullet runs the fixed steps and interpolates the motion states
+    m_physics->step(elapsedNs / 1e9f);
+}
+
+#endif
+
+#ifdef SPATIAL_AUDIO
+
+void OpenGLWindow::startAudio()
+{
+    m_audio = std::make_unique<AudioEngine>();
+    // The null device keeps the example running without audio hardware
+    if (!m_audio->open(AudioEngine::Device::Default) &&
+        !m_audio->open(AudioEngine::Device::Null))
+    {
+        m_audio.reset();
+        return;
+    }
+    AudioEngine::VoiceParams params;
+    params.position = QVector3D(0.f, 1.f, 0.f);
+    params.gain = 0.3f;
+    params.looping = true;
+    params.referenceDistance = 5.f;
+    if (std::unique_ptr<AudioStream> hum = openAudioStream(":/assets/sounds/hum.wav"))
+    {
+        m_audio->playStream(std::move(hum), params);
+    }
+
+    // Frames stop while nothing moves, the streams still need feeding
+    connect(&m_audioTimer, &QTimer::timeout, this, [this] { m_audio->update(); });
+    m_audioTimer.start(20);
+}
+
+// The listener takes the cached camera basis and is only moved when the
+// camera has changed
+void OpenGLWindow::updateListener()
+{
+    if (!m_audio || m_cameraController->version() == m_listenerVersion)
+    {
+        return;
+    }
+    m_audio->setListener(m_cameraController->getCameraPosition(),
+        m_cameraController->getBackVector(), m_cameraController->getUpVector());
+    m_listenerVersion = m_cameraController->version();
+}
+
+#endif
+
 void OpenGLWindow::mousePressEvent(QMouseEvent *event)
 {
     switch (event->button())
@@ -84,14 +302,14 @@ void OpenGLWindow::mousePressEvent(QMouseEvent *event)
         {
             int x = event->pos().x();
             int y = event->pos().y();
-            m_cameraController->startCameraRotation(x, y);
+            m_cameraInput->startCameraRotation(x, y, event->timestamp());
             break;
         }
         case Qt::MouseButton::RightButton:
         {
             int x = event->pos().x();
             int y = event->pos().y();
-            m_cameraController->startCameraPanning(x, y);
+            m_cameraInput->startCameraPanning(x, y, event->timestamp());
             break;
         }
         default:
@@ -103,7 +321,7 @@ void OpenGLWindow::mouseMoveEvent(QMouseEvent *event)
 {
     int x = event->pos().x();
     int y = event->pos().y();
-    m_cameraController->mouseMove(x, y);
+    m_cameraInput->mouseMove(x, y, event->timestamp());
 }
 
 void OpenGLWindow::mouseReleaseEvent(QMouseEvent *event)
@@ -111,12 +329,12 @@ void OpenGLWindow::mouseReleaseEvent(QMouseEvent *event)
     switch (event->button()) {
         case Qt::MouseButton::LeftButton:
         {
-            m_cameraController->finishCameraRotation();
+            m_cameraInput->finishCameraRotation(event->timestamp());
             break;
         }
         case Qt::MouseButton::RightButton:
         {
-            m_cameraController->finishCameraPanning();
+            m_cameraInput->finishCameraPanning(event->timestamp());
             break;
         }
         default:
@@ -126,5 +344,5 @@ void OpenGLWindow::mouseReleaseEvent(QMouseEvent *event)
 
 void OpenGLWindow::wheelEvent(QWheelEvent *event)
 {
-    m_cameraController->zoomInZoomOut(event->angleDelta().y());
+    m_cameraInput->zoomInZoomOut(event->angleDelta().y(), event->timestamp());
 }
@@ -1,22 +1,40 @@
 #ifndef OPENGL_WINDOW_H
 #define OPENGL_WINDOW_H
 
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QTimer>
 #include <QtGui/QMatrix4x4>
 #include <QtGui/QOpenGLFunctions>
 #include <QtGui/QVector3D>
 #include <QtGui/QMouseEvent>
 #include <QtGui/QWheelEvent>
-#include <QtOpenGL/QOpenGLBuffer>
 #include <QtOpenGL/QOpenGLShader>
 #include <QtOpenGL/QOpenGLShaderProgram>
 #include <QtOpenGL/QOpenGLWindow>
 
+#include <memory>
+
+#include "camera_input_accumulator.h"
+#include "frame_scheduler.h"
+#include "geometry_registry.h"
 #include "orbit_controls.h"
 
+#ifdef SPATIAL_AUDIO
+#include "audio_engine.h"
+#endif
+
+#ifdef BULLET_PHYSICS
+#include "culling_bvh.h"
+#include "instance_renderer.h"
+#include "physics_scene_3d.h"
+#endif
+
 class OpenGLWindow : public QOpenGLWindow, private QOpenGLFunctions
 {
     Q_OBJECT
 
+    friend class OffscreenHost;
+
 public:
     OpenGLWindow();
     ~OpenGLWindow();
@@ -32,17 +50,54 @@ private:
     void mouseMoveEvent(QMouseEvent *event) override;
     void mouseReleaseEvent(QMouseEvent *event) override;
     void wheelEvent(QWheelEvent *event) override;
+#ifdef SPATIAL_AUDIO
+    void startAudio();
+    void updateListener();
+#endif
+#ifdef BULLET_PHYSICS
+    void stepPhysics();
+    void drawBodies();
+    void cullInstances(int shape, const Frustum &frustum);
+#endif
 
 private:
-    QOpenGLBuffer m_vertPosBuffer;
-    QOpenGLShaderProgram m_program;
+    GeometryRegistry::Mesh m_quad;
+    QOpenGLShaderProgram *m_program = nullptr;
     int m_uMvpMatrixLocation;
     QMatrix4x4 m_mvpMatrix;
-    QMatrix4x4 m_projMatrix;
-    QMatrix4x4 m_viewMatrix;
-    QMatrix4x4 m_projViewMatrix;
     QMatrix4x4 m_modelMatrix;
     OrbitControls *m_cameraController;
+    CameraInputAccumulator *m_cameraInput;
+    FrameScheduler *m_frameScheduler;
+    float m_groundSize = 3.f;
+
+#ifdef BULLET_PHYSICS
+    // Only with --physics
+    std::unique_ptr<PhysicsScene3D> m_physics;
+    QElapsedTimer m_physicsClock;
+    InstanceRenderer m_instanceRenderer;
+    int m_meshes[PhysicsScene3D::shapeCount];
+
+    // One tree per mesh type, so each still takes one instanced call
+    CullingBvh m_culling[PhysicsScene3D::shapeCount];
+    std::vector<int> m_visible;
+    std::vector<float> m_visibleMatrices;
+    std::vector<float> m_boundsCenters;
+    std::vector<float> m_boundsExtents;
+    quint64 m_cullFrames = 0;
+    quint64 m_submitted = 0;
+    quint64 m_culled = 0;
+    qint64 m_cullNs = 0;
+#endif
+
+#ifdef SPATIAL_AUDIO
+    // Only with --audio, a hum streamed from just above the ground
+    std::unique_ptr<AudioEngine> m_audio;
+    QTimer m_audioTimer;
+    quint64 m_listenerVersion = ~0ull;
+#endif
+
+    bool m_printCullStats = false;
 };
 
 #endif // OPENGL_WINDOW_H
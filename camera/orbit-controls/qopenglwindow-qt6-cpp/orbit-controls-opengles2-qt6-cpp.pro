@@ -5,13 +5,58 @@ win32: LIBS += -lopengl32
 CONFIG += c++17
 
 SOURCES += \
+    camera_input_accumulator.cpp \
+    culling_benchmark.cpp \
     main.cpp \
     opengl_window.cpp \
-    orbit_controls.cpp
+    orbit_controls.cpp \
+    orbit_controls_benchmark.cpp
 
 HEADERS += \
+    camera_input_accumulator.h \
+    culling_benchmark.h \
     opengl_window.h \
-    orbit_controls.h
+    orbit_controls.h \
+    orbit_controls_benchmark.h
 
 RESOURCES += \
     assets.qrc
+
+include(../../../common/culling/culling.pri)
+include(../../../common/frame-scheduler/frame_scheduler.pri)
+include(../../../common/geometry-registry/geometry_registry.pri)
+include(../../../common/offscreen-host/offscreen_host.pri)
+include(../../../common/shader-cache/shader_cache.pri)
+
+# Bullet bodies for "--physics", configure with "qmake CONFIG+=bullet".
+# Without it, or without --physics, the window shows the single quad.
+bullet {
+    DEFINES += BULLET_PHYSICS
+
+    SOURCES += \
+        instance_renderer.cpp \
+        physics_scene.cpp \
+        physics_scene_benchmark.cpp
+
+    HEADERS += \
+        instance_renderer.h \
+        physics_scene.h \
+        physics_scene_benchmark.h
+
+    include(../../../common/physics-3d/physics_scene_3d.pri)
+}
+
+# OpenAL spatial audio for "--audio", configure with "qmake CONFIG+=openal"
+openal {
+    DEFINES += SPATIAL_AUDIO
+
+    SOURCES += \
+        audio_decode_benchmark.cpp \
+        spatial_audio_benchmark.cpp
+
+    HEADERS += \
+        audio_decode_benchmark.h \
+        spatial_audio_benchmark.h
+
+    include(../../../common/spatial-audio/spatial_audio.pri)
+}
@@ -41,23 +41,23 @@ void OrbitControls::mouseMove(int x, int y)
         if (m_mouseHolding)
         {
             float newCameraRotX = m_cameraRotationXY.x() + m_degreesPerPixelX * (y - m_mousePrevRotY);
-            newCameraRotX = qMax(-85.f, qMin(85.f, newCameraRotX));
+            newCameraRotX = clampRotationX(newCameraRotX);
             float newCameraRotY = m_cameraRotationXY.y() + m_degreesPerPixelY * (x - m_mousePrevRotX);
             m_cameraRotationXY.setX(newCameraRotX);
             m_cameraRotationXY.setY(newCameraRotY);
             m_mousePrevRotX = x;
             m_mousePrevRotY = y;
+            rotationChanged();
         }
 
         if (m_mousePanning)
         {
-            QMatrix4x4 viewMatrix = getViewMatrix();
-            // row(0) - X axis in camera space
-            m_center += QVector3D(viewMatrix.row(0)) * (m_mousePrevPanX - x) / 100.f;
-            // row(1) - Y axis in camera space
-            m_center += QVector3D(viewMatrix.row(1)) * (y - m_mousePrevPanY) / 100.f;
+            // Panning only needs the camera axes, not the whole view matrix
+            m_center += getRightVector() * (m_mousePrevPanX - x) / 100.f;
+            m_center += getUpVector() * (y - m_mousePrevPanY) / 100.f;
             m_mousePrevPanX = x;
             m_mousePrevPanY = y;
+            positionChanged();
         }
 
         emit update();
@@ -72,28 +72,133 @@ void OrbitControls::zoomInZoomOut(float angleDeltaY)
     {
         m_viewDistance = 1.f;
     }
+    positionChanged();
 
     emit update();
 }
 
-QMatrix4x4 OrbitControls::getViewMatrix()
+void OrbitControls::moveCamera(const QVector2D &rotation, const QVector2D &panPixels,
+    float angleDeltaY)
 {
-    QMatrix4x4 mat;
+    const QVector2D clamped(clampRotationX(rotation.x()), rotation.y());
+    if (clamped != m_cameraRotationXY)
+    {
+        m_cameraRotationXY = clamped;
+        rotationChanged();
+    }
+    if (!panPixels.isNull())
+    {
+        m_center += getRightVector() * -panPixels.x() / 100.f;
+        m_center += getUpVector() * panPixels.y() / 100.f;
+        positionChanged();
+    }
+    if (angleDeltaY != 0.f)
+    {
+        m_viewDistance = qMax(1.f, m_viewDistance - angleDeltaY / 100.f);
+        positionChanged();
+    }
+    emit update();
+}
 
-    const float cosX = qCos(m_cameraRotationXY.x() / 180.f * M_PI);
-    const float sinX = qSin(m_cameraRotationXY.x() / 180.f * M_PI);
-    const float cosY = qCos(m_cameraRotationXY.y() / 180.f * M_PI);
-    const float sinY = qSin(m_cameraRotationXY.y() / 180.f * M_PI);
+const QMatrix4x4 &OrbitControls::getViewMatrix()
+{
+    if (m_viewDirty)
+    {
+        m_viewDirty = false;
+        m_stats.viewRebuilds++;
+        m_viewMatrix.setToIdentity();
+        m_viewMatrix.lookAt(getCameraPosition(), m_center, getUpVector());
+    }
+    return m_viewMatrix;
+}
+
+const QMatrix4x4 &OrbitControls::getProjViewMatrix()
+{
+    if (m_projViewDirty)
+    {
+        m_projViewDirty = false;
+        m_stats.projViewRebuilds++;
+        m_projViewMatrix = m_projMatrix * getViewMatrix();
+    }
+    return m_projViewMatrix;
+}
+
+const QVector3D &OrbitControls::getCameraPosition()
+{
+    if (m_positionDirty)
+    {
+        m_positionDirty = false;
+        m_position = getBackVector() * m_viewDistance + m_center;
+    }
+    return m_position;
+}
 
-    QVector3D ay(sinX * sinY, cosX, -sinX * cosY); // Y axis in camera space
-    QVector3D az(-cosX * sinY, sinX, cosX * cosY); // Z axis in camera space
-    mat.lookAt(az * m_viewDistance + m_center, m_center, ay);
+const QVector3D &OrbitControls::getRightVector()
+{
+    updateBasis();
+    return m_right;
+}
 
-    return mat;
+const QVector3D &OrbitControls::getUpVector()
+{
+    updateBasis();
+    return m_up;
+}
+
+const QVector3D &OrbitControls::getBackVector()
+{
+    updateBasis();
+    return m_back;
+}
+
+void OrbitControls::setPerspective(float verticalAngle, float nearPlane, float farPlane)
+{
+    m_verticalAngle = verticalAngle;
+    m_nearPlane = nearPlane;
+    m_farPlane = farPlane;
+    m_projMatrix.setToIdentity();
+    m_projMatrix.perspective(m_verticalAngle, m_aspectRatio, m_nearPlane, m_farPlane);
+    m_projViewDirty = true;
+    m_version++;
 }
 
 void OrbitControls::resize(int width, int height)
 {
     m_degreesPerPixelX = 90.f / (float) width;
     m_degreesPerPixelY = 180.f / (float) height;
+    m_aspectRatio = width / (float) height;
+    setPerspective(m_verticalAngle, m_nearPlane, m_farPlane);
+}
+
+void OrbitControls::rotationChanged()
+{
+    m_basisDirty = true;
+    positionChanged();
+}
+
+void OrbitControls::positionChanged()
+{
+    m_positionDirty = true;
+    m_viewDirty = true;
+    m_projViewDirty = true;
+    m_version++;
+}
+
+void OrbitControls::updateBasis()
+{
+    if (!m_basisDirty)
+    {
+        return;
+    }
+    m_basisDirty = false;
+    m_stats.basisRebuilds++;
+
+    const float cosX = qCos(m_cameraRotationXY.x() / 180.f * M_PI);
+    const float sinX = qSin(m_cameraRotationXY.x() / 180.f * M_PI);
+    const float cosY = qCos(m_cameraRotationXY.y() / 180.f * M_PI);
+    const float sinY = qSin(m_cameraRotationXY.y() / 180.f * M_PI);
+
+    m_up = QVector3D(sinX * sinY, cosX, -sinX * cosY); // Y axis in camera space
+    m_back = QVector3D(-cosX * sinY, sinX, cosX * cosY); // Z axis in camera space
+    m_right = QVector3D::crossProduct(m_up, m_back); // X axis in camera space
 }
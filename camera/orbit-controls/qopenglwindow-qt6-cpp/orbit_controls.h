@@ -11,6 +11,14 @@ class OrbitControls : public QObject
     Q_OBJECT
 
 public:
+    // How many times the cached matrices had to be recomputed
+    struct Stats
+    {
+        quint64 basisRebuilds = 0;
+        quint64 viewRebuilds = 0;
+        quint64 projViewRebuilds = 0;
+    };
+
     OrbitControls(float viewDistance, const QVector2D &cameraRotationXY,
         const QVector2D &cameraPanXY);
 
@@ -23,13 +31,42 @@ public:
     void mouseMove(int x, int y);
     void zoomInZoomOut(float angleDeltaY);
 
-    QMatrix4x4 getViewMatrix();
+    // Input that was coalesced over a frame, applied as one update:
+    // rotation - absolute, clamped like mouseMove() does
+    // panPixels - mouse movement while panning, in the new rotation
+    // angleDeltaY - summed wheel movement
+    void moveCamera(const QVector2D &rotation, const QVector2D &panPixels, float angleDeltaY);
+    const QVector2D &rotation() const { return m_cameraRotationXY; }
+    // Rotation per pixel of mouse movement, x is taken from vertical and
+    // y from horizontal movement
+    QVector2D degreesPerPixel() const { return QVector2D(m_degreesPerPixelX, m_degreesPerPixelY); }
+    static float clampRotationX(float degrees) { return qMax(-85.f, qMin(85.f, degrees)); }
+
+    // The matrices and vectors below are cached and only recomputed
+    // after the rotation, pan, distance or viewport has changed
+    const QMatrix4x4 &getViewMatrix();
+    const QMatrix4x4 &getProjViewMatrix();
+    const QVector3D &getCameraPosition();
+    // Camera axes in world space
+    const QVector3D &getRightVector();
+    const QVector3D &getUpVector();
+    const QVector3D &getBackVector();
+
+    void setPerspective(float verticalAngle, float nearPlane, float farPlane);
     void resize(int width, int height);
 
+    // Incremented on every change of the camera
+    quint64 version() const { return m_version; }
+    const Stats &stats() const { return m_stats; }
+
 signals:
     void update();
 
 private:
+    void rotationChanged();
+    void positionChanged();
+    void updateBasis();
+
     float m_viewDistance;
     QVector2D m_cameraRotationXY;
     QVector2D m_cameraPanXY;
@@ -43,6 +80,25 @@ private:
     int m_mousePrevPanX = 0;
     int m_mousePrevPanY = 0;
     QVector3D m_center;
+
+    float m_verticalAngle = 50.f;
+    float m_nearPlane = 0.01f;
+    float m_farPlane = 100.f;
+    float m_aspectRatio = 1.f;
+
+    quint64 m_version = 0;
+    bool m_basisDirty = true;
+    bool m_positionDirty = true;
+    bool m_viewDirty = true;
+    bool m_projViewDirty = true;
+    QVector3D m_right;
+    QVector3D m_up;
+    QVector3D m_back;
+    QVector3D m_position;
+    QMatrix4x4 m_viewMatrix;
+    QMatrix4x4 m_projMatrix;
+    QMatrix4x4 m_projViewMatrix;
+    Stats m_stats;
 };
 
 #endif // ORBIT_CONTROLS_H
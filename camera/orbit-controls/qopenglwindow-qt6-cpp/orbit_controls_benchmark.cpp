@@ -0,0 +1,172 @@
+#include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QRandomGenerator>
+
+#include "camera_input_accumulator.h"
+#include "orbit_controls.h"
+#include "orbit_controls_benchmark.h"
+
+namespace
+{
+    const int inputRate = 1000;
+    const int displayRate = 60;
+
+    void replay(const char *name, bool panning)
+    {
+        OrbitControls controls(5.f, QVector2D(30.f, 0.f), QVector2D(0.f, 0.f));
+        controls.setPerspective(50.f, 0.01f, 100.f);
+        controls.resize(500, 500);
+
+        // Every event used to cost one view matrix in OpenGLWindow::onCameraUpdate
+        // plus one more for panning, and every frame one projection-view product
+        quint64 uncachedViews = 0;
+        quint64 uncachedProjViews = 0;
+        int frames = 0;
+        float checksum = 0.f;
+
+        QElapsedTimer timer;
+        timer.start();
+        if (panning)
+        {
+            controls.startCameraPanning(250, 250);
+        }
+        else
+        {
+            controls.startCameraRotation(250, 250);
+        }
+        for (int event = 1; event <= inputRate; ++event)
+        {
+            controls.mouseMove(250 + event % 200, 250 + event % 100);
+            uncachedViews += panning ? 2 : 1;
+
+            // A frame is presented every time the 60 Hz clock ticks
+            if (event * displayRate / inputRate != (event - 1) * displayRate / inputRate)
+            {
+                checksum += controls.getProjViewMatrix()(0, 0);
+                uncachedProjViews++;
+                frames++;
+            }
+        }
+        const double elapsed = timer.nsecsElapsed() / 1e3;
+
+        const OrbitControls::Stats &stats = controls.stats();
+        qInfo().noquote() << QString("%1: %2 events, %3 frames, %4 us (checksum %5)")
+            .arg(name).arg(inputRate).arg(frames).arg(elapsed, 0, 'f', 1).arg(checksum);
+        qInfo().noquote() << QString("    view matrices %1 instead of %2, "
+            "projection-view products %3 instead of %4, basis rebuilds %5")
+            .arg(stats.viewRebuilds).arg(uncachedViews)
+            .arg(stats.projViewRebuilds).arg(uncachedProjViews).arg(stats.basisRebuilds);
+    }
+
+    // Plays the same recorded input into one OrbitControls per event and
+    // into another through CameraInputAccumulator once per 60 Hz frame,
+    // then checks that both cameras ended up in the same state
+    bool replayCoalesced()
+    {
+        OrbitControls direct(5.f, QVector2D(30.f, 0.f), QVector2D(0.f, 0.f));
+        OrbitControls coalesced(5.f, QVector2D(30.f, 0.f), QVector2D(0.f, 0.f));
+        direct.resize(500, 500);
+        coalesced.resize(500, 500);
+        CameraInputAccumulator accumulator(&coalesced);
+
+        int directUpdates = 0;
+        QObject::connect(&direct, &OrbitControls::update, [&directUpdates]() { directUpdates++; });
+
+        QRandomGenerator random(7);
+        int x = 250;
+        int y = 250;
+        int frames = 0;
+        const int durationMs = 3000;
+        for (qint64 time = 1; time <= durationMs; ++time)
+        {
+            // Drags of a quarter second each, alternating the button,
+            // with large moves so that the rotation clamp gets hit
+            const int phase = int(time / 250);
+            if (time % 250 == 1)
+            {
+                if (phase % 2 == 0)
+                {
+                    direct.startCameraRotation(x, y);
+                    accumulator.startCameraRotation(x, y, time);
+                }
+                else
+                {
+                    direct.startCameraPanning(x, y);
+                    accumulator.startCameraPanning(x, y, time);
+                }
+            }
+            x += random.bounded(-20, 21);
+            y += random.bounded(-20, 21);
+            direct.mouseMove(x, y);
+            accumulator.mouseMove(x, y, time);
+            if (time % 97 == 0)
+            {
+                const float delta = random.bounded(-240, 241);
+                direct.zoomInZoomOut(delta);
+                accumulator.zoomInZoomOut(delta, time);
+            }
+            if (time % 250 == 0)
+            {
+                direct.finishCameraRotation();
+                direct.finishCameraPanning();
+                accumulator.finishCameraRotation(time);
+                accumulator.finishCameraPanning(time);
+            }
+
+            if (time * displayRate / 1000 != (time - 1) * displayRate / 1000)
+            {
+                accumulator.apply(time);
+                frames++;
+            }
+        }
+        accumulator.apply();
+
+        // The rotation is bit-identical, summed pan deltas round differently
+        const QMatrix4x4 &a = direct.getProjViewMatrix();
+        const QMatrix4x4 &b = coalesced.getProjViewMatrix();
+        float error = (direct.getCameraPosition() - coalesced.getCameraPosition()).length();
+        for (int i = 0; i < 16; ++i)
+        {
+            error = qMax(error, qAbs(a.constData()[i] - b.constData()[i]));
+        }
+        const bool matches = direct.rotation() == coalesced.rotation() && error < 1e-4f;
+        qInfo().noquote() << QString("Input replay: %1 events, %2 camera updates per event "
+            "vs %3 frames, final state %4 (max error %5)").arg(accumulator.receivedEvents())
+            .arg(directUpdates).arg(frames).arg(matches ? "matches" : "DIFFERS")
+            .arg(error, 0, 'g', 3);
+        return matches;
+    }
+
+    // A 10 pixel move 10 ms after the previous event, with a frame 4 ms
+    // in: 4 pixels belong to that frame, the other 6 to the next one
+    bool splitAtFrame()
+    {
+        OrbitControls controls(5.f, QVector2D(30.f, 0.f), QVector2D(0.f, 0.f));
+        controls.resize(500, 500);
+        CameraInputAccumulator accumulator(&controls);
+        const float degreesPerPixel = controls.degreesPerPixel().y();
+
+        accumulator.startCameraRotation(100, 100, 10);
+        accumulator.mouseMove(110, 100, 20);
+        accumulator.apply(14);
+        const float first = controls.rotation().y();
+        const bool kept = accumulator.pendingCount() == 1;
+        accumulator.apply(30);
+        const float second = controls.rotation().y();
+
+        const bool ok = kept && qAbs(first - 4.f * degreesPerPixel) < 1e-4f &&
+            qAbs(second - 10.f * degreesPerPixel) < 1e-4f;
+        qInfo().noquote() << QString("Frame boundary split: %1 then %2 degrees, %3")
+            .arg(first, 0, 'f', 3).arg(second, 0, 'f', 3).arg(ok ? "ok" : "WRONG");
+        return ok;
+    }
+}
+
+int runOrbitControlsBenchmark()
+{
+    replay("Rotation", false);
+    replay("Panning", true);
+    const bool coalescedOk = replayCoalesced();
+    const bool splitOk = splitAtFrame();
+    return coalescedOk && splitOk ? 0 : 1;
+}
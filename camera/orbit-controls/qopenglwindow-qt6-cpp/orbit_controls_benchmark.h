@@ -0,0 +1,14 @@
+#ifndef ORBIT_CONTROLS_BENCHMARK_H
+#define ORBIT_CONTROLS_BENCHMARK_H
+
+// Feeds one second of 1000 Hz mouse input (rotation, then panning) into
+// OrbitControls while a 60 Hz "display" asks for the projection-view
+// matrix, and prints how many matrix rebuilds the caching avoided
+// compared to recomputing on every call. Then replays recorded input
+// through CameraInputAccumulator, summed into one update per frame, and
+// checks that the camera ends up where per-event updates put it and that
+// a frame between two moves gets its share of the later one. Returns a
+// process exit code.
+int runOrbitControlsBenchmark();
+
+#endif // ORBIT_CONTROLS_BENCHMARK_H
@@ -0,0 +1,22 @@
+#include "physics_scene.h"
+
+void fillPhysicsScene(PhysicsScene3D *scene, int bodyCount)
+{
+    const int columns = 16;
+    const float size = 0.4f;
+    const float spacing = 0.6f;
+
+    scene->addGround(0.f, physicsGroundSize / 2.f);
+    for (int i = 0; i < bodyCount; ++i)
+    {
+        const int layer = i / (columns * columns);
+        const int x = i % columns;
+        const int z = (i / columns) % columns;
+        // Odd layers are shifted so the bodies do not land on each other
+        const float offset = (layer % 2) * spacing / 2.f;
+        const QVector3D position((x - columns / 2.f) * spacing + offset,
+            2.f + layer * spacing, (z - columns / 2.f) * spacing + offset);
+        scene->addBody(i % 2 ? PhysicsScene3D::Shape::Sphere : PhysicsScene3D::Shape::Box,
+            position, size);
+    }
+}
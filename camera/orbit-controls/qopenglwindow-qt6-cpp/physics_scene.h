@@ -0,0 +1,13 @@
+#ifndef PHYSICS_SCENE_H
+#define PHYSICS_SCENE_H
+
+#include "physics_scene_3d.h"
+
+// Extent of the ground plane, centered at the origin
+const float physicsGroundSize = 20.f;
+
+// Ground plus bodyCount boxes and spheres stacked in a column above it,
+// the scene shown by the window and stepped by the benchmark
+void fillPhysicsScene(PhysicsScene3D *scene, int bodyCount);
+
+#endif // PHYSICS_SCENE_H
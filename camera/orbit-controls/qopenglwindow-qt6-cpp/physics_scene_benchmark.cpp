@@ -0,0 +1,53 @@
+#include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QThread>
+
+#include "physics_scene.h"
+#include "physics_scene_3d.h"
+#include "physics_scene_benchmark.h"
+
+namespace
+{
+    const int measuredSteps = 240;
+    const float stepDt = 1.f / 60.f;
+}
+
+int runPhysicsSceneBenchmark()
+{
+    const int bodyCounts[] = { 2000, 8000 };
+    const int threadCounts[] = { 1, QThread::idealThreadCount() };
+    for (int bodyCount : bodyCounts)
+    {
+        for (int threadCount : threadCounts)
+        {
+            PhysicsScene3D scene(threadCount);
+            fillPhysicsScene(&scene, bodyCount);
+
+            PhysicsScene3D::Timings sum;
+            double instancesMs = 0.0;
+            QElapsedTimer timer;
+            for (int i = 0; i < measuredSteps; ++i)
+            {
+                timer.start();
+                scene.step(stepDt, 1, stepDt);
+                const PhysicsScene3D::Timings &timings = scene.timings();
+                instancesMs += timer.nsecsElapsed() / 1e6 - timings.totalMs;
+                sum.broadphaseMs += timings.broadphaseMs;
+                sum.narrowphaseMs += timings.narrowphaseMs;
+                sum.solveMs += timings.solveMs;
+                sum.totalMs += timings.totalMs;
+            }
+
+            qInfo().noquote() << QString("%1 bodies, %2 threads: broadphase %3 ms, "
+                "narrowphase %4 ms, solve %5 ms, step %6 ms, instances %7 ms, %8 active")
+                .arg(bodyCount, 4).arg(scene.threadCount(), 2)
+                .arg(sum.broadphaseMs / measuredSteps, 0, 'f', 3)
+                .arg(sum.narrowphaseMs / measuredSteps, 0, 'f', 3)
+                .arg(sum.solveMs / measuredSteps, 0, 'f', 3)
+                .arg(sum.totalMs / measuredSteps, 0, 'f', 3)
+                .arg(instancesMs / measuredSteps, 0, 'f', 3)
+                .arg(scene.activeCount());
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,10 @@
+#ifndef PHYSICS_SCENE_BENCHMARK_H
+#define PHYSICS_SCENE_BENCHMARK_H
+
+// Drops 2k and 8k boxes and spheres onto the ground with one thread and
+// with every core, without a window or an OpenGL context, and prints the
+// average broadphase, narrowphase and solver time per step and the time
+// to refresh the instance matrices. Returns a process exit code.
+int runPhysicsSceneBenchmark();
+
+#endif // PHYSICS_SCENE_BENCHMARK_H
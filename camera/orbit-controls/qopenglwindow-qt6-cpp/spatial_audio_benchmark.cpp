@@ -0,0 +1,123 @@
+#include <QtCore/QDebug>
+#include <QtCore/QRandomGenerator>
+#include <QtCore/QtMath>
+
+#include <memory>
+#include <vector>
+
+#include "audio_engine.h"
+#include "orbit_controls.h"
+#include "spatial_audio_benchmark.h"
+#include "tone_stream.h"
+
+namespace
+{
+    const int sampleRate = 44100;
+    // One mixer period, about 11.6 ms
+    const int blockFrames = 512;
+    const int blockCount = 2000;
+    const int effectsPerBlock = 4;
+    const int streamCount = 8;
+    const int clipCount = 8;
+    const int clipFrames = sampleRate / 5;
+    // Effects start anywhere over the physics scene's ground
+    const float groundSize = 20.f;
+}
+
+int runSpatialAudioBenchmark()
+{
+    const int voiceCounts[] = { 16, 64 };
+    for (int voiceCount : voiceCounts)
+    {
+        AudioEngine engine(voiceCount);
+        if (!engine.open(AudioEngine::Device::Loopback, sampleRate))
+        {
+            return 1;
+        }
+
+        // Short effects are uploaded once and played from memory
+        std::vector<ALuint> clips;
+        std::vector<qint16> pcm(clipFrames);
+        for (int clip = 0; clip < clipCount; ++clip)
+        {
+            ToneStream tone(220.f + 110.f * clip, sampleRate, clipFrames);
+            tone.read(pcm.data(), clipFrames);
+            clips.push_back(engine.createBuffer(pcm.data(), clipFrames, 1, sampleRate));
+        }
+
+        // Endless loops in a ring around the pile, above every effect
+        AudioEngine::VoiceParams loop;
+        loop.priority = 10;
+        loop.looping = true;
+        loop.referenceDistance = 4.f;
+        for (int stream = 0; stream < streamCount; ++stream)
+        {
+            const float angle = 2.f * float(M_PI) * stream / streamCount;
+            loop.position = QVector3D(8.f * qCos(angle), 1.f, 8.f * qSin(angle));
+            engine.playStream(std::make_unique<ToneStream>(110.f + 20.f * stream, sampleRate),
+                loop);
+        }
+
+        // The window's camera, orbiting the scene
+        OrbitControls controls(22.f, QVector2D(30.f, 0.f), QVector2D(0.f, 0.f));
+        controls.setPerspective(50.f, 0.01f, 100.f);
+        controls.resize(500, 500);
+        controls.startCameraRotation(0, 0);
+
+        QRandomGenerator random(42);
+        std::vector<qint16> output(blockFrames * 2);
+        quint64 listenerVersion = ~0ull;
+        int listenerUpdates = 0;
+        int peakVoices = 0;
+        int peakStreaming = 0;
+        int peakBacklog = 0;
+        for (int block = 0; block < blockCount; ++block)
+        {
+            controls.mouseMove(block, 0);
+            if (controls.version() != listenerVersion)
+            {
+                engine.setListener(controls.getCameraPosition(), controls.getBackVector(),
+                    controls.getUpVector());
+                listenerVersion = controls.version();
+                listenerUpdates++;
+            }
+
+            for (int effect = 0; effect < effectsPerBlock; ++effect)
+            {
+                AudioEngine::VoiceParams params;
+                params.position = QVector3D(
+                    random.bounded(groundSize) - groundSize / 2.f,
+                    random.bounded(4.f),
+                    random.bounded(groundSize) - groundSize / 2.f);
+                params.priority = int(random.bounded(4.f));
+                params.gain = 0.2f + random.bounded(0.8f);
+                engine.play(clips[int(random.bounded(float(clipCount))) % clipCount], params);
+            }
+
+            engine.update();
+            engine.render(output.data(), blockFrames);
+            peakVoices = qMax(peakVoices, engine.stats().activeVoices);
+            peakStreaming = qMax(peakStreaming, engine.stats().streamingVoices);
+            peakBacklog = qMax(peakBacklog, engine.stats().decodeBacklog);
+        }
+
+        const AudioEngine::Stats &stats = engine.stats();
+        const double audioMs = stats.mixedFrames * 1000.0 / sampleRate;
+        qInfo().noquote() << QString("%1 voices: %2 ms mixing for %3 ms of audio "
+            "(%4x real time), %5 ms in update() per block, %6 listener updates")
+            .arg(stats.voices, 2).arg(stats.mixMs, 0, 'f', 1).arg(audioMs, 0, 'f', 0)
+            .arg(audioMs / stats.mixMs, 0, 'f', 1).arg(stats.updateMs / blockCount, 0, 'f', 4)
+            .arg(listenerUpdates);
+        qInfo().noquote() << QString("    peak %1 voices (%2 streamed), %3 started, "
+            "%4 stolen, %5 rejected, peak decode backlog %6 slabs, %7 underruns")
+            .arg(peakVoices).arg(peakStreaming).arg(stats.started).arg(stats.stolen)
+            .arg(stats.rejected).arg(peakBacklog).arg(stats.underruns);
+
+        for (ALuint clip : clips)
+        {
+            engine.deleteBuffer(clip);
+        }
+        engine.close();
+    }
+    return 0;
+}
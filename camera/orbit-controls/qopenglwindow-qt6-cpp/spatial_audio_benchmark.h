@@ -0,0 +1,14 @@
+#ifndef SPATIAL_AUDIO_BENCHMARK_H
+#define SPATIAL_AUDIO_BENCHMARK_H
+
+// Mixes about 23 s of audio on OpenAL Soft's loopback device, with 8
+// streamed loops and 4 short effects started per 512-frame block while
+// the orbit camera moves the listener. Prints mixing time against real
+// time, peak voice count, stolen and rejected voices and the decode
+// backlog for pools of 16 and 64 voices. Mixing runs far ahead of real
+// time, so underruns count the blocks the decode thread fell behind.
+// Returns a process exit code, 1 when the loopback device is not
+// available.
+int runSpatialAudioBenchmark();
+
+#endif // SPATIAL_AUDIO_BENCHMARK_H
@@ -0,0 +1,13 @@
+isEmpty(CULLING_PRI) {
+CULLING_PRI = 1
+
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/culling_bvh.h \
+    $$PWD/frustum.h
+
+SOURCES += \
+    $$PWD/culling_bvh.cpp \
+    $$PWD/frustum.cpp
+}
@@ -0,0 +1,263 @@
+#include <QtCore/QtGlobal>
+
+#include <algorithm>
+#include <cmath>
+
+#include "culling_bvh.h"
+
+CullingBvh::CullingBvh(float margin)
+    : m_margin(margin)
+{
+}
+
+void CullingBvh::build(const float *centers, const float *extents, int count)
+{
+    m_ids.resize(count);
+    for (int i = 0; i < count; ++i)
+    {
+        m_ids[i] = i;
+    }
+    // Build order while splitting, tree order afterwards
+    m_centers.assign(centers, centers + count * 3);
+
+    m_nodes.clear();
+    m_parents.clear();
+    m_leafOfSlot.assign(count, -1);
+    m_dirtyLeaves.clear();
+    if (count > 0)
+    {
+        m_nodes.reserve(2 * (count / maxLeafSize) + 1);
+        m_nodes.resize(1);
+        m_parents.assign(1, -1);
+        buildNode(0, 0, count);
+    }
+    m_leafDirty.assign(m_nodes.size(), 0);
+
+    m_extents.resize(count * 3);
+    m_slots.resize(count);
+    for (int slot = 0; slot < count; ++slot)
+    {
+        const int id = m_ids[slot];
+        std::copy(centers + id * 3, centers + id * 3 + 3, &m_centers[slot * 3]);
+        std::copy(extents + id * 3, extents + id * 3 + 3, &m_extents[slot * 3]);
+        m_slots[id] = slot;
+    }
+
+    // Children always come after their parent
+    for (int i = int(m_nodes.size()) - 1; i >= 0; --i)
+    {
+        Node &node = m_nodes[i];
+        if (node.child < 0)
+        {
+            fitLeaf(&node);
+            continue;
+        }
+        const Node &a = m_nodes[node.child];
+        const Node &b = m_nodes[node.child + 1];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            node.min[axis] = qMin(a.min[axis], b.min[axis]);
+            node.max[axis] = qMax(a.max[axis], b.max[axis]);
+        }
+    }
+}
+
+// Median split along the longest axis of the object centers
+void CullingBvh::buildNode(int index, int first, int count)
+{
+    m_nodes[index].first = first;
+    m_nodes[index].count = count;
+    m_nodes[index].child = -1;
+    if (count <= maxLeafSize)
+    {
+        std::fill(m_leafOfSlot.begin() + first, m_leafOfSlot.begin() + first + count, index);
+        return;
+    }
+
+    float lo[3] = { INFINITY, INFINITY, INFINITY };
+    float hi[3] = { -INFINITY, -INFINITY, -INFINITY };
+    for (int slot = first; slot < first + count; ++slot)
+    {
+        const float *center = &m_centers[m_ids[slot] * 3];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            lo[axis] = qMin(lo[axis], center[axis]);
+            hi[axis] = qMax(hi[axis], center[axis]);
+        }
+    }
+    int axis = 0;
+    for (int a = 1; a < 3; ++a)
+    {
+        if (hi[a] - lo[a] > hi[axis] - lo[axis])
+        {
+            axis = a;
+        }
+    }
+
+    const int half = count / 2;
+    const float *centers = m_centers.data();
+    std::nth_element(m_ids.begin() + first, m_ids.begin() + first + half,
+        m_ids.begin() + first + count, [centers, axis](int a, int b)
+    {
+        return centers[a * 3 + axis] < centers[b * 3 + axis];
+    });
+
+    // Siblings are allocated together so that they stay adjacent
+    const int child = int(m_nodes.size());
+    m_nodes[index].child = child;
+    m_nodes.resize(child + 2);
+    m_parents.resize(child + 2, index);
+    buildNode(child, first, half);
+    buildNode(child + 1, first + half, count - half);
+}
+
+void CullingBvh::fitLeaf(Node *node)
+{
+    float lo[3] = { INFINITY, INFINITY, INFINITY };
+    float hi[3] = { -INFINITY, -INFINITY, -INFINITY };
+    for (int slot = node->first; slot < node->first + node->count; ++slot)
+    {
+        const float *center = &m_centers[slot * 3];
+        const float *extent = &m_extents[slot * 3];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            lo[axis] = qMin(lo[axis], center[axis] - extent[axis]);
+            hi[axis] = qMax(hi[axis], center[axis] + extent[axis]);
+        }
+    }
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        node->min[axis] = lo[axis] - m_margin;
+        node->max[axis] = hi[axis] + m_margin;
+    }
+}
+
+void CullingBvh::update(int id, const float *center, const float *extent)
+{
+    const int slot = m_slots[id];
+    std::copy(center, center + 3, &m_centers[slot * 3]);
+    std::copy(extent, extent + 3, &m_extents[slot * 3]);
+
+    const int leaf = m_leafOfSlot[slot];
+    if (m_leafDirty[leaf])
+    {
+        return;
+    }
+    const Node &node = m_nodes[leaf];
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        if (center[axis] - extent[axis] < node.min[axis] ||
+            center[axis] + extent[axis] > node.max[axis])
+        {
+            m_leafDirty[leaf] = 1;
+            m_dirtyLeaves.push_back(leaf);
+            return;
+        }
+    }
+}
+
+void CullingBvh::refit()
+{
+    m_stats.leavesRefitted = int(m_dirtyLeaves.size());
+    for (int leaf : m_dirtyLeaves)
+    {
+        m_leafDirty[leaf] = 0;
+        fitLeaf(&m_nodes[leaf]);
+
+        // Parents are recomputed exactly, so they shrink as well as grow;
+        // the walk stops at the first one that does not change
+        for (int index = m_parents[leaf]; index >= 0; index = m_parents[index])
+        {
+            Node &node = m_nodes[index];
+            const Node &a = m_nodes[node.child];
+            const Node &b = m_nodes[node.child + 1];
+            bool changed = false;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                const float lo = qMin(a.min[axis], b.min[axis]);
+                const float hi = qMax(a.max[axis], b.max[axis]);
+                changed = changed || lo != node.min[axis] || hi != node.max[axis];
+                node.min[axis] = lo;
+                node.max[axis] = hi;
+            }
+            if (!changed)
+            {
+                break;
+            }
+        }
+    }
+    m_dirtyLeaves.clear();
+}
+
+void CullingBvh::cull(const Frustum &frustum, int planeMask, std::vector<int> *visible)
+{
+    const int leavesRefitted = m_stats.leavesRefitted;
+    m_stats = Stats();
+    m_stats.leavesRefitted = leavesRefitted;
+    if (m_nodes.empty())
+    {
+        return;
+    }
+    const size_t visibleBefore = visible->size();
+
+    // Node index and the planes its box still straddles
+    m_stack.clear();
+    m_stack.push_back(0);
+    m_stack.push_back(planeMask);
+    while (!m_stack.empty())
+    {
+        int mask = m_stack.back();
+        m_stack.pop_back();
+        const Node &node = m_nodes[m_stack.back()];
+        m_stack.pop_back();
+        m_stats.nodesVisited++;
+
+        const float center[3] = {
+            (node.min[0] + node.max[0]) * 0.5f,
+            (node.min[1] + node.max[1]) * 0.5f,
+            (node.min[2] + node.max[2]) * 0.5f
+        };
+        const float extent[3] = {
+            (node.max[0] - node.min[0]) * 0.5f,
+            (node.max[1] - node.min[1]) * 0.5f,
+            (node.max[2] - node.min[2]) * 0.5f
+        };
+        const Frustum::Result result = frustum.test(center, extent, &mask);
+        if (result == Frustum::Result::Outside)
+        {
+            m_stats.culled += node.count;
+            continue;
+        }
+        if (result == Frustum::Result::Inside)
+        {
+            visible->insert(visible->end(), m_ids.begin() + node.first,
+                m_ids.begin() + node.first + node.count);
+            continue;
+        }
+        if (node.child >= 0)
+        {
+            m_stack.push_back(node.child);
+            m_stack.push_back(mask);
+            m_stack.push_back(node.child + 1);
+            m_stack.push_back(mask);
+            continue;
+        }
+
+        // Boundary leaf, test its objects against the remaining planes
+        m_stats.objectsTested += node.count;
+        for (int slot = node.first; slot < node.first + node.count; ++slot)
+        {
+            int objectMask = mask;
+            if (frustum.test(&m_centers[slot * 3], &m_extents[slot * 3], &objectMask) !=
+                Frustum::Result::Outside)
+            {
+                visible->push_back(m_ids[slot]);
+            }
+            else
+            {
+                m_stats.culled++;
+            }
+        }
+    }
+    m_stats.submitted = int(visible->size() - visibleBefore);
+}
@@ -0,0 +1,82 @@
+#ifndef CULLING_BVH_H
+#define CULLING_BVH_H
+
+#include <vector>
+
+#include "frustum.h"
+
+// Bounding volume hierarchy over axis-aligned boxes for frustum culling.
+// Objects are identified by their index at build() time and stored in
+// tree order, so every subtree covers a contiguous range of objects: a
+// subtree fully inside the frustum is emitted without testing its
+// objects, one fully outside is skipped, and only leaves on the frustum
+// boundary test their objects one by one.
+//
+// The tree is loose: leaf bounds are padded by a margin. update() only
+// marks a leaf dirty when an object leaves its padded bounds, and
+// refit() recomputes the dirty leaves and the nodes above them until
+// nothing changes. The topology is kept; call build() again when
+// objects are added or have moved far from where the tree was built.
+class CullingBvh
+{
+
+public:
+    struct Stats
+    {
+        int nodesVisited = 0;
+        int objectsTested = 0;
+        int submitted = 0;
+        int culled = 0;
+        int leavesRefitted = 0;
+    };
+
+    static constexpr int maxLeafSize = 16;
+
+    explicit CullingBvh(float margin = 0.f);
+
+    // center and extent hold 3 floats per object: box center and half size
+    void build(const float *centers, const float *extents, int count);
+    void update(int id, const float *center, const float *extent);
+    void refit();
+
+    // Appends the ids of the objects that may be visible
+    void cull(const Frustum &frustum, int planeMask, std::vector<int> *visible);
+
+    int objectCount() const { return int(m_ids.size()); }
+    // Counters of the last refit() and cull()
+    const Stats &stats() const { return m_stats; }
+
+private:
+    struct Node
+    {
+        float min[3];
+        float max[3];
+        // Objects first .. first + count - 1 in tree order
+        int first;
+        int count;
+        // Children are child and child + 1, -1 for leaves
+        int child;
+    };
+
+    void buildNode(int index, int first, int count);
+    void fitLeaf(Node *node);
+
+    float m_margin;
+    std::vector<Node> m_nodes;
+    std::vector<int> m_parents;
+    std::vector<int> m_leafOfSlot;
+    std::vector<char> m_leafDirty;
+    std::vector<int> m_dirtyLeaves;
+    std::vector<int> m_stack;
+
+    // Per slot in tree order
+    std::vector<int> m_ids;
+    std::vector<float> m_centers;
+    std::vector<float> m_extents;
+    // Slot of every id
+    std::vector<int> m_slots;
+
+    Stats m_stats;
+};
+
+#endif // CULLING_BVH_H
@@ -0,0 +1,68 @@
+#include <QtCore/QtMath>
+
+#include <cmath>
+
+#include "frustum.h"
+
+Frustum::Frustum()
+{
+    // Accepts everything
+    for (float *plane : m_planes)
+    {
+        plane[0] = plane[1] = plane[2] = 0.f;
+        plane[3] = 1.f;
+    }
+}
+
+Frustum::Frustum(const QMatrix4x4 &projViewMatrix)
+{
+    const QVector4D rows[4] = {
+        projViewMatrix.row(0), projViewMatrix.row(1),
+        projViewMatrix.row(2), projViewMatrix.row(3)
+    };
+    const QVector4D planes[6] = {
+        rows[3] + rows[0],
+        rows[3] - rows[0],
+        rows[3] + rows[1],
+        rows[3] - rows[1],
+        rows[3] + rows[2],
+        rows[3] - rows[2]
+    };
+    for (int p = 0; p < 6; ++p)
+    {
+        const float length = planes[p].toVector3D().length();
+        const QVector4D plane = length > 0.f ? planes[p] / length : planes[p];
+        m_planes[p][0] = plane.x();
+        m_planes[p][1] = plane.y();
+        m_planes[p][2] = plane.z();
+        m_planes[p][3] = plane.w();
+    }
+}
+
+Frustum::Result Frustum::test(const float *center, const float *extent, int *planeMask) const
+{
+    int mask = *planeMask;
+    for (int p = 0; p < 6; ++p)
+    {
+        if (!(mask & (1 << p)))
+        {
+            continue;
+        }
+        const float *plane = m_planes[p];
+        const float distance = plane[0] * center[0] + plane[1] * center[1] +
+            plane[2] * center[2] + plane[3];
+        // Distance from the center to the box corner nearest to the plane
+        const float radius = std::abs(plane[0]) * extent[0] +
+            std::abs(plane[1]) * extent[1] + std::abs(plane[2]) * extent[2];
+        if (distance < -radius)
+        {
+            return Result::Outside;
+        }
+        if (distance >= radius)
+        {
+            mask &= ~(1 << p);
+        }
+    }
+    *planeMask = mask;
+    return mask == 0 ? Result::Inside : Result::Intersects;
+}
@@ -0,0 +1,49 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <QtGui/QMatrix4x4>
+
+// The six clip planes of a projection-view matrix (Gribb and Hartmann),
+// normalized and pointing inwards. Works for perspective and orthographic
+// projections alike.
+class Frustum
+{
+
+public:
+    enum Plane
+    {
+        Left,
+        Right,
+        Bottom,
+        Top,
+        Near,
+        Far
+    };
+    static constexpr int allPlanes = 0x3F;
+    // For flat scenes that sit on the near or far plane, such as the
+    // fit-scale world
+    static constexpr int sidePlanes = 0x0F;
+
+    enum class Result
+    {
+        Outside,
+        Intersects,
+        Inside
+    };
+
+    Frustum();
+    explicit Frustum(const QMatrix4x4 &projViewMatrix);
+
+    // Box as center and half extents. Only the planes in *planeMask are
+    // tested; on return it holds the planes the box straddles, which are
+    // all that children of the box need to test.
+    Result test(const float *center, const float *extent, int *planeMask) const;
+
+    // a, b, c, d of plane p, inside where a x + b y + c z + d >= 0
+    const float *plane(int p) const { return m_planes[p]; }
+
+private:
+    float m_planes[6][4];
+};
+
+#endif // FRUSTUM_H
@@ -0,0 +1,94 @@
+#include <QtCore/QtMath>
+
+#include "damage_tracker.h"
+
+DamageTracker::DamageTracker(int maxRects)
+    : m_maxRects(qMax(1, maxRects))
+{
+}
+
+void DamageTracker::setMapping(const QSize &deviceSize, const QRect &viewport,
+    float worldWidth, float worldHeight)
+{
+    m_deviceSize = deviceSize;
+    m_viewport = viewport;
+    m_scaleX = viewport.width() / worldWidth;
+    m_scaleY = viewport.height() / worldHeight;
+    m_rects.clear();
+    m_full = true;
+}
+
+void DamageTracker::addWorldRect(const QRectF &rect)
+{
+    if (m_full || rect.isEmpty())
+    {
+        return;
+    }
+    // World and device y both point up. Grown by a pixel for the linear
+    // filtering at the edges.
+    const int left = m_viewport.x() + qFloor(rect.x() * m_scaleX) - 1;
+    const int bottom = m_viewport.y() + qFloor(rect.y() * m_scaleY) - 1;
+    const int right = m_viewport.x() + qCeil((rect.x() + rect.width()) * m_scaleX) + 1;
+    const int top = m_viewport.y() + qCeil((rect.y() + rect.height()) * m_scaleY) + 1;
+    // Nothing is drawn outside the world area
+    const QRect device = QRect(left, bottom, right - left, top - bottom).intersected(m_viewport);
+    if (!device.isEmpty())
+    {
+        addDeviceRect(device);
+    }
+}
+
+void DamageTracker::addDeviceRect(QRect rect)
+{
+    // A merged rectangle may reach others, start over until none overlap
+    for (size_t i = 0; i < m_rects.size();)
+    {
+        if (m_rects[i].intersects(rect))
+        {
+            rect = rect.united(m_rects[i]);
+            m_rects[i] = m_rects.back();
+            m_rects.pop_back();
+            i = 0;
+            continue;
+        }
+        ++i;
+    }
+    m_rects.push_back(rect);
+    if (int(m_rects.size()) > m_maxRects)
+    {
+        QRect bounds;
+        for (const QRect &r : m_rects)
+        {
+            bounds = bounds.united(r);
+        }
+        m_rects.assign(1, bounds);
+    }
+}
+
+bool DamageTracker::takeFrame(std::vector<QRect> *rects)
+{
+    const bool full = m_full;
+    rects->clear();
+    if (full)
+    {
+        rects->push_back(QRect(QPoint(0, 0), m_deviceSize));
+    }
+    else
+    {
+        rects->swap(m_rects);
+    }
+    m_rects.clear();
+    m_full = false;
+
+    qint64 pixels = 0;
+    for (const QRect &rect : *rects)
+    {
+        pixels += qint64(rect.width()) * rect.height();
+    }
+    m_stats.frames++;
+    m_stats.fullFrames += full;
+    m_stats.pixels += pixels;
+    m_stats.lastPixels = pixels;
+    m_stats.lastRects = int(rects->size());
+    return full;
+}
@@ -0,0 +1,63 @@
+#ifndef DAMAGE_TRACKER_H
+#define DAMAGE_TRACKER_H
+
+#include <QtCore/QRect>
+#include <QtCore/QRectF>
+#include <QtCore/QSize>
+
+#include <vector>
+
+// Collects the world rectangles that changed since the last frame of a
+// 2D scene and turns them into device rectangles to scissor the redraw
+// to. World (0, 0) - (worldWidth, worldHeight) maps onto the letterbox
+// viewport the same way the scene's projection does. The rest of the
+// frame has to survive from the previous one, so the window needs a
+// preserved back buffer or an FBO that is blitted to it, such as
+// QOpenGLWindow::PartialUpdateBlit.
+//
+// Overlapping rectangles are merged, more than maxRects are merged into
+// their bounds. A new mapping or invalidate() makes the next frame a
+// full one.
+class DamageTracker
+{
+
+public:
+    struct Stats
+    {
+        quint64 frames = 0;
+        quint64 fullFrames = 0;
+        // Pixels inside the redrawn rectangles
+        qint64 pixels = 0;
+        qint64 lastPixels = 0;
+        int lastRects = 0;
+    };
+
+    explicit DamageTracker(int maxRects = 8);
+
+    void setMapping(const QSize &deviceSize, const QRect &viewport, float worldWidth,
+        float worldHeight);
+    void addWorldRect(const QRectF &rect);
+    void invalidate() { m_full = true; }
+
+    bool hasDamage() const { return m_full || !m_rects.empty(); }
+    // Moves this frame's device rectangles to rects. Returns true when the
+    // whole window has to be redrawn, rects then holds the window.
+    bool takeFrame(std::vector<QRect> *rects);
+
+    QSize deviceSize() const { return m_deviceSize; }
+    const Stats &stats() const { return m_stats; }
+
+private:
+    void addDeviceRect(QRect rect);
+
+    int m_maxRects;
+    QSize m_deviceSize;
+    QRect m_viewport;
+    float m_scaleX = 1.f;
+    float m_scaleY = 1.f;
+    bool m_full = true;
+    std::vector<QRect> m_rects;
+    Stats m_stats;
+};
+
+#endif // DAMAGE_TRACKER_H
@@ -0,0 +1,11 @@
+isEmpty(DAMAGE_TRACKING_PRI) {
+DAMAGE_TRACKING_PRI = 1
+
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/damage_tracker.h
+
+SOURCES += \
+    $$PWD/damage_tracker.cpp
+}
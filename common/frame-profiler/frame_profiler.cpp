@@ -0,0 +1,252 @@
+#include "frame_profiler.h"
+
+#ifdef FRAME_PROFILER
+
+#include <QtCore/QDebug>
+#include <QtCore/QFile>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+
+#include <cstring>
+
+namespace
+{
+    const int cpuThreadId = 1;
+    const int gpuThreadId = 2;
+
+    QJsonObject traceEvent(const char *name, int threadId, qint64 startNs, double durationUs)
+    {
+        QJsonObject event;
+        event.insert("name", name);
+        event.insert("ph", "X");
+        event.insert("pid", 1);
+        event.insert("tid", threadId);
+        event.insert("ts", startNs / 1e3);
+        event.insert("dur", durationUs);
+        return event;
+    }
+
+    QJsonObject threadName(int threadId, const char *name)
+    {
+        QJsonObject args;
+        args.insert("name", name);
+        QJsonObject event;
+        event.insert("name", "thread_name");
+        event.insert("ph", "M");
+        event.insert("pid", 1);
+        event.insert("tid", threadId);
+        event.insert("args", args);
+        return event;
+    }
+}
+
+FrameProfiler *FrameProfiler::instance()
+{
+    static FrameProfiler profiler;
+    return &profiler;
+}
+
+FrameProfiler::FrameProfiler()
+    : m_frames(ringSize)
+{
+    m_clock.start();
+}
+
+void FrameProfiler::beginFrame()
+{
+    // Hosts without frameSwapped (offscreen rendering) never end frames,
+    // the next frame does it for them
+    if (m_frameOpen)
+    {
+        endFrame();
+    }
+
+    const quint64 index = m_publishedFrames.load(std::memory_order_relaxed);
+    FrameRecord &frame = m_frames[index % ringSize];
+    frame.index = index;
+    frame.startNs = now();
+    frame.durationNs = 0;
+    frame.scopeCount = 0;
+    m_frameOpen = true;
+    m_swapSlot = -1;
+}
+
+void FrameProfiler::beginSwap()
+{
+    m_swapSlot = beginScope("swap", false);
+}
+
+void FrameProfiler::endFrame()
+{
+    if (!m_frameOpen)
+    {
+        return;
+    }
+    if (m_swapSlot >= 0)
+    {
+        endScope(m_swapSlot);
+        m_swapSlot = -1;
+    }
+
+    const quint64 index = m_publishedFrames.load(std::memory_order_relaxed);
+    FrameRecord &frame = m_frames[index % ringSize];
+    frame.durationNs = now() - frame.startNs;
+    m_frameOpen = false;
+    m_publishedFrames.store(index + 1, std::memory_order_release);
+
+    collectGpuTimes(false);
+}
+
+int FrameProfiler::beginScope(const char *name, bool gpu)
+{
+    const quint64 index = m_publishedFrames.load(std::memory_order_relaxed);
+    FrameRecord &frame = m_frames[index % ringSize];
+    if (!m_frameOpen || frame.scopeCount == maxScopes)
+    {
+        return -1;
+    }
+
+    const int slot = frame.scopeCount++;
+    frame.scopes[slot] = { name, now(), 0, -1.0 };
+
+    if (gpu && !m_openGpuSection)
+    {
+        GpuSection *section = gpuSection(name);
+        if (section->timer.begin())
+        {
+            m_openGpuSection = section;
+            m_openGpuSlot = slot;
+        }
+    }
+    return slot;
+}
+
+void FrameProfiler::endScope(int slot)
+{
+    if (slot < 0 || !m_frameOpen)
+    {
+        return;
+    }
+    const quint64 index = m_publishedFrames.load(std::memory_order_relaxed);
+    FrameRecord &frame = m_frames[index % ringSize];
+    ScopeRecord &scope = frame.scopes[slot];
+    scope.durationNs = now() - scope.startNs;
+
+    if (m_openGpuSection && m_openGpuSlot == slot)
+    {
+        m_openGpuSection->timer.end();
+        m_openGpuSection->targets.emplace_back(index, slot);
+        m_openGpuSection = nullptr;
+        m_openGpuSlot = -1;
+    }
+}
+
+int FrameProfiler::recentFrameTimes(float *ms, int maxCount) const
+{
+    const quint64 published = m_publishedFrames.load(std::memory_order_acquire);
+    // The oldest slot may be rewritten by the render thread right now
+    const int count = int(qMin<quint64>(qMin<quint64>(maxCount, published), ringSize - 1));
+    for (int i = 0; i < count; ++i)
+    {
+        ms[i] = m_frames[(published - count + i) % ringSize].durationNs / 1e6f;
+    }
+    return count;
+}
+
+bool FrameProfiler::exportChromeTrace(const QString &path) const
+{
+    const quint64 published = m_publishedFrames.load(std::memory_order_acquire);
+    const quint64 first = published > ringSize - 1 ? published - (ringSize - 1) : 0;
+
+    QJsonArray events;
+    events.append(threadName(cpuThreadId, "CPU"));
+    events.append(threadName(gpuThreadId, "GPU"));
+    for (quint64 index = first; index < published; ++index)
+    {
+        const FrameRecord &frame = m_frames[index % ringSize];
+        events.append(traceEvent("frame", cpuThreadId, frame.startNs, frame.durationNs / 1e3));
+        for (int i = 0; i < frame.scopeCount; ++i)
+        {
+            const ScopeRecord &scope = frame.scopes[i];
+            events.append(traceEvent(scope.name, cpuThreadId, scope.startNs,
+                scope.durationNs / 1e3));
+            // Timer queries only give a duration, show it where the
+            // commands were submitted
+            if (scope.gpuMs >= 0.0)
+            {
+                events.append(traceEvent(scope.name, gpuThreadId, scope.startNs,
+                    scope.gpuMs * 1e3));
+            }
+        }
+    }
+
+    QJsonObject root;
+    root.insert("traceEvents", events);
+    root.insert("displayTimeUnit", "ms");
+
+    QFile file(path);
+    if (!file.open(QIODevice::OpenModeFlag::WriteOnly))
+    {
+        qWarning() << "Failed to write" << path;
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::JsonFormat::Compact));
+    return true;
+}
+
+void FrameProfiler::exportFromArguments(const QStringList &arguments) const
+{
+    const int index = arguments.indexOf("--trace");
+    if (index >= 0 && index + 1 < arguments.size())
+    {
+        exportChromeTrace(arguments[index + 1]);
+    }
+}
+
+FrameProfiler::GpuSection *FrameProfiler::gpuSection(const char *name)
+{
+    for (GpuSection &section : m_gpuSections)
+    {
+        if (section.name == name || std::strcmp(section.name, name) == 0)
+        {
+            return &section;
+        }
+    }
+    // Created on first use, when the render context is current
+    m_gpuSections.emplace_back();
+    GpuSection &section = m_gpuSections.back();
+    section.name = name;
+    section.timer.initialize();
+    return &section;
+}
+
+void FrameProfiler::collectGpuTimes(bool wait)
+{
+    const quint64 published = m_publishedFrames.load(std::memory_order_relaxed);
+    std::vector<double> results;
+    for (GpuSection &section : m_gpuSections)
+    {
+        results.clear();
+        section.timer.collect(&results, wait);
+
+        // The timer drops the oldest queries when nobody collects them
+        while (section.targets.size() > results.size() + size_t(section.timer.pendingCount()))
+        {
+            section.targets.pop_front();
+        }
+
+        for (double gpuMs : results)
+        {
+            const std::pair<quint64, int> target = section.targets.front();
+            section.targets.pop_front();
+            FrameRecord &frame = m_frames[target.first % ringSize];
+            if (frame.index == target.first && published - target.first < ringSize)
+            {
+                frame.scopes[target.second].gpuMs = gpuMs;
+            }
+        }
+    }
+}
+
+#endif // FRAME_PROFILER
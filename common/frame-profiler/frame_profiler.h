@@ -0,0 +1,127 @@
+#ifndef FRAME_PROFILER_H
+#define FRAME_PROFILER_H
+
+// Use the macros below instead of the class, they expand to nothing
+// unless FRAME_PROFILER is defined (qmake CONFIG+=frame_profiler):
+//
+//   PROFILE_FRAME_BEGIN()      at the top of paintGL()
+//   PROFILE_SCOPE("draw")      CPU and GPU time until the end of the block
+//   PROFILE_SWAP_BEGIN()       at the end of paintGL()
+//   PROFILE_FRAME_END()        on frameSwapped(), optional
+//   PROFILE_EXPORT(arguments)  writes a Chrome trace when "--trace <path>"
+//                              is among the arguments
+//
+// Scope names must be string literals. GPU scopes must not nest.
+
+#ifdef FRAME_PROFILER
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QStringList>
+
+#include <atomic>
+#include <deque>
+#include <vector>
+
+#include "gpu_timer.h"
+
+// Records per-frame CPU scopes and GL timer queries into a fixed ring of
+// frames. Only the render thread writes; a frame becomes visible to
+// readers when it is published with a release store of the frame counter,
+// so readers never take a lock. GPU durations arrive a few frames late
+// and are filled into frames that are already published.
+class FrameProfiler
+{
+
+public:
+    static constexpr int maxScopes = 16;
+    static constexpr int ringSize = 512;
+
+    struct ScopeRecord
+    {
+        const char *name;
+        qint64 startNs;
+        qint64 durationNs;
+        double gpuMs; // Negative while unknown
+    };
+
+    struct FrameRecord
+    {
+        quint64 index;
+        qint64 startNs;
+        qint64 durationNs;
+        int scopeCount;
+        ScopeRecord scopes[maxScopes];
+    };
+
+    class Scope
+    {
+
+    public:
+        explicit Scope(const char *name) { m_slot = instance()->beginScope(name, true); }
+        ~Scope() { instance()->endScope(m_slot); }
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        int m_slot;
+    };
+
+    static FrameProfiler *instance();
+
+    void beginFrame();
+    void beginSwap();
+    void endFrame();
+
+    int beginScope(const char *name, bool gpu);
+    void endScope(int slot);
+
+    // Copies the durations in milliseconds of up to maxCount latest
+    // frames, oldest first, and returns how many were copied
+    int recentFrameTimes(float *ms, int maxCount) const;
+
+    bool exportChromeTrace(const QString &path) const;
+    void exportFromArguments(const QStringList &arguments) const;
+
+private:
+    struct GpuSection
+    {
+        const char *name;
+        GpuTimer timer;
+        // (frame index, scope slot) of every measurement in flight
+        std::deque<std::pair<quint64, int>> targets;
+    };
+
+    FrameProfiler();
+    qint64 now() const { return m_clock.nsecsElapsed(); }
+    GpuSection *gpuSection(const char *name);
+    void collectGpuTimes(bool wait);
+
+    QElapsedTimer m_clock;
+    std::vector<FrameRecord> m_frames;
+    std::atomic<quint64> m_publishedFrames { 0 };
+    bool m_frameOpen = false;
+    int m_swapSlot = -1;
+    int m_openGpuSlot = -1;
+    GpuSection *m_openGpuSection = nullptr;
+    std::deque<GpuSection> m_gpuSections;
+};
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_SCOPE(name) FrameProfiler::Scope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_FRAME_BEGIN() FrameProfiler::instance()->beginFrame()
+#define PROFILE_SWAP_BEGIN() FrameProfiler::instance()->beginSwap()
+#define PROFILE_FRAME_END() FrameProfiler::instance()->endFrame()
+#define PROFILE_EXPORT(arguments) FrameProfiler::instance()->exportFromArguments(arguments)
+
+#else
+
+#define PROFILE_SCOPE(name) do { } while (false)
+#define PROFILE_FRAME_BEGIN() do { } while (false)
+#define PROFILE_SWAP_BEGIN() do { } while (false)
+#define PROFILE_FRAME_END() do { } while (false)
+#define PROFILE_EXPORT(arguments) do { } while (false)
+
+#endif // FRAME_PROFILER
+
+#endif // FRAME_PROFILER_H
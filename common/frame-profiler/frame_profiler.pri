@@ -0,0 +1,17 @@
+isEmpty(FRAME_PROFILER_PRI) {
+FRAME_PROFILER_PRI = 1
+
+include($$PWD/../gpu-timer/gpu_timer.pri)
+
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/frame_profiler.h
+
+SOURCES += \
+    $$PWD/frame_profiler.cpp
+
+# The instrumentation compiles to nothing unless the project is
+# configured with "qmake CONFIG+=frame_profiler"
+frame_profiler: DEFINES += FRAME_PROFILER
+}
@@ -0,0 +1,175 @@
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include <QtCore/QAbstractEventDispatcher>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDebug>
+#include <QtCore/QEvent>
+
+#include "frame_scheduler.h"
+
+FrameScheduler::Mode FrameScheduler::modeFromArguments(const QStringList &arguments,
+    Mode fallback)
+{
+    const int index = arguments.indexOf("--frame-mode");
+    if (index < 0 || index + 1 >= arguments.size())
+    {
+        return fallback;
+    }
+    const QString name = arguments[index + 1];
+    for (Mode mode : { Mode::OnDemand, Mode::VSync, Mode::Uncapped })
+    {
+        if (name == modeName(mode))
+        {
+            return mode;
+        }
+    }
+    qWarning() << "Unknown frame mode" << name;
+    return fallback;
+}
+
+const char *FrameScheduler::modeName(Mode mode)
+{
+    switch (mode)
+    {
+    case Mode::OnDemand:
+        return "on-demand";
+    case Mode::VSync:
+        return "vsync";
+    case Mode::Uncapped:
+        return "uncapped";
+    }
+    return "";
+}
+
+FrameScheduler::FrameScheduler(QOpenGLWindow *window, Mode mode)
+    : QObject(window)
+    , m_window(window)
+    , m_mode(mode)
+{
+    if (!window->handle())
+    {
+        QSurfaceFormat format = window->format();
+        format.setSwapInterval(mode == Mode::Uncapped ? 0 : 1);
+        window->setFormat(format);
+    }
+    else
+    {
+        qWarning() << "FrameScheduler: the window already exists, swap interval unchanged";
+    }
+
+    window->installEventFilter(this);
+    connect(window, &QOpenGLWindow::frameSwapped, this, &FrameScheduler::onFrameSwapped);
+    QAbstractEventDispatcher *dispatcher = QAbstractEventDispatcher::instance(thread());
+    if (dispatcher)
+    {
+        connect(dispatcher, &QAbstractEventDispatcher::awake, this, [this]() {
+            m_stats.wakeups++;
+        });
+    }
+
+    m_printStats = QCoreApplication::arguments().contains("--frame-stats");
+    resetStats();
+}
+
+FrameScheduler::~FrameScheduler()
+{
+    if (m_printStats)
+    {
+        qInfo().noquote() << statsSummary();
+    }
+}
+
+void FrameScheduler::setMode(Mode mode)
+{
+    m_mode = mode;
+    if (isContinuous())
+    {
+        m_window->update();
+    }
+}
+
+void FrameScheduler::requestFrame()
+{
+    m_stats.requests++;
+    // Continuous modes draw the change with the next frame anyway
+    if (isContinuous() || m_updatePending)
+    {
+        m_stats.coalesced++;
+        return;
+    }
+    m_updatePending = true;
+    m_window->update();
+}
+
+FrameScheduler::Stats FrameScheduler::stats() const
+{
+    Stats stats = m_stats;
+    stats.cpuNs = processCpuNs() - m_cpuStartNs;
+    stats.elapsedNs = m_clock.nsecsElapsed();
+    return stats;
+}
+
+void FrameScheduler::resetStats()
+{
+    m_stats = Stats();
+    m_clock.start();
+    m_cpuStartNs = processCpuNs();
+}
+
+QString FrameScheduler::statsSummary() const
+{
+    const Stats s = stats();
+    const double seconds = s.elapsedNs / 1e9;
+    return QString("Frame scheduler (%1): %2 frames, %3 wakeups, %4 requests "
+        "(%5 coalesced) in %6 s, %7 fps, CPU %8%")
+        .arg(modeName(m_mode)).arg(s.frames).arg(s.wakeups).arg(s.requests)
+        .arg(s.coalesced).arg(seconds, 0, 'f', 1)
+        .arg(seconds > 0.0 ? s.frames / seconds : 0.0, 0, 'f', 1)
+        .arg(s.elapsedNs > 0 ? 100.0 * s.cpuNs / s.elapsedNs : 0.0, 0, 'f', 2);
+}
+
+bool FrameScheduler::eventFilter(QObject *watched, QEvent *event)
+{
+    // The requested frame is being painted (or dropped because the window
+    // is hidden), later changes need a new one
+    if (watched == m_window && event->type() == QEvent::Type::UpdateRequest)
+    {
+        m_updatePending = false;
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+void FrameScheduler::onFrameSwapped()
+{
+    m_stats.frames++;
+    if (isContinuous())
+    {
+        m_window->update();
+    }
+}
+
+qint64 FrameScheduler::processCpuNs()
+{
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+    {
+        return 0;
+    }
+    // 100 ns ticks
+    const quint64 kernelTicks = (quint64(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime;
+    const quint64 userTicks = (quint64(user.dwHighDateTime) << 32) | user.dwLowDateTime;
+    return qint64(kernelTicks + userTicks) * 100;
+#else
+    timespec time;
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time) != 0)
+    {
+        return 0;
+    }
+    return qint64(time.tv_sec) * 1000000000 + time.tv_nsec;
+#endif
+}
@@ -0,0 +1,81 @@
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QObject>
+#include <QtCore/QStringList>
+#include <QtOpenGL/QOpenGLWindow>
+
+// Decides when a QOpenGLWindow produces frames:
+//
+//   OnDemand - only after requestFrame(), call it whenever the camera,
+//              input or scene changes. An idle window does not wake up.
+//   VSync    - continuously, one frame per display refresh
+//   Uncapped - continuously with swap interval 0, for benchmarking
+//
+// The swap interval is part of the surface format, so the scheduler has
+// to be created after the window's setFormat() and before it is shown.
+// "--frame-mode on-demand|vsync|uncapped" picks the mode and
+// "--frame-stats" prints the counters when the window goes away.
+class FrameScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Mode
+    {
+        OnDemand,
+        VSync,
+        Uncapped
+    };
+
+    struct Stats
+    {
+        quint64 frames = 0;
+        // Times the GUI thread event loop woke up, for any reason
+        quint64 wakeups = 0;
+        quint64 requests = 0;
+        // Requests that found a frame already scheduled
+        quint64 coalesced = 0;
+        qint64 cpuNs = 0; // Process CPU time
+        qint64 elapsedNs = 0;
+    };
+
+    static Mode modeFromArguments(const QStringList &arguments, Mode fallback = Mode::OnDemand);
+    static const char *modeName(Mode mode);
+
+    FrameScheduler(QOpenGLWindow *window, Mode mode);
+    ~FrameScheduler();
+
+    Mode mode() const { return m_mode; }
+    // Switching between VSync and Uncapped after the window was created
+    // keeps the swap interval it was created with
+    void setMode(Mode mode);
+
+    // Asks for one more frame, cheap to call many times per frame
+    void requestFrame();
+
+    Stats stats() const;
+    void resetStats();
+    QString statsSummary() const;
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private slots:
+    void onFrameSwapped();
+
+private:
+    static qint64 processCpuNs();
+    bool isContinuous() const { return m_mode != Mode::OnDemand; }
+
+    QOpenGLWindow *m_window;
+    Mode m_mode;
+    bool m_updatePending = false;
+    bool m_printStats = false;
+    Stats m_stats;
+    QElapsedTimer m_clock;
+    qint64 m_cpuStartNs = 0;
+};
+
+#endif // FRAME_SCHEDULER_H
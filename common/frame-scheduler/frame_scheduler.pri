@@ -0,0 +1,11 @@
+isEmpty(FRAME_SCHEDULER_PRI) {
+FRAME_SCHEDULER_PRI = 1
+
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/frame_scheduler.h
+
+SOURCES += \
+    $$PWD/frame_scheduler.cpp
+}
@@ -0,0 +1,53 @@
+#ifndef FIXED_TIMESTEP_H
+#define FIXED_TIMESTEP_H
+
+#include <QtCore/QtGlobal>
+
+// The fixed-step accumulator behind GameLoop, also for scenes that step
+// their own physics inline and do not need snapshots. Times are read from
+// one clock that starts at zero; time() is where the simulation is.
+class FixedTimestep
+{
+
+public:
+    // A slower machine drops time instead of falling further behind
+    static constexpr int maxStepsPerUpdate = 8;
+
+    explicit FixedTimestep(int stepsPerSecond)
+        : m_stepNs(1000000000LL / stepsPerSecond)
+    {
+    }
+
+    // Calls step(dt) for every step that is due at nowNs, time() already
+    // includes the step while it runs. Returns how many ran.
+    template<class Step>
+    int advance(qint64 nowNs, Step &&step)
+    {
+        int steps = 0;
+        while (m_timeNs + m_stepNs <= nowNs && steps < maxStepsPerUpdate)
+        {
+            m_timeNs += m_stepNs;
+            step(m_stepNs / 1e9f);
+            steps++;
+        }
+        if (m_timeNs + m_stepNs <= nowNs)
+        {
+            // Too far behind, skip the backlog instead of catching up forever
+            m_timeNs = nowNs - nowNs % m_stepNs;
+        }
+        return steps;
+    }
+
+    // Drops the time that passed, one step is due at nowNs
+    void restart(qint64 nowNs) { m_timeNs = nowNs - m_stepNs; }
+    void reset() { m_timeNs = 0; }
+
+    qint64 stepNs() const { return m_stepNs; }
+    qint64 time() const { return m_timeNs; }
+
+private:
+    const qint64 m_stepNs;
+    qint64 m_timeNs = 0;
+};
+
+#endif // FIXED_TIMESTEP_H
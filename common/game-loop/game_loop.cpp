@@ -0,0 +1,134 @@
+#include <chrono>
+
+#include "game_loop.h"
+
+GameLoop::GameLoop(int stepsPerSecond, StepFunction step)
+    : m_step(std::move(step))
+    , m_timestep(stepsPerSecond)
+{
+}
+
+GameLoop::~GameLoop()
+{
+    stop();
+}
+
+void GameLoop::startWorker()
+{
+    if (m_worker.joinable())
+    {
+        return;
+    }
+    prime();
+    // Simulated time restarts at zero together with the clock
+    m_clockDriven = true;
+    m_clock.start();
+    m_timestep.reset();
+    m_inlineElapsedNs = 0;
+    m_running = true;
+    m_worker = std::thread(&GameLoop::workerLoop, this);
+}
+
+void GameLoop::stop()
+{
+    m_running = false;
+    if (m_worker.joinable())
+    {
+        m_worker.join();
+    }
+}
+
+int GameLoop::advance(qint64 elapsedNs)
+{
+    prime();
+    m_inlineElapsedNs += elapsedNs;
+    return runDueSteps(m_inlineElapsedNs);
+}
+
+void GameLoop::prime()
+{
+    if (m_primed)
+    {
+        return;
+    }
+    m_step(0.f, &m_snapshots[m_current].transforms);
+    m_snapshots[m_previous].transforms = m_snapshots[m_current].transforms;
+    m_primed = true;
+}
+
+void GameLoop::runStep(float dt)
+{
+    Snapshot &back = m_snapshots[m_back];
+    m_step(dt, &back.transforms);
+    m_stepCount++;
+    back.step = m_stepCount;
+    back.timeNs = m_timestep.time();
+
+    // Only the index rotation happens under the lock
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const int oldPrevious = m_previous;
+    m_previous = m_current;
+    m_current = m_back;
+    m_back = oldPrevious;
+}
+
+int GameLoop::runDueSteps(qint64 nowNs)
+{
+    return m_timestep.advance(nowNs, [this](float dt) { runStep(dt); });
+}
+
+void GameLoop::workerLoop()
+{
+    while (m_running)
+    {
+        runDueSteps(m_clock.nsecsElapsed());
+        const qint64 waitNs = m_timestep.time() + m_timestep.stepNs() - m_clock.nsecsElapsed();
+        if (waitNs > 0)
+        {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(waitNs));
+        }
+    }
+}
+
+qint64 GameLoop::renderTimeNs() const
+{
+    const qint64 nowNs = m_clockDriven ? m_clock.nsecsElapsed() : m_inlineElapsedNs;
+    return nowNs - m_timestep.stepNs();
+}
+
+void GameLoop::interpolate(std::vector<Transform> *transforms) const
+{
+    const qint64 renderNs = renderTimeNs();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const Snapshot &previous = m_snapshots[m_previous];
+    const Snapshot &current = m_snapshots[m_current];
+    const qint64 spanNs = current.timeNs - previous.timeNs;
+    float alpha = spanNs > 0 ? float(renderNs - previous.timeNs) / spanNs : 1.f;
+    alpha = qBound(0.f, alpha, 1.f);
+
+    transforms->resize(current.transforms.size());
+    for (size_t i = 0; i < current.transforms.size(); ++i)
+    {
+        const Transform &b = current.transforms[i];
+        Transform &out = (*transforms)[i];
+        if (i >= previous.transforms.size())
+        {
+            // Appeared with the latest step, nothing to blend with
+            out = b;
+            continue;
+        }
+        const Transform &a = previous.transforms[i];
+        out.position = a.position + (b.position - a.position) * alpha;
+        out.rotation = QQuaternion::nlerp(a.rotation, b.rotation, alpha);
+        out.scale = a.scale + (b.scale - a.scale) * alpha;
+    }
+}
+
+quint64 GameLoop::latest(std::vector<Transform> *transforms) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const Snapshot &current = m_snapshots[m_current];
+    *transforms = current.transforms;
+    return current.step;
+}
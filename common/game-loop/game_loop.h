@@ -0,0 +1,97 @@
+#ifndef GAME_LOOP_H
+#define GAME_LOOP_H
+
+#include <QtCore/QElapsedTimer>
+#include <QtGui/QQuaternion>
+#include <QtGui/QVector3D>
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "fixed_timestep.h"
+
+// Fixed-timestep simulation decoupled from paintGL(). The step function
+// always advances the scene by the same dt, so the result after N steps
+// does not depend on the frame rate. Each step publishes a snapshot of
+// transforms; the renderer draws the last two snapshots interpolated at
+// its own time, one step behind the simulation.
+//
+// Steps run either on a worker thread against the wall clock
+// (startWorker()) or inline whenever the renderer calls advance().
+class GameLoop
+{
+
+public:
+    struct Transform
+    {
+        QVector3D position;
+        QQuaternion rotation;
+        QVector3D scale = QVector3D(1.f, 1.f, 1.f);
+    };
+
+    // Advances the scene by dt seconds and writes every transform. The
+    // vector holds an older snapshot, it must be overwritten, not updated.
+    // Called once with dt 0 to write the initial state.
+    typedef std::function<void(float dt, std::vector<Transform> *transforms)> StepFunction;
+
+    static constexpr int maxStepsPerUpdate = FixedTimestep::maxStepsPerUpdate;
+
+    GameLoop(int stepsPerSecond, StepFunction step);
+    ~GameLoop();
+
+    void startWorker();
+    void stop();
+    bool isWorkerRunning() const { return m_worker.joinable(); }
+
+    // Inline mode: moves the clock forward and runs the steps that fit,
+    // returns how many ran
+    int advance(qint64 elapsedNs);
+
+    // Transforms at the current render time, blended between the last
+    // two snapshots
+    void interpolate(std::vector<Transform> *transforms) const;
+    // The newest snapshot as it is
+    quint64 latest(std::vector<Transform> *transforms) const;
+
+    qint64 stepNs() const { return m_timestep.stepNs(); }
+
+private:
+    struct Snapshot
+    {
+        quint64 step = 0;
+        qint64 timeNs = 0;
+        std::vector<Transform> transforms;
+    };
+
+    void prime();
+    void runStep(float dt);
+    int runDueSteps(qint64 nowNs);
+    qint64 renderTimeNs() const;
+    void workerLoop();
+
+    StepFunction m_step;
+
+    // Three buffers: the simulation writes the back one while the
+    // renderer reads the previous and current ones
+    Snapshot m_snapshots[3];
+    int m_previous = 0;
+    int m_current = 1;
+    int m_back = 2;
+    mutable std::mutex m_mutex;
+    bool m_primed = false;
+
+    // Owned by whoever runs the steps
+    FixedTimestep m_timestep;
+    quint64 m_stepCount = 0;
+
+    qint64 m_inlineElapsedNs = 0;
+    bool m_clockDriven = false;
+    QElapsedTimer m_clock;
+    std::thread m_worker;
+    std::atomic<bool> m_running { false };
+};
+
+#endif // GAME_LOOP_H
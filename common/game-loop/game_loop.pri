@@ -0,0 +1,12 @@
+isEmpty(GAME_LOOP_PRI) {
+GAME_LOOP_PRI = 1
+
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/fixed_timestep.h \
+    $$PWD/game_loop.h
+
+SOURCES += \
+    $$PWD/game_loop.cpp
+}
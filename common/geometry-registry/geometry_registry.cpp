@@ -0,0 +1,201 @@
+#include <QtGui/QVector3D>
+
+#include "geometry_registry.h"
+
+GeometryRegistry *GeometryRegistry::instance()
+{
+    static GeometryRegistry registry;
+    return &registry;
+}
+
+GeometryRegistry::GeometryRegistry()
+{
+}
+
+int GeometryRegistry::floatsPerVertex(Layout layout)
+{
+    switch (layout)
+    {
+        case Layout::Position2D:
+            return 2;
+        case Layout::Position2DTexCoord:
+            return 4;
+        case Layout::Position3DNormal:
+            return 6;
+    }
+    return 0;
+}
+
+GeometryRegistry::Mesh GeometryRegistry::mesh(const QByteArray &key, Layout layout,
+    GLenum primitive, const std::vector<float> &vertices, const std::vector<quint16> &indices)
+{
+    Group *group = currentGroup();
+    if (!group)
+    {
+        return Mesh();
+    }
+    const auto existing = group->meshes.constFind(key);
+    if (existing != group->meshes.constEnd())
+    {
+        m_stats.reused++;
+        return existing.value();
+    }
+
+    Mesh mesh;
+    mesh.stride = floatsPerVertex(layout) * int(sizeof(float));
+    mesh.vertexCount = int(vertices.size()) / floatsPerVertex(layout);
+    mesh.primitive = primitive;
+    const int vertexBytes = int(vertices.size() * sizeof(float));
+    // Aligned to the stride so the offset also works as a first vertex
+    mesh.vertexOffset = append(&group->vertexPools, GL_ARRAY_BUFFER, vertices.data(),
+        vertexBytes, mesh.stride, &mesh.vertexBuffer);
+    m_stats.vertexBytes += vertexBytes;
+    if (!indices.empty())
+    {
+        const int indexBytes = int(indices.size() * sizeof(quint16));
+        mesh.indexCount = int(indices.size());
+        mesh.indexOffset = append(&group->indexPools, GL_ELEMENT_ARRAY_BUFFER, indices.data(),
+            indexBytes, int(sizeof(quint16)), &mesh.indexBuffer);
+        m_stats.indexBytes += indexBytes;
+    }
+
+    group->meshes.insert(key, mesh);
+    m_stats.meshes++;
+    return mesh;
+}
+
+bool GeometryRegistry::contains(const QByteArray &key)
+{
+    Group *group = currentGroup();
+    return group && group->meshes.contains(key);
+}
+
+GeometryRegistry::Mesh GeometryRegistry::quad()
+{
+    return mesh("quad", Layout::Position2D, GL_TRIANGLE_STRIP, {
+        -0.5f, -0.5f,
+        0.5f, -0.5f,
+        -0.5f, 0.5f,
+        0.5f, 0.5f
+    });
+}
+
+GeometryRegistry::Mesh GeometryRegistry::texturedQuad(float left, float bottom,
+    float right, float top)
+{
+    QByteArray key = "textured-quad";
+    for (float value : { left, bottom, right, top })
+    {
+        key.append(' ');
+        key.append(QByteArray::number(value, 'g', 9));
+    }
+    return mesh(key, Layout::Position2DTexCoord, GL_TRIANGLE_STRIP, {
+        -0.5f, -0.5f, left, bottom,
+        0.5f, -0.5f, right, bottom,
+        -0.5f, 0.5f, left, top,
+        0.5f, 0.5f, right, top
+    });
+}
+
+GeometryRegistry::Mesh GeometryRegistry::triangle()
+{
+    return mesh("triangle", Layout::Position2D, GL_TRIANGLES, {
+        -0.5f, -0.5f,
+        0.5f, -0.5f,
+        0.f, 0.5f
+    });
+}
+
+GeometryRegistry::Mesh GeometryRegistry::cube()
+{
+    // Normal and the two axes spanning each face
+    const float faces[6][9] = {
+        { 1, 0, 0, 0, 1, 0, 0, 0, 1 },
+        { -1, 0, 0, 0, 0, 1, 0, 1, 0 },
+        { 0, 1, 0, 0, 0, 1, 1, 0, 0 },
+        { 0, -1, 0, 1, 0, 0, 0, 0, 1 },
+        { 0, 0, 1, 1, 0, 0, 0, 1, 0 },
+        { 0, 0, -1, 0, 1, 0, 1, 0, 0 }
+    };
+    const float corners[6][2] = {
+        { -1, -1 }, { 1, -1 }, { 1, 1 },
+        { -1, -1 }, { 1, 1 }, { -1, 1 }
+    };
+
+    std::vector<float> vertices;
+    for (const float *face : faces)
+    {
+        const QVector3D normal(face[0], face[1], face[2]);
+        const QVector3D u(face[3], face[4], face[5]);
+        const QVector3D v(face[6], face[7], face[8]);
+        for (const float *corner : corners)
+        {
+            const QVector3D p = (normal + u * corner[0] + v * corner[1]) * 0.5f;
+            vertices.insert(vertices.end(), { p.x(), p.y(), p.z(),
+                normal.x(), normal.y(), normal.z() });
+        }
+    }
+    return mesh("cube", Layout::Position3DNormal, GL_TRIANGLES, vertices);
+}
+
+GeometryRegistry::Group *GeometryRegistry::currentGroup()
+{
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    if (!context)
+    {
+        return nullptr;
+    }
+    QOpenGLContextGroup *shareGroup = context->shareGroup();
+    Group *group = m_groups.value(shareGroup);
+    if (group)
+    {
+        return group;
+    }
+
+    group = new Group;
+    m_groups.insert(shareGroup, group);
+    // The buffers die with the share group, only the bookkeeping is left
+    QObject::connect(shareGroup, &QObject::destroyed, [this, shareGroup]() {
+        Group *dead = m_groups.take(shareGroup);
+        m_stats.pools -= int(dead->vertexPools.size() + dead->indexPools.size());
+        delete dead;
+    });
+    return group;
+}
+
+int GeometryRegistry::append(std::vector<Pool> *pools, GLenum target, const void *data,
+    int bytes, int alignment, GLuint *buffer)
+{
+    QOpenGLFunctions *gl = QOpenGLContext::currentContext()->functions();
+    Pool *pool = nullptr;
+    int offset = 0;
+    for (Pool &candidate : *pools)
+    {
+        offset = (candidate.used + alignment - 1) / alignment * alignment;
+        if (offset + bytes <= candidate.capacity)
+        {
+            pool = &candidate;
+            break;
+        }
+    }
+    if (!pool)
+    {
+        Pool newPool;
+        newPool.capacity = qMax(poolSize, bytes);
+        newPool.used = 0;
+        gl->glGenBuffers(1, &newPool.buffer);
+        gl->glBindBuffer(target, newPool.buffer);
+        gl->glBufferData(target, newPool.capacity, nullptr, GL_STATIC_DRAW);
+        pools->push_back(newPool);
+        pool = &pools->back();
+        offset = 0;
+        m_stats.pools++;
+    }
+
+    gl->glBindBuffer(target, pool->buffer);
+    gl->glBufferSubData(target, offset, bytes, data);
+    gl->glBindBuffer(target, 0);
+    pool->used = offset + bytes;
+    *buffer = pool->buffer;
+    return offset;
+}
@@ -0,0 +1,107 @@
+#ifndef GEOMETRY_REGISTRY_H
+#define GEOMETRY_REGISTRY_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtGui/QOpenGLContext>
+#include <QtGui/QOpenGLFunctions>
+
+#include <vector>
+
+// Static meshes shared by every context of a share group. Vertex data is
+// interleaved and packed into a few large vertex and index buffer pools,
+// so the unit quad every window needs exists once and meshes drawn one
+// after another usually sit in the same buffer. A mesh is identified by
+// a key; asking again for a key returns the mesh that is already there.
+//
+// The returned Mesh is a plain handle: buffer names and byte offsets
+// into them. Set attribute pointers relative to vertexOffset and draw
+// from vertex 0, or from indexOffset with glDrawElements. Adding a mesh
+// leaves the array and element array bindings at 0, so add meshes
+// before GLStateCache::initialize() or invalidate its buffers after.
+class GeometryRegistry
+{
+
+public:
+    enum class Layout
+    {
+        Position2D,         // x, y
+        Position2DTexCoord, // x, y, u, v
+        Position3DNormal    // x, y, z, nx, ny, nz
+    };
+
+    struct Mesh
+    {
+        GLuint vertexBuffer = 0;
+        GLuint indexBuffer = 0;
+        int vertexOffset = 0;
+        int vertexCount = 0;
+        // Unsigned short indices relative to the mesh's first vertex
+        int indexOffset = 0;
+        int indexCount = 0;
+        int stride = 0;
+        GLenum primitive = GL_TRIANGLES;
+
+        bool isValid() const { return vertexBuffer != 0; }
+    };
+
+    struct Stats
+    {
+        int meshes = 0;
+        int reused = 0;
+        int pools = 0;
+        qint64 vertexBytes = 0;
+        qint64 indexBytes = 0;
+    };
+
+    // Pools are allocated in this size, larger meshes get a pool of their own
+    static constexpr int poolSize = 1024 * 1024;
+
+    static GeometryRegistry *instance();
+    static int floatsPerVertex(Layout layout);
+
+    // Must be called with a current OpenGL context. Returns an invalid
+    // mesh when there is none. vertices and indices are ignored when the
+    // key is already registered.
+    Mesh mesh(const QByteArray &key, Layout layout, GLenum primitive,
+        const std::vector<float> &vertices,
+        const std::vector<quint16> &indices = std::vector<quint16>());
+    bool contains(const QByteArray &key);
+
+    // Unit quad centered at the origin as a triangle strip
+    Mesh quad();
+    // Unit quad with its own texture coordinates, for atlas frames
+    Mesh texturedQuad(float left, float bottom, float right, float top);
+    // Triangle inscribed in the unit quad, apex up
+    Mesh triangle();
+    // Cube with edge length 1 centered at the origin, with face normals
+    Mesh cube();
+
+    const Stats &stats() const { return m_stats; }
+
+private:
+    struct Pool
+    {
+        GLuint buffer;
+        int used;
+        int capacity;
+    };
+
+    struct Group
+    {
+        std::vector<Pool> vertexPools;
+        std::vector<Pool> indexPools;
+        QHash<QByteArray, Mesh> meshes;
+    };
+
+    GeometryRegistry();
+    Group *currentGroup();
+    // Returns the byte offset of the data in the pool buffer *buffer
+    int append(std::vector<Pool> *pools, GLenum target, const void *data, int bytes,
+        int alignment, GLuint *buffer);
+
+    QHash<QOpenGLContextGroup *, Group *> m_groups;
+    Stats m_stats;
+};
+
+#endif // GEOMETRY_REGISTRY_H
@@ -0,0 +1,11 @@
+isEmpty(GEOMETRY_REGISTRY_PRI) {
+GEOMETRY_REGISTRY_PRI = 1
+
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/geometry_registry.h
+
+SOURCES += \
+    $$PWD/geometry_registry.cpp
+}
@@ -0,0 +1,315 @@
+#include <QtGui/QOpenGLContext>
+
+#include <cstring>
+#include <vector>
+
+#include "gl_state_cache.h"
+
+namespace
+{
+    const GLenum trackedCapabilityNames[] = {
+        GL_BLEND, GL_CULL_FACE, GL_DEPTH_TEST, GL_SCISSOR_TEST
+    };
+
+    int capabilityIndex(GLenum capability)
+    {
+        for (int i = 0; i < int(sizeof(trackedCapabilityNames) / sizeof(GLenum)); ++i)
+        {
+            if (trackedCapabilityNames[i] == capability)
+            {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    struct UniformShadow
+    {
+        GLenum type = 0; // 0 while unknown
+        GLfloat values[16];
+    };
+
+    const char *uniformsObjectName = "GLStateCacheUniforms";
+}
+
+// Lives as a child of the program, so the shadows go away with the program
+// and a recycled program id never inherits stale values
+class GLStateCache::ProgramUniforms : public QObject
+{
+
+public:
+    explicit ProgramUniforms(QObject *parent)
+        : QObject(parent)
+    {
+        setObjectName(uniformsObjectName);
+    }
+
+    std::vector<UniformShadow> shadows;
+};
+
+GLStateCache::GLStateCache()
+{
+    invalidate();
+}
+
+void GLStateCache::initialize()
+{
+    initializeOpenGLFunctions();
+    invalidate();
+}
+
+void GLStateCache::invalidate(StateBits bits)
+{
+    if ((bits & StateBit::Uniforms) && m_uniforms)
+    {
+        m_uniforms->shadows.clear();
+    }
+    if (bits & StateBit::Program)
+    {
+        m_program = nullptr;
+        m_uniforms = nullptr;
+        m_programKnown = false;
+    }
+    if (bits & StateBit::Textures)
+    {
+        m_activeUnit = -1;
+        for (int i = 0; i < textureUnits; ++i)
+        {
+            m_textures[i] = unknownName;
+            m_textureTargets[i] = 0;
+        }
+    }
+    if (bits & StateBit::Buffers)
+    {
+        m_arrayBuffer = unknownName;
+        m_elementArrayBuffer = unknownName;
+    }
+    if (bits & StateBit::Viewport)
+    {
+        m_viewportKnown = false;
+    }
+    if (bits & StateBit::Scissor)
+    {
+        m_scissorKnown = false;
+    }
+    if (bits & StateBit::ClearColor)
+    {
+        m_clearColorKnown = false;
+    }
+    if (bits & StateBit::Capabilities)
+    {
+        for (int i = 0; i < trackedCapabilities; ++i)
+        {
+            m_capabilities[i] = -1;
+        }
+    }
+}
+
+bool GLStateCache::count(bool redundant)
+{
+    if (redundant)
+    {
+        m_stats.skipped++;
+        return false;
+    }
+    m_stats.issued++;
+    return true;
+}
+
+void GLStateCache::useProgram(QOpenGLShaderProgram *program)
+{
+    if (!count(m_programKnown && program == m_program))
+    {
+        return;
+    }
+    glUseProgram(program ? program->programId() : 0);
+    m_program = program;
+    m_programKnown = true;
+    m_uniforms = nullptr;
+    if (program)
+    {
+        m_uniforms = static_cast<ProgramUniforms *>(
+            program->findChild<QObject *>(uniformsObjectName, Qt::FindDirectChildrenOnly));
+        if (!m_uniforms)
+        {
+            m_uniforms = new ProgramUniforms(program);
+        }
+    }
+}
+
+void GLStateCache::bindTexture(GLenum target, GLuint texture, int unit)
+{
+    if (unit >= textureUnits)
+    {
+        count(false);
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(target, texture);
+        m_activeUnit = -1;
+        return;
+    }
+    if (!count(m_textures[unit] == texture && m_textureTargets[unit] == target))
+    {
+        return;
+    }
+    if (m_activeUnit != unit)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        m_activeUnit = unit;
+    }
+    glBindTexture(target, texture);
+    m_textures[unit] = texture;
+    m_textureTargets[unit] = target;
+}
+
+void GLStateCache::bindBuffer(GLenum target, GLuint buffer)
+{
+    GLuint *current = nullptr;
+    if (target == GL_ARRAY_BUFFER)
+    {
+        current = &m_arrayBuffer;
+    }
+    else if (target == GL_ELEMENT_ARRAY_BUFFER)
+    {
+        current = &m_elementArrayBuffer;
+    }
+    if (!count(current && *current == buffer))
+    {
+        return;
+    }
+    glBindBuffer(target, buffer);
+    if (current)
+    {
+        *current = buffer;
+    }
+}
+
+void GLStateCache::viewport(int x, int y, int width, int height)
+{
+    const int box[4] = { x, y, width, height };
+    if (!count(m_viewportKnown && std::memcmp(box, m_viewport, sizeof(box)) == 0))
+    {
+        return;
+    }
+    glViewport(x, y, width, height);
+    std::memcpy(m_viewport, box, sizeof(box));
+    m_viewportKnown = true;
+}
+
+void GLStateCache::scissor(int x, int y, int width, int height)
+{
+    const int box[4] = { x, y, width, height };
+    if (!count(m_scissorKnown && std::memcmp(box, m_scissor, sizeof(box)) == 0))
+    {
+        return;
+    }
+    glScissor(x, y, width, height);
+    std::memcpy(m_scissor, box, sizeof(box));
+    m_scissorKnown = true;
+}
+
+void GLStateCache::clearColor(float r, float g, float b, float a)
+{
+    const float color[4] = { r, g, b, a };
+    if (!count(m_clearColorKnown && std::memcmp(color, m_clearColor, sizeof(color)) == 0))
+    {
+        return;
+    }
+    glClearColor(r, g, b, a);
+    std::memcpy(m_clearColor, color, sizeof(color));
+    m_clearColorKnown = true;
+}
+
+void GLStateCache::setEnabled(GLenum capability, bool enabled)
+{
+    const int index = capabilityIndex(capability);
+    if (!count(index >= 0 && m_capabilities[index] == int(enabled)))
+    {
+        return;
+    }
+    if (enabled)
+    {
+        glEnable(capability);
+    }
+    else
+    {
+        glDisable(capability);
+    }
+    if (index >= 0)
+    {
+        m_capabilities[index] = int(enabled);
+    }
+}
+
+bool GLStateCache::uniformChanged(int location, GLenum type, const void *data, int size)
+{
+    // Without a known program there is nothing to compare with
+    if (!m_uniforms)
+    {
+        return count(false);
+    }
+    std::vector<UniformShadow> &shadows = m_uniforms->shadows;
+    if (location >= int(shadows.size()))
+    {
+        shadows.resize(location + 1);
+    }
+    UniformShadow &shadow = shadows[location];
+    if (!count(shadow.type == type && std::memcmp(shadow.values, data, size) == 0))
+    {
+        return false;
+    }
+    shadow.type = type;
+    std::memcpy(shadow.values, data, size);
+    return true;
+}
+
+void GLStateCache::setUniform(int location, GLint value)
+{
+    if (location >= 0 && uniformChanged(location, GL_INT, &value, sizeof(value)))
+    {
+        glUniform1i(location, value);
+    }
+}
+
+void GLStateCache::setUniform(int location, GLfloat value)
+{
+    if (location >= 0 && uniformChanged(location, GL_FLOAT, &value, sizeof(value)))
+    {
+        glUniform1f(location, value);
+    }
+}
+
+void GLStateCache::setUniform(int location, const QVector2D &value)
+{
+    const GLfloat values[2] = { value.x(), value.y() };
+    if (location >= 0 && uniformChanged(location, GL_FLOAT_VEC2, values, sizeof(values)))
+    {
+        glUniform2fv(location, 1, values);
+    }
+}
+
+void GLStateCache::setUniform(int location, const QVector3D &value)
+{
+    const GLfloat values[3] = { value.x(), value.y(), value.z() };
+    if (location >= 0 && uniformChanged(location, GL_FLOAT_VEC3, values, sizeof(values)))
+    {
+        glUniform3fv(location, 1, values);
+    }
+}
+
+void GLStateCache::setUniform(int location, const QVector4D &value)
+{
+    const GLfloat values[4] = { value.x(), value.y(), value.z(), value.w() };
+    if (location >= 0 && uniformChanged(location, GL_FLOAT_VEC4, values, sizeof(values)))
+    {
+        glUniform4fv(location, 1, values);
+    }
+}
+
+void GLStateCache::setUniform(int location, const QMatrix4x4 &value)
+{
+    if (location >= 0 &&
+        uniformChanged(location, GL_FLOAT_MAT4, value.constData(), 16 * sizeof(GLfloat)))
+    {
+        glUniformMatrix4fv(location, 1, GL_FALSE, value.constData());
+    }
+}
@@ -0,0 +1,111 @@
+#ifndef GL_STATE_CACHE_H
+#define GL_STATE_CACHE_H
+
+#include <QtCore/QFlags>
+#include <QtGui/QMatrix4x4>
+#include <QtGui/QOpenGLFunctions>
+#include <QtGui/QVector2D>
+#include <QtGui/QVector3D>
+#include <QtGui/QVector4D>
+#include <QtOpenGL/QOpenGLShaderProgram>
+
+// Shadows the GL state that is set every frame and drops the calls that
+// would not change it. Use one cache per context. Uniform shadows are
+// attached to the program object, so windows that share a program through
+// ShaderCache see each other's values. Anything that changes state behind
+// the cache's back - Qt classes, PickingService, QOpenGLWindow setting the
+// viewport before paintGL() - must be followed by invalidate() with the
+// affected bits.
+class GLStateCache : protected QOpenGLFunctions
+{
+
+public:
+    enum class StateBit
+    {
+        Program = 0x01,
+        Textures = 0x02,
+        Buffers = 0x04,
+        Viewport = 0x08,
+        Scissor = 0x10,
+        ClearColor = 0x20,
+        Capabilities = 0x40,
+        // Shadows of the current program's uniforms
+        Uniforms = 0x80,
+        All = 0xFF
+    };
+    Q_DECLARE_FLAGS(StateBits, StateBit)
+
+    struct Stats
+    {
+        int issued = 0;
+        int skipped = 0;
+    };
+
+    GLStateCache();
+
+    // Must be called with a current OpenGL context
+    void initialize();
+    void invalidate(StateBits bits = StateBit::All);
+
+    void useProgram(QOpenGLShaderProgram *program);
+    void bindTexture(GLenum target, GLuint texture, int unit = 0);
+    // GL_ARRAY_BUFFER and GL_ELEMENT_ARRAY_BUFFER are tracked,
+    // other targets are passed through
+    void bindBuffer(GLenum target, GLuint buffer);
+    void viewport(int x, int y, int width, int height);
+    void scissor(int x, int y, int width, int height);
+    void clearColor(float r, float g, float b, float a);
+    // GL_BLEND, GL_CULL_FACE, GL_DEPTH_TEST and GL_SCISSOR_TEST are
+    // tracked, other capabilities are passed through
+    void setEnabled(GLenum capability, bool enabled);
+
+    // Uniforms of the program set with useProgram()
+    void setUniform(int location, GLint value);
+    void setUniform(int location, GLfloat value);
+    void setUniform(int location, const QVector2D &value);
+    void setUniform(int location, const QVector3D &value);
+    void setUniform(int location, const QVector4D &value);
+    void setUniform(int location, const QMatrix4x4 &value);
+
+    const Stats &stats() const { return m_stats; }
+    void resetStats() { m_stats = Stats(); }
+
+private:
+    static constexpr int textureUnits = 8;
+    static constexpr int trackedCapabilities = 4;
+    static constexpr GLuint unknownName = ~GLuint(0);
+
+    class ProgramUniforms;
+
+    // Compares with the shadow of the current program and updates it
+    bool uniformChanged(int location, GLenum type, const void *data, int size);
+    // Counts the call, returns true when it has to reach the driver
+    bool count(bool redundant);
+
+    QOpenGLShaderProgram *m_program = nullptr;
+    ProgramUniforms *m_uniforms = nullptr;
+    bool m_programKnown = false;
+
+    // unknownName marks bindings the cache can not vouch for
+    int m_activeUnit = -1;
+    GLuint m_textures[textureUnits];
+    GLenum m_textureTargets[textureUnits];
+    GLuint m_arrayBuffer;
+    GLuint m_elementArrayBuffer;
+
+    int m_viewport[4] = {};
+    bool m_viewportKnown = false;
+    int m_scissor[4] = {};
+    bool m_scissorKnown = false;
+    float m_clearColor[4] = {};
+    bool m_clearColorKnown = false;
+
+    // -1 unknown, 0 disabled, 1 enabled
+    int m_capabilities[trackedCapabilities];
+
+    Stats m_stats;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(GLStateCache::StateBits)
+
+#endif // GL_STATE_CACHE_H
@@ -0,0 +1,11 @@
+isEmpty(GL_STATE_CACHE_PRI) {
+GL_STATE_CACHE_PRI = 1
+
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/gl_state_cache.h
+
+SOURCES += \
+    $$PWD/gl_state_cache.cpp
+}
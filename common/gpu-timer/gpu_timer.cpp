@@ -0,0 +1,131 @@
+#include <QtGui/QOpenGLContext>
+
+#include "gpu_timer.h"
+
+#ifndef GL_TIME_ELAPSED
+#define GL_TIME_ELAPSED 0x88BF
+#endif
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT 0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif
+
+// GL_TIME_ELAPSED queries can not nest, while one timer is measuring
+// the others skip their measurements
+static bool timeElapsedQueryActive = false;
+
+GpuTimer::GpuTimer()
+{
+}
+
+void GpuTimer::initialize()
+{
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    m_gl = context->functions();
+
+    QByteArray suffix;
+    if (context->isOpenGLES())
+    {
+        if (!context->hasExtension("GL_EXT_disjoint_timer_query"))
+        {
+            return;
+        }
+        suffix = "EXT";
+        m_disjointExtension = true;
+    }
+    else if (context->format().version() < qMakePair(3, 3) &&
+        !context->hasExtension("GL_ARB_timer_query"))
+    {
+        return;
+    }
+
+    auto resolve = [context, &suffix](const char *name) {
+        return context->getProcAddress(QByteArray(name) + suffix);
+    };
+    m_genQueries = reinterpret_cast<GenQueriesFunc>(resolve("glGenQueries"));
+    m_deleteQueries = reinterpret_cast<DeleteQueriesFunc>(resolve("glDeleteQueries"));
+    m_beginQuery = reinterpret_cast<BeginQueryFunc>(resolve("glBeginQuery"));
+    m_endQuery = reinterpret_cast<EndQueryFunc>(resolve("glEndQuery"));
+    m_getQueryObjectiv = reinterpret_cast<GetQueryObjectivFunc>(resolve("glGetQueryObjectiv"));
+    m_getQueryObjectui64v = reinterpret_cast<GetQueryObjectui64vFunc>(
+        resolve("glGetQueryObjectui64v"));
+    m_available = m_genQueries && m_deleteQueries && m_beginQuery && m_endQuery &&
+        m_getQueryObjectiv && m_getQueryObjectui64v;
+
+    if (m_available)
+    {
+        m_genQueries(ringSize, m_queries);
+    }
+}
+
+void GpuTimer::destroy()
+{
+    if (m_available)
+    {
+        m_deleteQueries(ringSize, m_queries);
+    }
+    m_available = false;
+    m_pendingCount = 0;
+}
+
+bool GpuTimer::begin()
+{
+    if (!m_available || m_open || timeElapsedQueryActive)
+    {
+        return false;
+    }
+    if (m_pendingCount == ringSize)
+    {
+        // Nobody collected in time, drop the oldest measurement
+        m_pendingCount--;
+    }
+    m_beginQuery(GL_TIME_ELAPSED, m_queries[m_writeIndex]);
+    m_open = true;
+    timeElapsedQueryActive = true;
+    return true;
+}
+
+void GpuTimer::end()
+{
+    if (!m_open)
+    {
+        return;
+    }
+    m_endQuery(GL_TIME_ELAPSED);
+    m_open = false;
+    timeElapsedQueryActive = false;
+    m_writeIndex = (m_writeIndex + 1) % ringSize;
+    m_pendingCount++;
+}
+
+void GpuTimer::collect(std::vector<double> *results, bool wait)
+{
+    while (m_pendingCount > 0)
+    {
+        const GLuint query = m_queries[(m_writeIndex - m_pendingCount + ringSize) % ringSize];
+        if (!wait)
+        {
+            GLint available = 0;
+            m_getQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+            {
+                break;
+            }
+        }
+        quint64 nanoseconds = 0;
+        m_getQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+        m_pendingCount--;
+
+        GLint disjoint = 0;
+        if (m_disjointExtension)
+        {
+            m_gl->glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+        }
+        results->push_back(disjoint ? -1.0 : nanoseconds / 1e6);
+    }
+}
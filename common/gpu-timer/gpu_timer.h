@@ -0,0 +1,65 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <QtGui/QOpenGLFunctions>
+
+#include <vector>
+
+// GPU time of a span of GL commands measured with GL_TIME_ELAPSED
+// queries: core in desktop GL 3.3, ARB_timer_query on older desktop GL
+// and EXT_disjoint_timer_query on OpenGL ES. Queries are kept in a ring
+// and results are collected a few frames later, so measuring never
+// stalls the pipeline. When none of the extensions is present
+// isAvailable() returns false and all calls do nothing.
+class GpuTimer
+{
+
+public:
+    static constexpr int ringSize = 4;
+
+    GpuTimer();
+
+    // Must be called with a current OpenGL context
+    void initialize();
+    void destroy();
+    bool isAvailable() const { return m_available; }
+    // Measurements submitted but not collected yet
+    int pendingCount() const { return m_pendingCount; }
+
+    // Only one begin()/end() pair can be open at a time. A begin() while
+    // another GpuTimer is measuring is ignored together with its end().
+    // Returns true when the measurement has started.
+    bool begin();
+    void end();
+
+    // Collects every finished measurement in submission order, in
+    // milliseconds. When wait is true it blocks until all are finished.
+    // Results spoiled by a disjoint event (GPU reset, clock change) are
+    // reported as negative values.
+    void collect(std::vector<double> *results, bool wait = false);
+
+private:
+    typedef void (QOPENGLF_APIENTRYP GenQueriesFunc)(GLsizei n, GLuint *ids);
+    typedef void (QOPENGLF_APIENTRYP DeleteQueriesFunc)(GLsizei n, const GLuint *ids);
+    typedef void (QOPENGLF_APIENTRYP BeginQueryFunc)(GLenum target, GLuint id);
+    typedef void (QOPENGLF_APIENTRYP EndQueryFunc)(GLenum target);
+    typedef void (QOPENGLF_APIENTRYP GetQueryObjectivFunc)(GLuint id, GLenum pname, GLint *params);
+    typedef void (QOPENGLF_APIENTRYP GetQueryObjectui64vFunc)(GLuint id, GLenum pname, quint64 *params);
+
+    bool m_available = false;
+    bool m_disjointExtension = false;
+    GenQueriesFunc m_genQueries = nullptr;
+    DeleteQueriesFunc m_deleteQueries = nullptr;
+    BeginQueryFunc m_beginQuery = nullptr;
+    EndQueryFunc m_endQuery = nullptr;
+    GetQueryObjectivFunc m_getQueryObjectiv = nullptr;
+    GetQueryObjectui64vFunc m_getQueryObjectui64v = nullptr;
+
+    GLuint m_queries[ringSize] = {};
+    int m_writeIndex = 0;
+    int m_pendingCount = 0;
+    bool m_open = false;
+    QOpenGLFunctions *m_gl = nullptr;
+};
+
+#endif // GPU_TIMER_H
@@ -0,0 +1,11 @@
+isEmpty(GPU_TIMER_PRI) {
+GPU_TIMER_PRI = 1
+
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/gpu_timer.h
+
+SOURCES += \
+    $$PWD/gpu_timer.cpp
+}
@@ -0,0 +1,269 @@
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDebug>
+#include <QtCore/QFile>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtGui/QImage>
+
+#include <algorithm>
+
+#include "offscreen_host.h"
+
+namespace
+{
+    QJsonObject percentiles(std::vector<double> values)
+    {
+        QJsonObject result;
+        if (values.empty())
+        {
+            return result;
+        }
+        std::sort(values.begin(), values.end());
+        auto at = [&values](double p) {
+            return values[std::min(values.size() - 1, size_t(p * values.size()))];
+        };
+        double sum = 0.0;
+        for (double value : values)
+        {
+            sum += value;
+        }
+        result.insert("mean", sum / values.size());
+        result.insert("p50", at(0.5));
+        result.insert("p90", at(0.9));
+        result.insert("p99", at(0.99));
+        result.insert("max", values.back());
+        return result;
+    }
+
+    QString summary(const QJsonObject &stats)
+    {
+        return QString("mean %1, p50 %2, p90 %3, p99 %4, max %5 ms")
+            .arg(stats.value("mean").toDouble(), 0, 'f', 3)
+            .arg(stats.value("p50").toDouble(), 0, 'f', 3)
+            .arg(stats.value("p90").toDouble(), 0, 'f', 3)
+            .arg(stats.value("p99").toDouble(), 0, 'f', 3)
+            .arg(stats.value("max").toDouble(), 0, 'f', 3);
+    }
+
+    // Measured frames render into an exactly sized target so that the
+    // numbers stay comparable to earlier runs, only a resize sweep
+    // buckets unless the policy is given
+    RenderTargetManager::Policy hostPolicy(const QStringList &arguments)
+    {
+        return RenderTargetManager::policyFromArguments(arguments,
+            arguments.contains("--resize-sweep") ? RenderTargetManager::Policy::PowerOfTwo :
+            RenderTargetManager::Policy::Exact);
+    }
+}
+
+bool OffscreenHost::isRequested(const QStringList &arguments)
+{
+    return arguments.contains("--offscreen");
+}
+
+OffscreenHost::OffscreenHost(const QStringList &arguments)
+    : m_name(QCoreApplication::applicationName())
+    , m_targets(hostPolicy(arguments))
+{
+    m_target = m_targets.addTarget(RenderTargetManager::Extent::Window,
+        QOpenGLFramebufferObject::Attachment::CombinedDepthStencil);
+    for (int i = 1; i + 1 < arguments.size(); ++i)
+    {
+        const QString &option = arguments[i];
+        const QString &value = arguments[i + 1];
+        if (option == "--frames")
+        {
+            m_frameCount = qMax(1, value.toInt());
+        }
+        else if (option == "--size")
+        {
+            const QStringList size = value.split('x');
+            if (size.size() == 2 && size[0].toInt() > 0 && size[1].toInt() > 0)
+            {
+                m_size = QSize(size[0].toInt(), size[1].toInt());
+            }
+        }
+        else if (option == "--json")
+        {
+            m_jsonPath = value;
+        }
+        else if (option == "--png")
+        {
+            m_pngPath = value;
+        }
+        else if (option == "--resize-sweep")
+        {
+            m_resizeSteps = qMax(0, value.toInt());
+        }
+    }
+}
+
+OffscreenHost::~OffscreenHost()
+{
+}
+
+bool OffscreenHost::begin()
+{
+    if (!m_context.create())
+    {
+        qWarning() << "Failed to create an OpenGL context";
+        return false;
+    }
+    m_surface.setFormat(m_context.format());
+    m_surface.create();
+    if (!m_context.makeCurrent(&m_surface))
+    {
+        qWarning() << "Failed to make the OpenGL context current";
+        return false;
+    }
+
+    m_targets.resize(m_size, QRect(QPoint(0, 0), m_size));
+    m_targets.framebuffer(m_target)->bind();
+    m_context.functions()->glViewport(0, 0, m_size.width(), m_size.height());
+    m_gpuTimer.initialize();
+
+    m_cpuTimes.reserve(m_frameCount);
+    m_frameTimes.reserve(m_frameCount);
+    m_gpuTimes.reserve(m_frameCount + m_warmUpFrames);
+    m_resizeTimes.reserve(m_resizeSteps);
+    return true;
+}
+
+void OffscreenHost::beginFrame()
+{
+    // Examples may bind their own framebuffers, start every frame
+    // from the host framebuffer like a window starts from its surface
+    m_targets.framebuffer(m_target)->bind();
+    m_gpuTimer.begin();
+    m_timer.start();
+}
+
+void OffscreenHost::endFrame(bool measured)
+{
+    const double cpuTime = m_timer.nsecsElapsed() / 1e6;
+    m_gpuTimer.end();
+    // Stands in for the swap: the next frame starts when this one is done
+    m_context.functions()->glFinish();
+    const double frameTime = m_timer.nsecsElapsed() / 1e6;
+
+    if (measured)
+    {
+        m_cpuTimes.push_back(cpuTime);
+        m_frameTimes.push_back(frameTime);
+    }
+    else
+    {
+        // Warm-up frames are timed on the GPU too, throw them away
+        std::vector<double> ignored;
+        m_gpuTimer.collect(&ignored, true);
+        return;
+    }
+    m_gpuTimer.collect(&m_gpuTimes);
+}
+
+// Down to half the size at the middle of the sweep and back up, the
+// last step is the full size again
+QSize OffscreenHost::sweepSize(int step) const
+{
+    const float t = step / float(m_resizeSteps);
+    const float scale = 0.5f + qAbs(t - 0.5f);
+    return QSize(qMax(1, qRound(m_size.width() * scale)),
+        qMax(1, qRound(m_size.height() * scale)));
+}
+
+// Measures like a window would see it: from the resize event to the
+// end of the first frame at the new size
+void OffscreenHost::beginResize(const QSize &size)
+{
+    m_timer.start();
+    m_targets.resize(size, QRect(QPoint(0, 0), size));
+    m_targets.framebuffer(m_target)->bind();
+    m_context.functions()->glViewport(0, 0, size.width(), size.height());
+}
+
+void OffscreenHost::endResize()
+{
+    m_context.functions()->glFinish();
+    m_resizeTimes.push_back(m_timer.nsecsElapsed() / 1e6);
+}
+
+int OffscreenHost::finish()
+{
+    m_gpuTimer.collect(&m_gpuTimes, true);
+    m_gpuTimes.erase(std::remove_if(m_gpuTimes.begin(), m_gpuTimes.end(),
+        [](double time) { return time < 0.0; }), m_gpuTimes.end());
+
+    QOpenGLFunctions *gl = m_context.functions();
+    QJsonObject root;
+    root.insert("example", m_name);
+    root.insert("renderer", reinterpret_cast<const char *>(gl->glGetString(GL_RENDERER)));
+    root.insert("width", m_size.width());
+    root.insert("height", m_size.height());
+    root.insert("frames", m_frameCount);
+    root.insert("cpu_ms", percentiles(m_cpuTimes));
+    root.insert("frame_ms", percentiles(m_frameTimes));
+    if (m_gpuTimer.isAvailable())
+    {
+        root.insert("gpu_ms", percentiles(m_gpuTimes));
+    }
+    if (!m_resizeTimes.empty())
+    {
+        root.insert("target_policy",
+            RenderTargetManager::policyName(m_targets.policy()));
+        root.insert("resize_steps", m_resizeSteps);
+        root.insert("resize_allocations", qint64(m_resizeAllocations));
+        root.insert("resize_ms", percentiles(m_resizeTimes));
+    }
+
+    qInfo().noquote() << QString("%1, %2 frames at %3x%4 on %5").arg(m_name)
+        .arg(m_frameCount).arg(m_size.width()).arg(m_size.height())
+        .arg(root.value("renderer").toString());
+    qInfo().noquote() << "    CPU:  " << summary(root.value("cpu_ms").toObject());
+    qInfo().noquote() << "    Frame:" << summary(root.value("frame_ms").toObject());
+    if (m_gpuTimer.isAvailable())
+    {
+        qInfo().noquote() << "    GPU:  " << summary(root.value("gpu_ms").toObject());
+    }
+    if (!m_resizeTimes.empty())
+    {
+        qInfo().noquote() << QString("    Resize sweep: %1 steps down to %2x%3 and back, "
+            "%4 render target allocations (%5 by the host), %6 policy")
+            .arg(m_resizeSteps).arg(sweepSize(m_resizeSteps / 2).width())
+            .arg(sweepSize(m_resizeSteps / 2).height()).arg(m_resizeAllocations)
+            .arg(m_hostResizeAllocations).arg(RenderTargetManager::policyName(m_targets.policy()));
+        qInfo().noquote() << "    Resize:" << summary(root.value("resize_ms").toObject());
+    }
+
+    int result = 0;
+    if (!m_jsonPath.isEmpty())
+    {
+        QFile file(m_jsonPath);
+        if (file.open(QIODevice::OpenModeFlag::WriteOnly))
+        {
+            file.write(QJsonDocument(root).toJson());
+        }
+        else
+        {
+            qWarning() << "Failed to write" << m_jsonPath;
+            result = 1;
+        }
+    }
+    if (!m_pngPath.isEmpty())
+    {
+        // Frames are drawn into the bottom-left of a possibly larger
+        // framebuffer, the image is top-down
+        const QImage image = m_targets.framebuffer(m_target)->toImage();
+        const QSize size = m_targets.size(m_target);
+        if (!image.copy(0, image.height() - size.height(), size.width(), size.height())
+            .save(m_pngPath))
+        {
+            qWarning() << "Failed to write" << m_pngPath;
+            result = 1;
+        }
+    }
+
+    m_gpuTimer.destroy();
+    m_targets.destroy();
+    m_context.doneCurrent();
+    return result;
+}
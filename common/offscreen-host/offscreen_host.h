@@ -0,0 +1,123 @@
+#ifndef OFFSCREEN_HOST_H
+#define OFFSCREEN_HOST_H
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QSize>
+#include <QtCore/QStringList>
+#include <QtGui/QOffscreenSurface>
+#include <QtGui/QOpenGLContext>
+
+#include <vector>
+
+#include "gpu_timer.h"
+#include "render_target_manager.h"
+
+// Runs the initializeGL()/resizeGL()/paintGL() of an example window or
+// widget against a QOffscreenSurface and a framebuffer object instead of
+// showing it, for a fixed number of frames at a fixed resolution. CPU and
+// GPU time of every frame is measured and the percentiles are printed and
+// optionally written to JSON, the last frame can be saved as PNG.
+//
+// A resize sweep then drags the size down to half and back up like a
+// window edge, one resizeGL() and paintGL() per step, and reports the
+// latency from the resize to the finished frame together with the
+// render target allocations it caused, the host's own and the scene's.
+//
+// On machines without a GPU run with QT_QPA_PLATFORM=offscreen and
+// LIBGL_ALWAYS_SOFTWARE=1 (Mesa llvmpipe), or with an EGL build of Qt
+// and EGL_PLATFORM=surfaceless.
+//
+// Command line:
+//   --offscreen         enable the host
+//   --frames <n>        measured frames, 300 by default
+//   --size <w>x<h>      framebuffer size in pixels, 800x600 by default
+//   --json <path>       write frame time percentiles to this file
+//   --png <path>        save the last frame to this file
+//   --resize-sweep <n>  run a resize sweep of n steps after the frames
+//   --target-policy exact|pow2|bucketed
+//                       render target sizing, see RenderTargetManager;
+//                       exact by default, pow2 with --resize-sweep
+//
+// The example class has to declare "friend class OffscreenHost;" because
+// the GL callbacks are protected.
+class OffscreenHost
+{
+
+public:
+    static bool isRequested(const QStringList &arguments);
+
+    explicit OffscreenHost(const QStringList &arguments);
+    ~OffscreenHost();
+
+    template <typename Scene>
+    int run(Scene &scene);
+
+private:
+    bool begin();
+    void beginFrame();
+    void endFrame(bool measured);
+    QSize sweepSize(int step) const;
+    void beginResize(const QSize &size);
+    void endResize();
+    int finish();
+
+    int m_frameCount = 300;
+    int m_warmUpFrames = 10;
+    QSize m_size = QSize(800, 600);
+    QString m_jsonPath;
+    QString m_pngPath;
+    QString m_name;
+    int m_resizeSteps = 0;
+
+    QOpenGLContext m_context;
+    QOffscreenSurface m_surface;
+    RenderTargetManager m_targets;
+    int m_target;
+    GpuTimer m_gpuTimer;
+    QElapsedTimer m_timer;
+    std::vector<double> m_cpuTimes;
+    std::vector<double> m_frameTimes;
+    std::vector<double> m_gpuTimes;
+    std::vector<double> m_resizeTimes;
+    quint64 m_resizeAllocations = 0;
+    quint64 m_hostResizeAllocations = 0;
+};
+
+template <typename Scene>
+int OffscreenHost::run(Scene &scene)
+{
+    const qreal devicePixelRatio = scene.devicePixelRatio();
+    if (!begin())
+    {
+        return 1;
+    }
+
+    scene.initializeGL();
+    // Examples scale the logical size by devicePixelRatio() themselves
+    scene.resizeGL(qRound(m_size.width() / devicePixelRatio),
+        qRound(m_size.height() / devicePixelRatio));
+
+    for (int frame = 0; frame < m_warmUpFrames + m_frameCount; ++frame)
+    {
+        beginFrame();
+        scene.paintGL();
+        endFrame(frame >= m_warmUpFrames);
+    }
+
+    const quint64 allocations = RenderTargetManager::totalStats().allocations;
+    const quint64 hostAllocations = m_targets.stats().allocations;
+    for (int step = 1; step <= m_resizeSteps; ++step)
+    {
+        const QSize size = sweepSize(step);
+        beginResize(size);
+        scene.resizeGL(qRound(size.width() / devicePixelRatio),
+            qRound(size.height() / devicePixelRatio));
+        scene.paintGL();
+        endResize();
+    }
+    m_resizeAllocations = RenderTargetManager::totalStats().allocations - allocations;
+    m_hostResizeAllocations = m_targets.stats().allocations - hostAllocations;
+    return finish();
+}
+
+#endif // OFFSCREEN_HOST_H
@@ -0,0 +1,14 @@
+isEmpty(OFFSCREEN_HOST_PRI) {
+OFFSCREEN_HOST_PRI = 1
+
+include($$PWD/../gpu-timer/gpu_timer.pri)
+include($$PWD/../render-targets/render_targets.pri)
+
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/offscreen_host.h
+
+SOURCES += \
+    $$PWD/offscreen_host.cpp
+}
@@ -0,0 +1,43 @@
+#include "contact_event_queue.h"
+
+ContactEventQueue::ContactEventQueue(int capacity)
+{
+    quint32 size = 1;
+    while (size < quint32(qMax(capacity, 1)))
+    {
+        size <<= 1;
+    }
+    m_events.resize(size);
+    m_mask = size - 1;
+}
+
+bool ContactEventQueue::push(const ContactEvent &event)
+{
+    const quint32 tail = m_tail.load(std::memory_order_relaxed);
+    const quint32 head = m_head.load(std::memory_order_acquire);
+    if (tail - head == quint32(m_events.size()))
+    {
+        m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1,
+            std::memory_order_relaxed);
+        return false;
+    }
+    m_events[tail & m_mask] = event;
+    // Publishes the event together with the new tail
+    m_tail.store(tail + 1, std::memory_order_release);
+    m_pushed.store(m_pushed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return true;
+}
+
+int ContactEventQueue::pop(ContactEvent *events, int maxCount)
+{
+    const quint32 head = m_head.load(std::memory_order_relaxed);
+    const quint32 tail = m_tail.load(std::memory_order_acquire);
+    const int count = int(qMin(tail - head, quint32(qMax(maxCount, 0))));
+    for (int i = 0; i < count; ++i)
+    {
+        events[i] = m_events[(head + quint32(i)) & m_mask];
+    }
+    // Hands the slots back to the producer
+    m_head.store(head + quint32(count), std::memory_order_release);
+    return count;
+}
@@ -0,0 +1,52 @@
+#ifndef CONTACT_EVENT_QUEUE_H
+#define CONTACT_EVENT_QUEUE_H
+
+#include <QtCore/QtGlobal>
+
+#include <atomic>
+#include <vector>
+
+struct ContactEvent
+{
+    // Contact point in world units
+    float x;
+    float y;
+    // Closing impulse along the contact normal in kg m/s
+    float impulse;
+    int bodyA;
+    int bodyB;
+};
+
+// Fixed-capacity ring of contact events with one producer, the physics
+// step, and one consumer that drains it once per frame. Neither side
+// locks or allocates; events that do not fit are dropped and counted,
+// so a pile-up never stalls the step.
+class ContactEventQueue
+{
+public:
+    // Rounded up to a power of two
+    explicit ContactEventQueue(int capacity);
+
+    int capacity() const { return int(m_events.size()); }
+
+    // Producer side
+    bool push(const ContactEvent &event);
+    // Consumer side, moves up to maxCount events to events and returns
+    // how many there were
+    int pop(ContactEvent *events, int maxCount);
+
+    quint64 pushed() const { return m_pushed.load(std::memory_order_relaxed); }
+    quint64 dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<ContactEvent> m_events;
+    quint32 m_mask;
+    // Next event to pop, written by the consumer
+    alignas(64) std::atomic<quint32> m_head { 0 };
+    // Next free slot, written by the producer
+    alignas(64) std::atomic<quint32> m_tail { 0 };
+    std::atomic<quint64> m_pushed { 0 };
+    std::atomic<quint64> m_dropped { 0 };
+};
+
+#endif // CONTACT_EVENT_QUEUE_H
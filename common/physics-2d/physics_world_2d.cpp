@@ -0,0 +1,199 @@
+#include <box2d/box2d.h>
+
+#include <algorithm>
+
+#include "contact_event_queue.h"
+#include "physics_world_2d.h"
+
+// Reports the closing impulse of contact points that appeared in this
+// step, the strongest point of each contact. Runs inside b2World::Step,
+// so it only computes and pushes.
+class PhysicsWorld2D::ContactListener : public b2ContactListener
+{
+public:
+    ContactListener(ContactEventQueue *queue, float minImpulse, float unitsPerMeter)
+        : m_queue(queue)
+        , m_minImpulse(minImpulse)
+        , m_unitsPerMeter(unitsPerMeter)
+    {
+    }
+
+    void PreSolve(b2Contact *contact, const b2Manifold *oldManifold) override
+    {
+        b2PointState oldStates[b2_maxManifoldPoints];
+        b2PointState newStates[b2_maxManifoldPoints];
+        const b2Manifold *manifold = contact->GetManifold();
+        b2GetPointStates(oldStates, newStates, oldManifold, manifold);
+
+        b2Body *bodyA = contact->GetFixtureA()->GetBody();
+        b2Body *bodyB = contact->GetFixtureB()->GetBody();
+        // Static bodies have no mass and take the whole impulse
+        const float massA = bodyA->GetMass();
+        const float massB = bodyB->GetMass();
+        const float mass = massA == 0.f ? massB :
+            massB == 0.f ? massA : massA * massB / (massA + massB);
+
+        b2WorldManifold worldManifold;
+        contact->GetWorldManifold(&worldManifold);
+        float strongest = 0.f;
+        b2Vec2 point(0.f, 0.f);
+        for (int i = 0; i < manifold->pointCount; ++i)
+        {
+            if (newStates[i] != b2_addState)
+            {
+                continue;
+            }
+            const b2Vec2 &p = worldManifold.points[i];
+            // The normal points from A to B
+            const float closing = b2Dot(bodyA->GetLinearVelocityFromWorldPoint(p) -
+                bodyB->GetLinearVelocityFromWorldPoint(p), worldManifold.normal);
+            if (closing * mass > strongest)
+            {
+                strongest = closing * mass;
+                point = p;
+            }
+        }
+        if (strongest <= 0.f || strongest < m_minImpulse)
+        {
+            return;
+        }
+        const ContactEvent event = {
+            point.x * m_unitsPerMeter, point.y * m_unitsPerMeter, strongest,
+            int(bodyA->GetUserData().pointer), int(bodyB->GetUserData().pointer)
+        };
+        m_queue->push(event);
+    }
+
+private:
+    ContactEventQueue *m_queue;
+    float m_minImpulse;
+    float m_unitsPerMeter;
+};
+
+PhysicsWorld2D::PhysicsWorld2D(const QVector2D &gravity, float metersPerUnit)
+    : m_world(new b2World(b2Vec2(gravity.x() * metersPerUnit, gravity.y() * metersPerUnit)))
+    , m_metersPerUnit(metersPerUnit)
+{
+}
+
+PhysicsWorld2D::~PhysicsWorld2D()
+{
+}
+
+int PhysicsWorld2D::addStaticBox(float x, float y, float w, float h, float angle)
+{
+    return addBox(b2_staticBody, x, y, w, h, angle, 0.f, 0.5f);
+}
+
+int PhysicsWorld2D::addDynamicBox(float x, float y, float w, float h, float angle,
+    float density, float friction)
+{
+    return addBox(b2_dynamicBody, x, y, w, h, angle, density, friction);
+}
+
+int PhysicsWorld2D::addBox(int type, float x, float y, float w, float h, float angle,
+    float density, float friction)
+{
+    const int id = bodyCount();
+
+    b2BodyDef bodyDef;
+    bodyDef.type = b2BodyType(type);
+    bodyDef.position.Set(x * m_metersPerUnit, y * m_metersPerUnit);
+    bodyDef.angle = angle;
+    bodyDef.userData.pointer = uintptr_t(id);
+    b2Body *body = m_world->CreateBody(&bodyDef);
+
+    b2PolygonShape shape;
+    shape.SetAsBox(w / 2.f * m_metersPerUnit, h / 2.f * m_metersPerUnit);
+    b2FixtureDef fixtureDef;
+    fixtureDef.shape = &shape;
+    fixtureDef.density = density;
+    fixtureDef.friction = friction;
+    body->CreateFixture(&fixtureDef);
+
+    m_bodies.push_back(body);
+    m_x.push_back(x);
+    m_y.push_back(y);
+    m_width.push_back(w);
+    m_height.push_back(h);
+    m_angle.push_back(angle);
+    if (type == b2_dynamicBody)
+    {
+        m_dynamicBodies.push_back(id);
+        m_wasAwake.push_back(true);
+    }
+    markDirty(id, 1);
+    return id;
+}
+
+void PhysicsWorld2D::step(float dt)
+{
+    m_world->Step(dt, m_velocityIterations, m_positionIterations);
+
+    const float unitsPerMeter = 1.f / m_metersPerUnit;
+    m_awakeCount = 0;
+    for (size_t i = 0; i < m_dynamicBodies.size(); ++i)
+    {
+        const b2Body *body = m_bodies[m_dynamicBodies[i]];
+        const bool awake = body->IsAwake();
+        if (!awake && !m_wasAwake[i])
+        {
+            continue;
+        }
+        m_wasAwake[i] = awake;
+        m_awakeCount += awake;
+
+        const int id = m_dynamicBodies[i];
+        const b2Vec2 &position = body->GetPosition();
+        m_x[id] = position.x * unitsPerMeter;
+        m_y[id] = position.y * unitsPerMeter;
+        m_angle[id] = body->GetAngle();
+        markDirty(id, 1);
+    }
+}
+
+void PhysicsWorld2D::setContactEvents(ContactEventQueue *queue, float minImpulse)
+{
+    m_world->SetContactListener(nullptr);
+    m_contactListener.reset();
+    if (queue)
+    {
+        m_contactListener.reset(new ContactListener(queue, minImpulse, 1.f / m_metersPerUnit));
+        m_world->SetContactListener(m_contactListener.get());
+    }
+}
+
+void PhysicsWorld2D::takeDirtyRanges(std::vector<Range> *ranges)
+{
+    ranges->clear();
+    // Ranges from one step are already sorted, several steps interleave
+    std::sort(m_dirty.begin(), m_dirty.end(), [](const Range &a, const Range &b)
+    {
+        return a.first < b.first;
+    });
+    for (const Range &range : m_dirty)
+    {
+        if (!ranges->empty() && range.first <= ranges->back().first + ranges->back().count)
+        {
+            Range &last = ranges->back();
+            last.count = qMax(last.count, range.first + range.count - last.first);
+        }
+        else
+        {
+            ranges->push_back(range);
+        }
+    }
+    m_dirty.clear();
+}
+
+void PhysicsWorld2D::markDirty(int first, int count)
+{
+    // Neighbouring ids extend the last range, so a step over a block of
+    // awake bodies yields one range
+    if (!m_dirty.empty() && m_dirty.back().first + m_dirty.back().count == first)
+    {
+        m_dirty.back().count += count;
+        return;
+    }
+    m_dirty.push_back({ first, count });
+}
@@ -0,0 +1,93 @@
+#ifndef PHYSICS_WORLD_2D_H
+#define PHYSICS_WORLD_2D_H
+
+#include <QtGui/QVector2D>
+
+#include <memory>
+#include <vector>
+
+class b2Body;
+class b2World;
+class ContactEventQueue;
+
+// Box2D world for box-shaped bodies, expressed in the example's world
+// units. Body state is published as structure-of-arrays indexed by the
+// id returned from addBox(), so a renderer can read it directly.
+//
+// Only bodies that were awake during a step are synced and recorded as
+// dirty until takeDirtyRanges() collects them, so static and sleeping
+// bodies cost the renderer nothing.
+//
+// Impacts can be reported to a ContactEventQueue: one event per contact
+// in the step where its bodies start to touch, none for resting contacts.
+class PhysicsWorld2D
+{
+
+public:
+    struct Range
+    {
+        int first;
+        int count;
+    };
+
+    // metersPerUnit - Box2D is tuned for objects of 0.1 to 10 meters,
+    // world units are scaled into that range
+    PhysicsWorld2D(const QVector2D &gravity, float metersPerUnit);
+    ~PhysicsWorld2D();
+
+    // x, y - center, w, h - size, angle - rotation in radians,
+    // all in world units. Returns the body id.
+    int addStaticBox(float x, float y, float w, float h, float angle = 0.f);
+    int addDynamicBox(float x, float y, float w, float h, float angle = 0.f,
+        float density = 1.f, float friction = 0.5f);
+
+    void step(float dt);
+
+    // Pushes impacts from step() to queue, skipping those under
+    // minImpulse in kg m/s. nullptr stops the events.
+    void setContactEvents(ContactEventQueue *queue, float minImpulse = 0.f);
+
+    int bodyCount() const { return int(m_x.size()); }
+    int awakeCount() const { return m_awakeCount; }
+
+    const float *x() const { return m_x.data(); }
+    const float *y() const { return m_y.data(); }
+    const float *width() const { return m_width.data(); }
+    const float *height() const { return m_height.data(); }
+    // Radians
+    const float *angle() const { return m_angle.data(); }
+
+    // Sorted, non-overlapping ranges of bodies changed since the last
+    // call. New bodies are included once.
+    void takeDirtyRanges(std::vector<Range> *ranges);
+
+private:
+    class ContactListener;
+
+    int addBox(int type, float x, float y, float w, float h, float angle,
+        float density, float friction);
+    void markDirty(int first, int count);
+
+    std::unique_ptr<b2World> m_world;
+    std::unique_ptr<ContactListener> m_contactListener;
+    float m_metersPerUnit;
+    int m_velocityIterations = 8;
+    int m_positionIterations = 3;
+
+    std::vector<b2Body *> m_bodies;
+    // Ids of bodies that can move and whether each was awake after the
+    // previous step; the step that puts a body to sleep still moves it
+    std::vector<int> m_dynamicBodies;
+    std::vector<char> m_wasAwake;
+    int m_awakeCount = 0;
+
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    std::vector<float> m_width;
+    std::vector<float> m_height;
+    std::vector<float> m_angle;
+
+    std::vector<Range> m_dirty;
+};
+
+#endif // PHYSICS_WORLD_2D_H
@@ -0,0 +1,21 @@
+isEmpty(PHYSICS_WORLD_2D_PRI) {
+PHYSICS_WORLD_2D_PRI = 1
+
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/contact_event_queue.h \
+    $$PWD/physics_world_2d.h
+
+SOURCES += \
+    $$PWD/contact_event_queue.cpp \
+    $$PWD/physics_world_2d.cpp
+
+# Box2D 2.4, pass BOX2D_DIR=<install prefix> to qmake when it is not
+# installed system-wide
+!isEmpty(BOX2D_DIR) {
+    INCLUDEPATH += $$BOX2D_DIR/include
+    LIBS += -L$$BOX2D_DIR/lib
+}
+LIBS += -lbox2d
+}
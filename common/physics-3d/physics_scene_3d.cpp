@@ -0,0 +1,253 @@
+#include <btBulletDynamicsCommon.h>
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
+#include <BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h>
+#include <BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
+#include <LinearMath/btThreads.h>
+
+#include <QtCore/QElapsedTimer>
+
+#include "physics_scene_3d.h"
+
+static_assert(sizeof(btScalar) == sizeof(float),
+    "Instance matrices are written straight from btTransform");
+
+namespace
+{
+    // Adds timers around the collision and solver phases. The collision
+    // part mirrors btCollisionWorld::performDiscreteCollisionDetection()
+    // with a clock between the broadphase and the narrowphase.
+    template <class World>
+    class TimedWorld : public World
+    {
+
+    public:
+        template <class... Args>
+        TimedWorld(PhysicsScene3D::Timings *timings, Args... args)
+            : World(args...)
+            , m_timings(timings)
+        {
+        }
+
+        void performDiscreteCollisionDetection() override
+        {
+            QElapsedTimer timer;
+            timer.start();
+            this->updateAabbs();
+            this->computeOverlappingPairs();
+            const qint64 broadphaseNs = timer.nsecsElapsed();
+
+            btDispatcher *dispatcher = this->getDispatcher();
+            if (dispatcher)
+            {
+                dispatcher->dispatchAllCollisionPairs(
+                    this->getBroadphase()->getOverlappingPairCache(),
+                    this->getDispatchInfo(), dispatcher);
+            }
+            m_timings->broadphaseMs += broadphaseNs / 1e6;
+            m_timings->narrowphaseMs += (timer.nsecsElapsed() - broadphaseNs) / 1e6;
+        }
+
+    protected:
+        void solveConstraints(btContactSolverInfo &solverInfo) override
+        {
+            QElapsedTimer timer;
+            timer.start();
+            World::solveConstraints(solverInfo);
+            m_timings->solveMs += timer.nsecsElapsed() / 1e6;
+        }
+
+    private:
+        PhysicsScene3D::Timings *m_timings;
+    };
+
+    // Bullet has one global scheduler, the default one (OpenMP, TBB or
+    // its own threads, whatever Bullet was built with) is created once.
+    // Null when Bullet was built without BT_THREADSAFE.
+    btITaskScheduler *defaultTaskScheduler()
+    {
+        static btITaskScheduler *scheduler = btCreateDefaultTaskScheduler();
+        return scheduler;
+    }
+}
+
+PhysicsScene3D::PhysicsScene3D(int threadCount)
+{
+    btITaskScheduler *scheduler = threadCount > 1 ? defaultTaskScheduler() : nullptr;
+    if (scheduler)
+    {
+        scheduler->setNumThreads(qMin(threadCount, scheduler->getMaxNumThreads()));
+        btSetTaskScheduler(scheduler);
+        m_threadCount = scheduler->getNumThreads();
+
+        // Large enough pools that worker threads do not fall back to malloc
+        btDefaultCollisionConstructionInfo constructionInfo;
+        constructionInfo.m_defaultMaxPersistentManifoldPoolSize = 80000;
+        constructionInfo.m_defaultMaxCollisionAlgorithmPoolSize = 80000;
+        m_collisionConfiguration.reset(new btDefaultCollisionConfiguration(constructionInfo));
+        m_dispatcher.reset(new btCollisionDispatcherMt(m_collisionConfiguration.get(), 40));
+        m_broadphase.reset(new btDbvtBroadphase());
+        m_solverPool.reset(new btConstraintSolverPoolMt(m_threadCount));
+        m_world.reset(new TimedWorld<btDiscreteDynamicsWorldMt>(&m_timings,
+            m_dispatcher.get(), m_broadphase.get(), m_solverPool.get(), nullptr,
+            m_collisionConfiguration.get()));
+    }
+    else
+    {
+        btSetTaskScheduler(btGetSequentialTaskScheduler());
+        m_threadCount = 1;
+
+        m_collisionConfiguration.reset(new btDefaultCollisionConfiguration());
+        m_dispatcher.reset(new btCollisionDispatcher(m_collisionConfiguration.get()));
+        m_broadphase.reset(new btDbvtBroadphase());
+        m_solver.reset(new btSequentialImpulseConstraintSolver());
+        m_world.reset(new TimedWorld<btDiscreteDynamicsWorld>(&m_timings,
+            m_dispatcher.get(), m_broadphase.get(), m_solver.get(),
+            m_collisionConfiguration.get()));
+    }
+    m_world->setGravity(btVector3(0.f, -9.81f, 0.f));
+}
+
+PhysicsScene3D::~PhysicsScene3D()
+{
+    auto destroyBody = [this](btRigidBody *body)
+    {
+        m_world->removeRigidBody(body);
+        delete body->getMotionState();
+        delete body;
+    };
+    for (btRigidBody *body : m_staticBodies)
+    {
+        destroyBody(body);
+    }
+    for (ShapeBodies &shapeBodies : m_shapeBodies)
+    {
+        for (btRigidBody *body : shapeBodies.bodies)
+        {
+            destroyBody(body);
+        }
+    }
+}
+
+void PhysicsScene3D::addGround(float y, float halfExtent)
+{
+    m_collisionShapes.emplace_back(new btBoxShape(btVector3(halfExtent, 1.f, halfExtent)));
+
+    btTransform transform;
+    transform.setIdentity();
+    transform.setOrigin(btVector3(0.f, y - 1.f, 0.f));
+    btRigidBody::btRigidBodyConstructionInfo info(0.f, new btDefaultMotionState(transform),
+        m_collisionShapes.back().get());
+    btRigidBody *body = new btRigidBody(info);
+    // Combined with the spheres' own rolling friction, so they come to rest
+    body->setRollingFriction(1.f);
+    m_world->addRigidBody(body);
+    m_staticBodies.push_back(body);
+}
+
+void PhysicsScene3D::addBody(Shape shape, const QVector3D &position, float size, float mass)
+{
+    btCollisionShape *bodyShape = collisionShape(shape, size);
+    btVector3 inertia(0.f, 0.f, 0.f);
+    bodyShape->calculateLocalInertia(mass, inertia);
+
+    btTransform transform;
+    transform.setIdentity();
+    transform.setOrigin(btVector3(position.x(), position.y(), position.z()));
+    btRigidBody::btRigidBodyConstructionInfo info(mass, new btDefaultMotionState(transform),
+        bodyShape, inertia);
+    btRigidBody *body = new btRigidBody(info);
+    if (shape == Shape::Sphere)
+    {
+        body->setRollingFriction(0.02f);
+    }
+    m_world->addRigidBody(body);
+
+    ShapeBodies &shapeBodies = m_shapeBodies[int(shape)];
+    shapeBodies.bodies.push_back(body);
+    shapeBodies.sizes.push_back(size);
+    shapeBodies.matrices.resize(shapeBodies.bodies.size() * 16);
+}
+
+void PhysicsScene3D::step(float elapsedSeconds, int maxSubSteps, float fixedStep)
+{
+    m_timings = Timings();
+    QElapsedTimer timer;
+    timer.start();
+    m_timings.substeps = m_world->stepSimulation(elapsedSeconds, maxSubSteps, fixedStep);
+    m_timings.totalMs = timer.nsecsElapsed() / 1e6;
+
+    updateInstances();
+}
+
+int PhysicsScene3D::instanceCount(Shape shape) const
+{
+    return int(m_shapeBodies[int(shape)].bodies.size());
+}
+
+const float *PhysicsScene3D::instances(Shape shape) const
+{
+    return m_shapeBodies[int(shape)].matrices.data();
+}
+
+const std::vector<int> &PhysicsScene3D::movedInstances(Shape shape) const
+{
+    return m_shapeBodies[int(shape)].moved;
+}
+
+btCollisionShape *PhysicsScene3D::collisionShape(Shape shape, float size)
+{
+    for (const CachedShape &cached : m_cachedShapes)
+    {
+        if (cached.shape == shape && cached.size == size)
+        {
+            return cached.collisionShape;
+        }
+    }
+
+    if (shape == Shape::Box)
+    {
+        m_collisionShapes.emplace_back(new btBoxShape(btVector3(size, size, size) / 2.f));
+    }
+    else
+    {
+        m_collisionShapes.emplace_back(new btSphereShape(size / 2.f));
+    }
+    m_cachedShapes.push_back({ shape, size, m_collisionShapes.back().get() });
+    return m_collisionShapes.back().get();
+}
+
+void PhysicsScene3D::updateInstances()
+{
+    m_activeCount = 0;
+    for (ShapeBodies &shapeBodies : m_shapeBodies)
+    {
+        float *matrix = shapeBodies.matrices.data();
+        shapeBodies.moved.clear();
+        const int bodyCount = int(shapeBodies.bodies.size());
+        for (int i = 0; i < bodyCount; ++i, matrix += 16)
+        {
+            const btRigidBody *body = shapeBodies.bodies[i];
+            // Motion states of sleeping bodies are not synchronized,
+            // their matrices are still up to date
+            if (!body->isActive() && i < shapeBodies.written)
+            {
+                continue;
+            }
+            m_activeCount += body->isActive();
+            shapeBodies.moved.push_back(i);
+
+            // Interpolated between the last two fixed steps
+            btTransform transform;
+            body->getMotionState()->getWorldTransform(transform);
+            transform.getOpenGLMatrix(matrix);
+            const float size = shapeBodies.sizes[i];
+            for (int column = 0; column < 3; ++column)
+            {
+                matrix[column * 4] *= size;
+                matrix[column * 4 + 1] *= size;
+                matrix[column * 4 + 2] *= size;
+            }
+        }
+        shapeBodies.written = bodyCount;
+    }
+}
@@ -0,0 +1,111 @@
+#ifndef PHYSICS_SCENE_3D_H
+#define PHYSICS_SCENE_3D_H
+
+#include <QtGui/QVector3D>
+
+#include <memory>
+#include <vector>
+
+class btBroadphaseInterface;
+class btCollisionConfiguration;
+class btCollisionDispatcher;
+class btCollisionShape;
+class btConstraintSolver;
+class btConstraintSolverPoolMt;
+class btDiscreteDynamicsWorld;
+class btRigidBody;
+
+// Bullet rigid-body scene of boxes and spheres on a static ground. After
+// every step the motion states are read into one packed array of
+// column-major 4x4 model matrices per shape, ready to be uploaded as an
+// instance buffer; a unit cube or a sphere of diameter 1 drawn with them
+// matches the collision shape.
+//
+// With threadCount > 1 the scene uses Bullet's multithreaded dispatcher
+// and solver pool, which needs Bullet built with BT_THREADSAFE. Otherwise
+// or when no task scheduler is available it runs single-threaded.
+class PhysicsScene3D
+{
+
+public:
+    enum class Shape
+    {
+        Box,
+        Sphere
+    };
+    static constexpr int shapeCount = 2;
+
+    // Milliseconds spent in the last step(), summed over its substeps.
+    // Broadphase includes the AABB update.
+    struct Timings
+    {
+        double broadphaseMs = 0.0;
+        double narrowphaseMs = 0.0;
+        double solveMs = 0.0;
+        double totalMs = 0.0;
+        int substeps = 0;
+    };
+
+    explicit PhysicsScene3D(int threadCount = 1);
+    ~PhysicsScene3D();
+
+    int threadCount() const { return m_threadCount; }
+
+    // A static box with its top face at height y
+    void addGround(float y, float halfExtent);
+    // size - edge length or diameter
+    void addBody(Shape shape, const QVector3D &position, float size, float mass = 1.f);
+
+    // Advances by elapsedSeconds in fixed steps of fixedStep, at most
+    // maxSubSteps of them, then refreshes the instance arrays
+    void step(float elapsedSeconds, int maxSubSteps = 4, float fixedStep = 1.f / 60.f);
+
+    const Timings &timings() const { return m_timings; }
+    // Bodies that Bullet has not put to sleep
+    int activeCount() const { return m_activeCount; }
+
+    int instanceCount(Shape shape) const;
+    // 16 floats per instance
+    const float *instances(Shape shape) const;
+    // Instances rewritten by the last step(), in ascending order
+    const std::vector<int> &movedInstances(Shape shape) const;
+
+private:
+    struct ShapeBodies
+    {
+        std::vector<btRigidBody *> bodies;
+        std::vector<float> sizes;
+        std::vector<float> matrices;
+        std::vector<int> moved;
+        // Bodies up to here have been written at least once
+        int written = 0;
+    };
+
+    btCollisionShape *collisionShape(Shape shape, float size);
+    void updateInstances();
+
+    int m_threadCount = 1;
+    Timings m_timings;
+    int m_activeCount = 0;
+
+    std::unique_ptr<btCollisionConfiguration> m_collisionConfiguration;
+    std::unique_ptr<btCollisionDispatcher> m_dispatcher;
+    std::unique_ptr<btBroadphaseInterface> m_broadphase;
+    std::unique_ptr<btConstraintSolver> m_solver;
+    std::unique_ptr<btConstraintSolverPoolMt> m_solverPool;
+    std::unique_ptr<btDiscreteDynamicsWorld> m_world;
+
+    // Shapes are shared by every body of the same kind and size
+    struct CachedShape
+    {
+        Shape shape;
+        float size;
+        btCollisionShape *collisionShape;
+    };
+    std::vector<CachedShape> m_cachedShapes;
+    std::vector<std::unique_ptr<btCollisionShape>> m_collisionShapes;
+    std::vector<btRigidBody *> m_staticBodies;
+    ShapeBodies m_shapeBodies[shapeCount];
+};
+
+#endif // PHYSICS_SCENE_3D_H
@@ -0,0 +1,22 @@
+isEmpty(PHYSICS_SCENE_3D_PRI) {
+PHYSICS_SCENE_3D_PRI = 1
+
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/physics_scene_3d.h
+
+SOURCES += \
+    $$PWD/physics_scene_3d.cpp
+
+# Bullet 2.88 or newer, built with BT_THREADSAFE=ON for the
+# multithreaded solver. Pass BULLET_DIR=<install prefix> to qmake
+# when pkg-config cannot find it.
+!isEmpty(BULLET_DIR) {
+    INCLUDEPATH += $$BULLET_DIR/include/bullet
+    LIBS += -L$$BULLET_DIR/lib -lBulletDynamics -lBulletCollision -lLinearMath
+} else {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += bullet
+}
+}
@@ -0,0 +1,342 @@
+#include <QtGui/QOpenGLContext>
+#include <QtMath>
+
+#include <algorithm>
+
+#include "rect_batch.h"
+#include "shader_cache.h"
+
+namespace
+{
+    const int positionLocation = 0;
+    const int rectLocation = 1;
+    const int angleLocation = 2;
+    const int colorLocation = 3;
+
+    const int floatsPerRect = 8;
+    const int floatsPerVertex = 2 + floatsPerRect;
+    const int verticesPerRect = 6;
+
+    // Two triangles of the unit quad for the expanded path
+    const float expandedCorners[] = {
+        -0.5f, -0.5f,
+        0.5f, -0.5f,
+        -0.5f, 0.5f,
+        -0.5f, 0.5f,
+        0.5f, -0.5f,
+        0.5f, 0.5f
+    };
+}
+
+RectBatch::RectBatch()
+    : m_quadBuffer(QOpenGLBuffer::Type::VertexBuffer)
+    , m_retainedBuffer(QOpenGLBuffer::Type::VertexBuffer)
+{
+}
+
+void RectBatch::initialize(GLStateCache *state)
+{
+    initializeOpenGLFunctions();
+    m_state = state;
+
+    const QByteArray vertShaderSrc =
+        "attribute vec2 aPosition;\n"
+        "attribute vec4 aRect;\n"
+        "attribute float aAngle;\n"
+        "attribute vec3 aColor;\n"
+        "uniform mat4 uProjViewMatrix;\n"
+        "varying vec3 vColor;\n"
+        "void main()\n"
+        "{\n"
+        "    vec2 p = aPosition * aRect.zw;\n"
+        "    float c = cos(aAngle);\n"
+        "    float s = sin(aAngle);\n"
+        "    p = vec2(c * p.x - s * p.y, s * p.x + c * p.y) + aRect.xy;\n"
+        "    gl_Position = uProjViewMatrix * vec4(p, 0.0, 1.0);\n"
+        "    vColor = aColor;\n"
+        "}\n";
+
+    const QByteArray fragShaderSrc =
+        "#ifdef GL_ES\n"
+        "precision mediump float;\n"
+        "#endif\n"
+        "varying vec3 vColor;\n"
+        "void main()\n"
+        "{\n"
+        "    gl_FragColor = vec4(vColor, 1.0);\n"
+        "}\n";
+
+    m_program = ShaderCache::instance()->program(vertShaderSrc, fragShaderSrc, {
+        { "aPosition", positionLocation },
+        { "aRect", rectLocation },
+        { "aAngle", angleLocation },
+        { "aColor", colorLocation }
+    });
+    m_uProjViewMatrixLocation = m_program->uniformLocation("uProjViewMatrix");
+
+    // Pick an instancing entry point: core ES 3.0 / GL 3.3 first,
+    // then the extensions that expose the same functionality on ES 2.0
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    const QSurfaceFormat format = context->format();
+    const char *drawName = nullptr;
+    const char *divisorName = nullptr;
+    if ((context->isOpenGLES() && format.majorVersion() >= 3) ||
+        (!context->isOpenGLES() && format.version() >= qMakePair(3, 3)))
+    {
+        drawName = "glDrawArraysInstanced";
+        divisorName = "glVertexAttribDivisor";
+    }
+    else if (context->hasExtension("GL_ANGLE_instanced_arrays"))
+    {
+        drawName = "glDrawArraysInstancedANGLE";
+        divisorName = "glVertexAttribDivisorANGLE";
+    }
+    else if (context->hasExtension("GL_ARB_instanced_arrays"))
+    {
+        drawName = "glDrawArraysInstancedARB";
+        divisorName = "glVertexAttribDivisorARB";
+    }
+    if (drawName)
+    {
+        m_drawArraysInstanced = reinterpret_cast<DrawArraysInstancedFunc>(
+            context->getProcAddress(drawName));
+        m_vertexAttribDivisor = reinterpret_cast<VertexAttribDivisorFunc>(
+            context->getProcAddress(divisorName));
+    }
+    m_instanced = m_drawArraysInstanced && m_vertexAttribDivisor;
+
+    if (m_instanced)
+    {
+        float quadCorners[] = {
+            -0.5f, -0.5f,
+            0.5f, -0.5f,
+            -0.5f, 0.5f,
+            0.5f, 0.5f
+        };
+        m_quadBuffer.create();
+        m_quadBuffer.bind();
+        m_quadBuffer.allocate(quadCorners, sizeof(quadCorners));
+        m_quadBuffer.release();
+    }
+
+    m_retainedBuffer.setUsagePattern(QOpenGLBuffer::UsagePattern::DynamicDraw);
+    m_retainedBuffer.create();
+    // QOpenGLBuffer changed the binding behind the cache's back
+    m_state->invalidate(GLStateCache::StateBit::Buffers);
+    m_streamBuffer.initialize(m_state);
+}
+
+void RectBatch::destroy()
+{
+    m_quadBuffer.destroy();
+    m_streamBuffer.destroy();
+    m_retainedBuffer.destroy();
+    m_retainedData.clear();
+    m_retainedCount = 0;
+    // The program belongs to the shader cache
+    m_program = nullptr;
+}
+
+void RectBatch::begin(const QMatrix4x4 &projViewMatrix)
+{
+    m_projViewMatrix = projViewMatrix;
+    m_data.clear();
+    m_rectCount = 0;
+}
+
+void RectBatch::endFrame()
+{
+    m_streamBuffer.endFrame();
+    m_frameDrawCallCount = m_drawCallCount;
+    m_drawCallCount = 0;
+}
+
+void RectBatch::add(float x, float y, float w, float h, float angle,
+    const QVector3D &color)
+{
+    const float rect[floatsPerRect] = {
+        x, y, w, h, qDegreesToRadians(angle),
+        color.x(), color.y(), color.z()
+    };
+    m_data.insert(m_data.end(), rect, rect + floatsPerRect);
+    m_rectCount++;
+}
+
+void RectBatch::end()
+{
+    if (m_rectCount == 0)
+    {
+        return;
+    }
+
+    m_state->useProgram(m_program);
+    m_state->setUniform(m_uProjViewMatrixLocation, m_projViewMatrix);
+
+    // Written straight into the ring, the GPU may still be reading
+    // earlier frames from other parts of it. Batches larger than a
+    // quarter of the ring are split so that several frames stay in it.
+    const int floatsPerSlot = m_instanced ? floatsPerRect : verticesPerRect * floatsPerVertex;
+    const int bytesPerSlot = floatsPerSlot * int(sizeof(float));
+    const int maxChunk = m_streamBuffer.capacity() / 4 / bytesPerSlot;
+    for (int first = 0; first < m_rectCount; first += maxChunk)
+    {
+        const int count = qMin(maxChunk, m_rectCount - first);
+        const StreamingBuffer::Allocation allocation = m_streamBuffer.allocate(
+            count * bytesPerSlot);
+        float *dst = static_cast<float *>(allocation.data);
+        const float *src = &m_data[size_t(first) * floatsPerRect];
+        if (m_instanced)
+        {
+            std::copy(src, src + size_t(count) * floatsPerRect, dst);
+        }
+        else
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                expandRect(src + size_t(i) * floatsPerRect, dst + size_t(i) * floatsPerSlot);
+            }
+        }
+        m_streamBuffer.commit();
+        if (m_instanced)
+        {
+            drawInstanced(m_streamBuffer.bufferId(), allocation.offset, count);
+        }
+        else
+        {
+            drawExpanded(m_streamBuffer.bufferId(), allocation.offset, count);
+        }
+        m_drawCallCount++;
+    }
+}
+
+void RectBatch::resizeRetained(int count)
+{
+    const int floatsPerSlot = m_instanced ? floatsPerRect : verticesPerRect * floatsPerVertex;
+    m_retainedCount = count;
+    m_retainedData.assign(size_t(count) * floatsPerSlot, 0.f);
+    m_state->bindBuffer(GL_ARRAY_BUFFER, m_retainedBuffer.bufferId());
+    m_retainedBuffer.allocate(m_retainedData.data(), int(m_retainedData.size() * sizeof(float)));
+}
+
+void RectBatch::updateRetained(int first, int count, const RectArrays &rects)
+{
+    count = qMin(count, m_retainedCount - first);
+    if (first < 0 || count <= 0)
+    {
+        return;
+    }
+
+    const int floatsPerSlot = m_instanced ? floatsPerRect : verticesPerRect * floatsPerVertex;
+    float *dst = &m_retainedData[size_t(first) * floatsPerSlot];
+    for (int i = first; i < first + count; ++i)
+    {
+        const float rect[floatsPerRect] = {
+            rects.x[i], rects.y[i], rects.w[i], rects.h[i], rects.angle[i],
+            rects.color[i].x(), rects.color[i].y(), rects.color[i].z()
+        };
+        if (m_instanced)
+        {
+            std::copy(rect, rect + floatsPerRect, dst);
+        }
+        else
+        {
+            expandRect(rect, dst);
+        }
+        dst += floatsPerSlot;
+    }
+
+    const int offset = first * floatsPerSlot * int(sizeof(float));
+    const int size = count * floatsPerSlot * int(sizeof(float));
+    m_state->bindBuffer(GL_ARRAY_BUFFER, m_retainedBuffer.bufferId());
+    m_retainedBuffer.write(offset, &m_retainedData[size_t(first) * floatsPerSlot], size);
+    m_retainedUploadBytes += size;
+}
+
+void RectBatch::drawRetained(const QMatrix4x4 &projViewMatrix)
+{
+    if (m_retainedCount == 0)
+    {
+        return;
+    }
+
+    m_state->useProgram(m_program);
+    m_state->setUniform(m_uProjViewMatrixLocation, projViewMatrix);
+    if (m_instanced)
+    {
+        drawInstanced(m_retainedBuffer.bufferId(), 0, m_retainedCount);
+    }
+    else
+    {
+        drawExpanded(m_retainedBuffer.bufferId(), 0, m_retainedCount);
+    }
+    m_drawCallCount++;
+}
+
+qint64 RectBatch::takeRetainedUploadBytes()
+{
+    const qint64 bytes = m_retainedUploadBytes;
+    m_retainedUploadBytes = 0;
+    return bytes;
+}
+
+void RectBatch::expandRect(const float *rect, float *vertices)
+{
+    for (int v = 0; v < verticesPerRect; ++v)
+    {
+        vertices[0] = expandedCorners[v * 2];
+        vertices[1] = expandedCorners[v * 2 + 1];
+        std::copy(rect, rect + floatsPerRect, vertices + 2);
+        vertices += floatsPerVertex;
+    }
+}
+
+void RectBatch::drawInstanced(GLuint buffer, int offset, int rectCount)
+{
+    const int stride = floatsPerRect * sizeof(float);
+
+    m_state->bindBuffer(GL_ARRAY_BUFFER, m_quadBuffer.bufferId());
+    m_program->setAttributeBuffer(positionLocation, GL_FLOAT, 0, 2);
+    m_program->enableAttributeArray(positionLocation);
+
+    m_state->bindBuffer(GL_ARRAY_BUFFER, buffer);
+    m_program->setAttributeBuffer(rectLocation, GL_FLOAT, offset, 4, stride);
+    m_program->setAttributeBuffer(angleLocation, GL_FLOAT, offset + 4 * sizeof(float), 1, stride);
+    m_program->setAttributeBuffer(colorLocation, GL_FLOAT, offset + 5 * sizeof(float), 3, stride);
+    m_program->enableAttributeArray(rectLocation);
+    m_program->enableAttributeArray(angleLocation);
+    m_program->enableAttributeArray(colorLocation);
+    m_vertexAttribDivisor(rectLocation, 1);
+    m_vertexAttribDivisor(angleLocation, 1);
+    m_vertexAttribDivisor(colorLocation, 1);
+
+    m_drawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, rectCount);
+
+    // Leave the attribute state as the rest of the code expects it
+    m_vertexAttribDivisor(rectLocation, 0);
+    m_vertexAttribDivisor(angleLocation, 0);
+    m_vertexAttribDivisor(colorLocation, 0);
+    m_program->disableAttributeArray(rectLocation);
+    m_program->disableAttributeArray(angleLocation);
+    m_program->disableAttributeArray(colorLocation);
+}
+
+void RectBatch::drawExpanded(GLuint buffer, int offset, int rectCount)
+{
+    const int stride = floatsPerVertex * sizeof(float);
+
+    m_state->bindBuffer(GL_ARRAY_BUFFER, buffer);
+    m_program->setAttributeBuffer(positionLocation, GL_FLOAT, offset, 2, stride);
+    m_program->setAttributeBuffer(rectLocation, GL_FLOAT, offset + 2 * sizeof(float), 4, stride);
+    m_program->setAttributeBuffer(angleLocation, GL_FLOAT, offset + 6 * sizeof(float), 1, stride);
+    m_program->setAttributeBuffer(colorLocation, GL_FLOAT, offset + 7 * sizeof(float), 3, stride);
+    m_program->enableAttributeArray(positionLocation);
+    m_program->enableAttributeArray(rectLocation);
+    m_program->enableAttributeArray(angleLocation);
+    m_program->enableAttributeArray(colorLocation);
+
+    glDrawArrays(GL_TRIANGLES, 0, rectCount * verticesPerRect);
+
+    m_program->disableAttributeArray(rectLocation);
+    m_program->disableAttributeArray(angleLocation);
+    m_program->disableAttributeArray(colorLocation);
+}
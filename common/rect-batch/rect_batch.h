@@ -0,0 +1,110 @@
+#ifndef RECT_BATCH_H
+#define RECT_BATCH_H
+
+#include <QtGui/QMatrix4x4>
+#include <QtGui/QOpenGLFunctions>
+#include <QtGui/QVector3D>
+#include <QtOpenGL/QOpenGLBuffer>
+#include <QtOpenGL/QOpenGLShaderProgram>
+
+#include <vector>
+
+#include "gl_state_cache.h"
+#include "streaming_buffer.h"
+
+// Collects colored rectangles between begin() and end() and draws them
+// with a single draw call (one per 1 MB of streamed data). Per-rectangle
+// data is sub-allocated from a StreamingBuffer every frame. When
+// instancing is available (ES 3.0, GL 3.3, ANGLE_instanced_arrays or
+// ARB_instanced_arrays) one instance is drawn per rectangle, otherwise
+// every rectangle is expanded into six vertices.
+//
+// Rectangles that mostly stay put, such as resting physics bodies, can be
+// kept in a retained buffer instead: only the ranges passed to
+// updateRetained() are uploaded again and drawRetained() draws all of
+// them with one call.
+class RectBatch : protected QOpenGLFunctions
+{
+
+public:
+    RectBatch();
+
+    // Must be called with a current OpenGL context. Program, buffer and
+    // uniform changes go through state, which must outlive the batch.
+    void initialize(GLStateCache *state);
+    void destroy();
+
+    void begin(const QMatrix4x4 &projViewMatrix);
+    // x, y - center, w, h - size, angle - rotation in degrees
+    void add(float x, float y, float w, float h, float angle,
+        const QVector3D &color);
+    void end();
+
+    // Structure-of-arrays input for the retained buffer, angle in radians
+    struct RectArrays
+    {
+        const float *x;
+        const float *y;
+        const float *w;
+        const float *h;
+        const float *angle;
+        const QVector3D *color;
+    };
+
+    void resizeRetained(int count);
+    // Copies rectangles first .. first + count - 1 from rects, which is
+    // indexed the same way as the retained buffer
+    void updateRetained(int first, int count, const RectArrays &rects);
+    void drawRetained(const QMatrix4x4 &projViewMatrix);
+    int retainedCount() const { return m_retainedCount; }
+    // Bytes uploaded by updateRetained() since the last call
+    qint64 takeRetainedUploadBytes();
+
+    // Call once per frame after the last end()
+    void endFrame();
+    const StreamingBuffer::Stats &streamStats() const { return m_streamBuffer.stats(); }
+
+    bool isInstanced() const { return m_instanced; }
+    int rectCount() const { return m_rectCount; }
+    // Of the last frame that endFrame() finished, over every begin() and
+    // end() pair and the retained draws
+    int drawCallCount() const { return m_frameDrawCallCount; }
+
+private:
+    // offset - byte offset of the first rectangle in buffer
+    void drawInstanced(GLuint buffer, int offset, int rectCount);
+    void drawExpanded(GLuint buffer, int offset, int rectCount);
+    static void expandRect(const float *rect, float *vertices);
+
+    typedef void (QOPENGLF_APIENTRYP DrawArraysInstancedFunc)(GLenum mode,
+        GLint first, GLsizei count, GLsizei instanceCount);
+    typedef void (QOPENGLF_APIENTRYP VertexAttribDivisorFunc)(GLuint index,
+        GLuint divisor);
+
+    GLStateCache *m_state = nullptr;
+    QOpenGLShaderProgram *m_program = nullptr;
+    QOpenGLBuffer m_quadBuffer;
+    StreamingBuffer m_streamBuffer;
+    int m_uProjViewMatrixLocation;
+    QMatrix4x4 m_projViewMatrix;
+
+    bool m_instanced = false;
+    DrawArraysInstancedFunc m_drawArraysInstanced = nullptr;
+    VertexAttribDivisorFunc m_vertexAttribDivisor = nullptr;
+
+    // x, y, w, h, angle (radians), r, g, b per rectangle
+    std::vector<float> m_data;
+    int m_rectCount = 0;
+    // Since the last endFrame(), the setScissor() and setTexture() style
+    // flushes through end() and begin() do not reset it
+    int m_drawCallCount = 0;
+    int m_frameDrawCallCount = 0;
+
+    // Laid out like the stream buffer of the active path
+    QOpenGLBuffer m_retainedBuffer;
+    std::vector<float> m_retainedData;
+    int m_retainedCount = 0;
+    qint64 m_retainedUploadBytes = 0;
+};
+
+#endif // RECT_BATCH_H
@@ -0,0 +1,15 @@
+isEmpty(RECT_BATCH_PRI) {
+RECT_BATCH_PRI = 1
+
+include($$PWD/../gl-state-cache/gl_state_cache.pri)
+include($$PWD/../shader-cache/shader_cache.pri)
+include($$PWD/../streaming-buffer/streaming_buffer.pri)
+
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/rect_batch.h
+
+SOURCES += \
+    $$PWD/rect_batch.cpp
+}
@@ -0,0 +1,35 @@
+#include "command_arena.h"
+
+CommandArena::CommandArena()
+{
+}
+
+void CommandArena::reset()
+{
+    m_block = 0;
+    m_offset = 0;
+    m_bytesUsed = 0;
+    m_entries.clear();
+}
+
+char *CommandArena::allocate(int size)
+{
+    // Packets never straddle blocks, the tail of a full block is wasted
+    if (m_blocks.empty() || m_offset + size > blockSize)
+    {
+        if (!m_blocks.empty())
+        {
+            m_block++;
+        }
+        if (m_block == int(m_blocks.size()))
+        {
+            m_blocks.emplace_back(new char[blockSize]);
+        }
+        m_offset = 0;
+    }
+    char *memory = m_blocks[m_block].get() + m_offset;
+    // Keeps the next header aligned
+    m_offset += (size + int(alignof(Header)) - 1) & ~(int(alignof(Header)) - 1);
+    m_bytesUsed += size;
+    return memory;
+}
@@ -0,0 +1,86 @@
+#ifndef COMMAND_ARENA_H
+#define COMMAND_ARENA_H
+
+#include <QtCore/QtGlobal>
+
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "render_commands.h"
+
+// Linear allocator for one recording thread. Packets are copied into
+// fixed-size blocks that are kept across frames, so once the arena has
+// grown to a frame's size recording does not allocate. Every packet also
+// gets a sort entry, which is what the queue sorts instead of the
+// packets themselves. Not thread-safe: one arena per thread.
+//
+// Arenas of different threads sit next to each other in the queue, each
+// starts on its own cache line so their cursors do not false-share.
+class alignas(64) CommandArena
+{
+
+public:
+    struct Header
+    {
+        RenderCommandType type;
+        quint32 size;
+    };
+
+    struct Entry
+    {
+        quint64 key;
+        const Header *header;
+    };
+
+    static constexpr int blockSize = 64 * 1024;
+
+    CommandArena();
+
+    template<class Command>
+    void push(quint64 key, const Command &command)
+    {
+        static_assert(std::is_trivially_copyable<Command>::value,
+            "Command packets must be plain data");
+        static_assert(alignof(Command) <= alignof(Header),
+            "Command packets must not need more alignment than the header");
+        const int size = int(sizeof(Header) + (std::is_empty<Command>::value ?
+            0 : sizeof(Command)));
+        char *memory = allocate(size);
+        Header *header = reinterpret_cast<Header *>(memory);
+        header->type = Command::type;
+        header->size = quint32(size);
+        if (!std::is_empty<Command>::value)
+        {
+            std::memcpy(memory + sizeof(Header), &command, sizeof(Command));
+        }
+        m_entries.push_back({ key, header });
+    }
+
+    // Forgets the recorded packets, keeps the memory
+    void reset();
+
+    const std::vector<Entry> &entries() const { return m_entries; }
+    int commandCount() const { return int(m_entries.size()); }
+    qint64 bytesUsed() const { return m_bytesUsed; }
+    qint64 bytesReserved() const { return qint64(m_blocks.size()) * blockSize; }
+
+    template<class Command>
+    static const Command &payload(const Header *header)
+    {
+        return *reinterpret_cast<const Command *>(
+            reinterpret_cast<const char *>(header) + sizeof(Header));
+    }
+
+private:
+    char *allocate(int size);
+
+    std::vector<std::unique_ptr<char[]>> m_blocks;
+    int m_block = 0;
+    int m_offset = 0;
+    qint64 m_bytesUsed = 0;
+    std::vector<Entry> m_entries;
+};
+
+#endif // COMMAND_ARENA_H
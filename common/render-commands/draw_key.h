@@ -0,0 +1,52 @@
+#ifndef DRAW_KEY_H
+#define DRAW_KEY_H
+
+#include <QtCore/QtGlobal>
+
+// 64-bit draw sort key, most significant field first:
+//
+//     opaque:      layer:8 | 0:1 | program:8 | texture:15 | ~depth:32
+//     translucent: layer:8 | 1:1 | depth:32  | program:8  | texture:15
+//
+// Layers draw in order, and inside a layer opaque draws come before
+// translucent ones. Opaque draws are grouped by program and texture and
+// only then go front to back, so they must not depend on their order:
+// either they do not overlap or they are depth tested. Translucent draws
+// keep strict back-to-front order and only share state where the order
+// allows it.
+//
+// depth is the paint order, larger is closer to the viewer. The top byte
+// is the layer also when the key is used on its own, as in fit-scale.
+namespace DrawKey
+{
+    const int layerBits = 8;
+    const int programBits = 8;
+    const int textureBits = 15;
+    const int maxLayer = (1 << layerBits) - 1;
+    const int maxProgram = (1 << programBits) - 1;
+    const int maxTexture = (1 << textureBits) - 1;
+
+    inline quint64 make(int layer, bool translucent, int program, int texture, quint32 depth)
+    {
+        const quint64 state = (quint64(program & maxProgram) << textureBits) |
+            quint64(texture & maxTexture);
+        quint64 key = quint64(layer & maxLayer) << 56;
+        if (translucent)
+        {
+            key |= quint64(1) << 55;
+            key |= quint64(depth) << (programBits + textureBits);
+            key |= state;
+        }
+        else
+        {
+            key |= state << 32;
+            key |= quint64(~depth);
+        }
+        return key;
+    }
+
+    inline int layer(quint64 key) { return int(key >> 56); }
+    inline bool isTranslucent(quint64 key) { return (key >> 55) & 1; }
+}
+
+#endif // DRAW_KEY_H
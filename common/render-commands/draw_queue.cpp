@@ -0,0 +1,41 @@
+#include "draw_queue.h"
+#include "radix_sort.h"
+
+DrawQueue::DrawQueue()
+{
+}
+
+void DrawQueue::clear()
+{
+    m_draws.clear();
+}
+
+void DrawQueue::add(int layer, bool translucent, int program, int texture, quint32 depth,
+    int payload)
+{
+    m_draws.push_back({ DrawKey::make(layer, translucent, program, texture, depth),
+        program, texture, translucent, payload });
+}
+
+void DrawQueue::sort()
+{
+    m_stats.draws = int(m_draws.size());
+    m_stats.unsorted = countStateChanges(m_draws);
+    radixSortByKey(&m_draws, &m_scratch);
+    m_stats.sorted = countStateChanges(m_draws);
+}
+
+DrawQueue::StateChanges DrawQueue::countStateChanges(const std::vector<Draw> &draws)
+{
+    // The first draw sets everything, as after GLStateCache::invalidate()
+    StateChanges changes;
+    const Draw *previous = nullptr;
+    for (const Draw &draw : draws)
+    {
+        changes.programs += !previous || previous->program != draw.program;
+        changes.textures += !previous || previous->texture != draw.texture;
+        changes.blends += !previous || previous->translucent != draw.translucent;
+        previous = &draw;
+    }
+    return changes;
+}
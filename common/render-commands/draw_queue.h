@@ -0,0 +1,66 @@
+#ifndef DRAW_QUEUE_H
+#define DRAW_QUEUE_H
+
+#include <QtCore/QtGlobal>
+
+#include <vector>
+
+#include "draw_key.h"
+
+// Collects the draws of a frame with the state they need, sorts them by
+// DrawKey and hands them back in submission order. program and texture
+// are small ids picked by the caller (an index into its own table), not
+// GL names. payload is passed through untouched, typically an index into
+// the caller's per-draw data.
+//
+// sort() also counts the program, texture and blend changes the frame
+// needs in the order it was added and in the sorted order.
+class DrawQueue
+{
+
+public:
+    struct Draw
+    {
+        quint64 key;
+        int program;
+        int texture;
+        bool translucent;
+        int payload;
+    };
+
+    struct StateChanges
+    {
+        int programs = 0;
+        int textures = 0;
+        int blends = 0;
+
+        int total() const { return programs + textures + blends; }
+    };
+
+    struct Stats
+    {
+        int draws = 0;
+        StateChanges unsorted;
+        StateChanges sorted;
+    };
+
+    DrawQueue();
+
+    void clear();
+    // depth - paint order, larger is closer to the viewer
+    void add(int layer, bool translucent, int program, int texture, quint32 depth,
+        int payload);
+    void sort();
+
+    const std::vector<Draw> &draws() const { return m_draws; }
+    const Stats &stats() const { return m_stats; }
+
+    static StateChanges countStateChanges(const std::vector<Draw> &draws);
+
+private:
+    std::vector<Draw> m_draws;
+    std::vector<Draw> m_scratch;
+    Stats m_stats;
+};
+
+#endif // DRAW_QUEUE_H
@@ -0,0 +1,65 @@
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include <QtCore/QtGlobal>
+
+#include <cstring>
+#include <vector>
+
+// Stable LSD radix sort on a 64-bit key member, a byte per pass. One read
+// over the items builds all eight histograms, and passes whose byte is
+// the same for every item are skipped, so keys that only use a few
+// fields sort in a few passes. Items are moved between items and scratch;
+// the result always ends up in items.
+template<class Item>
+void radixSortByKey(std::vector<Item> *items, std::vector<Item> *scratch)
+{
+    const size_t count = items->size();
+    if (count < 2)
+    {
+        return;
+    }
+    scratch->resize(count);
+
+    size_t histograms[8][256];
+    std::memset(histograms, 0, sizeof(histograms));
+    for (const Item &item : *items)
+    {
+        for (int pass = 0; pass < 8; ++pass)
+        {
+            histograms[pass][(item.key >> (pass * 8)) & 0xFF]++;
+        }
+    }
+
+    Item *source = items->data();
+    Item *destination = scratch->data();
+    for (int pass = 0; pass < 8; ++pass)
+    {
+        size_t *histogram = histograms[pass];
+        const int shift = pass * 8;
+        if (histogram[(source[0].key >> shift) & 0xFF] == count)
+        {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (int bucket = 0; bucket < 256; ++bucket)
+        {
+            const size_t bucketCount = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucketCount;
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            destination[histogram[(source[i].key >> shift) & 0xFF]++] = source[i];
+        }
+        std::swap(source, destination);
+    }
+
+    if (source != items->data())
+    {
+        items->swap(*scratch);
+    }
+}
+
+#endif // RADIX_SORT_H
@@ -0,0 +1,132 @@
+#include <QtCore/QElapsedTimer>
+
+#include "radix_sort.h"
+#include "render_command_queue.h"
+
+RenderCommandQueue::RenderCommandQueue(int threadCount)
+    : m_arenas(qMax(1, threadCount))
+{
+    for (int thread = 1; thread < int(m_arenas.size()); ++thread)
+    {
+        m_workers.emplace_back(&RenderCommandQueue::workerLoop, this, thread);
+    }
+}
+
+RenderCommandQueue::~RenderCommandQueue()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (std::thread &worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+void RenderCommandQueue::record(const RecordFunction &record)
+{
+    QElapsedTimer timer;
+    timer.start();
+    for (CommandArena &arena : m_arenas)
+    {
+        arena.reset();
+    }
+    m_sorted.clear();
+
+    const int count = threadCount();
+    if (!m_workers.empty())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_record = &record;
+            m_pending = int(m_workers.size());
+            m_generation++;
+        }
+        m_wake.notify_all();
+    }
+    record(0, count, &m_arenas[0]);
+    if (!m_workers.empty())
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this] { return m_pending == 0; });
+        m_record = nullptr;
+    }
+
+    m_stats.commands = 0;
+    m_stats.bytes = 0;
+    for (const CommandArena &arena : m_arenas)
+    {
+        m_stats.commands += arena.commandCount();
+        m_stats.bytes += arena.bytesUsed();
+    }
+    m_stats.recordMs = timer.nsecsElapsed() / 1e6;
+}
+
+void RenderCommandQueue::sort()
+{
+    QElapsedTimer timer;
+    timer.start();
+    m_sorted.clear();
+    m_sorted.reserve(m_stats.commands);
+    for (const CommandArena &arena : m_arenas)
+    {
+        m_sorted.insert(m_sorted.end(), arena.entries().begin(), arena.entries().end());
+    }
+    radixSortByKey(&m_sorted, &m_scratch);
+    m_stats.sortMs = timer.nsecsElapsed() / 1e6;
+}
+
+void RenderCommandQueue::replay(RenderCommandBackend *backend)
+{
+    QElapsedTimer timer;
+    timer.start();
+    for (const CommandArena::Entry &entry : m_sorted)
+    {
+        const CommandArena::Header *header = entry.header;
+        switch (header->type)
+        {
+            case RenderCommandType::DrawRect:
+                backend->drawRect(CommandArena::payload<DrawRectCommand>(header));
+                break;
+            case RenderCommandType::DrawRetained:
+                backend->drawRetained(DrawRetainedCommand());
+                break;
+            case RenderCommandType::SetTexture:
+                backend->setTexture(CommandArena::payload<SetTextureCommand>(header));
+                break;
+            case RenderCommandType::SetScissor:
+                backend->setScissor(CommandArena::payload<SetScissorCommand>(header));
+                break;
+        }
+    }
+    m_stats.replayMs = timer.nsecsElapsed() / 1e6;
+}
+
+void RenderCommandQueue::workerLoop(int thread)
+{
+    quint64 seen = 0;
+    for (;;)
+    {
+        const RecordFunction *record;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this, seen] { return m_stopping || m_generation != seen; });
+            if (m_stopping)
+            {
+                return;
+            }
+            seen = m_generation;
+            record = m_record;
+        }
+
+        (*record)(thread, threadCount(), &m_arenas[thread]);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_pending == 0)
+        {
+            m_done.notify_one();
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef RENDER_COMMAND_QUEUE_H
+#define RENDER_COMMAND_QUEUE_H
+
+#include <QtCore/QtGlobal>
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "command_arena.h"
+#include "render_commands.h"
+
+// Records render commands on several threads and replays them on the one
+// thread that owns the GL context. record() runs the record function once
+// per thread, each call with its own arena, and returns when all of them
+// are done; the calling thread takes part as thread 0. sort() merges the
+// arenas and radix sorts them by key, replay() hands the packets to a
+// backend. DrawKey describes the key layout used for draws.
+//
+// Lower keys replay first. Equal keys keep the order they were recorded
+// in, threads in index order, so the result does not depend on how the
+// threads were scheduled.
+class RenderCommandQueue
+{
+
+public:
+    // thread - 0 .. threadCount - 1, used to pick a slice of the scene
+    typedef std::function<void(int thread, int threadCount, CommandArena *arena)> RecordFunction;
+
+    struct Stats
+    {
+        int commands = 0;
+        qint64 bytes = 0;
+        double recordMs = 0.0;
+        double sortMs = 0.0;
+        double replayMs = 0.0;
+    };
+
+    explicit RenderCommandQueue(int threadCount);
+    ~RenderCommandQueue();
+
+    int threadCount() const { return int(m_arenas.size()); }
+
+    // Drops the previous frame's commands and records new ones
+    void record(const RecordFunction &record);
+    void sort();
+    void replay(RenderCommandBackend *backend);
+
+    const std::vector<CommandArena::Entry> &sortedEntries() const { return m_sorted; }
+    const Stats &stats() const { return m_stats; }
+
+private:
+    void workerLoop(int thread);
+
+    std::vector<CommandArena> m_arenas;
+    std::vector<CommandArena::Entry> m_sorted;
+    std::vector<CommandArena::Entry> m_scratch;
+    Stats m_stats;
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    const RecordFunction *m_record = nullptr;
+    quint64 m_generation = 0;
+    int m_pending = 0;
+    bool m_stopping = false;
+};
+
+#endif // RENDER_COMMAND_QUEUE_H
@@ -0,0 +1,62 @@
+#ifndef RENDER_COMMANDS_H
+#define RENDER_COMMANDS_H
+
+#include <QtCore/QtGlobal>
+
+#include <type_traits>
+
+// Command packets recorded by worker threads and replayed on the GL
+// thread. They are plain data: no pointers into the scene, no Qt types,
+// nothing that needs a destructor, so an arena can be reset by moving
+// its write position back to the start.
+enum class RenderCommandType : quint32
+{
+    DrawRect,
+    DrawRetained,
+    SetTexture,
+    SetScissor
+};
+
+struct DrawRectCommand
+{
+    static constexpr RenderCommandType type = RenderCommandType::DrawRect;
+    // Center, size, rotation in degrees and color, as RectBatch::add()
+    float x, y, w, h, angle;
+    float r, g, b;
+};
+
+// Draws whatever the renderer keeps in its retained buffers
+struct DrawRetainedCommand
+{
+    static constexpr RenderCommandType type = RenderCommandType::DrawRetained;
+};
+
+struct SetTextureCommand
+{
+    static constexpr RenderCommandType type = RenderCommandType::SetTexture;
+    quint32 texture;
+    qint32 unit;
+};
+
+struct SetScissorCommand
+{
+    static constexpr RenderCommandType type = RenderCommandType::SetScissor;
+    qint32 enabled;
+    qint32 x, y, width, height;
+};
+
+// Implemented by the GL side. Calls arrive in key order on the thread
+// that called RenderCommandQueue::replay().
+class RenderCommandBackend
+{
+
+public:
+    virtual ~RenderCommandBackend() {}
+
+    virtual void drawRect(const DrawRectCommand &command) = 0;
+    virtual void drawRetained(const DrawRetainedCommand &command) = 0;
+    virtual void setTexture(const SetTextureCommand &command) = 0;
+    virtual void setScissor(const SetScissorCommand &command) = 0;
+};
+
+#endif // RENDER_COMMANDS_H
@@ -0,0 +1,18 @@
+isEmpty(RENDER_COMMANDS_PRI) {
+RENDER_COMMANDS_PRI = 1
+
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/command_arena.h \
+    $$PWD/draw_key.h \
+    $$PWD/draw_queue.h \
+    $$PWD/radix_sort.h \
+    $$PWD/render_command_queue.h \
+    $$PWD/render_commands.h
+
+SOURCES += \
+    $$PWD/command_arena.cpp \
+    $$PWD/draw_queue.cpp \
+    $$PWD/render_command_queue.cpp
+}
@@ -0,0 +1,196 @@
+#include <QtCore/QDebug>
+
+#include "render_target_manager.h"
+
+namespace
+{
+    RenderTargetManager::Stats totals;
+}
+
+RenderTargetManager::Policy RenderTargetManager::policyFromArguments(
+    const QStringList &arguments, Policy fallback)
+{
+    const int index = arguments.indexOf("--target-policy");
+    if (index < 0 || index + 1 >= arguments.size())
+    {
+        return fallback;
+    }
+    const QString name = arguments[index + 1];
+    for (Policy policy : { Policy::Exact, Policy::PowerOfTwo, Policy::Bucketed })
+    {
+        if (name == policyName(policy))
+        {
+            return policy;
+        }
+    }
+    qWarning() << "Unknown render target policy" << name;
+    return fallback;
+}
+
+const char *RenderTargetManager::policyName(Policy policy)
+{
+    switch (policy)
+    {
+    case Policy::Exact:
+        return "exact";
+    case Policy::PowerOfTwo:
+        return "pow2";
+    case Policy::Bucketed:
+        return "bucketed";
+    }
+    return "";
+}
+
+const RenderTargetManager::Stats &RenderTargetManager::totalStats()
+{
+    return totals;
+}
+
+QRect RenderTargetManager::letterbox(const QSize &deviceSize, float worldAspect)
+{
+    const int deviceW = deviceSize.width();
+    const int deviceH = deviceSize.height();
+    const float deviceAspect = deviceH / (float) deviceW;
+
+    if (deviceAspect > worldAspect)
+    {
+        const int height = int(deviceW * worldAspect);
+        return QRect(0, int((deviceH - height) / 2.f), deviceW, height);
+    }
+    const int width = int(deviceH / worldAspect);
+    return QRect(int((deviceW - width) / 2.f), 0, width, deviceH);
+}
+
+RenderTargetManager::RenderTargetManager(Policy policy, int bucketSize)
+    : m_policy(policy)
+    , m_bucketSize(qMax(1, bucketSize))
+{
+}
+
+RenderTargetManager::~RenderTargetManager()
+{
+    for (Target &target : m_targets)
+    {
+        delete target.fbo;
+    }
+    totals.allocatedBytes -= m_stats.allocatedBytes;
+}
+
+int RenderTargetManager::addTarget(Extent extent, QOpenGLFramebufferObject::Attachment attachment,
+    float scale)
+{
+    Target target;
+    target.extent = extent;
+    target.attachment = attachment;
+    target.scale = scale;
+    m_targets.push_back(target);
+    return int(m_targets.size()) - 1;
+}
+
+int RenderTargetManager::capacityFor(int size) const
+{
+    switch (m_policy)
+    {
+    case Policy::Exact:
+        return size;
+    case Policy::PowerOfTwo:
+    {
+        int capacity = 1;
+        while (capacity < size)
+        {
+            capacity <<= 1;
+        }
+        return capacity;
+    }
+    case Policy::Bucketed:
+        return (size + m_bucketSize - 1) / m_bucketSize * m_bucketSize;
+    }
+    return size;
+}
+
+// Grows as soon as size does not fit, shrinks only when a quarter more
+// than size would still fit a smaller bucket
+bool RenderTargetManager::fits(int size, int capacity) const
+{
+    return size <= capacity && capacityFor(size + size / 4) >= capacity;
+}
+
+void RenderTargetManager::resize(const QSize &deviceSize, const QRect &viewport)
+{
+    m_timer.start();
+    for (Target &target : m_targets)
+    {
+        const QSize extent = target.extent == Extent::Window ? deviceSize : viewport.size();
+        target.size = QSize(qMax(1, qRound(extent.width() * target.scale)),
+            qMax(1, qRound(extent.height() * target.scale)));
+        target.viewport = target.extent == Extent::Window ?
+            QRect(qRound(viewport.x() * target.scale), qRound(viewport.y() * target.scale),
+                qRound(viewport.width() * target.scale), qRound(viewport.height() * target.scale)) :
+            QRect(QPoint(0, 0), target.size);
+
+        if (target.fbo && (m_policy == Policy::Exact ? target.fbo->size() == target.size :
+            fits(target.size.width(), target.fbo->width()) &&
+            fits(target.size.height(), target.fbo->height())))
+        {
+            continue;
+        }
+        if (target.fbo)
+        {
+            addAllocatedBytes(-qint64(target.fbo->width()) * target.fbo->height() * 4);
+            delete target.fbo;
+        }
+        const QSize capacity(capacityFor(target.size.width()), capacityFor(target.size.height()));
+        target.fbo = new QOpenGLFramebufferObject(capacity, target.attachment);
+        addAllocatedBytes(qint64(capacity.width()) * capacity.height() * 4);
+        m_stats.allocations++;
+        totals.allocations++;
+    }
+
+    const double ms = m_timer.nsecsElapsed() / 1e6;
+    for (Stats *stats : { &m_stats, &totals })
+    {
+        stats->resizes++;
+        stats->resizeMs += ms;
+        stats->maxResizeMs = qMax(stats->maxResizeMs, ms);
+    }
+}
+
+void RenderTargetManager::addAllocatedBytes(qint64 bytes)
+{
+    m_stats.allocatedBytes += bytes;
+    totals.allocatedBytes += bytes;
+}
+
+void RenderTargetManager::destroy()
+{
+    for (Target &target : m_targets)
+    {
+        delete target.fbo;
+        target.fbo = nullptr;
+    }
+    addAllocatedBytes(-m_stats.allocatedBytes);
+}
+
+QSize RenderTargetManager::capacity(int target) const
+{
+    const QOpenGLFramebufferObject *fbo = m_targets[target].fbo;
+    return fbo ? fbo->size() : QSize();
+}
+
+QVector2D RenderTargetManager::texCoordScale(int target) const
+{
+    const Target &t = m_targets[target];
+    if (!t.fbo)
+    {
+        return QVector2D(1.f, 1.f);
+    }
+    return QVector2D(t.size.width() / float(t.fbo->width()),
+        t.size.height() / float(t.fbo->height()));
+}
+
+void RenderTargetManager::resetStats()
+{
+    const qint64 allocatedBytes = m_stats.allocatedBytes;
+    m_stats = Stats();
+    m_stats.allocatedBytes = allocatedBytes;
+}
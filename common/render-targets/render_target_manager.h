@@ -0,0 +1,116 @@
+#ifndef RENDER_TARGET_MANAGER_H
+#define RENDER_TARGET_MANAGER_H
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QRect>
+#include <QtCore/QSize>
+#include <QtCore/QStringList>
+#include <QtGui/QVector2D>
+#include <QtOpenGL/QOpenGLFramebufferObject>
+
+#include <vector>
+
+// Offscreen framebuffers of a window that follow its size. Attachments
+// are allocated with a bucketed capacity and rendering uses only the
+// bottom-left part of them, so a drag-resize reallocates when the size
+// leaves its bucket instead of on every pixel. Shrinking waits until the
+// size fits a smaller bucket with a quarter to spare, a drag back and
+// forth over a bucket edge does not reallocate either.
+//
+// A target covers either the whole window, like a pick buffer that is
+// addressed with window coordinates, or only the letterbox viewport,
+// like a post-processing buffer of the world area.
+//
+// "--target-policy exact|pow2|bucketed" picks the policy, exact is the
+// baseline that reallocates on every resize.
+class RenderTargetManager
+{
+
+public:
+    enum class Policy
+    {
+        // Exactly the requested size, reallocates on every resize
+        Exact,
+        PowerOfTwo,
+        // Multiples of bucketSize pixels
+        Bucketed
+    };
+
+    enum class Extent
+    {
+        Window,
+        Viewport
+    };
+
+    struct Stats
+    {
+        quint64 resizes = 0;
+        quint64 allocations = 0;
+        // Color attachments currently allocated
+        qint64 allocatedBytes = 0;
+        double resizeMs = 0.0;
+        double maxResizeMs = 0.0;
+    };
+
+    static Policy policyFromArguments(const QStringList &arguments,
+        Policy fallback = Policy::PowerOfTwo);
+    static const char *policyName(Policy policy);
+    // Summed over every manager in the process
+    static const Stats &totalStats();
+
+    // The largest rectangle of worldAspect (height / width) centered in
+    // a framebuffer of deviceSize
+    static QRect letterbox(const QSize &deviceSize, float worldAspect);
+
+    explicit RenderTargetManager(Policy policy = Policy::PowerOfTwo, int bucketSize = 256);
+    ~RenderTargetManager();
+
+    // scale - size relative to the extent, 0.5 for a half resolution
+    // buffer. Allocation waits for the next resize().
+    int addTarget(Extent extent,
+        QOpenGLFramebufferObject::Attachment attachment = QOpenGLFramebufferObject::NoAttachment,
+        float scale = 1.f);
+
+    // Must be called with a current OpenGL context, resizeGL() is the
+    // place. viewport is the letterbox in deviceSize.
+    void resize(const QSize &deviceSize, const QRect &viewport);
+    // Must be called with a current OpenGL context
+    void destroy();
+
+    QOpenGLFramebufferObject *framebuffer(int target) const { return m_targets[target].fbo; }
+    // The part of the framebuffer in use
+    QSize size(int target) const { return m_targets[target].size; }
+    QSize capacity(int target) const;
+    // Where to render the world into the target, the letterbox itself
+    // for Window targets
+    QRect viewport(int target) const { return m_targets[target].viewport; }
+    // Multiplies texture coordinates of the used part when sampling
+    QVector2D texCoordScale(int target) const;
+
+    Policy policy() const { return m_policy; }
+    const Stats &stats() const { return m_stats; }
+    void resetStats();
+
+private:
+    struct Target
+    {
+        Extent extent;
+        QOpenGLFramebufferObject::Attachment attachment;
+        float scale;
+        QOpenGLFramebufferObject *fbo = nullptr;
+        QSize size;
+        QRect viewport;
+    };
+
+    int capacityFor(int size) const;
+    bool fits(int size, int capacity) const;
+    void addAllocatedBytes(qint64 bytes);
+
+    Policy m_policy;
+    int m_bucketSize;
+    std::vector<Target> m_targets;
+    QElapsedTimer m_timer;
+    Stats m_stats;
+};
+
+#endif // RENDER_TARGET_MANAGER_H
@@ -0,0 +1,11 @@
+isEmpty(RENDER_TARGETS_PRI) {
+RENDER_TARGETS_PRI = 1
+
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/render_target_manager.h
+
+SOURCES += \
+    $$PWD/render_target_manager.cpp
+}
@@ -0,0 +1,349 @@
+#include <QtCore/QDebug>
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QSaveFile>
+#include <QtCore/QStandardPaths>
+#include <QtGui/QOpenGLFunctions>
+
+#include <cstring>
+#include <utility>
+
+#include "shader_cache.h"
+
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+namespace
+{
+    const char binaryMagic[4] = { 'S', 'H', 'P', 'B' };
+    const quint32 binaryVersion = 1;
+
+    struct BinaryHeader
+    {
+        char magic[4];
+        quint32 version;
+        quint64 hash;
+        quint32 format;
+        quint32 length;
+    };
+
+    // FNV-1a, stable across runs and Qt versions unlike qHash
+    quint64 hashBytes(const QByteArray &data, quint64 hash = 14695981039346656037ULL)
+    {
+        for (char c : data)
+        {
+            hash ^= quint8(c);
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    QByteArray programKey(const QByteArray &vertexSource, const QByteArray &fragmentSource,
+        const ShaderCache::AttributeLocations &attributes)
+    {
+        QByteArray key = vertexSource;
+        key.append('\0');
+        key.append(fragmentSource);
+        for (const QPair<QByteArray, int> &attribute : attributes)
+        {
+            key.append('\0');
+            key.append(attribute.first);
+            key.append('=');
+            key.append(QByteArray::number(attribute.second));
+        }
+        return key;
+    }
+}
+
+ShaderCache *ShaderCache::instance()
+{
+    static ShaderCache cache;
+    return &cache;
+}
+
+ShaderCache::ShaderCache()
+{
+    m_diskCacheDirectory =
+        QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/shaders";
+}
+
+QOpenGLShaderProgram *ShaderCache::program(const QByteArray &vertexSource,
+    const QByteArray &fragmentSource, const AttributeLocations &attributes)
+{
+    Group *group = currentGroup();
+    if (!group)
+    {
+        qWarning() << "ShaderCache: no current OpenGL context";
+        return nullptr;
+    }
+
+    const QByteArray key = programKey(vertexSource, fragmentSource, attributes);
+    const quint64 hash = hashBytes(key);
+    for (auto it = group->programs.constFind(hash);
+        it != group->programs.constEnd() && it.key() == hash; ++it)
+    {
+        if (it->key == key)
+        {
+            m_stats.reused++;
+            return it->program;
+        }
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QOpenGLShaderProgram *program = loadBinary(group, hash);
+    if (program)
+    {
+        m_stats.loadedFromDisk++;
+    }
+    else
+    {
+        program = new QOpenGLShaderProgram;
+        program->create();
+        bool ok = program->addShaderFromSourceCode(QOpenGLShader::ShaderTypeBit::Vertex,
+            vertexSource);
+        ok = program->addShaderFromSourceCode(QOpenGLShader::ShaderTypeBit::Fragment,
+            fragmentSource) && ok;
+        for (const QPair<QByteArray, int> &attribute : attributes)
+        {
+            program->bindAttributeLocation(attribute.first, attribute.second);
+        }
+        if (group->programParameteri)
+        {
+            group->programParameteri(program->programId(),
+                GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+        if (!ok || !program->link())
+        {
+            qWarning().noquote() << "ShaderCache: failed to build a program\n" << program->log();
+            delete program;
+            return nullptr;
+        }
+        m_stats.compiled++;
+        saveBinary(group, hash, program);
+    }
+    m_stats.buildNs += timer.nsecsElapsed();
+
+    group->programs.insert(hash, { key, program });
+    return program;
+}
+
+QOpenGLShaderProgram *ShaderCache::programFromFiles(const QString &vertexPath,
+    const QString &fragmentPath, const AttributeLocations &attributes)
+{
+    QFile vertexFile(vertexPath);
+    QFile fragmentFile(fragmentPath);
+    if (!vertexFile.open(QIODevice::OpenModeFlag::ReadOnly) ||
+        !fragmentFile.open(QIODevice::OpenModeFlag::ReadOnly))
+    {
+        qWarning() << "ShaderCache: failed to open" << vertexPath << "or" << fragmentPath;
+        return nullptr;
+    }
+    return program(vertexFile.readAll(), fragmentFile.readAll(), attributes);
+}
+
+bool ShaderCache::hasBinarySupport()
+{
+    Group *group = currentGroup();
+    return group && group->binarySupport;
+}
+
+void ShaderCache::clear()
+{
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    if (!context)
+    {
+        return;
+    }
+    deleteGroup(m_groups.take(context->shareGroup()));
+}
+
+void ShaderCache::deleteGroup(Group *group)
+{
+    if (!group)
+    {
+        return;
+    }
+    for (const Entry &entry : std::as_const(group->programs))
+    {
+        delete entry.program;
+    }
+    delete group;
+}
+
+ShaderCache::Group *ShaderCache::currentGroup()
+{
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    if (!context)
+    {
+        return nullptr;
+    }
+    QOpenGLContextGroup *shareGroup = context->shareGroup();
+    Group *group = m_groups.value(shareGroup);
+    if (group)
+    {
+        return group;
+    }
+
+    group = new Group;
+    m_groups.insert(shareGroup, group);
+    // The programs die with the share group, OpenGL has already
+    // released them by then
+    QObject::connect(shareGroup, &QObject::destroyed, [this, shareGroup]() {
+        deleteGroup(m_groups.take(shareGroup));
+    });
+
+    const QSurfaceFormat format = context->format();
+    QByteArray suffix;
+    bool supported = false;
+    bool hasParameteri = true;
+    if (context->isOpenGLES())
+    {
+        if (format.majorVersion() >= 3)
+        {
+            supported = true;
+        }
+        else if (context->hasExtension("GL_OES_get_program_binary"))
+        {
+            supported = true;
+            suffix = "OES";
+            hasParameteri = false;
+        }
+    }
+    else
+    {
+        supported = format.version() >= qMakePair(4, 1) ||
+            context->hasExtension("GL_ARB_get_program_binary");
+    }
+
+    if (supported)
+    {
+        auto resolve = [context, &suffix](const char *name) {
+            return context->getProcAddress(QByteArray(name) + suffix);
+        };
+        group->getProgramBinary = reinterpret_cast<GetProgramBinaryFunc>(
+            resolve("glGetProgramBinary"));
+        group->programBinary = reinterpret_cast<ProgramBinaryFunc>(resolve("glProgramBinary"));
+        if (hasParameteri)
+        {
+            group->programParameteri = reinterpret_cast<ProgramParameteriFunc>(
+                resolve("glProgramParameteri"));
+        }
+
+        // Some drivers expose the entry points but no binary format
+        GLint formatCount = 0;
+        context->functions()->glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+        group->binarySupport = group->getProgramBinary && group->programBinary &&
+            formatCount > 0;
+    }
+
+    // Binaries only fit the driver that produced them
+    QOpenGLFunctions *gl = context->functions();
+    quint64 driverHash = hashBytes(reinterpret_cast<const char *>(gl->glGetString(GL_VENDOR)));
+    driverHash = hashBytes(reinterpret_cast<const char *>(gl->glGetString(GL_RENDERER)), driverHash);
+    driverHash = hashBytes(reinterpret_cast<const char *>(gl->glGetString(GL_VERSION)), driverHash);
+    group->driverHash = driverHash;
+    return group;
+}
+
+QString ShaderCache::binaryPath(const Group *group, quint64 hash) const
+{
+    return QString("%1/%2-%3.bin").arg(m_diskCacheDirectory)
+        .arg(group->driverHash, 16, 16, QChar('0')).arg(hash, 16, 16, QChar('0'));
+}
+
+QOpenGLShaderProgram *ShaderCache::loadBinary(Group *group, quint64 hash)
+{
+    if (!group->binarySupport || m_diskCacheDirectory.isEmpty())
+    {
+        return nullptr;
+    }
+
+    QFile file(binaryPath(group, hash));
+    if (!file.open(QIODevice::OpenModeFlag::ReadOnly))
+    {
+        return nullptr;
+    }
+    const QByteArray data = file.readAll();
+    if (data.size() < qsizetype(sizeof(BinaryHeader)))
+    {
+        return nullptr;
+    }
+    BinaryHeader header;
+    std::memcpy(&header, data.constData(), sizeof(header));
+    if (std::memcmp(header.magic, binaryMagic, sizeof(binaryMagic)) != 0 ||
+        header.version != binaryVersion || header.hash != hash ||
+        data.size() - qsizetype(sizeof(header)) != qsizetype(header.length))
+    {
+        return nullptr;
+    }
+
+    QOpenGLShaderProgram *program = new QOpenGLShaderProgram;
+    program->create();
+    group->programBinary(program->programId(), header.format,
+        data.constData() + sizeof(header), GLsizei(header.length));
+    GLint linked = GL_FALSE;
+    QOpenGLContext::currentContext()->functions()->glGetProgramiv(program->programId(),
+        GL_LINK_STATUS, &linked);
+    // Without shaders attached link() only picks up the link status
+    if (!linked || !program->link())
+    {
+        delete program;
+        return nullptr;
+    }
+    return program;
+}
+
+void ShaderCache::saveBinary(Group *group, quint64 hash, QOpenGLShaderProgram *program)
+{
+    if (!group->binarySupport || m_diskCacheDirectory.isEmpty())
+    {
+        return;
+    }
+
+    GLint length = 0;
+    QOpenGLContext::currentContext()->functions()->glGetProgramiv(program->programId(),
+        GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+    {
+        return;
+    }
+
+    QByteArray data(sizeof(BinaryHeader) + length, Qt::Initialization::Uninitialized);
+    GLenum format = 0;
+    GLsizei written = 0;
+    group->getProgramBinary(program->programId(), length, &written, &format,
+        data.data() + sizeof(BinaryHeader));
+    if (written <= 0)
+    {
+        return;
+    }
+    data.resize(sizeof(BinaryHeader) + written);
+
+    BinaryHeader header;
+    std::memcpy(header.magic, binaryMagic, sizeof(binaryMagic));
+    header.version = binaryVersion;
+    header.hash = hash;
+    header.format = format;
+    header.length = quint32(written);
+    std::memcpy(data.data(), &header, sizeof(header));
+
+    QDir().mkpath(m_diskCacheDirectory);
+    QSaveFile file(binaryPath(group, hash));
+    if (!file.open(QIODevice::OpenModeFlag::WriteOnly) || file.write(data) != data.size() ||
+        !file.commit())
+    {
+        qWarning() << "ShaderCache: failed to write" << file.fileName();
+        return;
+    }
+    m_stats.binariesWritten++;
+}
@@ -0,0 +1,96 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QPair>
+#include <QtCore/QString>
+#include <QtGui/QOpenGLContext>
+#include <QtOpenGL/QOpenGLShaderProgram>
+
+// Linked shader programs shared by every context of a share group and
+// deduplicated by a hash of their sources, so two windows asking for the
+// same program get the same object. When the driver can hand out program
+// binaries (ES 3.0, GL 4.1, OES_get_program_binary or
+// ARB_get_program_binary) they are stored on disk after the first link
+// and loaded instead of compiling on later runs. A binary rejected by the
+// driver, for example after a driver update, is compiled again.
+class ShaderCache
+{
+
+public:
+    // Attribute name and location, bound before linking
+    typedef QList<QPair<QByteArray, int>> AttributeLocations;
+
+    struct Stats
+    {
+        int compiled = 0;
+        int loadedFromDisk = 0;
+        int reused = 0;
+        int binariesWritten = 0;
+        qint64 buildNs = 0; // Compiling, linking and loading binaries
+    };
+
+    static ShaderCache *instance();
+
+    // Must be called with a current OpenGL context. Returns a linked
+    // program or nullptr when compiling or linking fails. The cache owns
+    // the program, it lives as long as the context share group.
+    QOpenGLShaderProgram *program(const QByteArray &vertexSource,
+        const QByteArray &fragmentSource,
+        const AttributeLocations &attributes = AttributeLocations());
+    QOpenGLShaderProgram *programFromFiles(const QString &vertexPath,
+        const QString &fragmentPath,
+        const AttributeLocations &attributes = AttributeLocations());
+
+    // Defaults to "shaders" in QStandardPaths::CacheLocation,
+    // an empty string turns the disk cache off
+    void setDiskCacheDirectory(const QString &dir) { m_diskCacheDirectory = dir; }
+    QString diskCacheDirectory() const { return m_diskCacheDirectory; }
+    // Whether the current context can store program binaries
+    bool hasBinarySupport();
+
+    // Deletes the programs of the current share group
+    void clear();
+
+    const Stats &stats() const { return m_stats; }
+    void resetStats() { m_stats = Stats(); }
+
+private:
+    typedef void (QOPENGLF_APIENTRYP GetProgramBinaryFunc)(GLuint program,
+        GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+    typedef void (QOPENGLF_APIENTRYP ProgramBinaryFunc)(GLuint program,
+        GLenum binaryFormat, const void *binary, GLsizei length);
+    typedef void (QOPENGLF_APIENTRYP ProgramParameteriFunc)(GLuint program,
+        GLenum pname, GLint value);
+
+    struct Entry
+    {
+        QByteArray key; // Sources and attributes, guards against collisions
+        QOpenGLShaderProgram *program;
+    };
+
+    struct Group
+    {
+        QMultiHash<quint64, Entry> programs;
+        bool binarySupport = false;
+        GetProgramBinaryFunc getProgramBinary = nullptr;
+        ProgramBinaryFunc programBinary = nullptr;
+        ProgramParameteriFunc programParameteri = nullptr;
+        quint64 driverHash = 0;
+    };
+
+    ShaderCache();
+    static void deleteGroup(Group *group);
+    Group *currentGroup();
+    QString binaryPath(const Group *group, quint64 hash) const;
+    QOpenGLShaderProgram *loadBinary(Group *group, quint64 hash);
+    void saveBinary(Group *group, quint64 hash, QOpenGLShaderProgram *program);
+
+    QHash<QOpenGLContextGroup *, Group *> m_groups;
+    QString m_diskCacheDirectory;
+    Stats m_stats;
+};
+
+#endif // SHADER_CACHE_H
@@ -0,0 +1,11 @@
+isEmpty(SHADER_CACHE_PRI) {
+SHADER_CACHE_PRI = 1
+
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/shader_cache.h
+
+SOURCES += \
+    $$PWD/shader_cache.cpp
+}
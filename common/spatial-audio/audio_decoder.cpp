@@ -0,0 +1,35 @@
+#include <QtCore/QDebug>
+
+#include "audio_decoder.h"
+#include "wav_stream.h"
+
+#ifdef VORBIS_AUDIO
+#include "vorbis_stream.h"
+#endif
+
+std::unique_ptr<AudioStream> openAudioStream(const QString &path)
+{
+    if (path.endsWith(".wav", Qt::CaseInsensitive))
+    {
+        auto stream = std::make_unique<WavStream>();
+        if (stream->open(path))
+        {
+            return stream;
+        }
+    }
+#ifdef VORBIS_AUDIO
+    else if (path.endsWith(".ogg", Qt::CaseInsensitive))
+    {
+        auto stream = std::make_unique<VorbisStream>();
+        if (stream->open(path))
+        {
+            return stream;
+        }
+    }
+#endif
+    else
+    {
+        qWarning() << "Unsupported audio file" << path;
+    }
+    return nullptr;
+}
@@ -0,0 +1,16 @@
+#ifndef AUDIO_DECODER_H
+#define AUDIO_DECODER_H
+
+#include <QtCore/QString>
+
+#include <memory>
+
+#include "audio_stream.h"
+
+// A stream over a .wav or .ogg file or resource, chosen by the suffix.
+// Only the headers are read here, the samples are decoded on demand.
+// nullptr when the file cannot be opened or is not supported, .ogg
+// files need the module built with CONFIG+=vorbis.
+std::unique_ptr<AudioStream> openAudioStream(const QString &path);
+
+#endif // AUDIO_DECODER_H
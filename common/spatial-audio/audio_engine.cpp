@@ -0,0 +1,713 @@
+#include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+
+#include <algorithm>
+
+#include "audio_engine.h"
+
+struct AudioEngine::Stream
+{
+    ~Stream()
+    {
+        // The list is reserved for every slab, this never allocates
+        freeSlabs->insert(freeSlabs->end(), slabs, slabs + streamRingSize);
+    }
+
+    std::vector<qint16 *> *freeSlabs = nullptr;
+    std::unique_ptr<AudioStream> source;
+    ALenum format = AL_FORMAT_MONO16;
+    int channels = 1;
+    int sampleRate = 0;
+    bool looping = false;
+
+    // Slabs in play order: [head, head + queued) are queued on the
+    // source, the next ready ones wait for update() and a decode thread
+    // fills the one after them
+    qint16 *slabs[streamRingSize] = {};
+    int slabFrames[streamRingSize] = {};
+    int head = 0;
+    int queued = 0;
+    int ready = 0;
+    bool decoding = false;
+    bool ended = false;
+};
+
+static ALenum formatFor(int channels)
+{
+    return channels == 2 ? AL_FORMAT_STEREO16 : AL_FORMAT_MONO16;
+}
+
+AudioEngine::AudioEngine(int voiceCount, int decodeThreads)
+    : m_voiceCount(voiceCount)
+    , m_decodeThreadCount(qMax(1, decodeThreads))
+{
+}
+
+AudioEngine::~AudioEngine()
+{
+    close();
+}
+
+bool AudioEngine::open(Device device, int sampleRate)
+{
+    close();
+    m_device = device;
+    m_sampleRate = sampleRate;
+
+    if (device == Device::Loopback)
+    {
+        if (!alcIsExtensionPresent(nullptr, "ALC_SOFT_loopback"))
+        {
+            qWarning() << "ALC_SOFT_loopback is not supported";
+            return false;
+        }
+        auto openLoopback = reinterpret_cast<LPALCLOOPBACKOPENDEVICESOFT>(
+            alcGetProcAddress(nullptr, "alcLoopbackOpenDeviceSOFT"));
+        auto isFormatSupported = reinterpret_cast<LPALCISRENDERFORMATSUPPORTEDSOFT>(
+            alcGetProcAddress(nullptr, "alcIsRenderFormatSupportedSOFT"));
+        m_renderSamples = reinterpret_cast<LPALCRENDERSAMPLESSOFT>(
+            alcGetProcAddress(nullptr, "alcRenderSamplesSOFT"));
+        m_alDevice = openLoopback(nullptr);
+        if (m_alDevice && !isFormatSupported(m_alDevice, sampleRate, ALC_STEREO_SOFT, ALC_SHORT_SOFT))
+        {
+            qWarning() << "The loopback device cannot mix 16-bit stereo at" << sampleRate << "Hz";
+            alcCloseDevice(m_alDevice);
+            m_alDevice = nullptr;
+        }
+    }
+    else
+    {
+        m_alDevice = alcOpenDevice(device == Device::Null ? "No Output" : nullptr);
+    }
+    if (!m_alDevice)
+    {
+        qWarning() << "Failed to open an OpenAL device";
+        m_renderSamples = nullptr;
+        return false;
+    }
+
+    // The render format is only given to the loopback device
+    const ALCint attributes[] = {
+        ALC_FORMAT_CHANNELS_SOFT, ALC_STEREO_SOFT,
+        ALC_FORMAT_TYPE_SOFT, ALC_SHORT_SOFT,
+        ALC_FREQUENCY, sampleRate,
+        ALC_MONO_SOURCES, m_voiceCount,
+        0
+    };
+    m_context = alcCreateContext(m_alDevice,
+        device == Device::Loopback ? attributes : attributes + 4);
+    if (!m_context || !alcMakeContextCurrent(m_context))
+    {
+        qWarning() << "Failed to create an OpenAL context";
+        if (m_context)
+        {
+            alcDestroyContext(m_context);
+            m_context = nullptr;
+        }
+        alcCloseDevice(m_alDevice);
+        m_alDevice = nullptr;
+        m_renderSamples = nullptr;
+        return false;
+    }
+    alDistanceModel(AL_INVERSE_DISTANCE_CLAMPED);
+
+    // As many sources as the device gives, up to the requested count
+    alGetError();
+    m_slots.reserve(m_voiceCount);
+    for (int i = 0; i < m_voiceCount; ++i)
+    {
+        ALuint source = 0;
+        alGenSources(1, &source);
+        if (alGetError() != AL_NO_ERROR)
+        {
+            qWarning() << "OpenAL gave" << i << "of" << m_voiceCount << "sources";
+            break;
+        }
+        m_slots.emplace_back();
+        m_slots.back().source = source;
+    }
+    m_streamBuffers.resize(m_slots.size() * streamRingSize);
+    alGenBuffers(ALsizei(m_streamBuffers.size()), m_streamBuffers.data());
+    if (alIsExtensionPresent("AL_EXT_STATIC_BUFFER"))
+    {
+        m_bufferDataStatic = reinterpret_cast<BufferDataStatic>(
+            alGetProcAddress("alBufferDataStatic"));
+    }
+
+    // Slabs for every voice, plus the streams that decode threads may
+    // still hold after their voice was stolen. Room for stereo.
+    const int slabCount = (int(m_slots.size()) + m_decodeThreadCount) * streamRingSize;
+    m_slabMemory.assign(size_t(slabCount) * streamChunkFrames * 2, 0);
+    m_freeSlabs.reserve(slabCount);
+    for (int slab = 0; slab < slabCount; ++slab)
+    {
+        m_freeSlabs.push_back(m_slabMemory.data() + size_t(slab) * streamChunkFrames * 2);
+    }
+
+    m_stats = Stats();
+    m_stats.voices = int(m_slots.size());
+    m_clock.start();
+    m_stopping = false;
+    for (int thread = 0; thread < m_decodeThreadCount; ++thread)
+    {
+        m_decodeThreads.emplace_back(&AudioEngine::decodeLoop, this);
+    }
+    return true;
+}
+
+void AudioEngine::close()
+{
+    if (!m_context)
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_streamMutex);
+        m_stopping = true;
+    }
+    m_decodeWake.notify_all();
+    for (std::thread &thread : m_decodeThreads)
+    {
+        thread.join();
+    }
+    m_decodeThreads.clear();
+
+    for (int slot = 0; slot < int(m_slots.size()); ++slot)
+    {
+        if (m_slots[slot].active)
+        {
+            releaseSlot(slot);
+        }
+        alDeleteSources(1, &m_slots[slot].source);
+    }
+    alDeleteBuffers(ALsizei(m_streamBuffers.size()), m_streamBuffers.data());
+    m_slots.clear();
+    m_streamBuffers.clear();
+    {
+        std::lock_guard<std::mutex> lock(m_streamMutex);
+        m_streams.clear();
+    }
+    m_freeSlabs.clear();
+    m_slabMemory.clear();
+
+    alcMakeContextCurrent(nullptr);
+    alcDestroyContext(m_context);
+    alcCloseDevice(m_alDevice);
+    m_context = nullptr;
+    m_alDevice = nullptr;
+    m_renderSamples = nullptr;
+    m_bufferDataStatic = nullptr;
+}
+
+ALuint AudioEngine::createBuffer(const qint16 *pcm, int frameCount, int channels, int sampleRate)
+{
+    ALuint buffer = 0;
+    alGenBuffers(1, &buffer);
+    alBufferData(buffer, formatFor(channels), pcm,
+        ALsizei(frameCount * channels * sizeof(qint16)), sampleRate);
+    return buffer;
+}
+
+ALuint AudioEngine::createSharedBuffer(const qint16 *pcm, int frameCount, int channels,
+    int sampleRate)
+{
+    if (!m_bufferDataStatic)
+    {
+        return createBuffer(pcm, frameCount, channels, sampleRate);
+    }
+    ALuint buffer = 0;
+    alGenBuffers(1, &buffer);
+    m_bufferDataStatic(buffer, formatFor(channels), const_cast<qint16 *>(pcm),
+        ALsizei(frameCount * channels * sizeof(qint16)), sampleRate);
+    return buffer;
+}
+
+void AudioEngine::deleteBuffer(ALuint buffer)
+{
+    // OpenAL does not delete a buffer that is attached to a source
+    for (int slot = 0; slot < int(m_slots.size()); ++slot)
+    {
+        if (m_slots[slot].active && m_slots[slot].buffer == buffer)
+        {
+            releaseSlot(slot);
+        }
+    }
+    alDeleteBuffers(1, &buffer);
+}
+
+bool AudioEngine::isBufferInUse(ALuint buffer) const
+{
+    for (const VoiceSlot &slot : m_slots)
+    {
+        if (slot.active && slot.buffer == buffer)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+AudioEngine::Voice AudioEngine::play(ALuint buffer, const VoiceParams &params)
+{
+    const int slot = acquireSlot(params.priority);
+    if (slot < 0)
+    {
+        return 0;
+    }
+    const ALuint source = m_slots[slot].source;
+    alSourcei(source, AL_BUFFER, ALint(buffer));
+    alSourcei(source, AL_LOOPING, params.looping ? AL_TRUE : AL_FALSE);
+    m_slots[slot].buffer = buffer;
+    const Voice voice = startVoice(slot, params);
+    alSourcePlay(source);
+    return voice;
+}
+
+AudioEngine::Voice AudioEngine::playStream(std::unique_ptr<AudioStream> stream,
+    const VoiceParams &params)
+{
+    // Checked before a voice is stolen for a stream that cannot start.
+    // Only this thread takes slabs, the decode threads only give them back.
+    {
+        std::lock_guard<std::mutex> lock(m_streamMutex);
+        if (int(m_freeSlabs.size()) < streamRingSize)
+        {
+            m_stats.rejected++;
+            return 0;
+        }
+    }
+    const int slot = acquireSlot(params.priority);
+    if (slot < 0)
+    {
+        return 0;
+    }
+    VoiceSlot &voiceSlot = m_slots[slot];
+    {
+        std::lock_guard<std::mutex> lock(m_streamMutex);
+        auto state = std::make_shared<Stream>();
+        state->freeSlabs = &m_freeSlabs;
+        std::copy(m_freeSlabs.end() - streamRingSize, m_freeSlabs.end(), state->slabs);
+        m_freeSlabs.resize(m_freeSlabs.size() - streamRingSize);
+        state->channels = stream->channels();
+        state->format = formatFor(state->channels);
+        state->sampleRate = stream->sampleRate();
+        state->looping = params.looping;
+        state->source = std::move(stream);
+        m_streams.push_back(state);
+        voiceSlot.stream = std::move(state);
+    }
+    m_decodeWake.notify_one();
+
+    // Looping is done by rewinding the stream, the source only sees chunks
+    alSourcei(voiceSlot.source, AL_LOOPING, AL_FALSE);
+    voiceSlot.buffer = 0;
+    voiceSlot.streamStarted = false;
+    voiceSlot.streamStartNs = m_clock.nsecsElapsed();
+    voiceSlot.freeBufferCount = streamRingSize;
+    std::copy(m_streamBuffers.begin() + slot * streamRingSize,
+        m_streamBuffers.begin() + (slot + 1) * streamRingSize, voiceSlot.freeBuffers);
+    // update() starts the source once the first chunks are decoded
+    return startVoice(slot, params);
+}
+
+void AudioEngine::setPosition(Voice voice, const QVector3D &position)
+{
+    if (VoiceSlot *slot = slotFor(voice))
+    {
+        slot->position = position;
+        alSource3f(slot->source, AL_POSITION, position.x(), position.y(), position.z());
+    }
+}
+
+void AudioEngine::setGain(Voice voice, float gain)
+{
+    if (VoiceSlot *slot = slotFor(voice))
+    {
+        slot->gain = gain;
+        alSourcef(slot->source, AL_GAIN, gain);
+    }
+}
+
+void AudioEngine::stop(Voice voice)
+{
+    if (VoiceSlot *slot = slotFor(voice))
+    {
+        releaseSlot(int(slot - m_slots.data()));
+    }
+}
+
+bool AudioEngine::isPlaying(Voice voice) const
+{
+    return slotFor(voice) != nullptr;
+}
+
+void AudioEngine::setListener(const QVector3D &position, const QVector3D &back,
+    const QVector3D &up)
+{
+    m_listenerPosition = position;
+    // "At" vector followed by "up"
+    const ALfloat orientation[6] = {
+        -back.x(), -back.y(), -back.z(),
+        up.x(), up.y(), up.z()
+    };
+    alListener3f(AL_POSITION, position.x(), position.y(), position.z());
+    alListenerfv(AL_ORIENTATION, orientation);
+}
+
+void AudioEngine::update()
+{
+    if (!isOpen())
+    {
+        return;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    m_stats.activeVoices = 0;
+    m_stats.streamingVoices = 0;
+    m_stats.decodeBacklog = 0;
+    for (int slot = 0; slot < int(m_slots.size()); ++slot)
+    {
+        VoiceSlot &voiceSlot = m_slots[slot];
+        if (!voiceSlot.active)
+        {
+            continue;
+        }
+        if (voiceSlot.stream)
+        {
+            feedStream(slot);
+        }
+        else
+        {
+            ALint state = AL_STOPPED;
+            alGetSourcei(voiceSlot.source, AL_SOURCE_STATE, &state);
+            if (state == AL_STOPPED)
+            {
+                releaseSlot(slot);
+            }
+        }
+        if (voiceSlot.active)
+        {
+            m_stats.activeVoices++;
+            m_stats.streamingVoices += voiceSlot.stream ? 1 : 0;
+        }
+    }
+    m_stats.updateMs += timer.nsecsElapsed() / 1e6;
+}
+
+void AudioEngine::render(qint16 *pcm, int frameCount)
+{
+    if (!m_renderSamples)
+    {
+        return;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    m_renderSamples(m_alDevice, pcm, frameCount);
+    m_stats.mixMs += timer.nsecsElapsed() / 1e6;
+    m_stats.mixedFrames += frameCount;
+}
+
+void AudioEngine::resetStats()
+{
+    m_stats.started = 0;
+    m_stats.stolen = 0;
+    m_stats.rejected = 0;
+    m_stats.underruns = 0;
+    m_stats.firstSamples = 0;
+    m_stats.firstSampleMs = 0.0;
+    m_stats.maxFirstSampleMs = 0.0;
+    m_stats.updateMs = 0.0;
+    m_stats.mixMs = 0.0;
+    m_stats.mixedFrames = 0;
+}
+
+// A free slot, or the least important voice when that is not more
+// important than the new sound. -1 drops the new sound.
+int AudioEngine::acquireSlot(int priority)
+{
+    if (!isOpen())
+    {
+        return -1;
+    }
+    int victim = -1;
+    float victimAudibility = 0.f;
+    for (int slot = 0; slot < int(m_slots.size()); ++slot)
+    {
+        const VoiceSlot &candidate = m_slots[slot];
+        if (!candidate.active)
+        {
+            return slot;
+        }
+        const float candidateAudibility = audibility(candidate);
+        if (victim < 0)
+        {
+            victim = slot;
+            victimAudibility = candidateAudibility;
+            continue;
+        }
+        const VoiceSlot &current = m_slots[victim];
+        if (candidate.priority != current.priority)
+        {
+            if (candidate.priority > current.priority)
+            {
+                continue;
+            }
+        }
+        else if (candidateAudibility != victimAudibility)
+        {
+            if (candidateAudibility > victimAudibility)
+            {
+                continue;
+            }
+        }
+        else if (candidate.startOrder > current.startOrder)
+        {
+            continue;
+        }
+        victim = slot;
+        victimAudibility = candidateAudibility;
+    }
+    if (victim < 0 || m_slots[victim].priority > priority)
+    {
+        m_stats.rejected++;
+        return -1;
+    }
+    releaseSlot(victim);
+    m_stats.stolen++;
+    return victim;
+}
+
+void AudioEngine::releaseSlot(int slot)
+{
+    VoiceSlot &voiceSlot = m_slots[slot];
+    alSourceStop(voiceSlot.source);
+    // Also unqueues every stream buffer
+    alSourcei(voiceSlot.source, AL_BUFFER, 0);
+    if (voiceSlot.stream)
+    {
+        std::lock_guard<std::mutex> lock(m_streamMutex);
+        // The decode thread keeps its own reference while it fills a slab
+        m_streams.erase(std::find(m_streams.begin(), m_streams.end(), voiceSlot.stream));
+        voiceSlot.stream.reset();
+    }
+    voiceSlot.buffer = 0;
+    voiceSlot.active = false;
+    voiceSlot.generation++;
+}
+
+// Voices are the slot index + 1 in the low 16 bits and the slot's
+// generation in the high 16, so a stale voice does not touch a reused slot
+AudioEngine::VoiceSlot *AudioEngine::slotFor(Voice voice)
+{
+    return const_cast<VoiceSlot *>(static_cast<const AudioEngine *>(this)->slotFor(voice));
+}
+
+const AudioEngine::VoiceSlot *AudioEngine::slotFor(Voice voice) const
+{
+    const int slot = int(voice & 0xffff) - 1;
+    if (slot < 0 || slot >= int(m_slots.size()))
+    {
+        return nullptr;
+    }
+    const VoiceSlot &voiceSlot = m_slots[slot];
+    if (!voiceSlot.active || (voiceSlot.generation & 0xffff) != (voice >> 16))
+    {
+        return nullptr;
+    }
+    return &voiceSlot;
+}
+
+AudioEngine::Voice AudioEngine::startVoice(int slot, const VoiceParams &params)
+{
+    VoiceSlot &voiceSlot = m_slots[slot];
+    voiceSlot.active = true;
+    voiceSlot.priority = params.priority;
+    voiceSlot.gain = params.gain;
+    voiceSlot.referenceDistance = params.referenceDistance;
+    voiceSlot.position = params.position;
+    voiceSlot.startOrder = m_startCounter++;
+
+    const ALuint source = voiceSlot.source;
+    alSource3f(source, AL_POSITION, params.position.x(), params.position.y(),
+        params.position.z());
+    alSourcef(source, AL_GAIN, params.gain);
+    alSourcef(source, AL_PITCH, params.pitch);
+    alSourcef(source, AL_REFERENCE_DISTANCE, params.referenceDistance);
+    m_stats.started++;
+    return ((voiceSlot.generation & 0xffff) << 16) | quint32(slot + 1);
+}
+
+// Recycles the buffers the source has played, queues the slabs decoded
+// since the last update and restarts a source that ran dry
+void AudioEngine::feedStream(int slot)
+{
+    VoiceSlot &voiceSlot = m_slots[slot];
+    Stream &stream = *voiceSlot.stream;
+    ALint processed = 0;
+    alGetSourcei(voiceSlot.source, AL_BUFFERS_PROCESSED, &processed);
+    // Buffers come back in the order they were queued, each one gives
+    // the oldest slab back to the decode threads
+    if (processed > 0)
+    {
+        alSourceUnqueueBuffers(voiceSlot.source, processed,
+            voiceSlot.freeBuffers + voiceSlot.freeBufferCount);
+        voiceSlot.freeBufferCount += processed;
+    }
+
+    // Only the ring is touched with the lock held, without static buffers
+    // alBufferData() copies every slab and the decode threads would wait
+    qint16 *slabs[streamRingSize];
+    int slabFrames[streamRingSize];
+    int count = 0;
+    const bool freed = processed > 0;
+    bool finished = false;
+    {
+        std::lock_guard<std::mutex> lock(m_streamMutex);
+        stream.head = (stream.head + processed) % streamRingSize;
+        stream.queued -= processed;
+        // Counted as queued already, so no decode thread refills them
+        for (; count < voiceSlot.freeBufferCount && stream.ready > 0; ++count)
+        {
+            const int slab = (stream.head + stream.queued) % streamRingSize;
+            slabs[count] = stream.slabs[slab];
+            slabFrames[count] = stream.slabFrames[slab];
+            stream.ready--;
+            stream.queued++;
+        }
+        finished = stream.ended && stream.ready == 0 && !stream.decoding;
+        if (!stream.ended)
+        {
+            m_stats.decodeBacklog += streamRingSize - stream.queued - stream.ready;
+        }
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        const ALuint buffer = voiceSlot.freeBuffers[--voiceSlot.freeBufferCount];
+        bufferData(buffer, stream.format, slabs[i],
+            int(slabFrames[i] * stream.channels * sizeof(qint16)), stream.sampleRate);
+        alSourceQueueBuffers(voiceSlot.source, 1, &buffer);
+    }
+    if (freed)
+    {
+        m_decodeWake.notify_all();
+    }
+
+    ALint state = AL_STOPPED;
+    ALint queued = 0;
+    alGetSourcei(voiceSlot.source, AL_SOURCE_STATE, &state);
+    alGetSourcei(voiceSlot.source, AL_BUFFERS_QUEUED, &queued);
+    if (state == AL_PLAYING)
+    {
+        return;
+    }
+    if (queued > 0)
+    {
+        // A started source that stopped had played everything it was given
+        if (voiceSlot.streamStarted)
+        {
+            m_stats.underruns++;
+        }
+        else
+        {
+            const double ms = (m_clock.nsecsElapsed() - voiceSlot.streamStartNs) / 1e6;
+            m_stats.firstSamples++;
+            m_stats.firstSampleMs += ms;
+            m_stats.maxFirstSampleMs = qMax(m_stats.maxFirstSampleMs, ms);
+        }
+        voiceSlot.streamStarted = true;
+        alSourcePlay(voiceSlot.source);
+    }
+    else if (finished)
+    {
+        releaseSlot(slot);
+    }
+}
+
+// Static buffers keep pointing at pcm, the caller must not touch it
+// until the buffer is unqueued or rebuffered
+void AudioEngine::bufferData(ALuint buffer, ALenum format, qint16 *pcm, int bytes,
+    int sampleRate)
+{
+    if (m_bufferDataStatic)
+    {
+        m_bufferDataStatic(buffer, format, pcm, bytes, sampleRate);
+    }
+    else
+    {
+        alBufferData(buffer, format, pcm, bytes, sampleRate);
+    }
+}
+
+// Inverse distance gain, the same curve as AL_INVERSE_DISTANCE_CLAMPED
+// with a rolloff factor of 1
+float AudioEngine::audibility(const VoiceSlot &slot) const
+{
+    const float distance = (slot.position - m_listenerPosition).length();
+    return slot.gain * slot.referenceDistance / qMax(slot.referenceDistance, distance);
+}
+
+void AudioEngine::decodeLoop()
+{
+    std::unique_lock<std::mutex> lock(m_streamMutex);
+    for (;;)
+    {
+        if (m_stopping)
+        {
+            return;
+        }
+        // The stream with the fewest slabs ahead of the mixer runs dry first
+        std::shared_ptr<Stream> stream;
+        int streamAhead = streamRingSize;
+        for (const std::shared_ptr<Stream> &candidate : m_streams)
+        {
+            const int ahead = candidate->queued + candidate->ready;
+            if (!candidate->decoding && !candidate->ended && ahead < streamAhead)
+            {
+                stream = candidate;
+                streamAhead = ahead;
+            }
+        }
+        if (!stream)
+        {
+            m_decodeWake.wait(lock);
+            continue;
+        }
+        stream->decoding = true;
+        const int slab = (stream->head + stream->queued + stream->ready) % streamRingSize;
+        lock.unlock();
+
+        qint16 *pcm = stream->slabs[slab];
+        int frames = 0;
+        bool ended = false;
+        bool rewound = false;
+        while (frames < streamChunkFrames)
+        {
+            const int read = stream->source->read(pcm + frames * stream->channels,
+                streamChunkFrames - frames);
+            if (read > 0)
+            {
+                frames += read;
+                rewound = false;
+            }
+            // An empty stream would otherwise loop forever
+            else if (stream->looping && !rewound && stream->source->rewind())
+            {
+                rewound = true;
+            }
+            else
+            {
+                ended = true;
+                break;
+            }
+        }
+
+        lock.lock();
+        stream->decoding = false;
+        stream->ended = ended;
+        if (frames > 0)
+        {
+            stream->slabFrames[slab] = frames;
+            stream->ready++;
+        }
+    }
+}
@@ -0,0 +1,193 @@
+#ifndef AUDIO_ENGINE_H
+#define AUDIO_ENGINE_H
+
+#include <QtCore/QElapsedTimer>
+#include <QtGui/QVector3D>
+
+#include <AL/al.h>
+#include <AL/alc.h>
+#include <AL/alext.h>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "audio_stream.h"
+
+// Positional sound on OpenAL with a fixed pool of sources. Every source
+// is created in open(), play() never allocates one: when the pool is full
+// the lowest priority voice is stolen, the quietest and then the oldest
+// among equal priorities, or the new sound is dropped when every voice
+// outranks it.
+//
+// Long clips are streamed through a ring of streamRingSize buffers per
+// voice. A pool of decode threads reads AudioStream chunks into PCM
+// slabs that are allocated once in open(), update() queues the decoded
+// slabs on the sources. With AL_EXT_STATIC_BUFFER OpenAL mixes straight
+// from the slabs, so a slab goes back to its stream only once the source
+// has played it. All OpenAL calls are made on the thread that calls
+// update().
+//
+// The listener takes the camera basis as it is, so the window passes
+// the vectors that OrbitControls already caches.
+class AudioEngine
+{
+public:
+    enum class Device
+    {
+        // The system output
+        Default,
+        // OpenAL Soft's "No Output" backend, mixes in real time and drops
+        // the result
+        Null,
+        // ALC_SOFT_loopback, mixes only when render() is called
+        Loopback
+    };
+
+    // 0 is never a valid voice
+    typedef quint32 Voice;
+
+    struct VoiceParams
+    {
+        QVector3D position;
+        float gain = 1.f;
+        float pitch = 1.f;
+        // Higher priorities steal voices from lower ones
+        int priority = 0;
+        bool looping = false;
+        // Distance at which the gain starts to fall off
+        float referenceDistance = 1.f;
+    };
+
+    struct Stats
+    {
+        int voices = 0;
+        int activeVoices = 0;
+        int streamingVoices = 0;
+        quint64 started = 0;
+        quint64 stolen = 0;
+        quint64 rejected = 0;
+        // Streamed voices that ran out of decoded data while playing
+        quint64 underruns = 0;
+        // PCM slabs waiting to be decoded over all streams
+        int decodeBacklog = 0;
+        // From playStream() to the source starting to play
+        quint64 firstSamples = 0;
+        double firstSampleMs = 0.0;
+        double maxFirstSampleMs = 0.0;
+        // Time spent in update() and, with the loopback device, in the
+        // mixer; other devices mix on OpenAL's own thread
+        double updateMs = 0.0;
+        double mixMs = 0.0;
+        qint64 mixedFrames = 0;
+    };
+
+    static const int streamRingSize = 4;
+    static const int streamChunkFrames = 4096;
+
+    explicit AudioEngine(int voiceCount = 32, int decodeThreads = 1);
+    ~AudioEngine();
+
+    bool open(Device device = Device::Default, int sampleRate = 44100);
+    void close();
+    bool isOpen() const { return m_context != nullptr; }
+    Device device() const { return m_device; }
+    int sampleRate() const { return m_sampleRate; }
+    // AL_EXT_STATIC_BUFFER, buffers reference PCM instead of copying it
+    bool hasStaticBuffers() const { return m_bufferDataStatic != nullptr; }
+
+    // Static clip played whole from memory, 1 or 2 channels
+    ALuint createBuffer(const qint16 *pcm, int frameCount, int channels, int sampleRate);
+    // The same without a copy when static buffers are supported, pcm has
+    // to stay valid until deleteBuffer()
+    ALuint createSharedBuffer(const qint16 *pcm, int frameCount, int channels, int sampleRate);
+    // Stops the voices that still play the buffer first
+    void deleteBuffer(ALuint buffer);
+    // Whether a voice is still playing the buffer
+    bool isBufferInUse(ALuint buffer) const;
+
+    Voice play(ALuint buffer, const VoiceParams &params);
+    Voice playStream(std::unique_ptr<AudioStream> stream, const VoiceParams &params);
+    void setPosition(Voice voice, const QVector3D &position);
+    void setGain(Voice voice, float gain);
+    void stop(Voice voice);
+    bool isPlaying(Voice voice) const;
+
+    // back points from the scene towards the camera
+    void setListener(const QVector3D &position, const QVector3D &back, const QVector3D &up);
+
+    // Reclaims finished voices and feeds the streams, once per frame or
+    // more often than streamChunkFrames of audio take to play
+    void update();
+
+    // Loopback device only: mixes frameCount interleaved stereo frames
+    void render(qint16 *pcm, int frameCount);
+
+    // Counters are reset by resetStats(), the gauges by update()
+    const Stats &stats() const { return m_stats; }
+    void resetStats();
+
+private:
+    struct Stream;
+    typedef void (AL_APIENTRY *BufferDataStatic)(ALuint buffer, ALenum format, ALvoid *data,
+        ALsizei size, ALsizei frequency);
+
+    struct VoiceSlot
+    {
+        ALuint source = 0;
+        quint32 generation = 0;
+        bool active = false;
+        int priority = 0;
+        float gain = 1.f;
+        float referenceDistance = 1.f;
+        QVector3D position;
+        quint64 startOrder = 0;
+        ALuint buffer = 0;
+        std::shared_ptr<Stream> stream;
+        bool streamStarted = false;
+        qint64 streamStartNs = 0;
+        ALuint freeBuffers[streamRingSize];
+        int freeBufferCount = 0;
+    };
+
+    int acquireSlot(int priority);
+    void releaseSlot(int slot);
+    VoiceSlot *slotFor(Voice voice);
+    const VoiceSlot *slotFor(Voice voice) const;
+    Voice startVoice(int slot, const VoiceParams &params);
+    void feedStream(int slot);
+    void bufferData(ALuint buffer, ALenum format, qint16 *pcm, int bytes, int sampleRate);
+    float audibility(const VoiceSlot &slot) const;
+    void decodeLoop();
+
+    int m_voiceCount;
+    int m_decodeThreadCount;
+    Device m_device = Device::Default;
+    int m_sampleRate = 0;
+    ALCdevice *m_alDevice = nullptr;
+    ALCcontext *m_context = nullptr;
+    LPALCRENDERSAMPLESSOFT m_renderSamples = nullptr;
+    BufferDataStatic m_bufferDataStatic = nullptr;
+
+    std::vector<VoiceSlot> m_slots;
+    std::vector<ALuint> m_streamBuffers;
+    QVector3D m_listenerPosition;
+    quint64 m_startCounter = 0;
+    QElapsedTimer m_clock;
+    Stats m_stats;
+
+    // Guards the stream list, the free slabs and every stream's ring.
+    // Streams are only released with it held, their slabs go back to
+    // m_freeSlabs then.
+    std::mutex m_streamMutex;
+    std::condition_variable m_decodeWake;
+    std::vector<std::shared_ptr<Stream>> m_streams;
+    std::vector<qint16> m_slabMemory;
+    std::vector<qint16 *> m_freeSlabs;
+    std::vector<std::thread> m_decodeThreads;
+    bool m_stopping = false;
+};
+
+#endif // AUDIO_ENGINE_H
@@ -0,0 +1,53 @@
+#include <QtCore/QDebug>
+
+#include <cstring>
+
+#include "audio_file.h"
+
+bool AudioFile::open(const QString &path)
+{
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly))
+    {
+        qWarning() << "Failed to open" << path;
+        return false;
+    }
+    m_size = m_file.size();
+    m_pos = 0;
+    m_mapped = m_file.map(0, m_size);
+    return true;
+}
+
+bool AudioFile::seek(qint64 pos)
+{
+    if (pos < 0 || pos > m_size)
+    {
+        return false;
+    }
+    if (!m_mapped && !m_file.seek(pos))
+    {
+        return false;
+    }
+    m_pos = pos;
+    return true;
+}
+
+qint64 AudioFile::read(char *data, qint64 maxSize)
+{
+    qint64 count;
+    if (m_mapped)
+    {
+        count = qMin(maxSize, m_size - m_pos);
+        std::memcpy(data, m_mapped + m_pos, size_t(count));
+    }
+    else
+    {
+        count = m_file.read(data, maxSize);
+        if (count < 0)
+        {
+            return -1;
+        }
+    }
+    m_pos += count;
+    return count;
+}
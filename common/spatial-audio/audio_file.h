@@ -0,0 +1,31 @@
+#ifndef AUDIO_FILE_H
+#define AUDIO_FILE_H
+
+#include <QtCore/QFile>
+#include <QtCore/QString>
+
+// Sequential and seekable reads of a sound asset, usually a Qt resource.
+// Plain files and uncompressed resources are mapped, so reading them is
+// a copy out of memory that is already there; compressed resources fall
+// back to QFile reads of the requested size.
+class AudioFile
+{
+public:
+    bool open(const QString &path);
+
+    qint64 size() const { return m_size; }
+    qint64 pos() const { return m_pos; }
+    bool seek(qint64 pos);
+    qint64 read(char *data, qint64 maxSize);
+
+    // The whole file when it is mapped, otherwise nullptr
+    const uchar *mapped() const { return m_mapped; }
+
+private:
+    QFile m_file;
+    const uchar *m_mapped = nullptr;
+    qint64 m_size = 0;
+    qint64 m_pos = 0;
+};
+
+#endif // AUDIO_FILE_H
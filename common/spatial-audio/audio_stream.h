@@ -0,0 +1,26 @@
+#ifndef AUDIO_STREAM_H
+#define AUDIO_STREAM_H
+
+#include <QtCore/QtGlobal>
+
+// Source of interleaved 16-bit PCM for a streamed voice. The audio
+// engine pulls it on its decode thread only, so an implementation does
+// not need to be thread-safe.
+class AudioStream
+{
+public:
+    virtual ~AudioStream() {}
+
+    virtual int channels() const = 0;
+    virtual int sampleRate() const = 0;
+    // Length in frames, -1 when unknown or endless
+    virtual qint64 frameCount() const = 0;
+
+    // Writes up to frameCount frames to pcm and returns how many were
+    // written, 0 at the end of the stream
+    virtual int read(qint16 *pcm, int frameCount) = 0;
+    // Goes back to the first frame, used by looping voices
+    virtual bool rewind() = 0;
+};
+
+#endif // AUDIO_STREAM_H
@@ -0,0 +1,119 @@
+#include <QtCore/QtMath>
+
+#include <algorithm>
+
+#include "impact_sounds.h"
+
+ImpactSounds::ImpactSounds(SoundCache *cache, const Settings &settings)
+    : m_cache(cache)
+    , m_settings(settings)
+{
+    m_settings.maxImpacts = qMax(m_settings.maxImpacts, 1);
+    m_settings.maxPerFrame = qMax(m_settings.maxPerFrame, 0);
+    m_impacts.resize(size_t(m_settings.maxImpacts));
+    // Under half full, so probe chains stay short
+    quint32 size = 1;
+    while (size < quint32(m_settings.maxImpacts) * 2)
+    {
+        size <<= 1;
+    }
+    m_cellTable.assign(size, -1);
+    m_cellMask = size - 1;
+}
+
+void ImpactSounds::setClips(const QStringList &paths)
+{
+    m_clips = paths;
+    // flush() runs in the frame, it must not decode a clip on first use
+    m_cache->preload(paths);
+}
+
+qint64 ImpactSounds::memoryBytes() const
+{
+    return qint64(m_impacts.size() * sizeof(Impact) + m_cellTable.size() * sizeof(int));
+}
+
+void ImpactSounds::add(const QVector3D &position, float impulse)
+{
+    m_stats.impacts++;
+    if (impulse < m_settings.minImpulse)
+    {
+        m_stats.quiet++;
+        return;
+    }
+
+    const qint32 cellX = qFloor(position.x() / m_settings.cellSize);
+    const qint32 cellY = qFloor(position.y() / m_settings.cellSize);
+    const quint64 cell = (quint64(quint32(cellX)) << 32) | quint32(cellY);
+    quint32 slot = quint32((cell * 0x9E3779B97F4A7C15ull) >> 32) & m_cellMask;
+    while (m_cellTable[slot] >= 0)
+    {
+        Impact &impact = m_impacts[size_t(m_cellTable[slot])];
+        if (impact.cell == cell)
+        {
+            m_stats.merged++;
+            if (impulse > impact.impulse)
+            {
+                impact.position = position;
+                impact.impulse = impulse;
+            }
+            return;
+        }
+        slot = (slot + 1) & m_cellMask;
+    }
+    if (m_impactCount == m_settings.maxImpacts)
+    {
+        m_stats.throttled++;
+        return;
+    }
+    m_cellTable[slot] = m_impactCount;
+    m_impacts[size_t(m_impactCount++)] = { position, impulse, cell, slot };
+}
+
+void ImpactSounds::flush()
+{
+    m_timer.start();
+    Impact *first = m_impacts.data();
+    Impact *last = first + m_impactCount;
+    Impact *end = last;
+    if (m_impactCount > m_settings.maxPerFrame)
+    {
+        end = first + m_settings.maxPerFrame;
+        std::nth_element(first, end, last, [](const Impact &a, const Impact &b)
+            {
+                return a.impulse > b.impulse;
+            });
+        m_stats.throttled += quint64(m_impactCount - m_settings.maxPerFrame);
+    }
+
+    const int clipCount = m_clips.size();
+    const float range = qLn(qMax(m_settings.fullImpulse / m_settings.minImpulse, 1.0001f));
+    for (Impact *impact = first; impact != end && clipCount > 0; ++impact)
+    {
+        // Loudness is heard on a log scale
+        const float level = qBound(0.f,
+            float(qLn(impact->impulse / m_settings.minImpulse)) / range, 1.f);
+        AudioEngine::VoiceParams params;
+        params.position = impact->position;
+        params.gain = 0.15f + 0.85f * level;
+        params.priority = qMin(int(level * 4.f), 3);
+        params.referenceDistance = m_settings.referenceDistance;
+        const int clip = qMin(int(level * clipCount), clipCount - 1);
+        if (m_cache->play(m_clips[clip], params))
+        {
+            m_stats.played++;
+        }
+        else
+        {
+            m_stats.rejected++;
+        }
+    }
+
+    // Only the slots that were used are cleared
+    for (int i = 0; i < m_impactCount; ++i)
+    {
+        m_cellTable[m_impacts[size_t(i)].slot] = -1;
+    }
+    m_impactCount = 0;
+    m_stats.flushMs += m_timer.nsecsElapsed() / 1e6;
+}
@@ -0,0 +1,90 @@
+#ifndef IMPACT_SOUNDS_H
+#define IMPACT_SOUNDS_H
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QStringList>
+#include <QtGui/QVector3D>
+
+#include <vector>
+
+#include "sound_cache.h"
+
+// Collects the impacts of a frame and turns them into a bounded number of
+// voices. Impacts in the same cell of a grid are merged into the
+// strongest one, then only the maxPerFrame strongest cells are played,
+// so a pile-up of hundreds of contacts costs a few voices. Louder
+// impacts pick heavier clips, higher gains and priorities.
+//
+// All storage is sized in the constructor, add() and flush() never
+// allocate.
+class ImpactSounds
+{
+public:
+    struct Settings
+    {
+        // Size of the merge grid in world units
+        float cellSize = 10.f;
+        // Impacts under minImpulse are not heard, fullImpulse and above
+        // play the heaviest clip at full gain
+        float minImpulse = 1.f;
+        float fullImpulse = 100.f;
+        int maxPerFrame = 8;
+        // Distance at which the voices start to fall off
+        float referenceDistance = 10.f;
+        // Cells per frame, impacts in further cells are dropped
+        int maxImpacts = 4096;
+    };
+
+    struct Stats
+    {
+        quint64 impacts = 0;
+        // Under minImpulse
+        quint64 quiet = 0;
+        // Merged into a stronger impact of the same cell
+        quint64 merged = 0;
+        // Cells that were not played because of maxPerFrame or
+        // maxImpacts
+        quint64 throttled = 0;
+        quint64 played = 0;
+        // Voices refused by the engine
+        quint64 rejected = 0;
+        double flushMs = 0.0;
+    };
+
+    ImpactSounds(SoundCache *cache, const Settings &settings);
+
+    // From the lightest to the heaviest impact. The clips are decoded
+    // here, so the engine has to be open already.
+    void setClips(const QStringList &paths);
+
+    void add(const QVector3D &position, float impulse);
+    // Plays the strongest impacts collected since the last flush()
+    void flush();
+
+    const Stats &stats() const { return m_stats; }
+    void resetStats() { m_stats = Stats(); }
+    // Fixed by the settings
+    qint64 memoryBytes() const;
+
+private:
+    struct Impact
+    {
+        QVector3D position;
+        float impulse;
+        quint64 cell;
+        quint32 slot;
+    };
+
+    SoundCache *m_cache;
+    Settings m_settings;
+    QStringList m_clips;
+    std::vector<Impact> m_impacts;
+    int m_impactCount = 0;
+    // Open addressing from a cell to its index in m_impacts, -1 is empty
+    std::vector<int> m_cellTable;
+    quint32 m_cellMask;
+    QElapsedTimer m_timer;
+    Stats m_stats;
+};
+
+#endif // IMPACT_SOUNDS_H
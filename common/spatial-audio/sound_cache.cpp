@@ -0,0 +1,136 @@
+#include <QtCore/QElapsedTimer>
+
+#include "audio_decoder.h"
+#include "sound_cache.h"
+
+SoundCache::SoundCache(AudioEngine *engine, qint64 budgetBytes, qint64 maxClipBytes)
+    : m_engine(engine)
+    , m_budgetBytes(budgetBytes)
+    , m_maxClipBytes(qMin(maxClipBytes, budgetBytes))
+{
+}
+
+SoundCache::~SoundCache()
+{
+    clear();
+}
+
+ALuint SoundCache::buffer(const QString &path)
+{
+    auto found = m_index.find(path);
+    if (found != m_index.end())
+    {
+        m_clips.splice(m_clips.begin(), m_clips, found.value());
+        m_stats.hits++;
+        return m_clips.front().buffer;
+    }
+    if (m_streamedPaths.contains(path))
+    {
+        return 0;
+    }
+    m_stats.misses++;
+
+    QElapsedTimer timer;
+    timer.start();
+    std::unique_ptr<AudioStream> stream = openAudioStream(path);
+    if (!stream)
+    {
+        return 0;
+    }
+    const qint64 frameCount = stream->frameCount();
+    const qint64 bytes = frameCount * stream->channels() * qint64(sizeof(qint16));
+    if (frameCount < 0 || bytes > m_maxClipBytes)
+    {
+        m_streamedPaths.insert(path, true);
+        return 0;
+    }
+    if (!makeRoom(bytes))
+    {
+        return 0;
+    }
+
+    Clip clip;
+    clip.path = path;
+    clip.pcm.resize(size_t(frameCount * stream->channels()));
+    int frames = 0;
+    while (frames < frameCount)
+    {
+        const int read = stream->read(clip.pcm.data() + frames * stream->channels(),
+            int(frameCount - frames));
+        if (read <= 0)
+        {
+            break;
+        }
+        frames += read;
+    }
+    clip.buffer = m_engine->createSharedBuffer(clip.pcm.data(), frames, stream->channels(),
+        stream->sampleRate());
+    m_stats.decodeMs += timer.nsecsElapsed() / 1e6;
+
+    m_clips.push_front(std::move(clip));
+    m_index.insert(path, m_clips.begin());
+    m_stats.clips++;
+    m_stats.bytes += bytes;
+    return m_clips.front().buffer;
+}
+
+void SoundCache::preload(const QStringList &paths)
+{
+    for (const QString &path : paths)
+    {
+        buffer(path);
+    }
+}
+
+AudioEngine::Voice SoundCache::play(const QString &path, const AudioEngine::VoiceParams &params)
+{
+    if (const ALuint clip = buffer(path))
+    {
+        return m_engine->play(clip, params);
+    }
+    std::unique_ptr<AudioStream> stream = openAudioStream(path);
+    if (!stream)
+    {
+        return 0;
+    }
+    m_stats.streamed++;
+    return m_engine->playStream(std::move(stream), params);
+}
+
+void SoundCache::clear()
+{
+    // The buffers went away with the engine's context when it is closed
+    if (m_engine && m_engine->isOpen())
+    {
+        for (const Clip &clip : m_clips)
+        {
+            m_engine->deleteBuffer(clip.buffer);
+        }
+    }
+    m_clips.clear();
+    m_index.clear();
+    m_stats.clips = 0;
+    m_stats.bytes = 0;
+}
+
+// Evicts from the least recently used end, skipping clips that voices
+// are playing rather than cutting them off
+bool SoundCache::makeRoom(qint64 bytes)
+{
+    auto clip = m_clips.end();
+    while (m_stats.bytes + bytes > m_budgetBytes && clip != m_clips.begin())
+    {
+        --clip;
+        if (m_engine->isBufferInUse(clip->buffer))
+        {
+            continue;
+        }
+        m_engine->deleteBuffer(clip->buffer);
+        m_stats.bytes -= qint64(clip->pcm.size() * sizeof(qint16));
+        m_stats.clips--;
+        m_stats.evictions++;
+        m_index.remove(clip->path);
+        clip = m_clips.erase(clip);
+    }
+    return m_stats.bytes + bytes <= m_budgetBytes;
+}
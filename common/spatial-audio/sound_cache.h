@@ -0,0 +1,67 @@
+#ifndef SOUND_CACHE_H
+#define SOUND_CACHE_H
+
+#include <QtCore/QHash>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+
+#include <list>
+#include <vector>
+
+#include "audio_engine.h"
+
+// Short, frequent effects kept fully decoded under a memory budget, the
+// least recently played are evicted first. Clips longer than
+// maxClipBytes are streamed instead. The decoded PCM is shared with
+// OpenAL through static buffers where they are supported, so the budget
+// is the memory actually used.
+class SoundCache
+{
+public:
+    struct Stats
+    {
+        int clips = 0;
+        qint64 bytes = 0;
+        quint64 hits = 0;
+        quint64 misses = 0;
+        quint64 evictions = 0;
+        quint64 streamed = 0;
+        double decodeMs = 0.0;
+    };
+
+    SoundCache(AudioEngine *engine, qint64 budgetBytes, qint64 maxClipBytes);
+    ~SoundCache();
+
+    // The decoded clip, 0 when it cannot be decoded, is too long or does
+    // not fit next to the clips that are playing
+    ALuint buffer(const QString &path);
+    // Decodes the clips up front, so that playing them later only hits
+    void preload(const QStringList &paths);
+    // Plays a cached clip, or streams the file when buffer() gives 0
+    AudioEngine::Voice play(const QString &path, const AudioEngine::VoiceParams &params);
+    // Also stops the voices that play cached clips
+    void clear();
+
+    const Stats &stats() const { return m_stats; }
+
+private:
+    struct Clip
+    {
+        QString path;
+        ALuint buffer = 0;
+        std::vector<qint16> pcm;
+    };
+
+    bool makeRoom(qint64 bytes);
+
+    AudioEngine *m_engine;
+    qint64 m_budgetBytes;
+    qint64 m_maxClipBytes;
+    // Most recently used first
+    std::list<Clip> m_clips;
+    QHash<QString, std::list<Clip>::iterator> m_index;
+    QHash<QString, bool> m_streamedPaths;
+    Stats m_stats;
+};
+
+#endif // SOUND_CACHE_H
@@ -0,0 +1,56 @@
+isEmpty(SPATIAL_AUDIO_PRI) {
+SPATIAL_AUDIO_PRI = 1
+
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/audio_decoder.h \
+    $$PWD/audio_engine.h \
+    $$PWD/audio_file.h \
+    $$PWD/audio_stream.h \
+    $$PWD/impact_sounds.h \
+    $$PWD/sound_cache.h \
+    $$PWD/tone_stream.h \
+    $$PWD/wav_stream.h
+
+SOURCES += \
+    $$PWD/audio_decoder.cpp \
+    $$PWD/audio_engine.cpp \
+    $$PWD/audio_file.cpp \
+    $$PWD/impact_sounds.cpp \
+    $$PWD/sound_cache.cpp \
+    $$PWD/tone_stream.cpp \
+    $$PWD/wav_stream.cpp
+
+# OpenAL Soft 1.19 or newer, the loopback device needs ALC_SOFT_loopback
+# and zero-copy streaming AL_EXT_STATIC_BUFFER. Pass OPENAL_DIR=<install
+# prefix> to qmake when pkg-config cannot find it.
+!isEmpty(OPENAL_DIR) {
+    INCLUDEPATH += $$OPENAL_DIR/include
+    LIBS += -L$$OPENAL_DIR/lib -lopenal
+} else {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += openal
+}
+
+# Ogg files are decoded by libvorbisfile, configure with
+# "qmake CONFIG+=vorbis" and pass VORBIS_DIR=<install prefix> when
+# pkg-config cannot find it. Without it only .wav files open.
+vorbis {
+    DEFINES += VORBIS_AUDIO
+
+    HEADERS += \
+        $$PWD/vorbis_stream.h
+
+    SOURCES += \
+        $$PWD/vorbis_stream.cpp
+
+    !isEmpty(VORBIS_DIR) {
+        INCLUDEPATH += $$VORBIS_DIR/include
+        LIBS += -L$$VORBIS_DIR/lib -lvorbisfile -lvorbis -logg
+    } else {
+        CONFIG += link_pkgconfig
+        PKGCONFIG += vorbisfile
+    }
+}
+}
@@ -0,0 +1,39 @@
+#include <QtCore/QtMath>
+
+#include "tone_stream.h"
+
+ToneStream::ToneStream(float frequency, int sampleRate, int frameCount, float amplitude)
+    : m_frequency(frequency)
+    , m_sampleRate(sampleRate)
+    , m_frameCount(frameCount)
+    , m_amplitude(amplitude)
+{
+}
+
+int ToneStream::read(qint16 *pcm, int frameCount)
+{
+    if (m_frameCount > 0)
+    {
+        frameCount = qMin(frameCount, m_frameCount - m_position);
+    }
+    const float step = 2.f * float(M_PI) * m_frequency / m_sampleRate;
+    for (int i = 0; i < frameCount; ++i)
+    {
+        pcm[i] = qint16(32767.f * m_amplitude * qSin(m_phase));
+        // Wrapped so that endless tones keep their precision
+        m_phase += step;
+        if (m_phase > 2.f * float(M_PI))
+        {
+            m_phase -= 2.f * float(M_PI);
+        }
+    }
+    m_position += frameCount;
+    return frameCount;
+}
+
+bool ToneStream::rewind()
+{
+    m_position = 0;
+    m_phase = 0.f;
+    return true;
+}
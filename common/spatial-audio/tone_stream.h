@@ -0,0 +1,28 @@
+#ifndef TONE_STREAM_H
+#define TONE_STREAM_H
+
+#include "audio_stream.h"
+
+// Mono sine tone, a stand-in for decoded clips in the examples and
+// benchmarks. frameCount = 0 makes it endless.
+class ToneStream : public AudioStream
+{
+public:
+    ToneStream(float frequency, int sampleRate, int frameCount = 0, float amplitude = 0.5f);
+
+    int channels() const override { return 1; }
+    int sampleRate() const override { return m_sampleRate; }
+    qint64 frameCount() const override { return m_frameCount > 0 ? m_frameCount : -1; }
+    int read(qint16 *pcm, int frameCount) override;
+    bool rewind() override;
+
+private:
+    float m_frequency;
+    int m_sampleRate;
+    int m_frameCount;
+    float m_amplitude;
+    int m_position = 0;
+    float m_phase = 0.f;
+};
+
+#endif // TONE_STREAM_H
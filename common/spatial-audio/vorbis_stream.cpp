@@ -0,0 +1,94 @@
+#include <QtCore/QDebug>
+
+#include "vorbis_stream.h"
+
+VorbisStream::~VorbisStream()
+{
+    if (m_open)
+    {
+        ov_clear(&m_vorbis);
+    }
+}
+
+bool VorbisStream::open(const QString &path)
+{
+    if (!m_file.open(path))
+    {
+        return false;
+    }
+    const ov_callbacks callbacks = { readFile, seekFile, nullptr, tellFile };
+    if (ov_open_callbacks(&m_file, &m_vorbis, nullptr, 0, callbacks) != 0)
+    {
+        qWarning() << path << "is not an Ogg Vorbis file";
+        return false;
+    }
+    m_open = true;
+
+    const vorbis_info *info = ov_info(&m_vorbis, -1);
+    m_channels = info->channels;
+    m_sampleRate = int(info->rate);
+    if (m_channels < 1 || m_channels > 2)
+    {
+        qWarning() << path << "has" << m_channels << "channels, only mono and stereo are played";
+        return false;
+    }
+    const ogg_int64_t total = ov_pcm_total(&m_vorbis, -1);
+    m_frameCount = total >= 0 ? qint64(total) : -1;
+    return true;
+}
+
+int VorbisStream::read(qint16 *pcm, int frameCount)
+{
+    const int frameBytes = m_channels * int(sizeof(qint16));
+    char *data = reinterpret_cast<char *>(pcm);
+    int bytes = 0;
+    while (bytes < frameCount * frameBytes)
+    {
+        int section = 0;
+        // Little-endian, 16-bit, signed
+        const long count = ov_read(&m_vorbis, data + bytes, frameCount * frameBytes - bytes,
+            0, 2, 1, &section);
+        if (count == OV_HOLE)
+        {
+            continue;
+        }
+        if (count <= 0)
+        {
+            break;
+        }
+        bytes += int(count);
+    }
+    return bytes / frameBytes;
+}
+
+bool VorbisStream::rewind()
+{
+    return ov_pcm_seek(&m_vorbis, 0) == 0;
+}
+
+size_t VorbisStream::readFile(void *data, size_t size, size_t count, void *file)
+{
+    const qint64 bytes = static_cast<AudioFile *>(file)->read(static_cast<char *>(data),
+        qint64(size * count));
+    return bytes > 0 ? size_t(bytes) / size : 0;
+}
+
+int VorbisStream::seekFile(void *file, ogg_int64_t offset, int whence)
+{
+    AudioFile *audioFile = static_cast<AudioFile *>(file);
+    qint64 pos = offset;
+    if (whence == SEEK_CUR)
+    {
+        pos += audioFile->pos();
+    }
+    else if (whence == SEEK_END)
+    {
+        pos += audioFile->size();
+    }
+    return audioFile->seek(pos) ? 0 : -1;
+}
+
+long VorbisStream::tellFile(void *file)
+{
+    return long(static_cast<AudioFile *>(file)->pos());
+}
@@ -0,0 +1,40 @@
+#ifndef VORBIS_STREAM_H
+#define VORBIS_STREAM_H
+
+#include <vorbis/vorbisfile.h>
+
+#include "audio_file.h"
+#include "audio_stream.h"
+
+// Ogg Vorbis through libvorbisfile, fed from an AudioFile so that
+// resources are decoded in place without being read into memory first
+class VorbisStream : public AudioStream
+{
+public:
+    VorbisStream() = default;
+    VorbisStream(const VorbisStream &) = delete;
+    VorbisStream &operator=(const VorbisStream &) = delete;
+    ~VorbisStream();
+
+    bool open(const QString &path);
+
+    int channels() const override { return m_channels; }
+    int sampleRate() const override { return m_sampleRate; }
+    qint64 frameCount() const override { return m_frameCount; }
+    int read(qint16 *pcm, int frameCount) override;
+    bool rewind() override;
+
+private:
+    static size_t readFile(void *data, size_t size, size_t count, void *file);
+    static int seekFile(void *file, ogg_int64_t offset, int whence);
+    static long tellFile(void *file);
+
+    AudioFile m_file;
+    OggVorbis_File m_vorbis;
+    bool m_open = false;
+    int m_channels = 0;
+    int m_sampleRate = 0;
+    qint64 m_frameCount = -1;
+};
+
+#endif // VORBIS_STREAM_H
@@ -0,0 +1,83 @@
+#include <QtCore/QDebug>
+#include <QtCore/QtEndian>
+
+#include <cstring>
+
+#include "wav_stream.h"
+
+bool WavStream::open(const QString &path)
+{
+    if (!m_file.open(path))
+    {
+        return false;
+    }
+    uchar header[12];
+    if (m_file.read(reinterpret_cast<char *>(header), sizeof(header)) != sizeof(header) ||
+        std::memcmp(header, "RIFF", 4) != 0 || std::memcmp(header + 8, "WAVE", 4) != 0)
+    {
+        qWarning() << path << "is not a WAVE file";
+        return false;
+    }
+
+    // Chunks in any order, fmt has to come before data
+    int bitsPerSample = 0;
+    uchar chunk[8];
+    while (m_file.read(reinterpret_cast<char *>(chunk), sizeof(chunk)) == sizeof(chunk))
+    {
+        const qint64 chunkSize = qFromLittleEndian<quint32>(chunk + 4);
+        const qint64 chunkStart = m_file.pos();
+        if (std::memcmp(chunk, "fmt ", 4) == 0)
+        {
+            uchar format[16];
+            if (chunkSize < 16 ||
+                m_file.read(reinterpret_cast<char *>(format), sizeof(format)) != sizeof(format))
+            {
+                break;
+            }
+            // PCM or WAVE_FORMAT_EXTENSIBLE around it
+            const int formatTag = qFromLittleEndian<quint16>(format);
+            m_channels = qFromLittleEndian<quint16>(format + 2);
+            m_sampleRate = int(qFromLittleEndian<quint32>(format + 4));
+            bitsPerSample = qFromLittleEndian<quint16>(format + 14);
+            if ((formatTag != 1 && formatTag != 0xfffe) || bitsPerSample != 16 ||
+                m_channels < 1 || m_channels > 2)
+            {
+                qWarning() << path << "is not 16-bit mono or stereo PCM";
+                return false;
+            }
+        }
+        else if (std::memcmp(chunk, "data", 4) == 0 && bitsPerSample != 0)
+        {
+            m_dataOffset = chunkStart;
+            const qint64 dataSize = qMin(chunkSize, m_file.size() - chunkStart);
+            m_frameCount = dataSize / (m_channels * qint64(sizeof(qint16)));
+            return rewind();
+        }
+        // Chunks are padded to an even size
+        if (!m_file.seek(chunkStart + chunkSize + (chunkSize & 1)))
+        {
+            break;
+        }
+    }
+    qWarning() << path << "has no PCM data";
+    return false;
+}
+
+int WavStream::read(qint16 *pcm, int frameCount)
+{
+    const qint64 frames = qMin(qint64(frameCount), m_frameCount - m_position);
+    const qint64 frameBytes = m_channels * qint64(sizeof(qint16));
+    const qint64 bytes = m_file.read(reinterpret_cast<char *>(pcm), frames * frameBytes);
+    if (bytes <= 0)
+    {
+        return 0;
+    }
+    m_position += bytes / frameBytes;
+    return int(bytes / frameBytes);
+}
+
+bool WavStream::rewind()
+{
+    m_position = 0;
+    return m_file.seek(m_dataOffset);
+}
@@ -0,0 +1,29 @@
+#ifndef WAV_STREAM_H
+#define WAV_STREAM_H
+
+#include "audio_file.h"
+#include "audio_stream.h"
+
+// RIFF WAVE with 16-bit PCM in one or two channels. The samples are used
+// as stored, little-endian like every platform the examples run on.
+class WavStream : public AudioStream
+{
+public:
+    bool open(const QString &path);
+
+    int channels() const override { return m_channels; }
+    int sampleRate() const override { return m_sampleRate; }
+    qint64 frameCount() const override { return m_frameCount; }
+    int read(qint16 *pcm, int frameCount) override;
+    bool rewind() override;
+
+private:
+    AudioFile m_file;
+    int m_channels = 0;
+    int m_sampleRate = 0;
+    qint64 m_dataOffset = 0;
+    qint64 m_frameCount = 0;
+    qint64 m_position = 0;
+};
+
+#endif // WAV_STREAM_H
@@ -0,0 +1,204 @@
+#include <QtGui/QOpenGLContext>
+
+#include "streaming_buffer.h"
+
+#ifndef GL_MAP_WRITE_BIT
+#define GL_MAP_WRITE_BIT 0x0002
+#endif
+#ifndef GL_MAP_INVALIDATE_RANGE_BIT
+#define GL_MAP_INVALIDATE_RANGE_BIT 0x0004
+#endif
+#ifndef GL_MAP_UNSYNCHRONIZED_BIT
+#define GL_MAP_UNSYNCHRONIZED_BIT 0x0020
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#endif
+#ifndef GL_SYNC_FLUSH_COMMANDS_BIT
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#endif
+#ifndef GL_ALREADY_SIGNALED
+#define GL_ALREADY_SIGNALED 0x911A
+#endif
+#ifndef GL_CONDITION_SATISFIED
+#define GL_CONDITION_SATISFIED 0x911C
+#endif
+#ifndef GL_WAIT_FAILED
+#define GL_WAIT_FAILED 0x911D
+#endif
+
+StreamingBuffer::StreamingBuffer(int capacity)
+    : m_capacity(capacity)
+{
+}
+
+void StreamingBuffer::initialize(GLStateCache *state, Mode mode)
+{
+    initializeOpenGLFunctions();
+    m_state = state;
+
+    // glMapBufferRange is core in ES 3.0 and GL 3.0, fences in ES 3.0
+    // and GL 3.2
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    const QSurfaceFormat format = context->format();
+    const bool mapRange = context->isOpenGLES() ? format.majorVersion() >= 3 :
+        format.version() >= qMakePair(3, 2);
+    m_mode = mode == Mode::Auto ? (mapRange ? Mode::MapRange : Mode::Orphaning) : mode;
+    if (m_mode == Mode::MapRange && !mapRange)
+    {
+        m_mode = Mode::Orphaning;
+    }
+
+    glGenBuffers(1, &m_buffer);
+    m_state->bindBuffer(GL_ARRAY_BUFFER, m_buffer);
+    glBufferData(GL_ARRAY_BUFFER, m_capacity, nullptr, GL_STREAM_DRAW);
+    m_head = 0;
+    m_frameStart = 0;
+}
+
+void StreamingBuffer::destroy()
+{
+    if (m_mapped)
+    {
+        commit();
+    }
+    deleteFences();
+    if (m_buffer)
+    {
+        glDeleteBuffers(1, &m_buffer);
+        // A deleted name reads as 0 to GL, the cache must not skip a bind
+        m_state->invalidate(GLStateCache::StateBit::Buffers);
+        m_buffer = 0;
+    }
+    m_staging.clear();
+    m_staging.shrink_to_fit();
+}
+
+StreamingBuffer::Allocation StreamingBuffer::allocate(int bytes, int alignment)
+{
+    Q_ASSERT(bytes > 0 && bytes <= m_capacity);
+    if (m_pendingBytes > 0)
+    {
+        commit();
+    }
+
+    qint64 start = (m_head + alignment - 1) / alignment * alignment;
+    if (start % m_capacity + bytes > m_capacity)
+    {
+        // Skip the tail, allocations never straddle the end
+        start = (start / m_capacity + 1) * m_capacity;
+        m_stats.wraps++;
+        if (m_mode == Mode::Orphaning)
+        {
+            orphan();
+            start = 0;
+        }
+    }
+    if (m_mode == Mode::MapRange && start + bytes - m_capacity > m_frameStart)
+    {
+        // The frame alone does not fit in the ring, orphaning is the
+        // only way to keep going without waiting on our own draws
+        orphan();
+        start = 0;
+    }
+    if (m_mode == Mode::MapRange)
+    {
+        waitForRange(start + bytes);
+    }
+
+    m_head = start + bytes;
+    m_pendingOffset = int(start % m_capacity);
+    m_pendingBytes = bytes;
+    m_stats.bytes += bytes;
+    m_stats.allocations++;
+
+    m_state->bindBuffer(GL_ARRAY_BUFFER, m_buffer);
+    if (m_mode == Mode::MapRange)
+    {
+        void *data = glMapBufferRange(GL_ARRAY_BUFFER, m_pendingOffset, bytes,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (data)
+        {
+            m_mapped = true;
+            return { data, m_pendingOffset };
+        }
+        // Mapping failed (out of memory, lost context), stage instead
+    }
+    if (int(m_staging.size()) < bytes)
+    {
+        m_staging.resize(bytes);
+    }
+    return { m_staging.data(), m_pendingOffset };
+}
+
+void StreamingBuffer::commit()
+{
+    if (m_pendingBytes == 0)
+    {
+        return;
+    }
+    m_state->bindBuffer(GL_ARRAY_BUFFER, m_buffer);
+    if (m_mapped)
+    {
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        m_mapped = false;
+    }
+    else
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, m_pendingOffset, m_pendingBytes, m_staging.data());
+    }
+    m_pendingBytes = 0;
+}
+
+void StreamingBuffer::endFrame()
+{
+    commit();
+    if (m_mode == Mode::MapRange && m_head > m_frameStart)
+    {
+        m_fences.push_back({ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), m_frameStart });
+    }
+    m_frameStart = m_head;
+}
+
+void StreamingBuffer::orphan()
+{
+    // The driver hands out fresh storage, draws still reading the old one
+    // keep it alive until they are done
+    m_state->bindBuffer(GL_ARRAY_BUFFER, m_buffer);
+    glBufferData(GL_ARRAY_BUFFER, m_capacity, nullptr, GL_STREAM_DRAW);
+    deleteFences();
+    m_head = 0;
+    m_frameStart = 0;
+    m_stats.orphans++;
+}
+
+// Writing up to ring position end overwrites what was written one lap
+// earlier; every frame that started before that point must be done
+void StreamingBuffer::waitForRange(qint64 end)
+{
+    const qint64 overwritten = end - m_capacity;
+    bool waited = false;
+    while (!m_fences.empty() && m_fences.front().start < overwritten)
+    {
+        GLsync fence = m_fences.front().fence;
+        GLenum status = glClientWaitSync(fence, 0, 0);
+        while (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED &&
+            status != GL_WAIT_FAILED)
+        {
+            waited = true;
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        }
+        glDeleteSync(fence);
+        m_fences.pop_front();
+    }
+    m_stats.waits += waited;
+}
+
+void StreamingBuffer::deleteFences()
+{
+    for (const FrameFence &frameFence : m_fences)
+    {
+        glDeleteSync(frameFence.fence);
+    }
+    m_fences.clear();
+}
@@ -0,0 +1,101 @@
+#ifndef STREAMING_BUFFER_H
+#define STREAMING_BUFFER_H
+
+#include <QtGui/QOpenGLExtraFunctions>
+
+#include <deque>
+#include <vector>
+
+#include "gl_state_cache.h"
+
+// One large vertex buffer that per-frame geometry (sprites, debug lines,
+// text) is sub-allocated from as a ring. allocate() returns memory to
+// write into and the byte offset to draw from; commit() hands the bytes
+// to GL before the draw that uses them.
+//
+// On ES 3.0 and desktop GL 3.2 the range is mapped unsynchronized and
+// endFrame() puts a fence after the frame's draws; the ring only waits
+// when it is about to overwrite a frame the GPU has not finished. On
+// ES 2.0 the bytes are staged on the CPU and written with
+// glBufferSubData(), and the store is orphaned with glBufferData(NULL)
+// whenever the ring wraps.
+class StreamingBuffer : protected QOpenGLExtraFunctions
+{
+
+public:
+    enum class Mode
+    {
+        Auto,
+        Orphaning,
+        MapRange
+    };
+
+    struct Allocation
+    {
+        void *data;
+        int offset;
+    };
+
+    struct Stats
+    {
+        qint64 bytes = 0;
+        int allocations = 0;
+        int wraps = 0;
+        int orphans = 0;
+        // Allocations that had to wait for the GPU
+        int waits = 0;
+    };
+
+    explicit StreamingBuffer(int capacity = 4 * 1024 * 1024);
+
+    // Must be called with a current OpenGL context. Buffer bindings go
+    // through state, which must outlive the buffer. Mode::Auto picks
+    // MapRange where it is available.
+    void initialize(GLStateCache *state, Mode mode = Mode::Auto);
+    void destroy();
+
+    // bytes must not exceed the capacity. The memory is write-only and
+    // valid until commit().
+    Allocation allocate(int bytes, int alignment = 16);
+    void commit();
+    // Call once per frame after the last draw that reads from the buffer
+    void endFrame();
+
+    GLuint bufferId() const { return m_buffer; }
+    int capacity() const { return m_capacity; }
+    Mode mode() const { return m_mode; }
+    const Stats &stats() const { return m_stats; }
+    void resetStats() { m_stats = Stats(); }
+
+private:
+    struct FrameFence
+    {
+        GLsync fence;
+        // Ring position, counted from the start without wrapping, where
+        // the frame began
+        qint64 start;
+    };
+
+    void orphan();
+    void waitForRange(qint64 end);
+    void deleteFences();
+
+    const int m_capacity;
+    GLStateCache *m_state = nullptr;
+    Mode m_mode = Mode::Orphaning;
+    GLuint m_buffer = 0;
+
+    qint64 m_head = 0;
+    qint64 m_frameStart = 0;
+    std::deque<FrameFence> m_fences;
+
+    // The allocation waiting for commit()
+    int m_pendingOffset = 0;
+    int m_pendingBytes = 0;
+    bool m_mapped = false;
+    std::vector<char> m_staging;
+
+    Stats m_stats;
+};
+
+#endif // STREAMING_BUFFER_H
@@ -0,0 +1,13 @@
+isEmpty(STREAMING_BUFFER_PRI) {
+STREAMING_BUFFER_PRI = 1
+
+include($$PWD/../gl-state-cache/gl_state_cache.pri)
+
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/streaming_buffer.h
+
+SOURCES += \
+    $$PWD/streaming_buffer.cpp
+}
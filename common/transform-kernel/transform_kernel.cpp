@@ -0,0 +1,203 @@
+#include "transform_kernel_p.h"
+
+#include <cmath>
+
+#if defined(_MSC_VER) && defined(TRANSFORM_KERNEL_X86)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+using namespace TransformKernelPaths;
+
+namespace
+{
+    TransformKernel::Rects offsetRects(const TransformKernel::Rects &rects, int offset)
+    {
+        return { rects.x + offset, rects.y + offset, rects.w + offset,
+            rects.h + offset, rects.angle + offset };
+    }
+
+    void mvpScalar(const float *p, const TransformKernel::Rects &rects, int count, float *out)
+    {
+        for (int i = 0; i < count; ++i, out += 16)
+        {
+            const float c = std::cos(rects.angle[i]);
+            const float s = std::sin(rects.angle[i]);
+            const float cw = c * rects.w[i];
+            const float sw = s * rects.w[i];
+            const float sh = s * rects.h[i];
+            const float ch = c * rects.h[i];
+            for (int row = 0; row < 4; ++row)
+            {
+                out[row] = p[row] * cw + p[4 + row] * sw;
+                out[4 + row] = p[4 + row] * ch - p[row] * sh;
+                out[8 + row] = p[8 + row];
+                out[12 + row] = p[row] * rects.x[i] + p[4 + row] * rects.y[i] + p[12 + row];
+            }
+        }
+    }
+
+    void affineScalar(const TransformKernel::Rects &rects, int count, float *out)
+    {
+        for (int i = 0; i < count; ++i, out += 6)
+        {
+            const float c = std::cos(rects.angle[i]);
+            const float s = std::sin(rects.angle[i]);
+            out[0] = c * rects.w[i];
+            out[1] = s * rects.w[i];
+            out[2] = -s * rects.h[i];
+            out[3] = c * rects.h[i];
+            out[4] = rects.x[i];
+            out[5] = rects.y[i];
+        }
+    }
+
+#ifdef TRANSFORM_KERNEL_X86
+    bool cpuHasSse2()
+    {
+#if defined(__x86_64__) || defined(_M_X64)
+        return true;
+#elif defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        return (info[3] & (1 << 26)) != 0;
+#else
+        return __builtin_cpu_supports("sse2");
+#endif
+    }
+
+    bool cpuHasAvx2()
+    {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+        {
+            return false;
+        }
+        __cpuid(info, 1);
+        const bool fma = (info[2] & (1 << 12)) != 0;
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+        // The OS must save the YMM registers on context switches
+        if (!fma || !osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+        {
+            return false;
+        }
+        __cpuid(info, 7);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        // Includes the check for OS support of the YMM state
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+    }
+#endif
+}
+
+TransformKernel::Path TransformKernel::bestPath()
+{
+    static const Path path = [] {
+        const Path candidates[] = { Path::Avx2, Path::Neon, Path::Sse2 };
+        for (Path candidate : candidates)
+        {
+            if (isSupported(candidate))
+            {
+                return candidate;
+            }
+        }
+        return Path::Scalar;
+    }();
+    return path;
+}
+
+bool TransformKernel::isSupported(Path path)
+{
+    switch (path)
+    {
+        case Path::Scalar:
+            return true;
+#ifdef TRANSFORM_KERNEL_X86
+        case Path::Sse2:
+        {
+            static const bool supported = cpuHasSse2();
+            return supported;
+        }
+        case Path::Avx2:
+        {
+            static const bool supported = cpuHasAvx2();
+            return supported;
+        }
+#endif
+#ifdef TRANSFORM_KERNEL_NEON
+        // Only compiled in where the target guarantees NEON
+        case Path::Neon:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+const char *TransformKernel::pathName(Path path)
+{
+    switch (path)
+    {
+        case Path::Scalar:
+            return "scalar";
+        case Path::Sse2:
+            return "SSE2";
+        case Path::Avx2:
+            return "AVX2";
+        case Path::Neon:
+            return "NEON";
+    }
+    return "";
+}
+
+void TransformKernel::computeMvp(const QMatrix4x4 &projViewMatrix, const Rects &rects,
+    int count, float *out, Path path)
+{
+    const float *projView = projViewMatrix.constData();
+    int done = 0;
+    if (isSupported(path))
+    {
+        switch (path)
+        {
+            case Path::Sse2:
+                done = mvpSse2(projView, rects, count, out);
+                break;
+            case Path::Avx2:
+                done = mvpAvx2(projView, rects, count, out);
+                break;
+            case Path::Neon:
+                done = mvpNeon(projView, rects, count, out);
+                break;
+            default:
+                break;
+        }
+    }
+    mvpScalar(projView, offsetRects(rects, done), count - done, out + done * 16);
+}
+
+void TransformKernel::computeAffine(const Rects &rects, int count, float *out, Path path)
+{
+    int done = 0;
+    if (isSupported(path))
+    {
+        switch (path)
+        {
+            case Path::Sse2:
+                done = affineSse2(rects, count, out);
+                break;
+            case Path::Avx2:
+                done = affineAvx2(rects, count, out);
+                break;
+            case Path::Neon:
+                done = affineNeon(rects, count, out);
+                break;
+            default:
+                break;
+        }
+    }
+    affineScalar(offsetRects(rects, done), count - done, out + done * 6);
+}
@@ -0,0 +1,52 @@
+#ifndef TRANSFORM_KERNEL_H
+#define TRANSFORM_KERNEL_H
+
+#include <QtGui/QMatrix4x4>
+
+// Batched transforms for 2D rectangles given as structure-of-arrays:
+// center x, y, size w, h and angle in radians. For every rectangle the
+// kernel writes either
+//   - the model-view-projection matrix
+//     projView * translate(x, y) * rotate(angle) * scale(w, h),
+//     16 floats in the column-major order of QMatrix4x4::constData(), or
+//   - the 2x3 affine model matrix as 6 floats a, b, c, d, tx, ty with
+//     x' = a x + c y + tx and y' = b x + d y + ty, the argument order of
+//     QTransform(m11, m12, m21, m22, dx, dy).
+//
+// The SSE2, AVX2 and NEON paths handle 4 or 8 rectangles per iteration
+// and use a polynomial sine and cosine accurate to a few float ulps. The
+// best path the CPU supports is picked at runtime.
+class TransformKernel
+{
+
+public:
+    enum class Path
+    {
+        Scalar,
+        Sse2,
+        Avx2,
+        Neon
+    };
+
+    struct Rects
+    {
+        const float *x;
+        const float *y;
+        const float *w;
+        const float *h;
+        const float *angle;
+    };
+
+    static Path bestPath();
+    static bool isSupported(Path path);
+    static const char *pathName(Path path);
+
+    // out - count * 16 floats
+    static void computeMvp(const QMatrix4x4 &projViewMatrix, const Rects &rects,
+        int count, float *out, Path path = bestPath());
+    // out - count * 6 floats
+    static void computeAffine(const Rects &rects, int count, float *out,
+        Path path = bestPath());
+};
+
+#endif // TRANSFORM_KERNEL_H
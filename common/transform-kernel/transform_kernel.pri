@@ -0,0 +1,18 @@
+isEmpty(TRANSFORM_KERNEL_PRI) {
+TRANSFORM_KERNEL_PRI = 1
+
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/transform_kernel.h \
+    $$PWD/transform_kernel_p.h
+
+# Every path is compiled into every build, the ones the target
+# architecture lacks compile to nothing. SIMD functions carry their own
+# target attributes, so no per-file compiler flags are needed.
+SOURCES += \
+    $$PWD/transform_kernel.cpp \
+    $$PWD/transform_kernel_avx2.cpp \
+    $$PWD/transform_kernel_neon.cpp \
+    $$PWD/transform_kernel_sse2.cpp
+}
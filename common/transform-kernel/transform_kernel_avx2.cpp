@@ -0,0 +1,161 @@
+#include "transform_kernel_p.h"
+
+#ifdef TRANSFORM_KERNEL_X86
+
+#include <immintrin.h>
+
+#define AVX2_TARGET TRANSFORM_KERNEL_TARGET("avx2,fma")
+
+namespace
+{
+    using namespace TransformKernelPaths;
+
+    // Same reduction and polynomials as the SSE2 path, eight lanes wide
+    AVX2_TARGET inline void sinCos(__m256 x, __m256 *sinOut, __m256 *cosOut)
+    {
+        const __m256i quadrant = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(twoOverPi)));
+        const __m256 j = _mm256_cvtepi32_ps(quadrant);
+        __m256 r = _mm256_fnmadd_ps(j, _mm256_set1_ps(halfPi1), x);
+        r = _mm256_fnmadd_ps(j, _mm256_set1_ps(halfPi2), r);
+        r = _mm256_fnmadd_ps(j, _mm256_set1_ps(halfPi3), r);
+        const __m256 z = _mm256_mul_ps(r, r);
+
+        __m256 s = _mm256_fmadd_ps(_mm256_set1_ps(sin3), z, _mm256_set1_ps(sin2));
+        s = _mm256_fmadd_ps(s, z, _mm256_set1_ps(sin1));
+        s = _mm256_fmadd_ps(_mm256_mul_ps(s, z), r, r);
+
+        __m256 c = _mm256_fmadd_ps(_mm256_set1_ps(cos3), z, _mm256_set1_ps(cos2));
+        c = _mm256_fmadd_ps(c, z, _mm256_set1_ps(cos1));
+        c = _mm256_mul_ps(_mm256_mul_ps(c, z), z);
+        c = _mm256_add_ps(_mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), c), _mm256_set1_ps(1.f));
+
+        const __m256i one = _mm256_set1_epi32(1);
+        const __m256i two = _mm256_set1_epi32(2);
+        const __m256 swap = _mm256_castsi256_ps(
+            _mm256_cmpeq_epi32(_mm256_and_si256(quadrant, one), one));
+        const __m256 sinValue = _mm256_blendv_ps(s, c, swap);
+        const __m256 cosValue = _mm256_blendv_ps(c, s, swap);
+        const __m256 sinSign = _mm256_castsi256_ps(
+            _mm256_slli_epi32(_mm256_and_si256(quadrant, two), 30));
+        const __m256 cosSign = _mm256_castsi256_ps(
+            _mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(quadrant, one), two), 30));
+        *sinOut = _mm256_xor_ps(sinValue, sinSign);
+        *cosOut = _mm256_xor_ps(cosValue, cosSign);
+    }
+
+    AVX2_TARGET inline __m128 half(__m256 v, int index)
+    {
+        return index == 0 ? _mm256_castps256_ps128(v) : _mm256_extractf128_ps(v, 1);
+    }
+}
+
+AVX2_TARGET int TransformKernelPaths::mvpAvx2(const float *p,
+    const TransformKernel::Rects &rects, int count, float *out)
+{
+    const int blockCount = count / 8;
+    for (int block = 0; block < blockCount; ++block, out += 128)
+    {
+        const int i = block * 8;
+        __m256 s;
+        __m256 c;
+        sinCos(_mm256_loadu_ps(rects.angle + i), &s, &c);
+        const __m256 w = _mm256_loadu_ps(rects.w + i);
+        const __m256 h = _mm256_loadu_ps(rects.h + i);
+        const __m256 x = _mm256_loadu_ps(rects.x + i);
+        const __m256 y = _mm256_loadu_ps(rects.y + i);
+        const __m256 cw = _mm256_mul_ps(c, w);
+        const __m256 sw = _mm256_mul_ps(s, w);
+        const __m256 sh = _mm256_mul_ps(s, h);
+        const __m256 ch = _mm256_mul_ps(c, h);
+
+        // Column 2 is the same for every rectangle
+        __m256 e[16];
+        for (int row = 0; row < 4; ++row)
+        {
+            const __m256 p0 = _mm256_set1_ps(p[row]);
+            const __m256 p1 = _mm256_set1_ps(p[4 + row]);
+            e[row] = _mm256_fmadd_ps(p0, cw, _mm256_mul_ps(p1, sw));
+            e[4 + row] = _mm256_fmsub_ps(p1, ch, _mm256_mul_ps(p0, sh));
+            e[8 + row] = _mm256_set1_ps(p[8 + row]);
+            e[12 + row] = _mm256_fmadd_ps(p0, x,
+                _mm256_fmadd_ps(p1, y, _mm256_set1_ps(p[12 + row])));
+        }
+
+        // AVX has no cheap 8x4 transpose, each 128-bit half is
+        // transposed like in the SSE2 path
+        for (int halfIndex = 0; halfIndex < 2; ++halfIndex)
+        {
+            float *dst = out + halfIndex * 64;
+            for (int column = 0; column < 4; ++column)
+            {
+                __m128 v0 = half(e[column * 4], halfIndex);
+                __m128 v1 = half(e[column * 4 + 1], halfIndex);
+                __m128 v2 = half(e[column * 4 + 2], halfIndex);
+                __m128 v3 = half(e[column * 4 + 3], halfIndex);
+                _MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+                _mm_storeu_ps(dst + column * 4, v0);
+                _mm_storeu_ps(dst + 16 + column * 4, v1);
+                _mm_storeu_ps(dst + 32 + column * 4, v2);
+                _mm_storeu_ps(dst + 48 + column * 4, v3);
+            }
+        }
+    }
+    return blockCount * 8;
+}
+
+AVX2_TARGET int TransformKernelPaths::affineAvx2(const TransformKernel::Rects &rects,
+    int count, float *out)
+{
+    const int blockCount = count / 8;
+    for (int block = 0; block < blockCount; ++block, out += 48)
+    {
+        const int i = block * 8;
+        __m256 s;
+        __m256 c;
+        sinCos(_mm256_loadu_ps(rects.angle + i), &s, &c);
+        const __m256 w = _mm256_loadu_ps(rects.w + i);
+        const __m256 h = _mm256_loadu_ps(rects.h + i);
+        const __m256 a = _mm256_mul_ps(c, w);
+        const __m256 b = _mm256_mul_ps(s, w);
+        const __m256 cc = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_mul_ps(s, h));
+        const __m256 d = _mm256_mul_ps(c, h);
+        const __m256 x = _mm256_loadu_ps(rects.x + i);
+        const __m256 y = _mm256_loadu_ps(rects.y + i);
+
+        for (int halfIndex = 0; halfIndex < 2; ++halfIndex)
+        {
+            float *dst = out + halfIndex * 24;
+            __m128 v0 = half(a, halfIndex);
+            __m128 v1 = half(b, halfIndex);
+            __m128 v2 = half(cc, halfIndex);
+            __m128 v3 = half(d, halfIndex);
+            _MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+            const __m128 xyLow = _mm_unpacklo_ps(half(x, halfIndex), half(y, halfIndex));
+            const __m128 xyHigh = _mm_unpackhi_ps(half(x, halfIndex), half(y, halfIndex));
+
+            _mm_storeu_ps(dst, v0);
+            _mm_storel_pi(reinterpret_cast<__m64 *>(dst + 4), xyLow);
+            _mm_storeu_ps(dst + 6, v1);
+            _mm_storeh_pi(reinterpret_cast<__m64 *>(dst + 10), xyLow);
+            _mm_storeu_ps(dst + 12, v2);
+            _mm_storel_pi(reinterpret_cast<__m64 *>(dst + 16), xyHigh);
+            _mm_storeu_ps(dst + 18, v3);
+            _mm_storeh_pi(reinterpret_cast<__m64 *>(dst + 22), xyHigh);
+        }
+    }
+    return blockCount * 8;
+}
+
+#else
+
+int TransformKernelPaths::mvpAvx2(const float *, const TransformKernel::Rects &, int, float *)
+{
+    return 0;
+}
+
+int TransformKernelPaths::affineAvx2(const TransformKernel::Rects &, int, float *)
+{
+    return 0;
+}
+
+#endif // TRANSFORM_KERNEL_X86
@@ -0,0 +1,148 @@
+#include "transform_kernel_p.h"
+
+#ifdef TRANSFORM_KERNEL_NEON
+
+#include <arm_neon.h>
+
+namespace
+{
+    using namespace TransformKernelPaths;
+
+    // Same reduction and polynomials as the SSE2 path
+    inline void sinCos(float32x4_t x, float32x4_t *sinOut, float32x4_t *cosOut)
+    {
+        // ARMv7 NEON only truncates, round half away from zero instead
+        const float32x4_t scaled = vmulq_n_f32(x, twoOverPi);
+        const uint32x4_t signBit = vdupq_n_u32(0x80000000u);
+        const float32x4_t half = vreinterpretq_f32_u32(vorrq_u32(
+            vreinterpretq_u32_f32(vdupq_n_f32(0.5f)),
+            vandq_u32(vreinterpretq_u32_f32(scaled), signBit)));
+        const int32x4_t quadrant = vcvtq_s32_f32(vaddq_f32(scaled, half));
+        const float32x4_t j = vcvtq_f32_s32(quadrant);
+        float32x4_t r = vmlsq_n_f32(x, j, halfPi1);
+        r = vmlsq_n_f32(r, j, halfPi2);
+        r = vmlsq_n_f32(r, j, halfPi3);
+        const float32x4_t z = vmulq_f32(r, r);
+
+        float32x4_t s = vmlaq_n_f32(vdupq_n_f32(sin2), z, sin3);
+        s = vmlaq_f32(vdupq_n_f32(sin1), s, z);
+        s = vmlaq_f32(r, vmulq_f32(s, z), r);
+
+        float32x4_t c = vmlaq_n_f32(vdupq_n_f32(cos2), z, cos3);
+        c = vmlaq_f32(vdupq_n_f32(cos1), c, z);
+        c = vmulq_f32(vmulq_f32(c, z), z);
+        c = vaddq_f32(vmlsq_n_f32(c, z, 0.5f), vdupq_n_f32(1.f));
+
+        const int32x4_t one = vdupq_n_s32(1);
+        const int32x4_t two = vdupq_n_s32(2);
+        const uint32x4_t swap = vceqq_s32(vandq_s32(quadrant, one), one);
+        const float32x4_t sinValue = vbslq_f32(swap, c, s);
+        const float32x4_t cosValue = vbslq_f32(swap, s, c);
+        const uint32x4_t sinSign = vreinterpretq_u32_s32(
+            vshlq_n_s32(vandq_s32(quadrant, two), 30));
+        const uint32x4_t cosSign = vreinterpretq_u32_s32(
+            vshlq_n_s32(vandq_s32(vaddq_s32(quadrant, one), two), 30));
+        *sinOut = vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(sinValue), sinSign));
+        *cosOut = vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(cosValue), cosSign));
+    }
+
+    // v[k] holds element k of four rectangles, afterwards v[i] holds the
+    // four elements of rectangle i
+    inline void transpose(float32x4_t *v)
+    {
+        const float32x4x2_t t01 = vtrnq_f32(v[0], v[1]);
+        const float32x4x2_t t23 = vtrnq_f32(v[2], v[3]);
+        v[0] = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+        v[1] = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+        v[2] = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+        v[3] = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+    }
+}
+
+int TransformKernelPaths::mvpNeon(const float *p, const TransformKernel::Rects &rects,
+    int count, float *out)
+{
+    const int blockCount = count / 4;
+    for (int block = 0; block < blockCount; ++block, out += 64)
+    {
+        const int i = block * 4;
+        float32x4_t s;
+        float32x4_t c;
+        sinCos(vld1q_f32(rects.angle + i), &s, &c);
+        const float32x4_t w = vld1q_f32(rects.w + i);
+        const float32x4_t h = vld1q_f32(rects.h + i);
+        const float32x4_t x = vld1q_f32(rects.x + i);
+        const float32x4_t y = vld1q_f32(rects.y + i);
+        const float32x4_t cw = vmulq_f32(c, w);
+        const float32x4_t sw = vmulq_f32(s, w);
+        const float32x4_t sh = vmulq_f32(s, h);
+        const float32x4_t ch = vmulq_f32(c, h);
+
+        float32x4_t e[16];
+        for (int row = 0; row < 4; ++row)
+        {
+            e[row] = vmlaq_n_f32(vmulq_n_f32(cw, p[row]), sw, p[4 + row]);
+            e[4 + row] = vmlsq_n_f32(vmulq_n_f32(ch, p[4 + row]), sh, p[row]);
+            e[8 + row] = vdupq_n_f32(p[8 + row]);
+            e[12 + row] = vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(p[12 + row]), x, p[row]),
+                y, p[4 + row]);
+        }
+        for (int column = 0; column < 4; ++column)
+        {
+            float32x4_t *v = e + column * 4;
+            transpose(v);
+            vst1q_f32(out + column * 4, v[0]);
+            vst1q_f32(out + 16 + column * 4, v[1]);
+            vst1q_f32(out + 32 + column * 4, v[2]);
+            vst1q_f32(out + 48 + column * 4, v[3]);
+        }
+    }
+    return blockCount * 4;
+}
+
+int TransformKernelPaths::affineNeon(const TransformKernel::Rects &rects, int count,
+    float *out)
+{
+    const int blockCount = count / 4;
+    for (int block = 0; block < blockCount; ++block, out += 24)
+    {
+        const int i = block * 4;
+        float32x4_t s;
+        float32x4_t c;
+        sinCos(vld1q_f32(rects.angle + i), &s, &c);
+        const float32x4_t w = vld1q_f32(rects.w + i);
+        const float32x4_t h = vld1q_f32(rects.h + i);
+        float32x4_t v[4] = {
+            vmulq_f32(c, w),
+            vmulq_f32(s, w),
+            vnegq_f32(vmulq_f32(s, h)),
+            vmulq_f32(c, h)
+        };
+        transpose(v);
+        const float32x4x2_t xy = vzipq_f32(vld1q_f32(rects.x + i), vld1q_f32(rects.y + i));
+
+        vst1q_f32(out, v[0]);
+        vst1_f32(out + 4, vget_low_f32(xy.val[0]));
+        vst1q_f32(out + 6, v[1]);
+        vst1_f32(out + 10, vget_high_f32(xy.val[0]));
+        vst1q_f32(out + 12, v[2]);
+        vst1_f32(out + 16, vget_low_f32(xy.val[1]));
+        vst1q_f32(out + 18, v[3]);
+        vst1_f32(out + 22, vget_high_f32(xy.val[1]));
+    }
+    return blockCount * 4;
+}
+
+#else
+
+int TransformKernelPaths::mvpNeon(const float *, const TransformKernel::Rects &, int, float *)
+{
+    return 0;
+}
+
+int TransformKernelPaths::affineNeon(const TransformKernel::Rects &, int, float *)
+{
+    return 0;
+}
+
+#endif // TRANSFORM_KERNEL_NEON
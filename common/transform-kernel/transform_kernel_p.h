@@ -0,0 +1,49 @@
+#ifndef TRANSFORM_KERNEL_P_H
+#define TRANSFORM_KERNEL_P_H
+
+#include "transform_kernel.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define TRANSFORM_KERNEL_X86
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define TRANSFORM_KERNEL_NEON
+#endif
+
+// GCC and Clang only allow intrinsics in functions compiled for the
+// instruction set, MSVC allows them anywhere
+#if defined(__GNUC__) || defined(__clang__)
+#define TRANSFORM_KERNEL_TARGET(isa) __attribute__((target(isa)))
+#else
+#define TRANSFORM_KERNEL_TARGET(isa)
+#endif
+
+// Internal entry points of the SIMD paths. Each handles the largest
+// multiple of its width not above count and returns how many rectangles
+// it wrote; the dispatcher finishes the rest with the scalar path.
+// projView is the column-major projection-view matrix.
+namespace TransformKernelPaths
+{
+    int mvpSse2(const float *projView, const TransformKernel::Rects &rects, int count, float *out);
+    int affineSse2(const TransformKernel::Rects &rects, int count, float *out);
+    int mvpAvx2(const float *projView, const TransformKernel::Rects &rects, int count, float *out);
+    int affineAvx2(const TransformKernel::Rects &rects, int count, float *out);
+    int mvpNeon(const float *projView, const TransformKernel::Rects &rects, int count, float *out);
+    int affineNeon(const TransformKernel::Rects &rects, int count, float *out);
+
+    // Sine and cosine after Cephes sinf/cosf: the angle is reduced by
+    // multiples of pi/2 in three parts, then both polynomials are
+    // evaluated on [-pi/4, pi/4] and swapped or negated by quadrant
+    const float twoOverPi = 0.636619772367581343f;
+    const float halfPi1 = 1.5703125f;
+    const float halfPi2 = 4.837512969970703125e-4f;
+    const float halfPi3 = 7.54978995489188216e-8f;
+    const float sin1 = -1.6666654611e-1f;
+    const float sin2 = 8.3321608736e-3f;
+    const float sin3 = -1.9515295891e-4f;
+    const float cos1 = 4.166664568298827e-2f;
+    const float cos2 = -1.388731625493765e-3f;
+    const float cos3 = 2.443315711809948e-5f;
+}
+
+#endif // TRANSFORM_KERNEL_P_H
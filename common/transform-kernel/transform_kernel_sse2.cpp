@@ -0,0 +1,141 @@
+#include "transform_kernel_p.h"
+
+#ifdef TRANSFORM_KERNEL_X86
+
+#include <emmintrin.h>
+
+#define SSE2_TARGET TRANSFORM_KERNEL_TARGET("sse2")
+
+namespace
+{
+    using namespace TransformKernelPaths;
+
+    SSE2_TARGET inline void sinCos(__m128 x, __m128 *sinOut, __m128 *cosOut)
+    {
+        // Round to nearest, the default MXCSR mode
+        const __m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(twoOverPi)));
+        const __m128 j = _mm_cvtepi32_ps(quadrant);
+        __m128 r = _mm_sub_ps(x, _mm_mul_ps(j, _mm_set1_ps(halfPi1)));
+        r = _mm_sub_ps(r, _mm_mul_ps(j, _mm_set1_ps(halfPi2)));
+        r = _mm_sub_ps(r, _mm_mul_ps(j, _mm_set1_ps(halfPi3)));
+        const __m128 z = _mm_mul_ps(r, r);
+
+        __m128 s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(sin3), z), _mm_set1_ps(sin2));
+        s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(sin1));
+        s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, z), r), r);
+
+        __m128 c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(cos3), z), _mm_set1_ps(cos2));
+        c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(cos1));
+        c = _mm_mul_ps(_mm_mul_ps(c, z), z);
+        c = _mm_add_ps(_mm_sub_ps(c, _mm_mul_ps(z, _mm_set1_ps(0.5f))), _mm_set1_ps(1.f));
+
+        // Odd quadrants swap sine and cosine, bit 1 of the quadrant
+        // negates the sine, bit 1 of quadrant + 1 the cosine
+        const __m128i one = _mm_set1_epi32(1);
+        const __m128i two = _mm_set1_epi32(2);
+        const __m128 swap = _mm_castsi128_ps(
+            _mm_cmpeq_epi32(_mm_and_si128(quadrant, one), one));
+        const __m128 sinValue = _mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s));
+        const __m128 cosValue = _mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c));
+        const __m128 sinSign = _mm_castsi128_ps(
+            _mm_slli_epi32(_mm_and_si128(quadrant, two), 30));
+        const __m128 cosSign = _mm_castsi128_ps(
+            _mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, one), two), 30));
+        *sinOut = _mm_xor_ps(sinValue, sinSign);
+        *cosOut = _mm_xor_ps(cosValue, cosSign);
+    }
+}
+
+SSE2_TARGET int TransformKernelPaths::mvpSse2(const float *p,
+    const TransformKernel::Rects &rects, int count, float *out)
+{
+    const int blockCount = count / 4;
+    for (int block = 0; block < blockCount; ++block, out += 64)
+    {
+        const int i = block * 4;
+        __m128 s;
+        __m128 c;
+        sinCos(_mm_loadu_ps(rects.angle + i), &s, &c);
+        const __m128 w = _mm_loadu_ps(rects.w + i);
+        const __m128 h = _mm_loadu_ps(rects.h + i);
+        const __m128 x = _mm_loadu_ps(rects.x + i);
+        const __m128 y = _mm_loadu_ps(rects.y + i);
+        const __m128 cw = _mm_mul_ps(c, w);
+        const __m128 sw = _mm_mul_ps(s, w);
+        const __m128 sh = _mm_mul_ps(s, h);
+        const __m128 ch = _mm_mul_ps(c, h);
+
+        // e[column * 4 + row] holds that matrix element for all four
+        // rectangles, transposing each column puts them in place
+        __m128 e[16];
+        for (int row = 0; row < 4; ++row)
+        {
+            const __m128 p0 = _mm_set1_ps(p[row]);
+            const __m128 p1 = _mm_set1_ps(p[4 + row]);
+            e[row] = _mm_add_ps(_mm_mul_ps(p0, cw), _mm_mul_ps(p1, sw));
+            e[4 + row] = _mm_sub_ps(_mm_mul_ps(p1, ch), _mm_mul_ps(p0, sh));
+            e[8 + row] = _mm_set1_ps(p[8 + row]);
+            e[12 + row] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(p0, x), _mm_mul_ps(p1, y)),
+                _mm_set1_ps(p[12 + row]));
+        }
+        for (int column = 0; column < 4; ++column)
+        {
+            __m128 *v = e + column * 4;
+            _MM_TRANSPOSE4_PS(v[0], v[1], v[2], v[3]);
+            _mm_storeu_ps(out + column * 4, v[0]);
+            _mm_storeu_ps(out + 16 + column * 4, v[1]);
+            _mm_storeu_ps(out + 32 + column * 4, v[2]);
+            _mm_storeu_ps(out + 48 + column * 4, v[3]);
+        }
+    }
+    return blockCount * 4;
+}
+
+SSE2_TARGET int TransformKernelPaths::affineSse2(const TransformKernel::Rects &rects,
+    int count, float *out)
+{
+    const int blockCount = count / 4;
+    for (int block = 0; block < blockCount; ++block, out += 24)
+    {
+        const int i = block * 4;
+        __m128 s;
+        __m128 c;
+        sinCos(_mm_loadu_ps(rects.angle + i), &s, &c);
+        const __m128 w = _mm_loadu_ps(rects.w + i);
+        const __m128 h = _mm_loadu_ps(rects.h + i);
+        __m128 a = _mm_mul_ps(c, w);
+        __m128 b = _mm_mul_ps(s, w);
+        __m128 cc = _mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(s, h));
+        __m128 d = _mm_mul_ps(c, h);
+        _MM_TRANSPOSE4_PS(a, b, cc, d);
+
+        const __m128 x = _mm_loadu_ps(rects.x + i);
+        const __m128 y = _mm_loadu_ps(rects.y + i);
+        const __m128 xyLow = _mm_unpacklo_ps(x, y);
+        const __m128 xyHigh = _mm_unpackhi_ps(x, y);
+
+        _mm_storeu_ps(out, a);
+        _mm_storel_pi(reinterpret_cast<__m64 *>(out + 4), xyLow);
+        _mm_storeu_ps(out + 6, b);
+        _mm_storeh_pi(reinterpret_cast<__m64 *>(out + 10), xyLow);
+        _mm_storeu_ps(out + 12, cc);
+        _mm_storel_pi(reinterpret_cast<__m64 *>(out + 16), xyHigh);
+        _mm_storeu_ps(out + 18, d);
+        _mm_storeh_pi(reinterpret_cast<__m64 *>(out + 22), xyHigh);
+    }
+    return blockCount * 4;
+}
+
+#else
+
+int TransformKernelPaths::mvpSse2(const float *, const TransformKernel::Rects &, int, float *)
+{
+    return 0;
+}
+
+int TransformKernelPaths::affineSse2(const TransformKernel::Rects &, int, float *)
+{
+    return 0;
+}
+
+#endif // TRANSFORM_KERNEL_X86
@@ -16,6 +16,11 @@ void main()
     }
     else
     {
+        // Transparent texels are not part of the widget
+        if (texture2D(uSampler, vTexCoord).a < 0.5)
+        {
+            discard;
+        }
         gl_FragColor = vec4(uPickColor, 1.0);
     }
 }
@@ -3,10 +3,34 @@ QT += core gui openglwidgets
 win32: LIBS += -lopengl32
 
 HEADERS += \
-    opengl_window.h
+    draw_queue_benchmark.h \
+    hit_test_benchmark.h \
+    opengl_window.h \
+    picking_service.h \
+    shader_cache_benchmark.h \
+    texture_atlas.h \
+    texture_atlas_benchmark.h \
+    widget_registry.h
 
 SOURCES += main.cpp \
-    opengl_window.cpp
+    draw_queue_benchmark.cpp \
+    hit_test_benchmark.cpp \
+    opengl_window.cpp \
+    picking_service.cpp \
+    shader_cache_benchmark.cpp \
+    texture_atlas.cpp \
+    texture_atlas_benchmark.cpp \
+    widget_registry.cpp
 
 RESOURCES += \
     assets.qrc
+
+include(../../../common/damage-tracking/damage_tracking.pri)
+include(../../../common/frame-profiler/frame_profiler.pri)
+include(../../../common/frame-scheduler/frame_scheduler.pri)
+include(../../../common/geometry-registry/geometry_registry.pri)
+include(../../../common/gl-state-cache/gl_state_cache.pri)
+include(../../../common/offscreen-host/offscreen_host.pri)
+include(../../../common/render-commands/render_commands.pri)
+include(../../../common/render-targets/render_targets.pri)
+include(../../../common/shader-cache/shader_cache.pri)
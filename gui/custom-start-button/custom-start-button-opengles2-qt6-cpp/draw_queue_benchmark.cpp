@@ -0,0 +1,149 @@
+#include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QRandomGenerator>
+
+#include <algorithm>
+#include <vector>
+
+#include "draw_queue.h"
+#include "draw_queue_benchmark.h"
+#include "radix_sort.h"
+
+namespace
+{
+    const int widgetCount = 10000;
+    const int layerCount = 4;
+    const int measuredRuns = 50;
+
+    struct WidgetType
+    {
+        int program;
+        int atlas;
+        bool translucent;
+    };
+
+    // Panels and frames are opaque, icons, text and shadows are blended
+    const WidgetType widgetTypes[] = {
+        { 0, 0, false }, { 0, 1, false }, { 0, 2, false }, { 1, 3, false },
+        { 1, 4, true }, { 1, 5, true }, { 2, 6, true }, { 2, 7, true },
+        { 3, 0, true }, { 3, 2, true }, { 0, 4, true }, { 2, 1, false }
+    };
+    const int widgetTypeCount = int(sizeof(widgetTypes) / sizeof(widgetTypes[0]));
+
+    void fillQueue(DrawQueue *queue, const std::vector<int> &types,
+        const std::vector<int> &layers)
+    {
+        queue->clear();
+        for (int i = 0; i < widgetCount; ++i)
+        {
+            const WidgetType &type = widgetTypes[types[i]];
+            queue->add(layers[i], type.translucent, type.program, type.atlas, quint32(i), i);
+        }
+    }
+
+    // Layers in order, opaque before translucent inside a layer and
+    // translucent draws in paint order
+    bool isPaintOrderKept(const std::vector<DrawQueue::Draw> &draws,
+        const std::vector<int> &layers)
+    {
+        int previousLayer = -1;
+        bool previousTranslucent = false;
+        int previousTranslucentPayload = -1;
+        for (const DrawQueue::Draw &draw : draws)
+        {
+            const int layer = layers[draw.payload];
+            if (layer < previousLayer)
+            {
+                return false;
+            }
+            if (layer != previousLayer)
+            {
+                previousLayer = layer;
+                previousTranslucent = false;
+                previousTranslucentPayload = -1;
+            }
+            if (previousTranslucent && !draw.translucent)
+            {
+                return false;
+            }
+            if (draw.translucent)
+            {
+                if (draw.payload < previousTranslucentPayload)
+                {
+                    return false;
+                }
+                previousTranslucentPayload = draw.payload;
+            }
+            previousTranslucent = draw.translucent;
+        }
+        return true;
+    }
+
+    QString formatChanges(const DrawQueue::StateChanges &changes)
+    {
+        return QString("%1 (program %2, texture %3, blend %4)").arg(changes.total())
+            .arg(changes.programs).arg(changes.textures).arg(changes.blends);
+    }
+}
+
+int runDrawQueueBenchmark()
+{
+    // Paint order of a widget tree mixes widget types freely, layers
+    // (content, popups, tooltips ...) come one after another
+    QRandomGenerator random(42);
+    std::vector<int> types(widgetCount);
+    std::vector<int> layers(widgetCount);
+    for (int i = 0; i < widgetCount; ++i)
+    {
+        types[i] = int(random.bounded(widgetTypeCount));
+        layers[i] = i * layerCount / widgetCount;
+    }
+
+    DrawQueue queue;
+    fillQueue(&queue, types, layers);
+    queue.sort();
+    const DrawQueue::Stats stats = queue.stats();
+    const bool ordered = isPaintOrderKept(queue.draws(), layers);
+    const std::vector<DrawQueue::Draw> radixSorted = queue.draws();
+
+    // Both sorts run on a copy, without the state change counting
+    QElapsedTimer timer;
+    std::vector<DrawQueue::Draw> draws;
+    std::vector<DrawQueue::Draw> scratch;
+    qint64 radixNs = 0;
+    for (int run = 0; run < measuredRuns; ++run)
+    {
+        fillQueue(&queue, types, layers);
+        draws = queue.draws();
+        timer.start();
+        radixSortByKey(&draws, &scratch);
+        radixNs += timer.nsecsElapsed();
+    }
+
+    qint64 stdNs = 0;
+    for (int run = 0; run < measuredRuns; ++run)
+    {
+        fillQueue(&queue, types, layers);
+        draws = queue.draws();
+        timer.start();
+        std::stable_sort(draws.begin(), draws.end(),
+            [](const DrawQueue::Draw &a, const DrawQueue::Draw &b)
+            {
+                return a.key < b.key;
+            });
+        stdNs += timer.nsecsElapsed();
+    }
+    bool same = draws.size() == radixSorted.size();
+    for (size_t i = 0; same && i < draws.size(); ++i)
+    {
+        same = draws[i].payload == radixSorted[i].payload;
+    }
+
+    qInfo().noquote() << QString("Draw queue, %1 widgets: state changes %2 unsorted, %3 sorted")
+        .arg(stats.draws).arg(formatChanges(stats.unsorted)).arg(formatChanges(stats.sorted));
+    qInfo().noquote() << QString("    radix sort %1 ms, std::stable_sort %2 ms%3%4")
+        .arg(radixNs / 1e6 / measuredRuns, 0, 'f', 3).arg(stdNs / 1e6 / measuredRuns, 0, 'f', 3)
+        .arg(ordered ? "" : ", paint order BROKEN")
+        .arg(same ? "" : ", differs from std::stable_sort");
+    return ordered && same ? 0 : 1;
+}
@@ -0,0 +1,11 @@
+#ifndef DRAW_QUEUE_BENCHMARK_H
+#define DRAW_QUEUE_BENCHMARK_H
+
+// Builds a UI of 10k widgets of 12 types spread over 4 programs and
+// 8 atlases, submits them in paint order and prints the state changes
+// before and after DrawQueue sorts them, with the radix sort timed
+// against std::stable_sort. Returns a process exit code, 1 when the
+// sorted order breaks layer or translucent paint order.
+int runDrawQueueBenchmark();
+
+#endif // DRAW_QUEUE_BENCHMARK_H
@@ -0,0 +1,140 @@
+#include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QRandomGenerator>
+#include <QtGui/QMatrix4x4>
+#include <QtGui/QOffscreenSurface>
+#include <QtGui/QOpenGLContext>
+#include <QtGui/QOpenGLFunctions>
+#include <QtOpenGL/QOpenGLBuffer>
+#include <QtOpenGL/QOpenGLFramebufferObject>
+#include <QtOpenGL/QOpenGLShaderProgram>
+#include <QtOpenGL/QOpenGLTexture>
+
+#include "hit_test_benchmark.h"
+#include "picking_service.h"
+#include "widget_registry.h"
+
+namespace
+{
+    const float worldWidth = 200.f;
+    const float worldHeight = 100.f;
+    const int framebufferWidth = 600;
+    const int framebufferHeight = 300;
+    const int cpuClicks = 100000;
+    const int gpuClicks = 20;
+}
+
+int runHitTestBenchmark()
+{
+    QOpenGLContext context;
+    if (!context.create())
+    {
+        qWarning() << "Failed to create an OpenGL context";
+        return 1;
+    }
+    QOffscreenSurface surface;
+    surface.setFormat(context.format());
+    surface.create();
+    if (!context.makeCurrent(&surface))
+    {
+        qWarning() << "Failed to make the OpenGL context current";
+        return 1;
+    }
+    QOpenGLFunctions *gl = context.functions();
+
+    QOpenGLShaderProgram program;
+    program.addShaderFromSourceFile(QOpenGLShader::ShaderTypeBit::Vertex,
+        ":/assets/shaders/texture.vert");
+    program.addShaderFromSourceFile(QOpenGLShader::ShaderTypeBit::Fragment,
+        ":/assets/shaders/texture.frag");
+    program.link();
+    program.bind();
+    program.setUniformValue("uClick", true);
+    const int uPickColorLocation = program.uniformLocation("uPickColor");
+    const int uMvpMatrixLocation = program.uniformLocation("uMvpMatrix");
+
+    float vertData[] = {
+        -0.5f, -0.5f, 0.f, 1.f,
+        0.5f, -0.5f, 1.f, 1.f,
+        -0.5f, 0.5f, 0.f, 0.f,
+        0.5f, 0.5f, 1.f, 0.f
+    };
+    QOpenGLBuffer vertBuffer;
+    vertBuffer.create();
+    vertBuffer.bind();
+    vertBuffer.allocate(vertData, sizeof(vertData));
+    program.setAttributeBuffer("aPosition", GL_FLOAT, 0, 2, 4 * sizeof(float));
+    program.enableAttributeArray("aPosition");
+    program.setAttributeBuffer("aTexCoord", GL_FLOAT, 2 * sizeof(float), 2, 4 * sizeof(float));
+    program.enableAttributeArray("aTexCoord");
+
+    QOpenGLTexture texture(QImage(":/assets/textures/button.png"));
+    texture.bind();
+
+    QOpenGLFramebufferObject fbo(framebufferWidth, framebufferHeight);
+    fbo.bind();
+    gl->glViewport(0, 0, framebufferWidth, framebufferHeight);
+    gl->glClearColor(0.f, 0.f, 0.f, 1.f);
+
+    QMatrix4x4 projViewMatrix;
+    projViewMatrix.ortho(0.f, worldWidth, 0.f, worldHeight, 1.f, -1.f);
+
+    QRandomGenerator random(42);
+    const int widgetCounts[] = { 10, 1000, 50000 };
+    for (int widgetCount : widgetCounts)
+    {
+        WidgetRegistry registry(worldWidth, worldHeight);
+        QVector<QMatrix4x4> mvpMatrices;
+        for (int i = 0; i < widgetCount; ++i)
+        {
+            QVector2D position(random.bounded(worldWidth), random.bounded(worldHeight));
+            QVector2D size(1.f + random.bounded(20.f), 1.f + random.bounded(10.f));
+            float angle = random.bounded(360.f);
+            registry.add(position, size, angle);
+
+            QMatrix4x4 modelMatrix;
+            modelMatrix.translate(position.toVector3D());
+            modelMatrix.rotate(angle, QVector3D(0, 0, 1));
+            modelMatrix.scale(size.x(), size.y(), 1.f);
+            mvpMatrices.append(projViewMatrix * modelMatrix);
+        }
+
+        QElapsedTimer timer;
+        // The first query builds the grid, count it in
+        timer.start();
+        int hits = 0;
+        for (int i = 0; i < cpuClicks; ++i)
+        {
+            QVector2D point(random.bounded(worldWidth), random.bounded(worldHeight));
+            hits += registry.hitTest(point) != nullptr;
+        }
+        const double cpuLatency = timer.nsecsElapsed() / 1e3 / cpuClicks;
+
+        timer.start();
+        for (int i = 0; i < gpuClicks; ++i)
+        {
+            gl->glClear(GL_COLOR_BUFFER_BIT);
+            for (int j = 0; j < widgetCount; ++j)
+            {
+                program.setUniformValue(uMvpMatrixLocation, mvpMatrices[j]);
+                program.setUniformValue(uPickColorLocation,
+                    PickingService::idToColor(quint32(j + 1)));
+                gl->glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+            }
+            GLubyte pixel[4];
+            gl->glReadPixels(random.bounded(framebufferWidth),
+                random.bounded(framebufferHeight), 1, 1, GL_RGBA,
+                GL_UNSIGNED_BYTE, pixel);
+        }
+        const double gpuLatency = timer.nsecsElapsed() / 1e3 / gpuClicks;
+
+        qInfo().noquote() << QString("%1 widgets: CPU hit test %2 us, GPU pick pass %3 us "
+            "(%4% of CPU clicks hit)").arg(widgetCount, 5).arg(cpuLatency, 0, 'f', 3)
+            .arg(gpuLatency, 0, 'f', 1).arg(100.0 * hits / cpuClicks, 0, 'f', 1);
+    }
+
+    texture.destroy();
+    fbo.release();
+    context.doneCurrent();
+    return 0;
+}
@@ -0,0 +1,9 @@
+#ifndef HIT_TEST_BENCHMARK_H
+#define HIT_TEST_BENCHMARK_H
+
+// Compares click latency of WidgetRegistry::hitTest() with a GPU pick
+// pass (draw every widget in its pick color, read one pixel back) for
+// 10, 1k and 50k widgets. Runs offscreen and returns a process exit code.
+int runHitTestBenchmark();
+
+#endif // HIT_TEST_BENCHMARK_H
@@ -1,12 +1,43 @@
 #include <QtWidgets/QApplication>
 
+#include "draw_queue_benchmark.h"
+#include "frame_profiler.h"
+#include "hit_test_benchmark.h"
+#include "offscreen_host.h"
 #include "opengl_window.h"
+#include "shader_cache_benchmark.h"
+#include "texture_atlas_benchmark.h"
 
 int main(int argc, char *argv[])
 {
     QApplication::setAttribute(Qt::ApplicationAttribute::AA_UseDesktopOpenGL);
     QApplication app(argc, argv);
+    if (app.arguments().contains("--benchmark"))
+    {
+        int result = runHitTestBenchmark();
+        if (result == 0)
+        {
+            result = runTextureAtlasBenchmark();
+        }
+        if (result == 0)
+        {
+            result = runShaderCacheBenchmark();
+        }
+        if (result == 0)
+        {
+            result = runDrawQueueBenchmark();
+        }
+        return result;
+    }
     OpenGLWindow w;
+    if (OffscreenHost::isRequested(app.arguments()))
+    {
+        const int result = OffscreenHost(app.arguments()).run(w);
+        PROFILE_EXPORT(app.arguments());
+        return result;
+    }
     w.show();
-    return app.exec();
+    const int result = app.exec();
+    PROFILE_EXPORT(app.arguments());
+    return result;
 }
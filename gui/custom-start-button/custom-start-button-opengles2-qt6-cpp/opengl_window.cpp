@@ -4,14 +4,22 @@
 #include <windows.h>
 #endif
 
-#include <QtCore/QFile>
-#include <QtCore/QJsonDocument>
-#include <QtCore/QJsonObject>
-#include <QtCore/QJsonValue>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDebug>
 #include <QtGui/QSurfaceFormat>
 
+#include "frame_profiler.h"
+#include "shader_cache.h"
+#include "texture_atlas.h"
+
 OpenGLWindow::OpenGLWindow()
-    : m_texture(QOpenGLTexture::Target::Target2D)
+    // PartialUpdateBlit renders into an FBO that is kept between frames
+    // and blitted to the back buffer, so its content is always preserved
+    : QOpenGLWindow(QCoreApplication::arguments().contains("--damage") ?
+        QOpenGLWindow::PartialUpdateBlit : QOpenGLWindow::NoPartialUpdate)
+    , m_renderTargets(RenderTargetManager::policyFromArguments(QCoreApplication::arguments()))
+    , m_damageMode(updateBehavior() == QOpenGLWindow::PartialUpdateBlit)
+    , m_texture(QOpenGLTexture::Target::Target2D)
 {
     setTitle("OpenGL ES 2.0, Qt6, C++");
 
@@ -26,12 +34,28 @@ OpenGLWindow::OpenGLWindow()
     // Set format
     // QSurfaceFormat format;
     // format.setSamples(4);
-    // format.setSwapInterval(0);
-    // connect(this, SIGNAL(frameSwapped()), this, SLOT(update()));
     // setFormat(format);
 
+    // Frames are drawn on demand unless "--frame-mode vsync|uncapped"
+    // asks for continuous rendering
+    m_frameScheduler = new FrameScheduler(this,
+        FrameScheduler::modeFromArguments(QCoreApplication::arguments()));
+
+#ifdef FRAME_PROFILER
+    connect(this, &QOpenGLWindow::frameSwapped, this, []() { PROFILE_FRAME_END(); });
+#endif
+
     m_viewMatrix.lookAt(QVector3D(0, 0, 1), QVector3D(0, 0, 0),
         QVector3D(0, 1, 0));
+
+    // Pass alphaAccurate = true to let the GPU pick pass ignore
+    // the transparent parts of the texture
+    m_buttonId = m_widgets.add(m_buttonPosition.toVector2D(),
+        m_buttonSize.toVector2D());
+    m_widgets.setDamageTracker(&m_damage);
+    m_pickTarget = m_renderTargets.addTarget(RenderTargetManager::Extent::Window);
+    m_picking.setTarget(&m_renderTargets, m_pickTarget);
+    m_printDrawStats = QCoreApplication::arguments().contains("--frame-stats");
 }
 
 void OpenGLWindow::initializeGL()
@@ -40,211 +64,332 @@ void OpenGLWindow::initializeGL()
 
         // glClearColor(0.77, 0.64, 0.52, 1); // Light brown
 
-        glEnable(GL_BLEND);
+        // Blending itself is switched per draw, translucent draws only
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-        m_pProgram = new QOpenGLShaderProgram(this);
-        m_pProgram->addShaderFromSourceFile(QOpenGLShader::ShaderTypeBit::Vertex,
-            ":/assets/shaders/texture.vert");
-        m_pProgram->addShaderFromSourceFile(QOpenGLShader::ShaderTypeBit::Fragment,
-            ":/assets/shaders/texture.frag");
-        m_pProgram->link();
+        m_pProgram = ShaderCache::instance()->programFromFiles(
+            ":/assets/shaders/texture.vert", ":/assets/shaders/texture.frag");
         m_pProgram->bind();
 
         m_uClickLocation = m_pProgram->uniformLocation("uClick");
         m_uPickColorLocation = m_pProgram->uniformLocation("uPickColor");
         m_uMvpMatrixLocation = m_pProgram->uniformLocation("uMvpMatrix");
-        m_pProgram->setUniformValue(m_uClickLocation, false);
 
-        QFile file(":/assets/textures/button.json");
-        QString content;
-        if (file.open(QIODevice::OpenModeFlag::ReadOnly))
-        {
-            content = file.readAll();
-        }
-        file.close();
-        QJsonDocument doc = QJsonDocument::fromJson(content.toUtf8());
-        QJsonObject root = doc.object();
-        // Width and height
-        QJsonValue meta = root.value("meta");
-        QJsonValue size = meta.toObject().value("size");
-        float tw = size.toObject().value("w").toDouble();
-        float th = size.toObject().value("h").toDouble();
-        // Frames
-        QJsonValue frames = root.value("frames");
-        // Button normal
-        QJsonValue buttonActive = frames.toObject().value("button-normal.png");
-        QJsonValue frame1 = buttonActive.toObject().value("frame");
-        float f1x = frame1.toObject().value("x").toDouble();
-        float f1y = frame1.toObject().value("y").toDouble();
-        float f1w = frame1.toObject().value("w").toDouble();
-        float f1h = frame1.toObject().value("h").toDouble();
-        // Button active
-        QJsonValue buttonNormal = frames.toObject().value("button-active.png");
-        QJsonValue frame2 = buttonNormal.toObject().value("frame");
-        float f2x = frame2.toObject().value("x").toDouble();
-        float f2y = frame2.toObject().value("y").toDouble();
-        float f2w = frame2.toObject().value("w").toDouble();
-        float f2h = frame2.toObject().value("h").toDouble();
-
-        float vertPositions[] = {
-            -0.5, -0.5,
-            0.5, -0.5,
-            -0.5, 0.5,
-            0.5, 0.5,
-            -0.5, -0.5,
-            0.5, -0.5,
-            -0.5, 0.5,
-            0.5, 0.5
-        };
-        m_vertPosBuffer.create();
-        m_vertPosBuffer.bind();
-        m_vertPosBuffer.allocate(vertPositions, sizeof(vertPositions));
-        int aPositionLocation = m_pProgram->attributeLocation("aPosition");
-        m_pProgram->setAttributeBuffer(aPositionLocation, GL_FLOAT, 0, 2);
-        m_pProgram->enableAttributeArray(aPositionLocation);
-
-        float texCoords[] = {
-            f1x / tw, (f1y + f1h) / th, // First button texture
-            (f1x + f1w) / tw, (f1y + f1h) / th,
-            f1x / tw, f1y / th,
-            (f1x + f1w) / tw, f1y / th,
-            f2x / tw, (f2y + f2h) / th, // Second button texture
-            (f2x + f2w) / tw, (f2y + f2h) / th,
-            f2x / tw, f2y / th,
-            (f2x + f2w) / tw, f2y / th
-        };
-        m_texCoordBuffer.create();
-        m_texCoordBuffer.bind();
-        m_texCoordBuffer.allocate(texCoords, sizeof(texCoords));
-        int aTexCoordLocation = m_pProgram->attributeLocation("aTexCoord");
-        m_pProgram->setAttributeBuffer(aTexCoordLocation, GL_FLOAT, 0, 2);
-        m_pProgram->enableAttributeArray(aTexCoordLocation);
+        m_picking.initialize();
+
+        TextureAtlas atlas;
+        atlas.load(":/assets/textures/button.json");
+        const TextureAtlas::Frame &f1 = atlas.frame(atlas.frameId("button-normal.png"));
+        const TextureAtlas::Frame &f2 = atlas.frame(atlas.frameId("button-active.png"));
+
+        // One interleaved quad per atlas frame, both end up in the
+        // same shared vertex buffer
+        m_normalQuad = GeometryRegistry::instance()->texturedQuad(f1.left, f1.bottom,
+            f1.right, f1.top);
+        m_activeQuad = GeometryRegistry::instance()->texturedQuad(f2.left, f2.bottom,
+            f2.right, f2.top);
+        m_aPositionLocation = m_pProgram->attributeLocation("aPosition");
+        m_aTexCoordLocation = m_pProgram->attributeLocation("aTexCoord");
+        m_pProgram->enableAttributeArray(m_aPositionLocation);
+        m_pProgram->enableAttributeArray(m_aTexCoordLocation);
 
         m_texture.create();
         m_texture.setData(QImage(":/assets/textures/button.png"));
         m_texture.setMinMagFilters(QOpenGLTexture::Filter::Linear,
             QOpenGLTexture::Filter::Linear);
         m_texture.setWrapMode(QOpenGLTexture::WrapMode::ClampToEdge);
+
+        m_drawPrograms = { m_pProgram };
+        m_drawTextures = { m_texture.textureId() };
+        m_buttonProgram = 0;
+        m_buttonTexture = 0;
+
+        // Qt classes bound whatever they needed above
+        m_glState.initialize();
+        // Through the cache, so that its shadow of uClick is right
+        m_glState.useProgram(m_pProgram);
+        m_glState.setUniform(m_uClickLocation, GLint(false));
 }
 
 void OpenGLWindow::resizeGL(int w, int h)
 {
-    int deviceW = w * devicePixelRatio();
-    int deviceH = h * devicePixelRatio();
-    float deviceAspect = deviceH / (float) deviceW;
-
-    if (deviceAspect > m_worldAspect)
-    {
-        m_viewportWidth = deviceW;
-        m_viewportHeight = (int) deviceW * m_worldAspect;
-        m_viewportX = 0;
-        m_viewportY = (int) (deviceH - m_viewportHeight) / 2.f;
-    }
-    else
-    {
-        m_viewportWidth = (int) deviceH / m_worldAspect;
-        m_viewportHeight = deviceH;
-        m_viewportX = (int) (deviceW - m_viewportWidth) / 2.f;
-        m_viewportY = 0;
-    }
+    const QSize deviceSize(w * devicePixelRatio(), h * devicePixelRatio());
+    const QRect viewport = RenderTargetManager::letterbox(deviceSize, m_worldAspect);
+    m_viewportX = viewport.x();
+    m_viewportY = viewport.y();
+    m_viewportWidth = viewport.width();
+    m_viewportHeight = viewport.height();
     m_projMatrix.setToIdentity();
     m_projMatrix.ortho(0.f, m_worldWidth, 0.f, m_worldHeight, 1.f, -1.f);
     m_projViewMatrix = m_projMatrix * m_viewMatrix;
+
+    // Reallocates only when the size leaves the targets' buckets
+    m_renderTargets.resize(deviceSize, viewport);
+    // The new mapping starts with a full frame
+    m_damage.setMapping(deviceSize, viewport, m_worldWidth, m_worldHeight);
 }
 
 void OpenGLWindow::paintGL()
 {
+    PROFILE_FRAME_BEGIN();
+    // QOpenGLWindow sets the viewport before every paintGL(). With
+    // PartialUpdateBlit, when there is no framebuffer blit, the previous
+    // frame was composited through QOpenGLTextureBlitter, which leaves its
+    // own program, texture, buffer and blend state behind.
+    m_glState.invalidate(m_damageMode ? GLStateCache::StateBits(GLStateCache::StateBit::All) :
+        GLStateCache::StateBits(GLStateCache::StateBit::Viewport));
+
     if (m_clicked)
     {
+        PROFILE_SCOPE("pick pass");
         m_clicked = false;
 
-        glClear(GL_COLOR_BUFFER_BIT);
-        glClearColor(m_windowColor.x(), m_windowColor.y(), m_windowColor.z(), 1.f);
-        glClear(GL_COLOR_BUFFER_BIT);
-        glViewport(m_viewportX, m_viewportY, m_viewportWidth, m_viewportHeight);
-        glScissor(m_viewportX, m_viewportY, m_viewportWidth, m_viewportHeight);
-        glClearColor(m_worldColor.x(), m_worldColor.y(), m_worldColor.z(), 1.f);
-        glEnable(GL_SCISSOR_TEST);
-        glClear(GL_COLOR_BUFFER_BIT);
-        glDisable(GL_SCISSOR_TEST);
+        m_glState.viewport(m_viewportX, m_viewportY, m_viewportWidth, m_viewportHeight);
+        m_picking.beginPickPass(m_mouseX, m_mouseY);
 
-        m_pProgram->bind();
+        m_glState.useProgram(m_pProgram);
+        m_glState.bindTexture(GL_TEXTURE_2D, m_texture.textureId());
 
-        m_pProgram->setUniformValue(m_uClickLocation, true);
-        m_pProgram->setUniformValue(m_uPickColorLocation, QVector3D(1, 0, 0));
+        m_glState.setUniform(m_uClickLocation, GLint(true));
+        m_glState.setUniform(m_uPickColorLocation, PickingService::idToColor(m_buttonId));
 
         m_modelMatrix.setToIdentity();
         m_modelMatrix.translate(m_buttonPosition);
         m_modelMatrix.scale(m_buttonSize);
         m_mvpMatrix = m_projViewMatrix * m_modelMatrix;
-        m_pProgram->setUniformValue(m_uMvpMatrixLocation, m_mvpMatrix);
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-
-        GLubyte pixels[4];
-        glReadPixels(m_mouseX, m_mouseY, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
-        GLubyte r = pixels[0];
-        GLubyte g = pixels[1];
-        GLubyte b = pixels[2];
-        qDebug() << r << g << b;
-        // qDebug() << m_mouseX << m_mouseY;
-        if (r == 255 && g == 0 && b == 0)
+        m_glState.setUniform(m_uMvpMatrixLocation, m_mvpMatrix);
+        drawQuad(m_normalQuad);
+
+        m_glState.setUniform(m_uClickLocation, GLint(false));
+        m_picking.endPickPass();
+        // The pick pass restores the framebuffer and the enabled
+        // capabilities but leaves its own scissor box and clear color
+        m_glState.invalidate(GLStateCache::StateBit::Scissor |
+            GLStateCache::StateBit::ClearColor);
+    }
+
+    quint32 pickedId;
+    if (m_picking.takeResult(&pickedId))
+    {
+        // The result may land after the mouse button was released
+        if (pickedId != PickingService::noObject && m_mouseDown)
+        {
+            onWidgetPressed(pickedId);
+        }
+    }
+    else if (m_picking.hasPendingResult())
+    {
+        // Keep frames coming until the read back lands
+        m_frameScheduler->requestFrame();
+    }
+
+    // Without damage tracking every frame is a full one
+    if (!m_damageMode)
+    {
+        m_damage.invalidate();
+    }
+    const bool fullFrame = m_damage.takeFrame(&m_damageRects);
+
+    if (fullFrame)
+    {
+        {
+            PROFILE_SCOPE("clear");
+            clearWindow();
+        }
+
+        {
+            PROFILE_SCOPE("draw");
+            queueDraws();
+            replayDraws();
+        }
+    }
+    else if (!m_damageRects.empty())
+    {
+        PROFILE_SCOPE("draw damage");
+        // The rest of the frame is still in the FBO, only the damaged
+        // rectangles are cleared and drawn into
+        queueDraws();
+        m_glState.viewport(m_viewportX, m_viewportY, m_viewportWidth, m_viewportHeight);
+        m_glState.clearColor(m_worldColor.x(), m_worldColor.y(), m_worldColor.z(), 1.f);
+        m_glState.setEnabled(GL_SCISSOR_TEST, true);
+        for (const QRect &rect : m_damageRects)
         {
-            qDebug() << "clicked";
-            m_pressed = true;
+            m_glState.scissor(rect.x(), rect.y(), rect.width(), rect.height());
+            glClear(GL_COLOR_BUFFER_BIT);
+            replayDraws();
         }
+        m_glState.setEnabled(GL_SCISSOR_TEST, false);
+    }
 
-        m_pProgram->setUniformValue(m_uClickLocation, false);
+    // Frames that drew nothing are not worth a line
+    if (m_printDrawStats && m_damageMode && !m_damageRects.empty())
+    {
+        const DamageTracker::Stats &stats = m_damage.stats();
+        const QSize deviceSize = m_damage.deviceSize();
+        qDebug().noquote() << QString("Frame %1: %2 rectangles%3, %4 pixels (%5% of the window)")
+            .arg(stats.frames).arg(stats.lastRects).arg(fullFrame ? " (full)" : "")
+            .arg(stats.lastPixels)
+            .arg(100.0 * stats.lastPixels / qMax(1, deviceSize.width() * deviceSize.height()),
+                0, 'f', 1);
     }
 
+    PROFILE_SWAP_BEGIN();
+}
+
+void OpenGLWindow::clearWindow()
+{
     glClear(GL_COLOR_BUFFER_BIT);
-    glClearColor(m_windowColor.x(), m_windowColor.y(), m_windowColor.z(), 1.f);
+    m_glState.clearColor(m_windowColor.x(), m_windowColor.y(), m_windowColor.z(), 1.f);
     glClear(GL_COLOR_BUFFER_BIT);
-    glViewport(m_viewportX, m_viewportY, m_viewportWidth, m_viewportHeight);
-    glScissor(m_viewportX, m_viewportY, m_viewportWidth, m_viewportHeight);
-    glClearColor(m_worldColor.x(), m_worldColor.y(), m_worldColor.z(), 1.f);
-    glEnable(GL_SCISSOR_TEST);
+    m_glState.viewport(m_viewportX, m_viewportY, m_viewportWidth, m_viewportHeight);
+    m_glState.scissor(m_viewportX, m_viewportY, m_viewportWidth, m_viewportHeight);
+    m_glState.clearColor(m_worldColor.x(), m_worldColor.y(), m_worldColor.z(), 1.f);
+    m_glState.setEnabled(GL_SCISSOR_TEST, true);
     glClear(GL_COLOR_BUFFER_BIT);
-    glDisable(GL_SCISSOR_TEST);
+    m_glState.setEnabled(GL_SCISSOR_TEST, false);
+}
 
-    m_pProgram->bind();
-    m_texture.bind();
+// Queues one draw per widget and sorts them by state. The button texture
+// has soft edges, so the button is translucent and its paint order is
+// kept.
+void OpenGLWindow::queueDraws()
+{
+    m_drawQueue.clear();
+    m_drawQueue.add(uiLayer, true, m_buttonProgram, m_buttonTexture, m_buttonId,
+        int(m_buttonId));
+    m_drawQueue.sort();
 
-    m_modelMatrix.setToIdentity();
-    m_modelMatrix.translate(m_buttonPosition);
-    m_modelMatrix.scale(m_buttonSize);
-    m_mvpMatrix = m_projViewMatrix * m_modelMatrix;
-    m_pProgram->setUniformValue(m_uMvpMatrixLocation, m_mvpMatrix);
-    if (!m_pressed)
+    const DrawQueue::Stats &stats = m_drawQueue.stats();
+    m_unsortedChanges.programs += stats.unsorted.programs;
+    m_unsortedChanges.textures += stats.unsorted.textures;
+    m_unsortedChanges.blends += stats.unsorted.blends;
+    m_sortedChanges.programs += stats.sorted.programs;
+    m_sortedChanges.textures += stats.sorted.textures;
+    m_sortedChanges.blends += stats.sorted.blends;
+    m_drawFrames++;
+}
+
+// Submits the queued draws, once per damaged rectangle in a partial frame
+void OpenGLWindow::replayDraws()
+{
+    for (const DrawQueue::Draw &draw : m_drawQueue.draws())
     {
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        m_glState.useProgram(m_drawPrograms[draw.program]);
+        m_glState.bindTexture(GL_TEXTURE_2D, m_drawTextures[draw.texture]);
+        m_glState.setEnabled(GL_BLEND, draw.translucent);
+        drawWidget(quint32(draw.payload));
     }
-    else
+}
+
+void OpenGLWindow::drawWidget(quint32 id)
+{
+    if (id == m_buttonId)
     {
-        glDrawArrays(GL_TRIANGLE_STRIP, 4, 4);
+        m_modelMatrix.setToIdentity();
+        m_modelMatrix.translate(m_buttonPosition);
+        m_modelMatrix.scale(m_buttonSize);
+        m_mvpMatrix = m_projViewMatrix * m_modelMatrix;
+        m_glState.setUniform(m_uMvpMatrixLocation, m_mvpMatrix);
+        drawQuad(m_pressed ? m_activeQuad : m_normalQuad);
     }
 }
 
+void OpenGLWindow::drawQuad(const GeometryRegistry::Mesh &quad)
+{
+    // Quads of the same pool share the buffer, the cache skips the rebind
+    m_glState.bindBuffer(GL_ARRAY_BUFFER, quad.vertexBuffer);
+    m_pProgram->setAttributeBuffer(m_aPositionLocation, GL_FLOAT, quad.vertexOffset, 2,
+        quad.stride);
+    m_pProgram->setAttributeBuffer(m_aTexCoordLocation, GL_FLOAT,
+        quad.vertexOffset + 2 * sizeof(float), 2, quad.stride);
+    glDrawArrays(quad.primitive, 0, quad.vertexCount);
+}
+
 void OpenGLWindow::mousePressEvent(QMouseEvent *event)
 {
     if (event->button() == Qt::MouseButton::LeftButton)
     {
         m_mouseX = event->pos().x() * devicePixelRatio();
         m_mouseY = (height() - event->pos().y() - 1) * devicePixelRatio();
-        m_clicked = true;
-        update();
+        m_mouseDown = true;
+
+        QVector2D worldPoint(
+            (m_mouseX - m_viewportX) * m_worldWidth / m_viewportWidth,
+            (m_mouseY - m_viewportY) * m_worldHeight / m_viewportHeight);
+        const WidgetRegistry::Widget *widget = m_widgets.hitTest(worldPoint);
+        if (!widget)
+        {
+            return;
+        }
+        if (widget->alphaAccurate)
+        {
+            // Inside the bounds, let the pick pass check the texture
+            m_clicked = true;
+        }
+        else
+        {
+            onWidgetPressed(widget->id);
+        }
+        m_frameScheduler->requestFrame();
+    }
+}
+
+void OpenGLWindow::onWidgetPressed(quint32 id)
+{
+    if (id == m_buttonId)
+    {
+        qDebug() << "clicked";
+        m_pressed = true;
+        m_widgets.markDirty(id);
     }
 }
 
 void OpenGLWindow::mouseReleaseEvent(QMouseEvent *event)
 {
     Q_UNUSED(event);
-    m_pressed = false;
-    update();
+    m_mouseDown = false;
+    if (m_pressed)
+    {
+        m_pressed = false;
+        m_widgets.markDirty(m_buttonId);
+    }
+    m_frameScheduler->requestFrame();
 }
 
 void OpenGLWindow::closeEvent(QCloseEvent *event)
 {
     Q_UNUSED(event);
+    if (m_printDrawStats && m_drawFrames > 0)
+    {
+        qInfo().noquote() << QString("Draw queue: %1 frames, state changes "
+            "%2 unsorted, %3 sorted (program %4, texture %5, blend %6)")
+            .arg(m_drawFrames).arg(m_unsortedChanges.total()).arg(m_sortedChanges.total())
+            .arg(m_sortedChanges.programs).arg(m_sortedChanges.textures)
+            .arg(m_sortedChanges.blends);
+    }
+    if (m_printDrawStats && m_damage.stats().frames > 0)
+    {
+        const DamageTracker::Stats &stats = m_damage.stats();
+        const QSize deviceSize = m_damage.deviceSize();
+        const double pixels = double(stats.pixels) / stats.frames;
+        qInfo().noquote() << QString("Damage: %1 frames, %2 full, %3 pixels per frame "
+            "(%4% of the window)").arg(stats.frames).arg(stats.fullFrames)
+            .arg(pixels, 0, 'f', 0)
+            .arg(100.0 * pixels / qMax(1, deviceSize.width() * deviceSize.height()), 0, 'f', 1);
+    }
+    if (m_printDrawStats)
+    {
+        const RenderTargetManager::Stats &stats = m_renderTargets.stats();
+        qInfo().noquote() << QString("Render targets: %1 resizes, %2 allocations, "
+            "%3 KB allocated, %4 ms per resize (max %5)")
+            .arg(stats.resizes).arg(stats.allocations).arg(stats.allocatedBytes / 1024)
+            .arg(stats.resizes > 0 ? stats.resizeMs / stats.resizes : 0.0, 0, 'f', 3)
+            .arg(stats.maxResizeMs, 0, 'f', 3);
+    }
+    // PBOs, fences and FBOs are deleted with raw GL calls
+    makeCurrent();
     m_texture.destroy();
+    m_picking.destroy();
+    m_renderTargets.destroy();
+    doneCurrent();
 }
@@ -6,13 +6,24 @@
 #include <QtGui/QMouseEvent>
 #include <QtGui/QOpenGLFunctions>
 #include <QtGui/QVector3D>
-#include <QtOpenGL/QOpenGLBuffer>
 #include <QtOpenGL/QOpenGLShaderProgram>
 #include <QtOpenGL/QOpenGLTexture>
 #include <QtOpenGL/QOpenGLWindow>
 
+#include <vector>
+
+#include "damage_tracker.h"
+#include "draw_queue.h"
+#include "frame_scheduler.h"
+#include "geometry_registry.h"
+#include "gl_state_cache.h"
+#include "picking_service.h"
+#include "render_target_manager.h"
+#include "widget_registry.h"
+
 class OpenGLWindow : public QOpenGLWindow, private QOpenGLFunctions
 {
+    friend class OffscreenHost;
 
 public:
     OpenGLWindow();
@@ -26,6 +37,13 @@ private:
     void mouseReleaseEvent(QMouseEvent *event) override;
     void closeEvent(QCloseEvent *event) override;
 
+    void onWidgetPressed(quint32 id);
+    void clearWindow();
+    void queueDraws();
+    void replayDraws();
+    void drawWidget(quint32 id);
+    void drawQuad(const GeometryRegistry::Mesh &quad);
+
     QMatrix4x4 m_modelMatrix;
     QMatrix4x4 m_viewMatrix;
     QMatrix4x4 m_projMatrix;
@@ -43,21 +61,52 @@ private:
     int m_viewportY;
     int m_viewportWidth;
     int m_viewportHeight;
+    // Offscreen buffers that follow the window size, only the pick
+    // buffer for now
+    RenderTargetManager m_renderTargets;
+    int m_pickTarget;
+    // "--damage" redraws only what widgets reported as changed, on top
+    // of the previous frame that QOpenGLWindow keeps in its FBO
+    bool m_damageMode;
+    DamageTracker m_damage;
+    std::vector<QRect> m_damageRects;
 
-    QOpenGLBuffer m_vertPosBuffer;
-    QOpenGLBuffer m_texCoordBuffer;
+    GeometryRegistry::Mesh m_normalQuad;
+    GeometryRegistry::Mesh m_activeQuad;
     QOpenGLShaderProgram *m_pProgram;
+    int m_aPositionLocation;
+    int m_aTexCoordLocation;
     int m_uClickLocation;
     int m_uPickColorLocation;
     int m_uMvpMatrixLocation;
 
     QOpenGLTexture m_texture;
+    GLStateCache m_glState;
+    PickingService m_picking;
+    FrameScheduler *m_frameScheduler;
+    WidgetRegistry m_widgets = WidgetRegistry(m_worldWidth, m_worldHeight);
     QVector3D m_buttonPosition = QVector3D(m_worldWidth / 2.f,
         m_worldHeight / 2.f, 0.f);
     QVector3D m_buttonSize = QVector3D(60.f, 20.f, 1.f);
+    quint32 m_buttonId;
+
+    // Every widget goes through the draw queue; its program and texture
+    // ids index these tables
+    static constexpr int uiLayer = 1;
+    DrawQueue m_drawQueue;
+    std::vector<QOpenGLShaderProgram *> m_drawPrograms;
+    std::vector<GLuint> m_drawTextures;
+    int m_buttonProgram = 0;
+    int m_buttonTexture = 0;
+    bool m_printDrawStats = false;
+    quint64 m_drawFrames = 0;
+    DrawQueue::StateChanges m_unsortedChanges;
+    DrawQueue::StateChanges m_sortedChanges;
+
     int m_mouseX = 0;
     int m_mouseY = 0;
     bool m_clicked = false;
+    bool m_mouseDown = false;
     bool m_pressed = false;
 };
 
@@ -0,0 +1,222 @@
+#include <QtGui/QOpenGLContext>
+
+#include <algorithm>
+
+#include "picking_service.h"
+
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#endif
+#ifndef GL_STREAM_READ
+#define GL_STREAM_READ 0x88E1
+#endif
+#ifndef GL_MAP_READ_BIT
+#define GL_MAP_READ_BIT 0x0001
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#endif
+#ifndef GL_ALREADY_SIGNALED
+#define GL_ALREADY_SIGNALED 0x911A
+#endif
+#ifndef GL_CONDITION_SATISFIED
+#define GL_CONDITION_SATISFIED 0x911C
+#endif
+
+QVector3D PickingService::idToColor(quint32 id)
+{
+    return QVector3D(((id >> 16) & 0xFF) / 255.f, ((id >> 8) & 0xFF) / 255.f,
+        (id & 0xFF) / 255.f);
+}
+
+static quint32 colorToId(const GLubyte *pixel)
+{
+    return (quint32(pixel[0]) << 16) | (quint32(pixel[1]) << 8) | quint32(pixel[2]);
+}
+
+PickingService::PickingService()
+{
+}
+
+PickingService::~PickingService()
+{
+    if (m_context && QOpenGLContext::currentContext() == m_context)
+    {
+        destroy();
+    }
+    QObject::disconnect(m_contextConnection);
+}
+
+void PickingService::initialize()
+{
+    initializeOpenGLFunctions();
+
+    // Pixel pack buffers, glMapBufferRange and fences are all core
+    // in ES 3.0 and desktop GL 3.2
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    m_context = context;
+    // Cleans up after an owner that did not call destroy(). A context
+    // that is not current takes its objects along, only the names are
+    // dropped then.
+    m_contextConnection = QObject::connect(context, &QOpenGLContext::aboutToBeDestroyed,
+        [this]() {
+            if (QOpenGLContext::currentContext() == m_context)
+            {
+                destroy();
+                return;
+            }
+            QObject::disconnect(m_contextConnection);
+            m_context = nullptr;
+            std::fill(m_fences, m_fences + ringSize, nullptr);
+            std::fill(m_packBuffers, m_packBuffers + ringSize, 0);
+        });
+    const QSurfaceFormat format = context->format();
+    m_async = context->isOpenGLES() ? format.majorVersion() >= 3 :
+        format.version() >= qMakePair(3, 2);
+
+    if (m_async)
+    {
+        glGenBuffers(ringSize, m_packBuffers);
+        for (int i = 0; i < ringSize; ++i)
+        {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, m_packBuffers[i]);
+            glBufferData(GL_PIXEL_PACK_BUFFER, 4, nullptr, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+}
+
+void PickingService::destroy()
+{
+    QObject::disconnect(m_contextConnection);
+    m_context = nullptr;
+    if (m_async)
+    {
+        for (int i = 0; i < ringSize; ++i)
+        {
+            if (m_fences[i])
+            {
+                glDeleteSync(m_fences[i]);
+                m_fences[i] = nullptr;
+            }
+        }
+        glDeleteBuffers(ringSize, m_packBuffers);
+        std::fill(m_packBuffers, m_packBuffers + ringSize, 0);
+    }
+    m_pendingCount = 0;
+    m_resultReady = false;
+}
+
+void PickingService::setTarget(RenderTargetManager *targets, int target)
+{
+    m_targets = targets;
+    m_target = target;
+}
+
+void PickingService::beginPickPass(int x, int y)
+{
+    // Only the used part of the target holds the window's pixels
+    const QSize size = m_targets->size(m_target);
+    m_x = qBound(0, x, size.width() - 1);
+    m_y = qBound(0, y, size.height() - 1);
+
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &m_prevFramebuffer);
+    m_prevScissorTest = glIsEnabled(GL_SCISSOR_TEST);
+    m_prevBlend = glIsEnabled(GL_BLEND);
+
+    m_targets->framebuffer(m_target)->bind();
+    // Only the pixel under the cursor matters, so rasterize nothing else
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(m_x, m_y, 1, 1);
+    glDisable(GL_BLEND);
+    glClearColor(0.f, 0.f, 0.f, 1.f);
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void PickingService::endPickPass()
+{
+    if (m_async)
+    {
+        // When every slot is still in flight the oldest request is dropped,
+        // a newer click supersedes it anyway
+        if (m_pendingCount == ringSize)
+        {
+            const int oldest = m_writeIndex;
+            glDeleteSync(m_fences[oldest]);
+            m_fences[oldest] = nullptr;
+            m_pendingCount--;
+        }
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_packBuffers[m_writeIndex]);
+        glReadPixels(m_x, m_y, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        m_fences[m_writeIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        m_writeIndex = (m_writeIndex + 1) % ringSize;
+        m_pendingCount++;
+    }
+    else
+    {
+        GLubyte pixel[4];
+        glReadPixels(m_x, m_y, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+        m_result = colorToId(pixel);
+        m_resultReady = true;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_prevFramebuffer);
+    if (!m_prevScissorTest)
+    {
+        glDisable(GL_SCISSOR_TEST);
+    }
+    if (m_prevBlend)
+    {
+        glEnable(GL_BLEND);
+    }
+}
+
+bool PickingService::takeResult(quint32 *id)
+{
+    // Drain everything that has landed, the latest pick wins
+    while (m_pendingCount > 0)
+    {
+        const int before = m_pendingCount;
+        pollOldest();
+        if (m_pendingCount == before)
+        {
+            break;
+        }
+    }
+
+    if (!m_resultReady)
+    {
+        return false;
+    }
+    m_resultReady = false;
+    *id = m_result;
+    return true;
+}
+
+void PickingService::pollOldest()
+{
+    const int oldest = (m_writeIndex - m_pendingCount + ringSize) % ringSize;
+
+    // Zero timeout: never wait, just ask whether the copy has landed
+    const GLenum status = glClientWaitSync(m_fences[oldest], 0, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+    {
+        return;
+    }
+    glDeleteSync(m_fences[oldest]);
+    m_fences[oldest] = nullptr;
+    m_pendingCount--;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_packBuffers[oldest]);
+    const GLubyte *pixel = static_cast<const GLubyte *>(
+        glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, 4, GL_MAP_READ_BIT));
+    if (pixel)
+    {
+        m_result = colorToId(pixel);
+        m_resultReady = true;
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
@@ -0,0 +1,74 @@
+#ifndef PICKING_SERVICE_H
+#define PICKING_SERVICE_H
+
+#include <QtCore/QMetaObject>
+#include <QtGui/QOpenGLContext>
+#include <QtGui/QOpenGLExtraFunctions>
+#include <QtGui/QVector3D>
+
+#include "render_target_manager.h"
+
+// Color picking through an offscreen framebuffer. Objects are drawn with
+// idToColor(id) between beginPickPass() and endPickPass(), id 0 means
+// "nothing". On ES 3.0 and desktop GL 3.2 the pixel under the cursor is
+// copied into a ring of pixel pack buffers and resolved a frame or two
+// later without stalling the pipeline. On ES 2.0 it is read synchronously.
+//
+// The framebuffer is a Window target of the window's RenderTargetManager,
+// so resizing the window reuses it while the size stays in its bucket.
+class PickingService : protected QOpenGLExtraFunctions
+{
+
+public:
+    static constexpr quint32 noObject = 0;
+    static constexpr quint32 maxObjectId = 0xFFFFFF;
+
+    static QVector3D idToColor(quint32 id);
+
+    PickingService();
+    ~PickingService();
+
+    // Must be called with a current OpenGL context. Without destroy() the
+    // buffers are released when the context is about to be destroyed.
+    void initialize();
+    void destroy();
+    // A Window extent target that has been resized before the first
+    // pick pass
+    void setTarget(RenderTargetManager *targets, int target);
+
+    bool isAsync() const { return m_async; }
+    bool hasPendingResult() const { return m_pendingCount > 0 || m_resultReady; }
+
+    // x, y - pixel to pick in framebuffer coordinates (bottom-left origin)
+    void beginPickPass(int x, int y);
+    void endPickPass();
+
+    // Returns true and the picked id once a requested pick has resolved
+    bool takeResult(quint32 *id);
+
+private:
+    static constexpr int ringSize = 3;
+
+    void pollOldest();
+
+    QOpenGLContext *m_context = nullptr;
+    QMetaObject::Connection m_contextConnection;
+    RenderTargetManager *m_targets = nullptr;
+    int m_target = -1;
+    int m_x = 0;
+    int m_y = 0;
+    GLint m_prevFramebuffer = 0;
+    GLboolean m_prevScissorTest = GL_FALSE;
+    GLboolean m_prevBlend = GL_FALSE;
+
+    bool m_async = false;
+    GLuint m_packBuffers[ringSize] = {};
+    GLsync m_fences[ringSize] = {};
+    int m_writeIndex = 0;
+    int m_pendingCount = 0;
+
+    bool m_resultReady = false;
+    quint32 m_result = noObject;
+};
+
+#endif // PICKING_SERVICE_H
@@ -0,0 +1,117 @@
+#include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QRandomGenerator>
+#include <QtCore/QTemporaryDir>
+#include <QtGui/QOffscreenSurface>
+#include <QtGui/QOpenGLContext>
+
+#include "shader_cache.h"
+#include "shader_cache_benchmark.h"
+
+namespace
+{
+    const int variantCount = 64;
+
+    QByteArray readFile(const QString &path)
+    {
+        QFile file(path);
+        return file.open(QIODevice::OpenModeFlag::ReadOnly) ? file.readAll() : QByteArray();
+    }
+
+    // Builds every variant and returns the elapsed time in milliseconds or
+    // a negative value when a program fails. A fresh salt per run keeps the
+    // driver's own shader cache from hiding the compile time.
+    double buildVariants(const QByteArray &vertSrc, const QByteArray &fragSrc, quint32 salt)
+    {
+        ShaderCache *cache = ShaderCache::instance();
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < variantCount; ++i)
+        {
+            const QByteArray prefix = QString("#define VARIANT %1\n// %2\n")
+                .arg(i).arg(salt).toLatin1();
+            if (!cache->program(prefix + vertSrc, prefix + fragSrc))
+            {
+                return -1.0;
+            }
+        }
+        return timer.nsecsElapsed() / 1e6;
+    }
+}
+
+int runShaderCacheBenchmark()
+{
+    QOpenGLContext context;
+    if (!context.create())
+    {
+        qWarning() << "Failed to create an OpenGL context";
+        return 1;
+    }
+    QOffscreenSurface surface;
+    surface.setFormat(context.format());
+    surface.create();
+    if (!context.makeCurrent(&surface))
+    {
+        qWarning() << "Failed to make the OpenGL context current";
+        return 1;
+    }
+
+    QTemporaryDir dir;
+    if (!dir.isValid())
+    {
+        qWarning() << "Failed to create a temporary directory";
+        return 1;
+    }
+
+    const QByteArray vertSrc = readFile(":/assets/shaders/texture.vert");
+    const QByteArray fragSrc = readFile(":/assets/shaders/texture.frag");
+    ShaderCache *cache = ShaderCache::instance();
+    const QString previousDirectory = cache->diskCacheDirectory();
+    const bool binarySupport = cache->hasBinarySupport();
+
+    // Baseline, what every start costs without the disk cache
+    cache->setDiskCacheDirectory(QString());
+    const double uncachedTime = buildVariants(vertSrc, fragSrc,
+        QRandomGenerator::global()->generate());
+    cache->clear();
+
+    cache->setDiskCacheDirectory(dir.path());
+    const quint32 salt = QRandomGenerator::global()->generate();
+    cache->resetStats();
+    const double coldTime = buildVariants(vertSrc, fragSrc, salt);
+    const ShaderCache::Stats coldStats = cache->stats();
+
+    // A second window asking for the same programs
+    cache->resetStats();
+    const double sharedTime = buildVariants(vertSrc, fragSrc, salt);
+    const int reused = cache->stats().reused;
+
+    // Forget the linked programs, as if the application was restarted
+    cache->clear();
+    cache->resetStats();
+    const double warmTime = buildVariants(vertSrc, fragSrc, salt);
+    const ShaderCache::Stats warmStats = cache->stats();
+    cache->clear();
+    cache->setDiskCacheDirectory(previousDirectory);
+    context.doneCurrent();
+
+    if (uncachedTime < 0.0 || coldTime < 0.0 || warmTime < 0.0)
+    {
+        qWarning() << "Failed to build the shader variants";
+        return 1;
+    }
+
+    qInfo().noquote() << QString("%1 programs: uncached %2 ms, cold %3 ms (%4 binaries "
+        "written), warm %5 ms (%6 loaded from disk), saved %7 ms per start")
+        .arg(variantCount).arg(uncachedTime, 0, 'f', 2).arg(coldTime, 0, 'f', 2)
+        .arg(coldStats.binariesWritten).arg(warmTime, 0, 'f', 2)
+        .arg(warmStats.loadedFromDisk).arg(uncachedTime - warmTime, 0, 'f', 2);
+    qInfo().noquote() << QString("%1 programs requested again by another window: "
+        "%2 ms, %3 reused").arg(variantCount).arg(sharedTime, 0, 'f', 3).arg(reused);
+    if (!binarySupport)
+    {
+        qInfo() << "The driver does not provide program binaries, the disk cache is inactive";
+    }
+    return 0;
+}
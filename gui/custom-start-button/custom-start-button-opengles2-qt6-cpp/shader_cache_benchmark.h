@@ -0,0 +1,11 @@
+#ifndef SHADER_CACHE_BENCHMARK_H
+#define SHADER_CACHE_BENCHMARK_H
+
+// Builds 64 variants of the button shaders three times: without the
+// disk cache, cold (compile and store binaries in a temporary directory)
+// and warm (load the stored binaries, as on the next start). Prints the
+// startup time of each run and the time the warm run saves. Returns a
+// process exit code.
+int runShaderCacheBenchmark();
+
+#endif // SHADER_CACHE_BENCHMARK_H
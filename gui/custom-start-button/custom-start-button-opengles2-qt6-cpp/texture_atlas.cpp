@@ -0,0 +1,227 @@
+#include <QtCore/QDebug>
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QSaveFile>
+#include <QtCore/QStandardPaths>
+
+#include <cstring>
+
+#include "texture_atlas.h"
+
+namespace
+{
+    const char cacheMagic[4] = { 'T', 'X', 'A', 'T' };
+    const quint32 cacheVersion = 1;
+
+    // Sidecar layout: header, frameCount frames, frameCount name entries,
+    // then the UTF-8 names blob
+    struct CacheHeader
+    {
+        char magic[4];
+        quint32 version;
+        quint64 sourceHash;
+        quint32 textureWidth;
+        quint32 textureHeight;
+        quint32 frameCount;
+        quint32 namesSize;
+    };
+
+    struct CacheName
+    {
+        quint32 offset;
+        quint32 length;
+    };
+
+    // FNV-1a, stable across runs and Qt versions unlike qHash
+    quint64 hashBytes(const QByteArray &data)
+    {
+        quint64 hash = 14695981039346656037ULL;
+        for (char c : data)
+        {
+            hash ^= quint8(c);
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+}
+
+TextureAtlas::TextureAtlas()
+{
+}
+
+bool TextureAtlas::load(const QString &jsonPath, const QString &cacheDir)
+{
+    reset();
+
+    QFile file(jsonPath);
+    if (!file.open(QIODevice::OpenModeFlag::ReadOnly))
+    {
+        qWarning() << "Failed to open" << jsonPath;
+        return false;
+    }
+    const QByteArray json = file.readAll();
+    file.close();
+
+    const QString dir = cacheDir.isEmpty() ?
+        QStandardPaths::writableLocation(QStandardPaths::CacheLocation) : cacheDir;
+    const QString cachePath = dir + "/" + QFileInfo(jsonPath).fileName() + ".atlas";
+    const quint64 sourceHash = hashBytes(json);
+
+    if (loadCache(cachePath, sourceHash))
+    {
+        m_loadedFromCache = true;
+        return true;
+    }
+
+    if (!parseJson(json))
+    {
+        qWarning() << "Failed to parse" << jsonPath;
+        return false;
+    }
+    QDir().mkpath(dir);
+    if (!writeCache(cachePath, sourceHash))
+    {
+        qWarning() << "Failed to write" << cachePath;
+    }
+    return true;
+}
+
+void TextureAtlas::reset()
+{
+    if (m_cacheFile.isOpen())
+    {
+        m_cacheFile.close();
+    }
+    m_textureSize = QSize();
+    m_frameCount = 0;
+    m_frames = nullptr;
+    m_parsedFrames.clear();
+    m_names.clear();
+    m_ids.clear();
+    m_loadedFromCache = false;
+}
+
+bool TextureAtlas::parseJson(const QByteArray &json)
+{
+    const QJsonObject root = QJsonDocument::fromJson(json).object();
+    const QJsonObject size = root.value("meta").toObject().value("size").toObject();
+    const float tw = size.value("w").toDouble();
+    const float th = size.value("h").toDouble();
+    if (tw <= 0.f || th <= 0.f)
+    {
+        return false;
+    }
+    m_textureSize = QSize(int(tw), int(th));
+
+    const QJsonObject frames = root.value("frames").toObject();
+    m_parsedFrames.reserve(frames.size());
+    m_names.reserve(frames.size());
+    m_ids.reserve(frames.size());
+    for (auto it = frames.begin(); it != frames.end(); ++it)
+    {
+        const QJsonObject rect = it.value().toObject().value("frame").toObject();
+        const float x = rect.value("x").toDouble();
+        const float y = rect.value("y").toDouble();
+        const float w = rect.value("w").toDouble();
+        const float h = rect.value("h").toDouble();
+        m_ids.insert(it.key(), int(m_parsedFrames.size()));
+        m_names.append(it.key());
+        m_parsedFrames.push_back({ x / tw, y / th, (x + w) / tw, (y + h) / th, w, h });
+    }
+    m_frames = m_parsedFrames.data();
+    m_frameCount = int(m_parsedFrames.size());
+    return true;
+}
+
+bool TextureAtlas::loadCache(const QString &path, quint64 sourceHash)
+{
+    m_cacheFile.setFileName(path);
+    if (!m_cacheFile.open(QIODevice::OpenModeFlag::ReadOnly))
+    {
+        return false;
+    }
+
+    const qint64 fileSize = m_cacheFile.size();
+    const uchar *data = fileSize >= qint64(sizeof(CacheHeader)) ?
+        m_cacheFile.map(0, fileSize) : nullptr;
+    if (!data)
+    {
+        m_cacheFile.close();
+        return false;
+    }
+
+    CacheHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    const qint64 expectedSize = qint64(sizeof(CacheHeader)) +
+        qint64(header.frameCount) * qint64(sizeof(Frame) + sizeof(CacheName)) +
+        header.namesSize;
+    if (std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 ||
+        header.version != cacheVersion || header.sourceHash != sourceHash ||
+        fileSize != expectedSize)
+    {
+        // Stale or foreign file, it gets rewritten after parsing the JSON
+        m_cacheFile.close();
+        return false;
+    }
+
+    m_textureSize = QSize(int(header.textureWidth), int(header.textureHeight));
+    m_frameCount = int(header.frameCount);
+    // The header keeps frames 4-byte aligned and the mapping is page aligned
+    m_frames = reinterpret_cast<const Frame *>(data + sizeof(CacheHeader));
+
+    const CacheName *names = reinterpret_cast<const CacheName *>(
+        data + sizeof(CacheHeader) + m_frameCount * sizeof(Frame));
+    const char *namesBlob = reinterpret_cast<const char *>(names + m_frameCount);
+    m_names.reserve(m_frameCount);
+    m_ids.reserve(m_frameCount);
+    for (int i = 0; i < m_frameCount; ++i)
+    {
+        if (quint64(names[i].offset) + names[i].length > header.namesSize)
+        {
+            reset();
+            return false;
+        }
+        const QString name = QString::fromUtf8(namesBlob + names[i].offset,
+            names[i].length);
+        m_names.append(name);
+        m_ids.insert(name, i);
+    }
+    return true;
+}
+
+bool TextureAtlas::writeCache(const QString &path, quint64 sourceHash) const
+{
+    QByteArray namesBlob;
+    std::vector<CacheName> names;
+    names.reserve(m_frameCount);
+    for (const QString &name : m_names)
+    {
+        const QByteArray utf8 = name.toUtf8();
+        names.push_back({ quint32(namesBlob.size()), quint32(utf8.size()) });
+        namesBlob.append(utf8);
+    }
+
+    CacheHeader header;
+    std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = cacheVersion;
+    header.sourceHash = sourceHash;
+    header.textureWidth = quint32(m_textureSize.width());
+    header.textureHeight = quint32(m_textureSize.height());
+    header.frameCount = quint32(m_frameCount);
+    header.namesSize = quint32(namesBlob.size());
+
+    // QSaveFile never leaves a half-written sidecar behind
+    QSaveFile file(path);
+    if (!file.open(QIODevice::OpenModeFlag::WriteOnly))
+    {
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(m_frames), m_frameCount * sizeof(Frame));
+    file.write(reinterpret_cast<const char *>(names.data()),
+        names.size() * sizeof(CacheName));
+    file.write(namesBlob);
+    return file.commit();
+}
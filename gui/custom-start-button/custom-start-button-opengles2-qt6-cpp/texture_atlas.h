@@ -0,0 +1,63 @@
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+#include <QtCore/QFile>
+#include <QtCore/QHash>
+#include <QtCore/QSize>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+
+#include <vector>
+
+// Sprite sheet description exported by free-texture-packer (JSON hash
+// format). The JSON is parsed once, after that a binary sidecar with
+// normalized UV rects is written to the cache directory and memory-mapped
+// on later loads. Look a frame up by name once with frameId(), then use
+// the id for constant-time access.
+class TextureAtlas
+{
+
+public:
+    struct Frame
+    {
+        // Normalized texture coordinates, top is the smaller v
+        float left;
+        float top;
+        float right;
+        float bottom;
+        // Size in pixels
+        float width;
+        float height;
+    };
+
+    TextureAtlas();
+
+    // cacheDir defaults to QStandardPaths::CacheLocation
+    bool load(const QString &jsonPath, const QString &cacheDir = QString());
+    bool isLoadedFromCache() const { return m_loadedFromCache; }
+
+    // Returns -1 when there is no frame with this name
+    int frameId(const QString &name) const { return m_ids.value(name, -1); }
+    const Frame &frame(int id) const { return m_frames[id]; }
+    int frameCount() const { return m_frameCount; }
+    QSize textureSize() const { return m_textureSize; }
+
+private:
+    void reset();
+    bool parseJson(const QByteArray &json);
+    bool loadCache(const QString &path, quint64 sourceHash);
+    bool writeCache(const QString &path, quint64 sourceHash) const;
+
+    QSize m_textureSize;
+    int m_frameCount = 0;
+    // Points either into the mapped sidecar or into m_parsedFrames
+    const Frame *m_frames = nullptr;
+    std::vector<Frame> m_parsedFrames;
+    QStringList m_names;
+    QHash<QString, int> m_ids;
+
+    QFile m_cacheFile;
+    bool m_loadedFromCache = false;
+};
+
+#endif // TEXTURE_ATLAS_H
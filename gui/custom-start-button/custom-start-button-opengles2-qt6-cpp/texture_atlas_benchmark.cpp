@@ -0,0 +1,90 @@
+#include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QTemporaryDir>
+
+#include "texture_atlas.h"
+#include "texture_atlas_benchmark.h"
+
+namespace
+{
+    const int frameCount = 5000;
+    const int frameSize = 32;
+    const int columns = 64;
+    const int warmRuns = 20;
+}
+
+int runTextureAtlasBenchmark()
+{
+    QTemporaryDir dir;
+    if (!dir.isValid())
+    {
+        qWarning() << "Failed to create a temporary directory";
+        return 1;
+    }
+
+    // Same layout as the files exported by free-texture-packer
+    QJsonObject frames;
+    for (int i = 0; i < frameCount; ++i)
+    {
+        QJsonObject rect;
+        rect.insert("x", (i % columns) * frameSize);
+        rect.insert("y", (i / columns) * frameSize);
+        rect.insert("w", frameSize);
+        rect.insert("h", frameSize);
+        QJsonObject frame;
+        frame.insert("frame", rect);
+        frame.insert("rotated", false);
+        frame.insert("trimmed", false);
+        frames.insert(QString("sprite-%1.png").arg(i), frame);
+    }
+    QJsonObject size;
+    size.insert("w", columns * frameSize);
+    size.insert("h", (frameCount / columns + 1) * frameSize);
+    QJsonObject meta;
+    meta.insert("size", size);
+    QJsonObject root;
+    root.insert("frames", frames);
+    root.insert("meta", meta);
+
+    const QString jsonPath = dir.filePath("sprites.json");
+    QFile file(jsonPath);
+    if (!file.open(QIODevice::OpenModeFlag::WriteOnly))
+    {
+        qWarning() << "Failed to write" << jsonPath;
+        return 1;
+    }
+    file.write(QJsonDocument(root).toJson());
+    file.close();
+
+    // Ids follow the sorted key order of QJsonObject, not the insertion order
+    QElapsedTimer timer;
+    int lastId = -1;
+    timer.start();
+    {
+        TextureAtlas atlas;
+        atlas.load(jsonPath, dir.path());
+        lastId = atlas.frameId("sprite-4999.png");
+    }
+    const double coldTime = timer.nsecsElapsed() / 1e6;
+
+    int checksum = 0;
+    bool fromCache = true;
+    timer.start();
+    for (int i = 0; i < warmRuns; ++i)
+    {
+        TextureAtlas atlas;
+        atlas.load(jsonPath, dir.path());
+        fromCache = fromCache && atlas.isLoadedFromCache();
+        checksum += atlas.frameId("sprite-4999.png");
+    }
+    const double warmTime = timer.nsecsElapsed() / 1e6 / warmRuns;
+
+    qInfo().noquote() << QString("%1-frame atlas: cold load %2 ms, warm load %3 ms%4")
+        .arg(frameCount).arg(coldTime, 0, 'f', 3).arg(warmTime, 0, 'f', 3)
+        .arg(fromCache && lastId >= 0 && checksum == warmRuns * lastId ? "" :
+            " (sidecar was not used)");
+    return 0;
+}
@@ -0,0 +1,9 @@
+#ifndef TEXTURE_ATLAS_BENCHMARK_H
+#define TEXTURE_ATLAS_BENCHMARK_H
+
+// Generates a 5,000-frame free-texture-packer atlas in a temporary
+// directory and prints the time of a cold load (JSON parse and sidecar
+// write) and a warm load (mapped sidecar). Returns a process exit code.
+int runTextureAtlasBenchmark();
+
+#endif // TEXTURE_ATLAS_BENCHMARK_H
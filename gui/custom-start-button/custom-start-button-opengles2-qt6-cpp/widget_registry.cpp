@@ -0,0 +1,167 @@
+#include <QtMath>
+
+#include "widget_registry.h"
+
+WidgetRegistry::WidgetRegistry(float worldWidth, float worldHeight)
+    : m_worldWidth(worldWidth)
+    , m_worldHeight(worldHeight)
+    , m_cellWidth(worldWidth)
+    , m_cellHeight(worldHeight)
+{
+}
+
+quint32 WidgetRegistry::add(const QVector2D &position, const QVector2D &size,
+    float angle, bool alphaAccurate)
+{
+    Widget widget;
+    widget.id = quint32(m_widgets.size() + 1);
+    widget.alphaAccurate = alphaAccurate;
+    m_widgets.push_back(widget);
+    setTransform(widget.id, position, size, angle);
+    return widget.id;
+}
+
+void WidgetRegistry::setTransform(quint32 id, const QVector2D &position,
+    const QVector2D &size, float angle)
+{
+    Widget &widget = m_widgets[id - 1];
+    // Where the widget was, a new widget has no size yet
+    if (m_damage && widget.size.x() > 0.f)
+    {
+        m_damage->addWorldRect(bounds(id));
+    }
+    widget.position = position;
+    widget.size = size;
+    widget.angle = angle;
+    widget.cosAngle = qCos(qDegreesToRadians(angle));
+    widget.sinAngle = qSin(qDegreesToRadians(angle));
+    m_dirty = true;
+    markDirty(id);
+}
+
+void WidgetRegistry::markDirty(quint32 id)
+{
+    if (m_damage)
+    {
+        m_damage->addWorldRect(bounds(id));
+    }
+}
+
+QRectF WidgetRegistry::bounds(quint32 id) const
+{
+    return widgetBounds(m_widgets[id - 1]);
+}
+
+QRectF WidgetRegistry::widgetBounds(const Widget &widget)
+{
+    const float halfW = (qAbs(widget.cosAngle) * widget.size.x() +
+        qAbs(widget.sinAngle) * widget.size.y()) / 2.f;
+    const float halfH = (qAbs(widget.sinAngle) * widget.size.x() +
+        qAbs(widget.cosAngle) * widget.size.y()) / 2.f;
+    return QRectF(widget.position.x() - halfW, widget.position.y() - halfH,
+        2.f * halfW, 2.f * halfH);
+}
+
+void WidgetRegistry::clear()
+{
+    for (const Widget &widget : m_widgets)
+    {
+        markDirty(widget.id);
+    }
+    m_widgets.clear();
+    m_dirty = true;
+}
+
+const WidgetRegistry::Widget *WidgetRegistry::hitTest(const QVector2D &worldPoint)
+{
+    if (worldPoint.x() < 0.f || worldPoint.x() >= m_worldWidth ||
+        worldPoint.y() < 0.f || worldPoint.y() >= m_worldHeight)
+    {
+        return nullptr;
+    }
+    if (m_dirty)
+    {
+        rebuild();
+    }
+
+    const int column = qMin(int(worldPoint.x() / m_cellWidth), m_columns - 1);
+    const int row = qMin(int(worldPoint.y() / m_cellHeight), m_rows - 1);
+    const int cell = cellIndex(column, row);
+
+    // Cells are filled in registration order, so walking backwards
+    // finds the topmost widget first
+    for (int i = m_cellStart[cell + 1] - 1; i >= m_cellStart[cell]; --i)
+    {
+        const Widget &widget = m_widgets[m_cellWidgets[i]];
+        if (contains(widget, worldPoint))
+        {
+            return &widget;
+        }
+    }
+    return nullptr;
+}
+
+void WidgetRegistry::rebuild()
+{
+    m_dirty = false;
+
+    // Roughly one widget per cell, but never more cells than is useful
+    const int widgetCount = int(m_widgets.size());
+    const int cellsPerAxis = qBound(1, int(qSqrt(float(widgetCount))), 256);
+    m_columns = cellsPerAxis;
+    m_rows = cellsPerAxis;
+    m_cellWidth = m_worldWidth / m_columns;
+    m_cellHeight = m_worldHeight / m_rows;
+
+    // Axis-aligned bounds of every widget in cell coordinates
+    std::vector<int> ranges(widgetCount * 4);
+    std::vector<int> counts(m_columns * m_rows + 1, 0);
+    for (int i = 0; i < widgetCount; ++i)
+    {
+        const QRectF box = widgetBounds(m_widgets[i]);
+        int *range = &ranges[i * 4];
+        range[0] = qBound(0, int(box.left() / m_cellWidth), m_columns - 1);
+        range[1] = qBound(0, int(box.right() / m_cellWidth), m_columns - 1);
+        range[2] = qBound(0, int(box.top() / m_cellHeight), m_rows - 1);
+        range[3] = qBound(0, int(box.bottom() / m_cellHeight), m_rows - 1);
+        for (int row = range[2]; row <= range[3]; ++row)
+        {
+            for (int column = range[0]; column <= range[1]; ++column)
+            {
+                counts[cellIndex(column, row) + 1]++;
+            }
+        }
+    }
+
+    m_cellStart.resize(counts.size());
+    m_cellStart[0] = 0;
+    for (size_t i = 1; i < counts.size(); ++i)
+    {
+        m_cellStart[i] = m_cellStart[i - 1] + counts[i];
+    }
+
+    m_cellWidgets.resize(m_cellStart.back());
+    std::vector<int> fill(m_cellStart.begin(), m_cellStart.end() - 1);
+    for (int i = 0; i < widgetCount; ++i)
+    {
+        const int *range = &ranges[i * 4];
+        for (int row = range[2]; row <= range[3]; ++row)
+        {
+            for (int column = range[0]; column <= range[1]; ++column)
+            {
+                m_cellWidgets[fill[cellIndex(column, row)]++] = i;
+            }
+        }
+    }
+}
+
+bool WidgetRegistry::contains(const Widget &widget, const QVector2D &point)
+{
+    // Inverse of the model matrix: translate back, then rotate by -angle
+    const float dx = point.x() - widget.position.x();
+    const float dy = point.y() - widget.position.y();
+    const float localX = widget.cosAngle * dx + widget.sinAngle * dy;
+    const float localY = -widget.sinAngle * dx + widget.cosAngle * dy;
+    return qAbs(localX) <= 0.5f * widget.size.x() &&
+        qAbs(localY) <= 0.5f * widget.size.y();
+}
@@ -0,0 +1,79 @@
+#ifndef WIDGET_REGISTRY_H
+#define WIDGET_REGISTRY_H
+
+#include <QtCore/QRectF>
+#include <QtGui/QVector2D>
+
+#include <vector>
+
+#include "damage_tracker.h"
+
+// Keeps the bounds of rectangular (optionally rotated) widgets in world
+// units and answers "which widget is under this point" on the CPU.
+// Widgets are binned into a uniform grid over the world, so a query only
+// tests the few widgets that overlap the cell under the point. Widgets
+// registered later are considered to be drawn on top.
+//
+// With a DamageTracker attached, widgets report the world rectangles
+// they cover when they move or change their look.
+class WidgetRegistry
+{
+
+public:
+    struct Widget
+    {
+        quint32 id;
+        QVector2D position; // Center
+        QVector2D size;
+        float angle; // Degrees
+        // Rectangle bounds are not enough, the GPU pick pass decides
+        bool alphaAccurate;
+        float cosAngle;
+        float sinAngle;
+    };
+
+    WidgetRegistry(float worldWidth, float worldHeight);
+
+    // Returns an id starting from 1 that can be used as a pick id
+    quint32 add(const QVector2D &position, const QVector2D &size,
+        float angle = 0.f, bool alphaAccurate = false);
+    void setTransform(quint32 id, const QVector2D &position,
+        const QVector2D &size, float angle = 0.f);
+    void clear();
+
+    void setDamageTracker(DamageTracker *damage) { m_damage = damage; }
+    // The widget looks different, its bounds have to be redrawn
+    void markDirty(quint32 id);
+    // Axis-aligned bounds in world units, rotation included
+    QRectF bounds(quint32 id) const;
+
+    int count() const { return int(m_widgets.size()); }
+    const Widget *widget(quint32 id) const { return &m_widgets[id - 1]; }
+
+    // Returns the topmost widget containing the point or nullptr
+    const Widget *hitTest(const QVector2D &worldPoint);
+
+private:
+    void rebuild();
+    int cellIndex(int column, int row) const { return row * m_columns + column; }
+    static bool contains(const Widget &widget, const QVector2D &point);
+    // Shared by the grid and the damage rects, so they cannot disagree
+    static QRectF widgetBounds(const Widget &widget);
+
+    const float m_worldWidth;
+    const float m_worldHeight;
+    std::vector<Widget> m_widgets;
+
+    // Grid in compressed form: widgets of cell i are
+    // m_cellWidgets[m_cellStart[i]] .. m_cellWidgets[m_cellStart[i + 1] - 1]
+    int m_columns = 1;
+    int m_rows = 1;
+    float m_cellWidth;
+    float m_cellHeight;
+    std::vector<int> m_cellStart;
+    std::vector<int> m_cellWidgets;
+    bool m_dirty = true;
+    DamageTracker *m_damage = nullptr;
+};
+
+#endif // WIDGET_REGISTRY_H
@@ -5,8 +5,12 @@
 #include <QtOpenGL/QOpenGLWindow>
 #include <QtWidgets/QApplication>
 
+#include "offscreen_host.h"
+
 class OpenGLWindow : public QOpenGLWindow, private QOpenGLFunctions
 {
+    friend class OffscreenHost;
+
 public:
     OpenGLWindow()
     {
@@ -69,6 +73,10 @@ int main(int argc, char *argv[])
     QApplication::setAttribute(Qt::ApplicationAttribute::AA_UseDesktopOpenGL);
     QApplication app(argc, argv);
     OpenGLWindow w;
+    if (OffscreenHost::isRequested(app.arguments()))
+    {
+        return OffscreenHost(app.arguments()).run(w);
+    }
     w.show();
     return app.exec();
 }
@@ -6,3 +6,5 @@ CONFIG += c++17
 
 SOURCES += \
     main.cpp
+
+include(../../../common/offscreen-host/offscreen_host.pri)
@@ -0,0 +1,108 @@
+#include <QtCore/QDebug>
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#include "game_loop_test.h"
+#include "rectangle_simulation.h"
+
+namespace
+{
+    const int stepsPerSecond = 60;
+    const qint64 runNs = 2000000000LL;
+    const int renderRates[] = { 30, 60, 240 };
+    const float angleTolerance = 0.01f;
+
+    typedef std::vector<GameLoop::Transform> Transforms;
+
+    // Remembers the output of every real step, the dt 0 call included
+    GameLoop::StepFunction recordingStep(RectangleSimulation *simulation,
+        std::vector<Transforms> *history)
+    {
+        return [simulation, history](float dt, Transforms *transforms) {
+            simulation->step(dt, transforms);
+            history->push_back(*transforms);
+        };
+    }
+
+    bool sameSteps(const std::vector<Transforms> &a, const std::vector<Transforms> &b)
+    {
+        const size_t count = qMin(a.size(), b.size());
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (a[i].size() != b[i].size() ||
+                std::memcmp(a[i].data(), b[i].data(), a[i].size() * sizeof(GameLoop::Transform)) != 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    float angleOf(const GameLoop::Transform &transform)
+    {
+        QVector3D axis;
+        float angle;
+        transform.rotation.getAxisAndAngle(&axis, &angle);
+        return axis.z() < 0.f ? -angle : angle;
+    }
+}
+
+int runGameLoopTest()
+{
+    bool ok = true;
+    std::vector<std::vector<Transforms>> histories;
+
+    for (int rate : renderRates)
+    {
+        RectangleSimulation simulation;
+        std::vector<Transforms> history;
+        GameLoop loop(stepsPerSecond, recordingStep(&simulation, &history));
+
+        const qint64 frameNs = (1000000000LL + rate / 2) / rate;
+        float maxAngleError = 0.f;
+        Transforms transforms;
+        for (qint64 elapsedNs = 0; elapsedNs + frameNs <= runNs; elapsedNs += frameNs)
+        {
+            loop.advance(frameNs);
+            loop.interpolate(&transforms);
+
+            // Drawn one step behind, the rotation is linear in time
+            const double renderSeconds = (elapsedNs + frameNs - loop.stepNs()) / 1e9;
+            const float expected = RectangleSimulation::initialAngle +
+                RectangleSimulation::angularVelocity * float(qMax(0.0, renderSeconds));
+            maxAngleError = qMax(maxAngleError, std::abs(angleOf(transforms[0]) - expected));
+        }
+
+        const bool angleOk = maxAngleError < angleTolerance;
+        const bool stepsOk = histories.empty() || sameSteps(histories[0], history);
+        ok = ok && angleOk && stepsOk;
+        qInfo().noquote() << QString("%1 Hz render: %2 steps, max interpolated angle error "
+            "%3 deg, steps %4").arg(rate, 3).arg(history.size() - 1)
+            .arg(maxAngleError, 0, 'g', 3).arg(stepsOk ? "identical" : "DIFFER");
+        if (!angleOk)
+        {
+            qWarning() << "Interpolated angle off by more than" << angleTolerance << "deg";
+        }
+        histories.push_back(std::move(history));
+    }
+
+    // The worker paces itself by the wall clock but must step the same way
+    RectangleSimulation simulation;
+    std::vector<Transforms> history;
+    {
+        GameLoop loop(stepsPerSecond, recordingStep(&simulation, &history));
+        loop.startWorker();
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        loop.stop();
+    }
+    const bool workerOk = history.size() > 1 && sameSteps(histories[0], history);
+    ok = ok && workerOk;
+    qInfo().noquote() << QString("Worker thread: %1 steps, steps %2")
+        .arg(history.size() - 1).arg(workerOk ? "identical" : "DIFFER");
+
+    qInfo() << (ok ? "Game loop test passed" : "Game loop test FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,11 @@
+#ifndef GAME_LOOP_TEST_H
+#define GAME_LOOP_TEST_H
+
+// Drives RectangleSimulation through GameLoop at 30, 60 and 240 Hz render
+// rates without a window and checks that every run produces bit-identical
+// steps, that interpolated angles follow the analytic rotation and that
+// the worker thread produces the same steps as inline stepping. Returns a
+// process exit code.
+int runGameLoopTest();
+
+#endif // GAME_LOOP_TEST_H
@@ -8,12 +8,22 @@
 #include <QtOpenGL/QOpenGLWindow>
 #include <QtWidgets/QApplication>
 
+#include "frame_scheduler.h"
+#include "game_loop.h"
+#include "game_loop_test.h"
+#include "offscreen_host.h"
+#include "rectangle_simulation.h"
+
 class OpenGLWindow : public QOpenGLWindow, private QOpenGLFunctions
 {
+    friend class OffscreenHost;
 
 public:
 
     OpenGLWindow()
+        : m_loop(60, [this](float dt, std::vector<GameLoop::Transform> *transforms) {
+            m_simulation.step(dt, transforms);
+        })
     {
         setTitle("OpenGL ES 2.0, Qt6, C++");
         resize(380, 380);
@@ -22,6 +32,11 @@ public:
         surfaceFormat.setDepthBufferSize(24);
         surfaceFormat.setSamples(4);
         setFormat(surfaceFormat);
+        // The rectangle never stops turning, so one frame per refresh.
+        // "--frame-mode on-demand" only redraws when the window is exposed.
+        // Owned by the window
+        new FrameScheduler(this, FrameScheduler::modeFromArguments(
+            QCoreApplication::arguments(), FrameScheduler::Mode::VSync));
     }
 
     void initializeGL() override
@@ -66,6 +81,9 @@ public:
 
         m_uMvpMatrixLocation = m_program.uniformLocation("uMvpMatrix");
         m_viewMatrix.lookAt(QVector3D(0, 0, 1), QVector3D(0, 0, 0), QVector3D(0, 1, 0));
+
+        // The simulation steps at 60 Hz whatever the display does
+        m_loop.startWorker();
     }
 
     void resizeGL(int w, int h) override
@@ -82,10 +100,12 @@ public:
     void paintGL() override
     {
         glClear(GL_COLOR_BUFFER_BIT);
+        m_loop.interpolate(&m_transforms);
+        const GameLoop::Transform &transform = m_transforms[0];
         m_modelMatrix.setToIdentity();
-        m_modelMatrix.translate(QVector3D(50, 50, 0));
-        m_modelMatrix.rotate(10, QVector3D(0, 0, 1));
-        m_modelMatrix.scale(QVector3D(80, 10, 1));
+        m_modelMatrix.translate(transform.position);
+        m_modelMatrix.rotate(transform.rotation);
+        m_modelMatrix.scale(transform.scale);
         m_mvpMatrix = m_projViewMatrix * m_modelMatrix;
         m_program.setUniformValue(m_uMvpMatrixLocation, m_mvpMatrix);
         glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
@@ -105,13 +125,25 @@ private:
     const int m_initialWindowHeight = 380;
     const float m_worldWidth = 100.f;
     const float m_worldHeight = 100.f;
+    RectangleSimulation m_simulation;
+    // Declared after the simulation so that the worker stops first
+    GameLoop m_loop;
+    std::vector<GameLoop::Transform> m_transforms;
 };
 
 int main(int argc, char *argv[])
 {
     QApplication::setAttribute(Qt::ApplicationAttribute::AA_UseDesktopOpenGL);
     QApplication app(argc, argv);
+    if (app.arguments().contains("--test"))
+    {
+        return runGameLoopTest();
+    }
     OpenGLWindow w;
+    if (OffscreenHost::isRequested(app.arguments()))
+    {
+        return OffscreenHost(app.arguments()).run(w);
+    }
     w.show();
     return app.exec();
 }
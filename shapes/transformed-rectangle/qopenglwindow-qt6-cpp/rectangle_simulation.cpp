@@ -0,0 +1,20 @@
+#include "rectangle_simulation.h"
+
+namespace
+{
+    // Half a swing per second
+    const float springStiffness = 9.8696f;
+}
+
+void RectangleSimulation::step(float dt, std::vector<GameLoop::Transform> *transforms)
+{
+    m_velocity -= springStiffness * m_offset * dt;
+    m_offset += m_velocity * dt;
+    m_angle += angularVelocity * dt;
+
+    transforms->resize(1);
+    GameLoop::Transform &transform = (*transforms)[0];
+    transform.position = QVector3D(50.f + m_offset, 50.f, 0.f);
+    transform.rotation = QQuaternion::fromAxisAndAngle(QVector3D(0.f, 0.f, 1.f), m_angle);
+    transform.scale = QVector3D(80.f, 10.f, 1.f);
+}
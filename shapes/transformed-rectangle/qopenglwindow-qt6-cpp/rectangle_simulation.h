@@ -0,0 +1,26 @@
+#ifndef RECTANGLE_SIMULATION_H
+#define RECTANGLE_SIMULATION_H
+
+#include <vector>
+
+#include "game_loop.h"
+
+// The rectangle as a small simulation: it spins at a constant rate and
+// sways on an undamped spring. Semi-implicit Euler keeps the swing from
+// gaining or losing energy over time.
+class RectangleSimulation
+{
+
+public:
+    static constexpr float angularVelocity = 45.f; // Degrees per second
+    static constexpr float initialAngle = 10.f;
+
+    void step(float dt, std::vector<GameLoop::Transform> *transforms);
+
+private:
+    float m_angle = initialAngle;
+    float m_offset = 10.f;
+    float m_velocity = 0.f;
+};
+
+#endif // RECTANGLE_SIMULATION_H
@@ -5,4 +5,14 @@ win32: LIBS += -lopengl32
 CONFIG += c++17
 
 SOURCES += \
-    main.cpp
+    game_loop_test.cpp \
+    main.cpp \
+    rectangle_simulation.cpp
+
+HEADERS += \
+    game_loop_test.h \
+    rectangle_simulation.h
+
+include(../../../common/frame-scheduler/frame_scheduler.pri)
+include(../../../common/game-loop/game_loop.pri)
+include(../../../common/offscreen-host/offscreen_host.pri)